@@ -0,0 +1,277 @@
+// Animating and skinning a crowd: every character cross-fades two looping clips on a 64 joint
+// skeleton. Times sampling with cursors against a binary search for the keys and against the
+// compressed clip, the whole animation update (sampling, blending and the palette) on one thread
+// and spread over the JobSystem, and CPU skinning with plain glm and with SSE. The clips and the
+// mesh are generated.
+//
+// Usage: AnimationBenchmark [characters] [verticesPerCharacter] [frames]
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include "Animation.h"
+#include "AnimationCompression.h"
+#include "BenchmarkClock.h"
+#include "JobSystem.h"
+#include "Skinning.h"
+#include "TransformHierarchy.h"
+
+namespace
+{
+	const uint32_t JOINT_COUNT = 64;
+	const float KEYS_PER_SECOND = 30.0f;
+	const float FRAME_TIME = 1.0f / 60.0f;
+
+	// A binary tree of joints, every joint is a bone
+	Skeleton MakeSkeleton()
+	{
+		Skeleton skeleton;
+		skeleton.bindPose.Resize(JOINT_COUNT);
+		std::vector<glm::mat4> worlds(JOINT_COUNT);
+		for (uint32_t i = 0; i < JOINT_COUNT; ++i)
+		{
+			uint32_t parent = i == 0 ? TransformHierarchy::NO_PARENT : (i - 1) / 2;
+			skeleton.parents.push_back(parent);
+			skeleton.names.push_back("joint" + std::to_string(i));
+			skeleton.bindPose.translations[i] = glm::vec3(i % 2 ? 0.1f : -0.1f, 0.2f, 0.0f);
+			glm::mat4 local = ComposeTransform(skeleton.bindPose.translations[i], skeleton.bindPose.rotations[i], skeleton.bindPose.scales[i]);
+			worlds[i] = parent == TransformHierarchy::NO_PARENT ? local : worlds[parent] * local;
+			skeleton.boneJoints.push_back(i);
+			skeleton.inverseBindMatrices.push_back(glm::inverse(worlds[i]));
+		}
+		return skeleton;
+	}
+
+	// Every joint swings around its own axis, the root moves as well
+	AnimationClip MakeClip(const char* name, float duration, float frequency)
+	{
+		AnimationClip clip;
+		clip.name = name;
+		clip.duration = duration;
+		clip.tracks.resize(JOINT_COUNT);
+		unsigned int keyCount = (unsigned int)(duration * KEYS_PER_SECOND) + 1;
+		for (uint32_t joint = 0; joint < JOINT_COUNT; ++joint)
+		{
+			JointTrack& track = clip.tracks[joint];
+			glm::vec3 axis = glm::normalize(glm::vec3(1.0f, (float)(joint % 3), (float)(joint % 5)));
+			for (unsigned int key = 0; key < keyCount; ++key)
+			{
+				float time = key / KEYS_PER_SECOND;
+				float angle = 0.5f * glm::sin(6.2831853f * frequency * time + joint);
+				track.rotations.times.push_back(time);
+				track.rotations.values.push_back(glm::angleAxis(angle, axis));
+				if (joint == 0)
+				{
+					track.translations.times.push_back(time);
+					track.translations.values.push_back(glm::vec3(0.0f, 0.05f * glm::sin(12.566f * frequency * time), 0.0f));
+				}
+			}
+		}
+		return clip;
+	}
+
+	// What the cursors replace, an upper_bound per channel and sample
+	template <typename T>
+	T SearchKeys(const Keyframes<T>& keys, float time, const T& bind)
+	{
+		if (keys.times.empty())
+			return bind;
+		size_t next = std::upper_bound(keys.times.begin(), keys.times.end(), time) - keys.times.begin();
+		if (next == 0)
+			return keys.values[0];
+		if (next == keys.times.size())
+			return keys.values.back();
+		size_t key = next - 1;
+		float t = (time - keys.times[key]) / (keys.times[next] - keys.times[key]);
+		return glm::mix(keys.values[key], keys.values[next], t);
+	}
+
+	glm::quat SearchKeys(const Keyframes<glm::quat>& keys, float time, const glm::quat& bind)
+	{
+		if (keys.times.empty())
+			return bind;
+		size_t next = std::upper_bound(keys.times.begin(), keys.times.end(), time) - keys.times.begin();
+		if (next == 0)
+			return keys.values[0];
+		if (next == keys.times.size())
+			return keys.values.back();
+		size_t key = next - 1;
+		float t = (time - keys.times[key]) / (keys.times[next] - keys.times[key]);
+		float sign = glm::dot(keys.values[key], keys.values[next]) < 0.0f ? -1.0f : 1.0f;
+		return glm::normalize(keys.values[key] * (1.0f - t) + keys.values[next] * (t * sign));
+	}
+
+	void SearchClip(const AnimationClip& clip, const Skeleton& skeleton, float time, Pose& pose)
+	{
+		for (size_t joint = 0; joint < JOINT_COUNT; ++joint)
+		{
+			const JointTrack& track = clip.tracks[joint];
+			pose.translations[joint] = SearchKeys(track.translations, time, skeleton.bindPose.translations[joint]);
+			pose.rotations[joint] = SearchKeys(track.rotations, time, skeleton.bindPose.rotations[joint]);
+			pose.scales[joint] = SearchKeys(track.scales, time, skeleton.bindPose.scales[joint]);
+		}
+	}
+}
+
+int main(int argc, char** argv)
+{
+	size_t characterCount = argc > 1 ? (size_t)std::atoi(argv[1]) : 1000;
+	size_t vertexCount = argc > 2 ? (size_t)std::atoi(argv[2]) : 2000;
+	int frames = argc > 3 ? std::atoi(argv[3]) : 60;
+
+	Skeleton skeleton = MakeSkeleton();
+	AnimationClip walk = MakeClip("walk", 2.0f, 0.5f);
+	AnimationClip run = MakeClip("run", 1.5f, 1.3f);
+
+	std::mt19937 random(1234);
+	std::uniform_real_distribution<float> phase(0.0f, 1.0f);
+	std::vector<Animator> animators;
+	animators.reserve(characterCount);
+	std::vector<float> phases(characterCount);
+	for (size_t i = 0; i < characterCount; ++i)
+	{
+		phases[i] = phase(random);
+		animators.emplace_back(skeleton);
+		animators[i].SetClip(0, &walk, phases[i] * walk.duration);
+		animators[i].SetClip(1, &run, phases[i] * run.duration);
+		animators[i].SetBlendWeight(phase(random));
+	}
+
+	// One mesh everyone shares, each vertex follows up to four bones
+	std::vector<Vertex> vertices(vertexCount);
+	std::vector<VertexWeights> weights(vertexCount);
+	std::uniform_int_distribution<int> pickBone(0, JOINT_COUNT - 1);
+	for (size_t i = 0; i < vertexCount; ++i)
+	{
+		vertices[i].position = glm::vec3(phase(random), phase(random) * 2.0f, phase(random));
+		vertices[i].normal = glm::normalize(vertices[i].position - glm::vec3(0.5f, 1.0f, 0.5f));
+		vertices[i].texCoords = glm::vec2(phase(random), phase(random));
+		float total = 0.0f;
+		for (unsigned int j = 0; j < VertexWeights::MAX_INFLUENCES; ++j)
+		{
+			weights[i].bones[j] = (uint8_t)pickBone(random);
+			weights[i].weights[j] = phase(random);
+			total += weights[i].weights[j];
+		}
+		for (unsigned int j = 0; j < VertexWeights::MAX_INFLUENCES; ++j)
+			weights[i].weights[j] /= total;
+	}
+	std::vector<Vertex> skinned(characterCount * vertexCount);
+
+	unsigned int hardwareThreads = std::thread::hardware_concurrency();
+	JobSystem jobs(hardwareThreads > 1 ? hardwareThreads - 1 : 0);
+
+	std::cout << characterCount << " characters, " << JOINT_COUNT << " joints, " << vertexCount << " vertices each, "
+		<< frames << " frames, " << jobs.GetWorkerCount() << " workers + the calling thread\n";
+	std::cout << "step\tms/frame\n";
+
+	// Sampling alone, one clip per character
+	std::vector<ClipCursor> cursors(characterCount);
+	Pose pose;
+	pose.Resize(JOINT_COUNT);
+	float checksum = 0.0f;
+	auto start = std::chrono::steady_clock::now();
+	for (int frame = 0; frame < frames; ++frame)
+	{
+		for (size_t i = 0; i < characterCount; ++i)
+		{
+			float time = std::fmod(phases[i] * walk.duration + frame * FRAME_TIME, walk.duration);
+			SearchClip(walk, skeleton, time, pose);
+			checksum += pose.rotations[JOINT_COUNT - 1].x;
+		}
+	}
+	std::cout << "sample, binary search\t" << MillisecondsSince(start) / frames << "\n";
+
+	start = std::chrono::steady_clock::now();
+	for (int frame = 0; frame < frames; ++frame)
+	{
+		for (size_t i = 0; i < characterCount; ++i)
+		{
+			float time = std::fmod(phases[i] * walk.duration + frame * FRAME_TIME, walk.duration);
+			SampleClip(walk, skeleton, time, cursors[i], pose);
+			checksum -= pose.rotations[JOINT_COUNT - 1].x;
+		}
+	}
+	std::cout << "sample, cursor\t" << MillisecondsSince(start) / frames << "\n";
+
+	CompressedClip compressedWalk = CompressedClip::Compress(walk, skeleton);
+	for (ClipCursor& cursor : cursors)
+		cursor.Reset();
+	start = std::chrono::steady_clock::now();
+	for (int frame = 0; frame < frames; ++frame)
+	{
+		for (size_t i = 0; i < characterCount; ++i)
+		{
+			float time = std::fmod(phases[i] * walk.duration + frame * FRAME_TIME, walk.duration);
+			compressedWalk.Sample(skeleton, time, cursors[i], pose);
+			checksum += pose.rotations[JOINT_COUNT - 1].x;
+		}
+	}
+	std::cout << "sample, compressed\t" << MillisecondsSince(start) / frames << "\n";
+	CompressionError error = MeasureCompressionError(walk, compressedWalk, skeleton);
+	std::cout << "  clip " << walk.GetKeyCount() << " -> " << compressedWalk.GetKeyCount() << " keys, " << walk.GetMemoryUsage()
+		<< " -> " << compressedWalk.GetMemoryUsage() << " bytes, max error " << error.translation << " translation, "
+		<< error.rotation << " rad\n";
+
+	// Sampling both clips, blending and the palette
+	start = std::chrono::steady_clock::now();
+	for (int frame = 0; frame < frames; ++frame)
+	{
+		for (Animator& animator : animators)
+			animator.Update(FRAME_TIME);
+	}
+	std::cout << "animate, 1 thread\t" << MillisecondsSince(start) / frames << "\n";
+
+	start = std::chrono::steady_clock::now();
+	for (int frame = 0; frame < frames; ++frame)
+		Animator::UpdateAll(jobs, animators.data(), animators.size(), FRAME_TIME);
+	std::cout << "animate, " << jobs.GetWorkerCount() << " workers + caller\t" << MillisecondsSince(start) / frames << "\n";
+
+	start = std::chrono::steady_clock::now();
+	for (int frame = 0; frame < frames; ++frame)
+	{
+		for (size_t i = 0; i < characterCount; ++i)
+			SkinVerticesScalar(vertices.data(), weights.data(), vertexCount, animators[i].GetPalette(), &skinned[i * vertexCount]);
+	}
+	std::cout << "skin, glm, 1 thread\t" << MillisecondsSince(start) / frames << "\n";
+	std::vector<Vertex> reference(skinned.begin(), skinned.begin() + vertexCount);
+
+	start = std::chrono::steady_clock::now();
+	for (int frame = 0; frame < frames; ++frame)
+	{
+		for (size_t i = 0; i < characterCount; ++i)
+			SkinVertices(vertices.data(), weights.data(), vertexCount, animators[i].GetPalette(), &skinned[i * vertexCount]);
+	}
+	std::cout << "skin, SSE, 1 thread\t" << MillisecondsSince(start) / frames << "\n";
+
+	float maxError = 0.0f;
+	for (size_t i = 0; i < vertexCount; ++i)
+	{
+		maxError = std::max(maxError, glm::length(skinned[i].position - reference[i].position));
+		maxError = std::max(maxError, glm::length(skinned[i].normal - reference[i].normal));
+	}
+
+	start = std::chrono::steady_clock::now();
+	for (int frame = 0; frame < frames; ++frame)
+	{
+		jobs.ParallelFor(characterCount, 1, [&](size_t begin, size_t end)
+		{
+			for (size_t i = begin; i < end; ++i)
+				SkinVertices(vertices.data(), weights.data(), vertexCount, animators[i].GetPalette(), &skinned[i * vertexCount]);
+		});
+	}
+	std::cout << "skin, SSE, " << jobs.GetWorkerCount() << " workers + caller\t" << MillisecondsSince(start) / frames << "\n";
+
+	for (size_t i = 0; i < skinned.size(); i += 4999)
+		checksum += skinned[i].position.y;
+	std::cout << "SSE vs glm max difference " << maxError << ", checksum " << checksum << "\n";
+	return 0;
+}
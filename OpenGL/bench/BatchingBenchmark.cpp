@@ -0,0 +1,114 @@
+// Draw calls of a scene with many materials, one draw per mesh against the maps packed into texture
+// arrays by TextureArrayPlan and the meshes merged by GroupBatches, like ModelSettings::textureArrays
+// does. Every mesh has its own material with its own maps, mostly in a few common sizes with some
+// odd ones, and one of a small palette of parameter sets. Some meshes have no normal map and so no
+// tangent stream. Only the planning is timed, the scene is generated.
+//
+// Usage: BatchingBenchmark [materials] [transforms] [oddSizePercent]
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <random>
+#include <tuple>
+#include <vector>
+
+#include "BenchmarkClock.h"
+#include "TextureBatching.h"
+
+namespace
+{
+	const int SLOT_COUNT = 3;
+	const int NORMAL_SLOT = 2;
+	const uint32_t PARAMETER_SETS = 4;
+	const uint32_t NO_IMAGE = 0xffffffff;
+
+	struct SyntheticMaterial
+	{
+		uint32_t images[SLOT_COUNT];
+		uint32_t parameters;
+	};
+}
+
+int main(int argc, char** argv)
+{
+	uint32_t materialCount = argc > 1 ? (uint32_t)std::atoi(argv[1]) : 1000;
+	uint32_t transformCount = argc > 2 ? (uint32_t)std::atoi(argv[2]) : 1;
+	double oddPercent = argc > 3 ? std::atof(argv[3]) : 5.0;
+	if (transformCount == 0)
+		transformCount = 1;
+
+	std::mt19937 random(1234);
+	std::uniform_real_distribution<double> percent(0.0, 100.0);
+	const int commonSizes[] = { 256, 512, 1024 };
+	std::vector<int> widths, heights;
+	std::vector<SyntheticMaterial> materials(materialCount);
+	for (SyntheticMaterial& material : materials)
+	{
+		// A material's maps are usually all the same size
+		int size = commonSizes[random() % 3];
+		for (int slot = 0; slot < SLOT_COUNT; ++slot)
+		{
+			// A quarter without a normal map
+			if (slot == NORMAL_SLOT && percent(random) < 25.0)
+			{
+				material.images[slot] = NO_IMAGE;
+				continue;
+			}
+			material.images[slot] = (uint32_t)widths.size();
+			if (percent(random) < oddPercent)
+			{
+				widths.push_back(100 + (int)(random() % 400));
+				heights.push_back(100 + (int)(random() % 400));
+			}
+			else
+			{
+				widths.push_back(size);
+				heights.push_back(size);
+			}
+		}
+		material.parameters = random() % PARAMETER_SETS;
+	}
+
+	// One mesh per material
+	std::vector<uint32_t> meshTransforms(materialCount);
+	for (uint32_t& transform : meshTransforms)
+		transform = random() % transformCount;
+
+	std::cout << materialCount << " materials and meshes, " << widths.size() << " maps, " << transformCount
+		<< " transforms, " << oddPercent << "% odd sizes\n";
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	TextureArrayPlan plan = TextureArrayPlan::Plan(widths, heights);
+	double planMs = MillisecondsSince(start);
+
+	// Materials the library would keep apart, arrays and parameters
+	start = std::chrono::steady_clock::now();
+	std::map<std::tuple<uint32_t, uint32_t, uint32_t, uint32_t>, uint32_t> arrayMaterials;
+	std::vector<BatchKey> keys(materialCount);
+	for (uint32_t i = 0; i < materialCount; ++i)
+	{
+		uint32_t arrays[SLOT_COUNT];
+		for (int slot = 0; slot < SLOT_COUNT; ++slot)
+			arrays[slot] = materials[i].images[slot] == NO_IMAGE ? NO_IMAGE : plan.placements[materials[i].images[slot]].array;
+		auto key = std::make_tuple(arrays[0], arrays[1], arrays[2], materials[i].parameters);
+		auto found = arrayMaterials.insert(std::make_pair(key, (uint32_t)arrayMaterials.size())).first;
+		keys[i].material = found->second;
+		keys[i].transform = meshTransforms[i];
+		keys[i].streams = materials[i].images[NORMAL_SLOT] == NO_IMAGE ? 0 : 2;
+	}
+	uint32_t batchCount = 0;
+	GroupBatches(keys, batchCount);
+	double groupMs = MillisecondsSince(start);
+
+	size_t maxLayers = 0;
+	for (const TextureArrayPlan::Array& array : plan.arrays)
+		maxLayers = array.images.size() > maxLayers ? array.images.size() : maxLayers;
+
+	std::cout << "method\tdraws\tmaterials\ttextures\n";
+	std::cout << "per mesh\t" << materialCount << "\t" << materialCount << "\t" << widths.size() << "\n";
+	std::cout << "arrays\t" << batchCount << "\t" << arrayMaterials.size() << "\t" << plan.arrays.size() << "\n";
+	std::cout << "draws " << (double)materialCount / batchCount << "x fewer, largest array " << maxLayers << " layers\n";
+	std::cout << "plan " << planMs << " ms, grouping " << groupMs << " ms\n";
+	return 0;
+}
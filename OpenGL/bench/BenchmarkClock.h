@@ -0,0 +1,8 @@
+#pragma once
+#include <chrono>
+
+// Wall time for the benchmarks
+inline double MillisecondsSince(std::chrono::steady_clock::time_point start)
+{
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
@@ -0,0 +1,139 @@
+// GPU cost of the blur effects against their radius: the original 3x3 Blur.fs, the separable
+// Gaussian with and without linear sampling, and the dual Kawase pyramid. Timed with GPU queries
+// through the post-process graph. Needs a headless context (EGL or OSMesa build), run from the
+// OpenGL directory so the shaders are found.
+//
+// Usage: BlurBenchmark [width] [height] [frames]
+#include <GL/glew.h>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "GaussianBlur.h"
+#include "GpuProfiler.h"
+#include "HeadlessContext.h"
+#include "Material.h"
+#include "Mesh.h"
+#include "PostProcessGraph.h"
+#include "RenderState.h"
+
+namespace
+{
+	// Average GPU ms of the only enabled effect
+	double Measure(PostProcessGraph& graph, unsigned int output, const char* zone, int frames)
+	{
+		GpuProfiler profiler;
+		graph.SetProfiler(&profiler);
+		// The profiler reads results a few frames late, so run a few more than are needed
+		for (int frame = 0; frame < frames + (int)GpuProfiler::FRAME_LATENCY; ++frame)
+		{
+			profiler.BeginFrame();
+			glBindFramebuffer(GL_FRAMEBUFFER, graph.BeginScene(output));
+			glClearColor(0.2f, 0.4f, 0.8f, 1.0f);
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+			graph.Execute(output);
+			profiler.EndFrame();
+			// Keeps the GPU from falling far enough behind for the profiler to drop frames
+			glFinish();
+		}
+		graph.SetProfiler(nullptr);
+		for (unsigned int i = 0; i < profiler.GetZoneCount(); ++i)
+		{
+			GpuZoneStats stats = profiler.GetZoneStats(i);
+			if (std::string(stats.name) == zone)
+				return stats.avg;
+		}
+		return 0.0;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	int width = argc > 1 ? std::atoi(argv[1]) : 1920;
+	int height = argc > 2 ? std::atoi(argv[2]) : 1080;
+	int frames = argc > 3 ? std::atoi(argv[3]) : 50;
+
+	HeadlessContext context;
+	if (!HeadlessContext::IsAvailable() || !context.Create(width, height))
+	{
+		std::cout << "No headless context (" << HeadlessContext::GetBackendName() << ")\n";
+		return -1;
+	}
+	RenderState::Invalidate();
+	glViewport(0, 0, width, height);
+
+	std::vector<Vertex> quadVertices = {
+		{ { -1.0f, 1.0f, 0 }, { 0, 0, 0 }, { 0, 1.0f } },
+		{ { -1.0f, -1.0f, 0 }, { 0, 0, 0 }, { 0, 0 } },
+		{ { 1.0f, 1.0f, 0 }, { 0, 0, 0 }, { 1, 1 } },
+		{ { 1.0f, -1.0f, 0 }, { 0, 0, 0 }, { 1, 0 } }
+	};
+	std::vector<unsigned int> quadIndices = { 0, 1, 2, 2, 1, 3 };
+
+	{
+		Mesh quad(quadVertices, quadIndices, MaterialLibrary::NO_MATERIAL);
+		PostProcessGraph graph(quad, width, height);
+		PostProcessEffect& original = graph.AddEffect(std::unique_ptr<PostProcessEffect>(new ShaderEffect("Blur", "res/shaders/Blur.fs")));
+		GaussianBlurEffect* gaussianEffect = new GaussianBlurEffect("GaussianBlur");
+		graph.AddEffect(std::unique_ptr<PostProcessEffect>(gaussianEffect));
+		GaussianBlurEffect& gaussian = *gaussianEffect;
+		unsigned int output = context.GetFramebuffer();
+
+		std::cout << width << "x" << height << ", " << frames << " frames, " << glGetString(GL_RENDERER) << "\n";
+		std::cout << std::fixed << std::setprecision(3);
+
+		gaussian.SetEnabled(false);
+		std::cout << "Blur.fs, fixed 3x3 at 1/300 of the screen: " << Measure(graph, output, "Blur", frames) << " ms\n\n";
+		original.SetEnabled(false);
+		gaussian.SetEnabled(true);
+
+		std::cout << "radius\tseparable\tlinear taps\tpyramid\t\tfetches (separable/linear)\tpyramid levels\n";
+		const float radii[] = { 1, 2, 4, 8, 16, 24, 32, 48, 62, 96, 128 };
+		for (float radius : radii)
+		{
+			gaussian.SetRadius(radius);
+			double separable = -1.0, linear = -1.0;
+			// Past these the kernel doesn't fit the shader's arrays
+			if (radius < GaussianKernel::MAX_TAPS)
+			{
+				gaussian.SetMethod(BlurMethod::Separable);
+				gaussian.SetLinearSampling(false);
+				separable = Measure(graph, output, "GaussianBlur", frames);
+			}
+			if (radius <= (GaussianKernel::MAX_TAPS - 1) * 2)
+			{
+				gaussian.SetMethod(BlurMethod::Separable);
+				gaussian.SetLinearSampling(true);
+				linear = Measure(graph, output, "GaussianBlur", frames);
+			}
+			gaussian.SetMethod(BlurMethod::Pyramid);
+			double pyramid = Measure(graph, output, "GaussianBlur", frames);
+
+			int levels;
+			float spread;
+			GaussianBlurEffect::GetPyramidLayout(radius, levels, spread);
+			// Per pixel over both passes
+			int discreteFetches = (ComputeGaussianKernel((int)radius, false).tapCount * 2 - 1) * 2;
+			int linearFetches = (ComputeGaussianKernel((int)radius, true).tapCount * 2 - 1) * 2;
+			std::cout << (int)radius << "\t";
+			if (separable >= 0.0)
+				std::cout << separable << "\t\t";
+			else
+				std::cout << "-\t\t";
+			if (linear >= 0.0)
+				std::cout << linear << "\t\t";
+			else
+				std::cout << "-\t\t";
+			std::cout << pyramid << "\t\t";
+			if (linear >= 0.0)
+				std::cout << (separable >= 0.0 ? std::to_string(discreteFetches) : "-") << " / " << linearFetches << "\t\t\t";
+			else
+				std::cout << "-\t\t\t\t";
+			std::cout << levels << " (spread " << std::setprecision(2) << spread << ")" << std::setprecision(3) << "\n";
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,158 @@
+// Measures frame capture at 1080p: what a synchronous glReadPixels costs the render thread against
+// the PBO ring in FrameCapture, and how many frames each encoder keeps up with at a given frame rate.
+// Needs a headless context (EGL or OSMesa build).
+//
+// Usage: CaptureBenchmark [width] [height] [frames] [fps] [outputDirectory]
+#include <GL/glew.h>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "FrameCapture.h"
+#include "HeadlessContext.h"
+#include "RenderState.h"
+#include "SampleStats.h"
+
+namespace
+{
+	int width = 1920;
+	int height = 1080;
+	unsigned int sourceFramebuffer = 0;
+	unsigned int sourceTexture = 0;
+
+	// Something with gradients and detail so the encoders don't get an easy ride
+	void CreateSource()
+	{
+		std::vector<unsigned char> pixels((size_t)width * height * 4);
+		unsigned int noise = 12345;
+		for (int y = 0; y < height; ++y)
+		{
+			for (int x = 0; x < width; ++x)
+			{
+				noise = noise * 1664525u + 1013904223u;
+				unsigned char* pixel = &pixels[((size_t)y * width + x) * 4];
+				pixel[0] = (unsigned char)(x * 255 / width);
+				pixel[1] = (unsigned char)(y * 255 / height);
+				pixel[2] = (unsigned char)(((x / 32 + y / 32) & 1) * 128 + (noise >> 28));
+				pixel[3] = 255;
+			}
+		}
+		glGenTextures(1, &sourceTexture);
+		RenderState::BindTexture(RenderState::GetActiveTextureUnit(), GL_TEXTURE_2D, sourceTexture);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+		glGenFramebuffers(1, &sourceFramebuffer);
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, sourceFramebuffer);
+		glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, sourceTexture, 0);
+	}
+
+	// Copies the source in and clears a moving square so every frame is different
+	void DrawFrame(unsigned int framebuffer, int frame)
+	{
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, sourceFramebuffer);
+		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, framebuffer);
+		glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+		glEnable(GL_SCISSOR_TEST);
+		glScissor((frame * 16) % (width - 128), height / 2 - 64, 128, 128);
+		glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
+		glClear(GL_COLOR_BUFFER_BIT);
+		glDisable(GL_SCISSOR_TEST);
+	}
+
+	double Milliseconds(std::chrono::steady_clock::duration duration)
+	{
+		return std::chrono::duration<double, std::milli>(duration).count();
+	}
+}
+
+int main(int argc, char** argv)
+{
+	width = argc > 1 ? std::atoi(argv[1]) : 1920;
+	height = argc > 2 ? std::atoi(argv[2]) : 1080;
+	int frames = argc > 3 ? std::atoi(argv[3]) : 300;
+	int framesPerSecond = argc > 4 ? std::atoi(argv[4]) : 60;
+	std::string outputDirectory = argc > 5 ? argv[5] : "capture_benchmark";
+
+	HeadlessContext context;
+	if (!HeadlessContext::IsAvailable() || !context.Create(width, height))
+	{
+		std::cout << "No headless context (" << HeadlessContext::GetBackendName() << ")\n";
+		return -1;
+	}
+	std::filesystem::create_directories(outputDirectory);
+	CreateSource();
+	unsigned int framebuffer = context.GetFramebuffer();
+	std::chrono::steady_clock::duration frameTime = std::chrono::nanoseconds(1000000000ll / framesPerSecond);
+	double frameMegabytes = (double)width * height * 4 / (1024.0 * 1024.0);
+
+	std::cout << width << "x" << height << ", " << frames << " frames at " << framesPerSecond << " fps, "
+		<< std::thread::hardware_concurrency() << " hardware threads, " << glGetString(GL_RENDERER) << "\n\n";
+	std::cout << std::fixed << std::setprecision(2);
+	std::cout << "mode\t\trender ms (avg/p99)\tcaptured\tdropped\tencoder ms/frame\tMB/s out\n";
+
+	// The naive way, every frame waits for the GPU and the copy
+	{
+		std::vector<unsigned char> pixels((size_t)width * height * 4);
+		SampleStats readMs;
+		for (int frame = 0; frame < frames; ++frame)
+		{
+			DrawFrame(framebuffer, frame);
+			auto start = std::chrono::steady_clock::now();
+			glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+			glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+			readMs.Add(Milliseconds(std::chrono::steady_clock::now() - start));
+		}
+		std::cout << "glReadPixels\t" << readMs.GetMean() << " / " << readMs.GetPercentile(99.0) << "\t\t"
+			<< frames << "\t\t0\t-\t\t\t" << frameMegabytes * 1000.0 / readMs.GetMean() << " (readback)\n";
+	}
+
+	struct Mode
+	{
+		const char* name;
+		CaptureFormat format;
+		int pngLevel;
+		const char* file;
+	};
+	const Mode modes[] =
+	{
+		{ "PNG stored", CaptureFormat::PngSequence, 0, "stored" },
+		{ "PNG level 1", CaptureFormat::PngSequence, 1, "level1" },
+		{ "Y4M 4:2:0", CaptureFormat::Y4m, 0, "capture.y4m" },
+	};
+	for (const Mode& mode : modes)
+	{
+		SampleStats captureMs;
+		auto runStart = std::chrono::steady_clock::now();
+		FrameCapture capture(width, height, mode.format, outputDirectory + "/" + mode.file);
+		capture.GetEncoder().SetPngLevel(mode.pngLevel);
+		auto deadline = std::chrono::steady_clock::now();
+		for (int frame = 0; frame < frames; ++frame)
+		{
+			DrawFrame(framebuffer, frame);
+			auto start = std::chrono::steady_clock::now();
+			capture.Capture(framebuffer);
+			captureMs.Add(Milliseconds(std::chrono::steady_clock::now() - start));
+			// Stand in for vsync so the encoders see a real frame rate
+			deadline += frameTime;
+			std::this_thread::sleep_until(deadline);
+		}
+		capture.Finish();
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - runStart).count();
+
+		const FrameCaptureStats& stats = capture.GetStats();
+		FrameEncoderStats encoder = capture.GetEncoder().GetStats();
+		double encodeMs = encoder.encoded ? encoder.encodeSeconds * 1000.0 / encoder.encoded : 0.0;
+		std::cout << mode.name << "\t" << captureMs.GetMean() << " / " << captureMs.GetPercentile(99.0) << "\t\t"
+			<< stats.captured << "\t\t" << stats.droppedReadbacks + stats.droppedEncodes << "\t" << encodeMs << "\t\t\t"
+			<< encoder.bytesWritten / (1024.0 * 1024.0) / seconds << "\n";
+	}
+
+	glDeleteFramebuffers(1, &sourceFramebuffer);
+	RenderState::ForgetTexture(sourceTexture);
+	glDeleteTextures(1, &sourceTexture);
+	return 0;
+}
@@ -0,0 +1,172 @@
+// Runs the Scene systems over a million entities, each with a transform, a renderable, bounds and a
+// point light: the transform system with 1% of the entities moving, culling on its own, culling
+// plus recording through the FrameBuilder, and finding the nearest light. Culling and lighting
+// are also run over the same data as one struct per object, which is what the component pools
+// replace. Needs a headless context (EGL or OSMesa build) for the model. Run from the OpenGL directory.
+//
+// Usage: EntityBenchmark [entityCount] [frames]
+#include <GL/glew.h>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "BenchmarkClock.h"
+#include "FrameBuilder.h"
+#include "HeadlessContext.h"
+#include "JobSystem.h"
+#include "Model.h"
+#include "Scene.h"
+#include "Shader.h"
+
+namespace
+{
+	// Everything about an object in one place
+	struct ObjectStruct
+	{
+		RenderableComponent renderable;
+		Bounds localBounds;
+		Bounds worldBounds;
+		PointLightComponent light;
+		glm::mat4 world;
+	};
+}
+
+int main(int argc, char** argv)
+{
+	int entityCount = argc > 1 ? std::atoi(argv[1]) : 1000000;
+	int frames = argc > 2 ? std::atoi(argv[2]) : 20;
+
+	HeadlessContext context;
+	if (!HeadlessContext::IsAvailable() || !context.Create(64, 64))
+	{
+		std::cout << "No headless context (" << HeadlessContext::GetBackendName() << ")\n";
+		return 1;
+	}
+
+	{
+		Model cube("res/models/cube/cube.obj");
+		Shader shader("res/shaders/BasicLit.vs", "res/shaders/Color.fs");
+
+		// A square grid around the camera, roughly a quarter ends up in the frustum
+		Scene scene;
+		scene.Reserve(entityCount);
+		std::vector<ObjectStruct> objects(entityCount);
+		int side = (int)glm::ceil(glm::sqrt((float)entityCount));
+		for (int i = 0; i < entityCount; ++i)
+		{
+			glm::vec3 position((i % side - side / 2) * 2.0f, 0.0f, (i / side - side / 2) * 2.0f);
+			Entity entity = scene.CreateEntity(glm::translate(glm::mat4(1.0f), position));
+			RenderableComponent renderable;
+			renderable.model = &cube;
+			renderable.shader = &shader;
+			renderable.params.flags = DrawParams::EMISSION;
+			scene.AddRenderable(entity, renderable);
+			PointLightComponent light;
+			light.color = glm::vec3((i & 3) / 3.0f, 1.0f, 0.5f);
+			scene.AddPointLight(entity, light);
+
+			objects[i].renderable = renderable;
+			objects[i].light = light;
+			objects[i].world = glm::translate(glm::mat4(1.0f), position);
+			objects[i].localBounds = cube.GetBounds();
+			objects[i].worldBounds = cube.GetBounds().Transformed(objects[i].world);
+		}
+		scene.UpdateTransforms();
+
+		float farPlane = side * 2.0f;
+		glm::mat4 projection = glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.01f, farPlane);
+		glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 5.0f, 0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+		Frustum frustum(projection * view);
+		glm::vec3 viewPosition(0.0f, 5.0f, 0.0f);
+
+		// Entities that move, picked up front
+		std::mt19937 random(1234);
+		std::uniform_int_distribution<int> pick(0, entityCount - 1);
+		std::vector<Entity> moving((size_t)entityCount / 100 * frames);
+		for (Entity& entity : moving)
+			entity = (Entity)pick(random);
+
+		std::cout << entityCount << " entities, " << frames << " frames\n";
+		std::cout << "system\tcomponent pools ms\tstruct per object ms\n";
+
+		size_t movingPerFrame = (size_t)entityCount / 100;
+		auto start = std::chrono::steady_clock::now();
+		for (int frame = 0; frame < frames; ++frame)
+		{
+			for (size_t i = 0; i < movingPerFrame; ++i)
+			{
+				Entity entity = moving[frame * movingPerFrame + i];
+				scene.SetLocalTransform(entity, glm::translate(scene.GetTransforms().GetLocal(scene.GetNode(entity)), glm::vec3(0.0f, 0.01f, 0.0f)));
+			}
+			scene.UpdateTransforms();
+		}
+		std::cout << "transforms (1% moving)\t" << MillisecondsSince(start) / frames << "\t-\n";
+
+		unsigned int visible = 0;
+		start = std::chrono::steady_clock::now();
+		for (int frame = 0; frame < frames; ++frame)
+		{
+			const ComponentPool<Bounds>& bounds = scene.GetWorldBounds();
+			for (size_t slot = 0; slot < bounds.GetSize(); ++slot)
+				visible += frustum.Intersects(bounds[slot]);
+		}
+		double poolMs = MillisecondsSince(start) / frames;
+		start = std::chrono::steady_clock::now();
+		for (int frame = 0; frame < frames; ++frame)
+		{
+			for (const ObjectStruct& object : objects)
+				visible += frustum.Intersects(object.worldBounds);
+		}
+		std::cout << "culling\t" << poolMs << "\t" << MillisecondsSince(start) / frames << "\n";
+
+		// The render thread helps out, like in the demo
+		unsigned int hardwareThreads = std::thread::hardware_concurrency();
+		JobSystem jobs(hardwareThreads > 1 ? hardwareThreads - 1 : 0);
+		FrameBuilder builder(jobs);
+		FrameArena arena;
+		RenderQueue queue(arena);
+		builder.Record(scene, projection * view, queue);
+		start = std::chrono::steady_clock::now();
+		for (int frame = 0; frame < frames; ++frame)
+			builder.Record(scene, projection * view, queue);
+		std::cout << "culling + recording (" << jobs.GetThreadCount() << " threads)\t" << MillisecondsSince(start) / frames << "\t-\n";
+
+		// The nearest light, the demo gathers a few but the walk over the lights is the same
+		PointLightInstance light;
+		float checksum = 0.0f;
+		start = std::chrono::steady_clock::now();
+		for (int frame = 0; frame < frames; ++frame)
+		{
+			if (scene.GatherPointLights(viewPosition, &light, 1))
+				checksum += light.position.x + light.light.color.x;
+		}
+		poolMs = MillisecondsSince(start) / frames;
+		start = std::chrono::steady_clock::now();
+		for (int frame = 0; frame < frames; ++frame)
+		{
+			const ObjectStruct* nearest = nullptr;
+			float nearestDistance = 0.0f;
+			for (const ObjectStruct& object : objects)
+			{
+				glm::vec3 offset = glm::vec3(object.world[3]) - viewPosition;
+				float distance = glm::dot(offset, offset);
+				if (!nearest || distance < nearestDistance)
+				{
+					nearest = &object;
+					nearestDistance = distance;
+				}
+			}
+			checksum += nearest->world[3].x + nearest->light.color.x;
+		}
+		std::cout << "nearest light\t" << poolMs << "\t" << MillisecondsSince(start) / frames << "\n";
+
+		std::cout << "visible " << builder.GetStats().visible << ", checksum " << visible + checksum << "\n";
+	}
+	context.Destroy();
+	return 0;
+}
@@ -0,0 +1,101 @@
+// Measures how command recording in FrameBuilder scales with worker threads.
+// Needs a GL context for the models, so a hidden window is created. Run from the OpenGL directory.
+//
+// Usage: FrameBuilderBenchmark [objectCount] [maxWorkers] [frames]
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "FrameBuilder.h"
+#include "JobSystem.h"
+#include "Model.h"
+#include "RenderQueue.h"
+#include "Scene.h"
+#include "Shader.h"
+#include "TransformHierarchy.h"
+
+int main(int argc, char** argv)
+{
+	int objectCount = argc > 1 ? std::atoi(argv[1]) : 50000;
+	unsigned int maxWorkers = argc > 2 ? (unsigned int)std::atoi(argv[2]) : std::thread::hardware_concurrency();
+	int frames = argc > 3 ? std::atoi(argv[3]) : 200;
+
+	if (!glfwInit())
+		return -1;
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+	glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+	GLFWwindow* window = glfwCreateWindow(64, 64, "FrameBuilderBenchmark", NULL, NULL);
+	if (!window)
+	{
+		glfwTerminate();
+		return -1;
+	}
+	glfwMakeContextCurrent(window);
+	if (glewInit() != GLEW_OK)
+		std::cout << "Error!\n";
+
+	{
+		Model cube("res/models/cube/cube.obj");
+		Shader shader("res/shaders/BasicLit.vs", "res/shaders/Color.fs");
+
+		// Objects on a square grid around the camera, roughly a quarter ends up in the frustum
+		Scene scene;
+		scene.Reserve(objectCount);
+		int side = (int)glm::ceil(glm::sqrt((float)objectCount));
+		for (int i = 0; i < objectCount; ++i)
+		{
+			glm::vec3 position((i % side - side / 2) * 2.0f, 0.0f, (i / side - side / 2) * 2.0f);
+			Entity entity = scene.CreateEntity(ComposeTransform(position, glm::angleAxis((float)i, glm::vec3(0.0f, 1.0f, 0.0f)), glm::vec3(1.0f)));
+			RenderableComponent renderable;
+			renderable.model = &cube;
+			renderable.shader = &shader;
+			renderable.params.flags = DrawParams::EMISSION;
+			scene.AddRenderable(entity, renderable);
+		}
+		// Nothing moves, so the world matrices and bounds are computed once (see EntityBenchmark for that part)
+		scene.UpdateTransforms();
+
+		float farPlane = side * 2.0f;
+		glm::mat4 projection = glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.01f, farPlane);
+		glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 5.0f, 0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+		FrameArena arena;
+		RenderQueue queue(arena);
+
+		std::cout << objectCount << " objects, " << frames << " frames\n";
+		std::cout << "workers\tms/frame\tspeedup\tvisible\n";
+		double baseline = 0.0;
+		for (unsigned int workers = 0; workers <= maxWorkers; ++workers)
+		{
+			JobSystem jobs(workers);
+			FrameBuilder builder(jobs);
+			// Warm up so the draw lists have grown to their steady-state size
+			builder.Record(scene, projection * view, queue);
+
+			auto start = std::chrono::steady_clock::now();
+			for (int frame = 0; frame < frames; ++frame)
+			{
+				arena.BeginFrame();
+				queue.Begin(glm::vec3(0.0f, 5.0f, 0.0f), farPlane);
+				builder.Build(scene, projection * view, queue);
+			}
+			auto end = std::chrono::steady_clock::now();
+
+			double ms = std::chrono::duration<double, std::milli>(end - start).count() / frames;
+			if (workers == 0)
+				baseline = ms;
+			std::cout << workers << "\t" << ms << "\t" << baseline / ms << "\t" << builder.GetStats().visible << "\n";
+		}
+	}
+
+	glfwDestroyWindow(window);
+	glfwTerminate();
+	return 0;
+}
@@ -0,0 +1,97 @@
+// Microbenchmarks for JobSystem: cost of spawning and finishing an empty job, nested spawning,
+// dependency chains and ParallelFor scaling over 0..N workers.
+//
+// Usage: JobSystemBenchmark [maxWorkers]
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "BenchmarkClock.h"
+#include "JobSystem.h"
+
+namespace
+{
+	// Enough arithmetic per element that memory bandwidth isn't the bottleneck
+	float Work(float x)
+	{
+		for (int i = 0; i < 16; ++i)
+			x = std::sqrt(x * x + 1.0f);
+		return x;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	unsigned int maxWorkers = argc > 1 ? (unsigned int)std::atoi(argv[1]) : std::thread::hardware_concurrency();
+
+	const int spawnCount = 1000000;
+	const int chainLength = 10000;
+	std::vector<float> data(1 << 22, 1.0f);
+
+	std::cout << "workers\tspawn ns/job\tnested ns/job\tchain ns/link\tparallel_for ms\tspeedup\n";
+	double baseline = 0.0;
+	for (unsigned int workers = 0; workers <= maxWorkers; ++workers)
+	{
+		JobSystem jobs(workers);
+
+		// Flat spawn from one thread, everyone else steals
+		std::atomic<int> executed(0);
+		auto start = std::chrono::steady_clock::now();
+		{
+			JobCounter counter;
+			for (int i = 0; i < spawnCount; ++i)
+				jobs.Run([&executed]() { executed.fetch_add(1, std::memory_order_relaxed); }, &counter);
+			jobs.Wait(counter);
+		}
+		double spawnNs = MillisecondsSince(start) * 1e6 / spawnCount;
+
+		// Jobs spawning jobs, spreads the spawning across workers
+		start = std::chrono::steady_clock::now();
+		{
+			JobCounter counter;
+			const int outer = 1000;
+			for (int i = 0; i < outer; ++i)
+			{
+				jobs.Run([&jobs, &counter, &executed]()
+				{
+					for (int j = 0; j < spawnCount / outer - 1; ++j)
+						jobs.Run([&executed]() { executed.fetch_add(1, std::memory_order_relaxed); }, &counter);
+				}, &counter);
+			}
+			jobs.Wait(counter);
+		}
+		double nestedNs = MillisecondsSince(start) * 1e6 / spawnCount;
+
+		// Every job only becomes runnable once the previous one finished
+		start = std::chrono::steady_clock::now();
+		{
+			std::vector<JobCounter> links(chainLength);
+			jobs.Run([]() {}, &links[0]);
+			for (int i = 1; i < chainLength; ++i)
+				jobs.RunAfter(links[i - 1], []() {}, &links[i]);
+			jobs.Wait(links[chainLength - 1]);
+		}
+		double chainNs = MillisecondsSince(start) * 1e6 / chainLength;
+
+		start = std::chrono::steady_clock::now();
+		const int repeats = 10;
+		for (int r = 0; r < repeats; ++r)
+		{
+			jobs.ParallelFor(data.size(), 4096, [&data](size_t begin, size_t end)
+			{
+				for (size_t i = begin; i < end; ++i)
+					data[i] = Work(data[i]) * 0.5f;
+			});
+		}
+		double parallelMs = MillisecondsSince(start) / repeats;
+		if (workers == 0)
+			baseline = parallelMs;
+
+		std::cout << workers << "\t" << spawnNs << "\t" << nestedNs << "\t" << chainNs << "\t"
+			<< parallelMs << "\t" << baseline / parallelMs << "\n";
+	}
+	return 0;
+}
@@ -0,0 +1,182 @@
+// The planning half of TextureStreamer on a synthetic level: objects with textures of 256 to 4096
+// texels on a grid, a camera flying a loop over them, and the streamer's rules for what happens
+// with the plan (drops at once, at most a few level uploads per frame). Prints how much memory the
+// resident levels take against loading every chain whole, how often visible textures have the
+// level they want and how long planning takes. Exits with 1 if the resident levels ever go over
+// the budget while the minimum levels would fit in it, or if a plan after the first allocates.
+// TextureStreamer plans the same way every few frames, so that would break --report-allocations.
+//
+// Usage: MipStreamingBenchmark [textureCount] [budgetMB] [frames] [maxUploadsPerFrame]
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include "AllocationCounter.h"
+#include "BenchmarkClock.h"
+#include "MipStreaming.h"
+
+namespace
+{
+	const float SCREEN_HEIGHT = 1080.0f;
+	const float FOV_Y = 0.785398f; // 45 degrees
+	const float SPACING = 3.0f;
+	const float VIEW_DISTANCE = 40.0f;
+	const uint32_t RESIDENT_SIZE = 64;
+	const int PLAN_INTERVAL = 10;
+
+	struct StreamedTexture
+	{
+		uint32_t size;
+		Bounds bounds;
+		uint32_t minResident;
+		uint32_t base;
+		uint32_t target;
+	};
+}
+
+int main(int argc, char** argv)
+{
+	int textureCount = argc > 1 ? std::atoi(argv[1]) : 400;
+	double budgetMB = argc > 2 ? std::atof(argv[2]) : 128.0;
+	int frames = argc > 3 ? std::atoi(argv[3]) : 3000;
+	uint32_t maxUploads = argc > 4 ? (uint32_t)std::atoi(argv[4]) : 2;
+	uint64_t budget = (uint64_t)(budgetMB * 1024.0 * 1024.0);
+
+	// Same sizes every run
+	uint32_t seed = 12345;
+	auto random = [&seed]() { seed = seed * 1664525u + 1013904223u; return seed >> 8; };
+	int side = (int)std::ceil(std::sqrt((double)textureCount));
+	std::vector<StreamedTexture> textures(textureCount);
+	uint64_t fullBytes = 0, minimumBytes = 0;
+	for (int i = 0; i < textureCount; ++i)
+	{
+		StreamedTexture& texture = textures[i];
+		texture.size = 256u << (random() % 5);
+		glm::vec3 center((i % side - side / 2) * SPACING, 0.0f, (i / side - side / 2) * SPACING);
+		texture.bounds.Expand(center - glm::vec3(1.0f));
+		texture.bounds.Expand(center + glm::vec3(1.0f));
+		uint32_t levelCount = GetMipLevelCount(texture.size, texture.size);
+		uint32_t coarse = 0;
+		while ((texture.size >> coarse) > RESIDENT_SIZE)
+			++coarse;
+		texture.minResident = levelCount - coarse;
+		texture.base = texture.target = coarse;
+		fullBytes += GetMipChainBytes(texture.size, texture.size, 0);
+		minimumBytes += GetMipChainBytes(texture.size, texture.size, coarse);
+	}
+	std::cout << textureCount << " textures, " << fullBytes / (1024.0 * 1024.0) << " MB with every level, "
+		<< minimumBytes / (1024.0 * 1024.0) << " MB always resident, budget " << budgetMB << " MB, " << frames << " frames\n";
+
+	std::vector<MipRequest> requests(textureCount);
+	std::vector<uint32_t> levels(textureCount);
+	MipPlanScratch scratch;
+	size_t planAllocations = 0;
+	std::vector<uint32_t> wanted(textureCount);
+	std::vector<bool> visible(textureCount);
+	double planMs = 0.0, residentSum = 0.0;
+	unsigned long long visibleCount = 0, satisfied = 0, levelsShort = 0, uploads = 0, drops = 0, plans = 0;
+	uint64_t residentBytes = minimumBytes, peakBytes = minimumBytes;
+	for (int frame = 0; frame < frames; ++frame)
+	{
+		// A loop over the grid, dipping down close to the objects and back up
+		double t = frame / 1500.0 * 2.0 * 3.14159;
+		float radius = side * SPACING * 0.35f;
+		glm::vec3 position(radius * (float)std::cos(t), 1.5f + 6.0f * (float)(0.5 + 0.5 * std::sin(t * 3.0)), radius * (float)std::sin(t));
+		glm::vec3 forward = glm::normalize(glm::vec3(-(float)std::sin(t), -0.3f, (float)std::cos(t)));
+
+		for (int i = 0; i < textureCount; ++i)
+		{
+			// A cone instead of the frustum, close enough for the texture counts
+			glm::vec3 toObject = textures[i].bounds.GetCenter() - position;
+			float distance = glm::length(toObject);
+			visible[i] = distance < VIEW_DISTANCE && (distance < 2.0f || glm::dot(toObject / distance, forward) > 0.6f);
+			if (!visible[i])
+				continue;
+			// One texture repeat per world unit, so level 0 has size texels per unit
+			float pixelsPerUnit = PixelsPerWorldUnit(textures[i].bounds, position, FOV_Y, SCREEN_HEIGHT);
+			uint32_t levelCount = GetMipLevelCount(textures[i].size, textures[i].size);
+			wanted[i] = std::min(WantedMip((float)textures[i].size, pixelsPerUnit), levelCount - 1);
+			requests[i].priority = pixelsPerUnit * 2.0f;
+		}
+
+		if (frame % PLAN_INTERVAL == 0)
+		{
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			size_t allocationsBefore = AllocationCounter::GetAllocationCount();
+			for (int i = 0; i < textureCount; ++i)
+			{
+				MipRequest& request = requests[i];
+				request.width = request.height = textures[i].size;
+				request.minResident = textures[i].minResident;
+				request.wanted = visible[i] ? wanted[i] : textures[i].target;
+				if (!visible[i])
+					request.priority = 0.0f;
+			}
+			PlanMipResidency(requests.data(), requests.size(), budget, levels.data(), scratch);
+			for (int i = 0; i < textureCount; ++i)
+				textures[i].target = levels[i];
+			planMs += MillisecondsSince(start);
+			// The first one grows the scratch
+			if (plans > 0)
+				planAllocations += AllocationCounter::GetAllocationCount() - allocationsBefore;
+			++plans;
+		}
+
+		// Drops straight away, then a level for as many textures as the upload limit allows
+		for (StreamedTexture& texture : textures)
+		{
+			for (; texture.base < texture.target; ++texture.base, ++drops)
+				residentBytes -= (uint64_t)(texture.size >> texture.base) * (texture.size >> texture.base) * 4;
+		}
+		uint32_t frameUploads = 0;
+		for (StreamedTexture& texture : textures)
+		{
+			if (frameUploads >= maxUploads)
+				break;
+			if (texture.target >= texture.base)
+				continue;
+			--texture.base;
+			residentBytes += (uint64_t)(texture.size >> texture.base) * (texture.size >> texture.base) * 4;
+			++frameUploads;
+		}
+		uploads += frameUploads;
+
+		if (residentBytes > std::max(budget, minimumBytes))
+		{
+			std::cout << "Resident levels take " << residentBytes << " bytes after frame " << frame << ", over the budget\n";
+			return 1;
+		}
+		peakBytes = std::max(peakBytes, residentBytes);
+		residentSum += (double)residentBytes;
+		for (int i = 0; i < textureCount; ++i)
+		{
+			if (!visible[i])
+				continue;
+			++visibleCount;
+			satisfied += textures[i].base <= wanted[i];
+			levelsShort += textures[i].base > wanted[i] ? textures[i].base - wanted[i] : 0;
+		}
+	}
+
+	std::cout << "resident " << residentSum / frames / (1024.0 * 1024.0) << " MB on average, peak " << peakBytes / (1024.0 * 1024.0)
+		<< " MB, " << 100.0 * residentSum / frames / (double)fullBytes << "% of every level\n";
+	std::cout << (double)visibleCount / frames << " visible textures/frame, " << 100.0 * satisfied / std::max(1ull, visibleCount)
+		<< "% at their wanted level, " << (double)levelsShort / std::max(1ull, visibleCount - satisfied) << " levels short otherwise\n";
+	std::cout << "uploads/frame " << (double)uploads / frames << ", drops/frame " << (double)drops / frames << ", plan "
+		<< planMs * 1000.0 / std::max(1ull, plans) << " us\n";
+	if (!AllocationCounter::IsEnabled())
+	{
+		std::cout << "never over the budget, allocation counting is disabled in this build\n";
+		return 0;
+	}
+	if (planAllocations > 0)
+	{
+		std::cout << planAllocations << " heap allocations while planning after the first plan\n";
+		return 1;
+	}
+	std::cout << "never over the budget, no allocations after the first plan, ok\n";
+	return 0;
+}
@@ -0,0 +1,124 @@
+// World matrix updates in TransformHierarchy: recomputing every node, only the dirty subtrees with a
+// small fraction of nodes changed per frame, and a pointer based node tree walked recursively for
+// comparison. The scene is many small hierarchies, 64 nodes each, like characters or props.
+//
+// Usage: TransformBenchmark [nodeCount] [dirtyPercent] [frames]
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include "BenchmarkClock.h"
+#include "TransformHierarchy.h"
+
+namespace
+{
+	const uint32_t NODES_PER_OBJECT = 64;
+
+	// Binary tree inside each object, the first node is the object's root
+	uint32_t ParentOf(uint32_t node)
+	{
+		uint32_t local = node % NODES_PER_OBJECT;
+		return local == 0 ? TransformHierarchy::NO_PARENT : node - local + (local - 1) / 2;
+	}
+
+	glm::mat4 RandomLocal(std::mt19937& random)
+	{
+		std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+		glm::vec3 position(distribution(random), distribution(random), distribution(random));
+		glm::quat rotation = glm::angleAxis(distribution(random) * 3.14159f, glm::vec3(0.0f, 1.0f, 0.0f));
+		return ComposeTransform(position, rotation, glm::vec3(1.0f));
+	}
+
+	// What the hierarchy replaces, one heap allocation per node
+	struct TreeNode
+	{
+		glm::mat4 local;
+		glm::mat4 world;
+		std::vector<TreeNode*> children;
+	};
+
+	void UpdateTree(TreeNode& node, const glm::mat4& parent)
+	{
+		node.world = parent * node.local;
+		for (TreeNode* child : node.children)
+			UpdateTree(*child, node.world);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	uint32_t nodeCount = argc > 1 ? (uint32_t)std::atoi(argv[1]) : 1000000;
+	double dirtyPercent = argc > 2 ? std::atof(argv[2]) : 1.0;
+	int frames = argc > 3 ? std::atoi(argv[3]) : 100;
+
+	std::mt19937 random(1234);
+	TransformHierarchy hierarchy;
+	hierarchy.Reserve(nodeCount);
+	std::vector<std::unique_ptr<TreeNode>> tree(nodeCount);
+	std::vector<TreeNode*> roots;
+	for (uint32_t i = 0; i < nodeCount; ++i)
+	{
+		glm::mat4 local = RandomLocal(random);
+		uint32_t parent = ParentOf(i);
+		hierarchy.AddNode(parent, local);
+
+		tree[i].reset(new TreeNode());
+		tree[i]->local = local;
+		if (parent == TransformHierarchy::NO_PARENT)
+			roots.push_back(tree[i].get());
+		else
+			tree[parent]->children.push_back(tree[i].get());
+	}
+	hierarchy.UpdateAll();
+
+	// Which nodes change each frame, picked up front so the generator isn't timed
+	uint32_t dirtyPerFrame = (uint32_t)(nodeCount * dirtyPercent / 100.0);
+	std::vector<uint32_t> dirtyNodes(dirtyPerFrame * frames);
+	std::uniform_int_distribution<uint32_t> pick(0, nodeCount - 1);
+	for (uint32_t& node : dirtyNodes)
+		node = pick(random);
+	std::vector<glm::mat4> newLocals(256);
+	for (glm::mat4& local : newLocals)
+		local = RandomLocal(random);
+
+	std::cout << nodeCount << " nodes, " << dirtyPerFrame << " changed per frame (" << dirtyPercent << "%), "
+		<< frames << " frames\n";
+	std::cout << "method\tms/frame\tnodes recomputed\n";
+
+	auto start = std::chrono::steady_clock::now();
+	for (int frame = 0; frame < frames; ++frame)
+	{
+		for (TreeNode* root : roots)
+			UpdateTree(*root, glm::mat4(1.0f));
+	}
+	std::cout << "pointer tree\t" << MillisecondsSince(start) / frames << "\t" << nodeCount << "\n";
+
+	start = std::chrono::steady_clock::now();
+	for (int frame = 0; frame < frames; ++frame)
+		hierarchy.UpdateAll();
+	std::cout << "flat, all\t" << MillisecondsSince(start) / frames << "\t" << nodeCount << "\n";
+
+	// Setting the locals is part of the frame, it's what marks the nodes
+	unsigned long long recomputed = 0;
+	start = std::chrono::steady_clock::now();
+	for (int frame = 0; frame < frames; ++frame)
+	{
+		const uint32_t* nodes = dirtyNodes.data() + (size_t)frame * dirtyPerFrame;
+		for (uint32_t i = 0; i < dirtyPerFrame; ++i)
+			hierarchy.SetLocal(nodes[i], newLocals[i & 255]);
+		recomputed += hierarchy.Update();
+	}
+	std::cout << "flat, dirty\t" << MillisecondsSince(start) / frames << "\t" << recomputed / frames << "\n";
+
+	// Keeps the results alive
+	float checksum = 0.0f;
+	for (uint32_t i = 0; i < nodeCount; i += 997)
+		checksum += hierarchy.GetWorld(i)[3].x + tree[i]->world[3].y;
+	std::cout << "checksum " << checksum << "\n";
+	return 0;
+}
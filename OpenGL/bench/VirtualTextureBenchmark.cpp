@@ -0,0 +1,135 @@
+// PageResidency driven by a simulated camera instead of GPU feedback: a 1920x1080 view pans and
+// zooms over a huge virtual texture and requests every tile it covers at the mip its zoom needs,
+// like the feedback pass would report them. Prints hit rates, loads and evictions per frame and the
+// time the bookkeeping takes, and checks the indirection table against the resident pages every
+// few frames. Exits with 1 if the check fails, so it also serves as the manager's test.
+//
+// With a .vtex (AssetTool vt) the loads are also read from the file to time the streaming.
+//
+// Usage: VirtualTextureBenchmark [tilesPerSide] [pagesPerSide] [frames] [maxLoadsPerFrame] [file.vtex]
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "BenchmarkClock.h"
+#include "PageResidency.h"
+#include "VirtualTextureFile.h"
+
+namespace
+{
+	const double SCREEN_WIDTH = 1920.0;
+	const double SCREEN_HEIGHT = 1080.0;
+	const uint32_t TILE_SIZE = 128;
+	const int VALIDATE_EVERY = 50;
+}
+
+int main(int argc, char** argv)
+{
+	uint32_t tilesPerSide = argc > 1 ? (uint32_t)std::atoi(argv[1]) : 512;
+	uint32_t pagesPerSide = argc > 2 ? (uint32_t)std::atoi(argv[2]) : 32;
+	int frames = argc > 3 ? std::atoi(argv[3]) : 1000;
+	uint32_t maxLoads = argc > 4 ? (uint32_t)std::atoi(argv[4]) : 32;
+	std::string filePath = argc > 5 ? argv[5] : "";
+
+	VirtualTextureFile file;
+	std::vector<unsigned char> tile;
+	if (!filePath.empty())
+	{
+		if (!file.Open(filePath))
+		{
+			std::cout << "Could not open " << filePath << "\n";
+			return 1;
+		}
+		tilesPerSide = file.GetTilesPerSide();
+		tile.resize((size_t)file.GetPageSize() * file.GetPageSize() * 4);
+	}
+	uint32_t tileSize = file.IsOpen() ? file.GetTileSize() : TILE_SIZE;
+
+	PageResidency residency(tilesPerSide, pagesPerSide);
+	double size = (double)tilesPerSide * tileSize;
+	std::cout << tilesPerSide << "x" << tilesPerSide << " tiles of " << tileSize << " (" << size / 1024.0 << "K texels square, "
+		<< residency.GetMipCount() << " mips), " << pagesPerSide * pagesPerSide << " pages, " << frames << " frames\n";
+
+	unsigned long long hits = 0, misses = 0, loads = 0, evictions = 0, deferred = 0, requests = 0;
+	uint32_t worstLoads = 0;
+	double updateMs = 0.0, requestMs = 0.0, readMs = 0.0;
+	for (int frame = 0; frame < frames; ++frame)
+	{
+		// Pans along a circle and zooms from a texel per pixel out to a quarter of the texture
+		double t = frame / 600.0;
+		double texelsPerPixel = std::pow(2.0, 0.5 + 0.5 * std::sin(t * 3.7)) * std::pow(2.0, 4.0 * (0.5 + 0.5 * std::sin(t * 1.3))) / 2.0;
+		double viewWidth = SCREEN_WIDTH * texelsPerPixel;
+		double viewHeight = SCREEN_HEIGHT * texelsPerPixel;
+		double centerX = size * (0.5 + 0.35 * std::cos(t * 2.0 * 3.14159));
+		double centerY = size * (0.5 + 0.35 * std::sin(t * 2.0 * 3.14159));
+
+		uint32_t mip = (uint32_t)std::max(0.0, std::floor(std::log2(texelsPerPixel)));
+		mip = std::min(mip, residency.GetMipCount() - 1);
+		double mipTile = (double)tileSize * (1u << mip);
+		uint32_t tiles = tilesPerSide >> mip;
+		auto first = [&](double texel) { return (uint32_t)std::max(0.0, std::floor(texel / mipTile)); };
+		auto last = [&](double texel) { return std::min(tiles - 1, (uint32_t)std::max(0.0, std::floor(texel / mipTile))); };
+
+		auto start = std::chrono::steady_clock::now();
+		for (uint32_t y = first(centerY - viewHeight / 2); y <= last(centerY + viewHeight / 2); ++y)
+		{
+			for (uint32_t x = first(centerX - viewWidth / 2); x <= last(centerX + viewWidth / 2); ++x)
+			{
+				residency.Request(mip, x, y);
+				++requests;
+			}
+		}
+		requestMs += MillisecondsSince(start);
+
+		start = std::chrono::steady_clock::now();
+		std::vector<PageLoad> frameLoads = residency.Update(maxLoads);
+		updateMs += MillisecondsSince(start);
+
+		if (file.IsOpen())
+		{
+			start = std::chrono::steady_clock::now();
+			for (const PageLoad& load : frameLoads)
+			{
+				if (!file.ReadTile(load.mip, load.x, load.y, tile.data()))
+				{
+					std::cout << "Could not read tile " << load.mip << "/" << load.x << "/" << load.y << "\n";
+					return 1;
+				}
+			}
+			readMs += MillisecondsSince(start);
+		}
+
+		const PageResidencyStats& stats = residency.GetStats();
+		hits += stats.hits;
+		misses += stats.misses;
+		loads += stats.loads;
+		evictions += stats.evictions;
+		deferred += stats.deferred;
+		worstLoads = std::max(worstLoads, stats.loads);
+
+		if ((frame + 1) % VALIDATE_EVERY == 0 && !residency.Validate())
+		{
+			std::cout << "Indirection doesn't match the resident pages after frame " << frame << "\n";
+			return 1;
+		}
+	}
+	if (!residency.Validate())
+	{
+		std::cout << "Indirection doesn't match the resident pages at the end\n";
+		return 1;
+	}
+
+	std::cout << "hit rate " << 100.0 * hits / std::max(1ull, hits + misses) << "%, " << (double)requests / frames << " requests/frame\n";
+	std::cout << "loads/frame " << (double)loads / frames << " (worst " << worstLoads << "), evictions/frame "
+		<< (double)evictions / frames << ", deferred/frame " << (double)deferred / frames << "\n";
+	std::cout << "resident " << residency.GetResidentCount() << " pages\n";
+	std::cout << "request " << requestMs * 1000.0 / frames << " us/frame, update " << updateMs * 1000.0 / frames << " us/frame";
+	if (file.IsOpen())
+		std::cout << ", reading tiles " << readMs / frames << " ms/frame";
+	std::cout << "\nindirection checked every " << VALIDATE_EVERY << " frames, ok\n";
+	return 0;
+}
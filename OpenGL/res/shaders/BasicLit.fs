@@ -1,16 +1,55 @@
 #version 330 core
+#ifdef BINDLESS
+#extension GL_ARB_bindless_texture : require
+#endif
 
 in vec3 v_Normal;
 in vec3 v_FragPos;
 in vec2 v_TexCoords;
-
-struct Material {
-    sampler2D diffuse;
-    sampler2D specular;
+#ifdef NORMAL_MAP
+in vec3 v_Tangent;
+in vec3 v_Bitangent;
+#endif
+#ifdef TEXTURE_ARRAY
+// Diffuse, specular and normal layer
+flat in vec3 v_Layers;
+#define MAP sampler2DArray
+#define SAMPLE_MAP(map, layer) texture(map, vec3(v_TexCoords, layer))
+#else
+#define MAP sampler2D
+#define SAMPLE_MAP(map, layer) texture(map, v_TexCoords)
+#endif
+
+// MaterialParameters, the bound material's slot of MaterialLibrary's buffer
+layout (std140) uniform MaterialBlock
+{
+    vec4 diffuseColor;
+    vec4 specularColor;
     float shininess;
     float reflectivity;
+#ifdef BINDLESS
+    // Diffuse and specular, normal
+    uvec4 mapHandles[2];
+#endif
+};
+
+#ifdef BINDLESS
+#define DIFFUSE_MAP MAP(mapHandles[0].xy)
+#define SPECULAR_MAP MAP(mapHandles[0].zw)
+#define NORMAL_MAP_SAMPLER MAP(mapHandles[1].xy)
+#else
+struct Material {
+    MAP diffuse;
+    MAP specular;
+#ifdef NORMAL_MAP
+    MAP normal;
+#endif
 };
 uniform Material material;
+#define DIFFUSE_MAP material.diffuse
+#define SPECULAR_MAP material.specular
+#define NORMAL_MAP_SAMPLER material.normal
+#endif
 
 struct DirectionalLight {
     vec3 direction;
@@ -53,16 +92,27 @@ uniform samplerCube skybox;
 
 out vec4 FragColor;
 
+vec3 GetNormal()
+{
+#ifdef NORMAL_MAP
+    // Tangent space, 0..1 stored for -1..1
+    vec3 sampled = SAMPLE_MAP(NORMAL_MAP_SAMPLER, v_Layers.z).rgb * 2.0 - 1.0;
+    mat3 tbn = mat3(normalize(v_Tangent), normalize(v_Bitangent), normalize(v_Normal));
+    return normalize(tbn * sampled);
+#else
+    return normalize(v_Normal);
+#endif
+}
 
 vec3 CalcDirectionalLight(DirectionalLight light) 
 {
-    vec3 rawDiffuseColor = vec3(texture(material.diffuse, v_TexCoords));
+    vec3 rawDiffuseColor = vec3(SAMPLE_MAP(DIFFUSE_MAP, v_Layers.x)) * diffuseColor.rgb;
 
     // Ambient
     vec3 ambient = light.ambient * rawDiffuseColor;
 
     // Diffuse
-    vec3 norm = normalize(v_Normal);
+    vec3 norm = GetNormal();
     vec3 toLight = normalize(-light.direction);
     float diffStrength = max(dot(norm, toLight), 0);
     vec3 diffuse = light.diffuse * (diffStrength * rawDiffuseColor);
@@ -70,8 +120,8 @@ vec3 CalcDirectionalLight(DirectionalLight light)
     // Specular
     vec3 toViewer = normalize(viewPos - v_FragPos);
     vec3 reflectDir = reflect(-toLight, norm);
-    float spec = pow(max(dot(toViewer, reflectDir), 0.0), material.shininess);
-    vec3 specular = light.specular * (spec * vec3(texture(material.specular, v_TexCoords)));
+    float spec = pow(max(dot(toViewer, reflectDir), 0.0), shininess);
+    vec3 specular = light.specular * (spec * vec3(SAMPLE_MAP(SPECULAR_MAP, v_Layers.y)) * specularColor.rgb);
 
     // Combine
     vec3 result = ambient + diffuse + specular;
@@ -80,13 +130,13 @@ vec3 CalcDirectionalLight(DirectionalLight light)
 
 vec3 CalcPointLight(PointLight light)
 {
-    vec3 rawDiffuseColor = vec3(texture(material.diffuse, v_TexCoords));
+    vec3 rawDiffuseColor = vec3(SAMPLE_MAP(DIFFUSE_MAP, v_Layers.x)) * diffuseColor.rgb;
 
     // Ambient
     vec3 ambient = light.ambient * rawDiffuseColor;
 
     // Diffuse
-    vec3 norm = normalize(v_Normal);
+    vec3 norm = GetNormal();
     vec3 toLight = normalize(light.position - v_FragPos);
     float diffStrength = max(dot(norm, toLight), 0);
     vec3 diffuse = light.diffuse * (diffStrength * rawDiffuseColor);
@@ -94,8 +144,8 @@ vec3 CalcPointLight(PointLight light)
     // Specular
     vec3 toViewer = normalize(viewPos - v_FragPos);
     vec3 reflectDir = reflect(-toLight, norm);
-    float spec = pow(max(dot(toViewer, reflectDir), 0.0), material.shininess);
-    vec3 specular = light.specular * (spec * vec3(texture(material.specular, v_TexCoords)));
+    float spec = pow(max(dot(toViewer, reflectDir), 0.0), shininess);
+    vec3 specular = light.specular * (spec * vec3(SAMPLE_MAP(SPECULAR_MAP, v_Layers.y)) * specularColor.rgb);
 
     // Attenuation
     float dist = length(v_FragPos - light.position);
@@ -111,13 +161,13 @@ vec3 CalcPointLight(PointLight light)
 
 vec3 CalcSpotLight(SpotLight light)
 {
-    vec3 rawDiffuseColor = vec3(texture(material.diffuse, v_TexCoords));
+    vec3 rawDiffuseColor = vec3(SAMPLE_MAP(DIFFUSE_MAP, v_Layers.x)) * diffuseColor.rgb;
 
     // Ambient
     vec3 ambient = light.ambient * rawDiffuseColor;
 
     // Diffuse
-    vec3 norm = normalize(v_Normal);
+    vec3 norm = GetNormal();
     vec3 toLight = normalize(light.position - v_FragPos);
     float diffStrength = max(dot(norm, toLight), 0);
     vec3 diffuse = light.diffuse * (diffStrength * rawDiffuseColor);
@@ -125,8 +175,8 @@ vec3 CalcSpotLight(SpotLight light)
     // Specular
     vec3 toViewer = normalize(viewPos - v_FragPos);
     vec3 reflectDir = reflect(-toLight, norm);
-    float spec = pow(max(dot(toViewer, reflectDir), 0.0), material.shininess);
-    vec3 specular = light.specular * (spec * vec3(texture(material.specular, v_TexCoords)));
+    float spec = pow(max(dot(toViewer, reflectDir), 0.0), shininess);
+    vec3 specular = light.specular * (spec * vec3(SAMPLE_MAP(SPECULAR_MAP, v_Layers.y)) * specularColor.rgb);
 
     // Spot-light intensity
     float cosTheta = dot(toLight, normalize(-light.direction));
@@ -154,8 +204,12 @@ void main()
 
     // Environment Mapping
     vec3 I = normalize(v_FragPos - viewPos);
+#ifdef NORMAL_MAP
+    vec3 R = reflect(I, GetNormal());
+#else
     vec3 R = reflect(I, v_Normal);
+#endif
     vec3 refl = texture(skybox, R).rgb;
 
-    FragColor = vec4(mix(result, refl, material.reflectivity), 1.0);
+    FragColor = vec4(mix(result, refl, reflectivity), 1.0);
 }
\ No newline at end of file
@@ -2,6 +2,14 @@
 layout (location = 0) in vec3 position;
 layout (location = 1) in vec3 normal;
 layout (location = 2) in vec2 texCoords;
+#ifdef NORMAL_MAP
+// Mesh::m_Tangents, or PackedTangentFrame with PACKED_TANGENT_FRAME
+layout (location = 5) in vec4 tangent;
+#endif
+#ifdef TEXTURE_ARRAY
+// VertexLayers, the layer of each map
+layout (location = 6) in uvec4 layers;
+#endif
 
 uniform mat4 model;
 
@@ -15,12 +23,44 @@ layout (std140) uniform Matrices
 out vec3 v_Normal;
 out vec3 v_FragPos;
 out vec2 v_TexCoords;
+#ifdef NORMAL_MAP
+out vec3 v_Tangent;
+out vec3 v_Bitangent;
+#endif
+#ifdef TEXTURE_ARRAY
+flat out vec3 v_Layers;
+#endif
+
+#ifdef PACKED_TANGENT_FRAME
+vec3 Rotate(vec4 q, vec3 v)
+{
+    return v + 2.0 * cross(q.xyz, cross(q.xyz, v) + q.w * v);
+}
+#endif
 
 void main()
 {
     gl_Position = projection * view * model * vec4(position, 1);
     v_FragPos = vec3(model * vec4(position, 1));
     // This is called a normal matrix - avoids non-uniform scale issues!
-    v_Normal = mat3(transpose(inverse(model))) * normal; 
+    mat3 normalMatrix = mat3(transpose(inverse(model)));
+#ifdef PACKED_TANGENT_FRAME
+    vec4 frame = normalize(tangent);
+    vec3 localNormal = Rotate(frame, vec3(0, 0, 1));
+    vec4 localTangent = vec4(Rotate(frame, vec3(1, 0, 0)), frame.w < 0.0 ? -1.0 : 1.0);
+#else
+    vec3 localNormal = normal;
+#ifdef NORMAL_MAP
+    vec4 localTangent = tangent;
+#endif
+#endif
+    v_Normal = normalMatrix * localNormal; 
+#ifdef NORMAL_MAP
+    v_Tangent = mat3(model) * localTangent.xyz;
+    v_Bitangent = cross(v_Normal, v_Tangent) * localTangent.w;
+#endif
     v_TexCoords = texCoords;
+#ifdef TEXTURE_ARRAY
+    v_Layers = vec3(layers.xyz);
+#endif
 }
\ No newline at end of file
@@ -0,0 +1,75 @@
+#version 330 core
+layout (location = 0) in vec3 position;
+layout (location = 1) in vec3 normal;
+layout (location = 2) in vec2 texCoords;
+layout (location = 3) in uvec4 boneIds;
+layout (location = 4) in vec4 boneWeights;
+#ifdef NORMAL_MAP
+layout (location = 5) in vec4 tangent;
+#endif
+#ifdef TEXTURE_ARRAY
+layout (location = 6) in uvec4 layers;
+#endif
+
+// Skeleton::MAX_BONES
+const int MAX_BONES = 100;
+
+uniform mat4 model;
+// Model space skinning matrices, Animator::GetPalette()
+uniform mat4 bones[MAX_BONES];
+
+layout (std140) uniform Matrices 
+{
+    mat4 projection;
+    mat4 view;
+};
+
+
+out vec3 v_Normal;
+out vec3 v_FragPos;
+out vec2 v_TexCoords;
+#ifdef NORMAL_MAP
+out vec3 v_Tangent;
+out vec3 v_Bitangent;
+#endif
+#ifdef TEXTURE_ARRAY
+flat out vec3 v_Layers;
+#endif
+
+#ifdef PACKED_TANGENT_FRAME
+vec3 Rotate(vec4 q, vec3 v)
+{
+    return v + 2.0 * cross(q.xyz, cross(q.xyz, v) + q.w * v);
+}
+#endif
+
+void main()
+{
+    // Same as BasicLit.vs, with the blend of the bones in front of the model matrix
+    mat4 skin = bones[boneIds.x] * boneWeights.x
+        + bones[boneIds.y] * boneWeights.y
+        + bones[boneIds.z] * boneWeights.z
+        + bones[boneIds.w] * boneWeights.w;
+    mat4 skinnedModel = model * skin;
+    gl_Position = projection * view * skinnedModel * vec4(position, 1);
+    v_FragPos = vec3(skinnedModel * vec4(position, 1));
+#ifdef PACKED_TANGENT_FRAME
+    vec4 frame = normalize(tangent);
+    vec3 localNormal = Rotate(frame, vec3(0, 0, 1));
+    vec4 localTangent = vec4(Rotate(frame, vec3(1, 0, 0)), frame.w < 0.0 ? -1.0 : 1.0);
+#else
+    vec3 localNormal = normal;
+#ifdef NORMAL_MAP
+    vec4 localTangent = tangent;
+#endif
+#endif
+    v_Normal = mat3(transpose(inverse(skinnedModel))) * localNormal;
+#ifdef NORMAL_MAP
+    v_Tangent = mat3(skinnedModel) * localTangent.xyz;
+    v_Bitangent = cross(v_Normal, v_Tangent) * localTangent.w;
+#endif
+    v_TexCoords = texCoords;
+#ifdef TEXTURE_ARRAY
+    v_Layers = vec3(layers.xyz);
+#endif
+}
@@ -0,0 +1,27 @@
+#version 330 core
+// Downsampling step of the dual Kawase blur, from Marius Bjorge's "Bandwidth-Efficient Rendering" (SIGGRAPH 2015)
+
+in vec2 v_TexCoords;
+
+uniform sampler2D screenTexture;
+// Half a texel of the target, scaled by the spread
+uniform vec2 halfPixel;
+// Clamps the taps to the image, see GaussianBlur.fs
+uniform vec2 uvMax = vec2(1.0);
+
+out vec4 FragColor;
+
+vec3 Fetch(vec2 position)
+{
+    return texture(screenTexture, min(position, uvMax)).rgb;
+}
+
+void main()
+{
+    vec3 sum = Fetch(v_TexCoords) * 4.0;
+    sum += Fetch(v_TexCoords - halfPixel);
+    sum += Fetch(v_TexCoords + halfPixel);
+    sum += Fetch(v_TexCoords + vec2(halfPixel.x, -halfPixel.y));
+    sum += Fetch(v_TexCoords - vec2(halfPixel.x, -halfPixel.y));
+    FragColor = vec4(sum / 8.0, 1.0);
+}
@@ -0,0 +1,34 @@
+#version 330 core
+// Upsampling step of the dual Kawase blur, see DualKawaseDown.fs
+
+in vec2 v_TexCoords;
+
+uniform sampler2D screenTexture;
+// Only read on the last step, which draws the full size image
+uniform sampler2D originalTexture;
+uniform float strength = 1.0;
+// Half a texel of the target, scaled by the spread
+uniform vec2 halfPixel;
+// Clamps the taps to the image, see GaussianBlur.fs
+uniform vec2 uvMax = vec2(1.0);
+
+out vec4 FragColor;
+
+vec3 Fetch(vec2 position)
+{
+    return texture(screenTexture, min(position, uvMax)).rgb;
+}
+
+void main()
+{
+    vec3 sum = Fetch(v_TexCoords + vec2(-halfPixel.x * 2.0, 0.0));
+    sum += Fetch(v_TexCoords + vec2(-halfPixel.x, halfPixel.y)) * 2.0;
+    sum += Fetch(v_TexCoords + vec2(0.0, halfPixel.y * 2.0));
+    sum += Fetch(v_TexCoords + vec2(halfPixel.x, halfPixel.y)) * 2.0;
+    sum += Fetch(v_TexCoords + vec2(halfPixel.x * 2.0, 0.0));
+    sum += Fetch(v_TexCoords + vec2(halfPixel.x, -halfPixel.y)) * 2.0;
+    sum += Fetch(v_TexCoords + vec2(0.0, -halfPixel.y * 2.0));
+    sum += Fetch(v_TexCoords + vec2(-halfPixel.x, -halfPixel.y)) * 2.0;
+    vec3 original = texture(originalTexture, v_TexCoords).rgb;
+    FragColor = vec4(mix(original, sum / 12.0, strength), 1.0);
+}
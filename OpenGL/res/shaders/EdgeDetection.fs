@@ -4,9 +4,13 @@
 in vec2 v_TexCoords;
 
 uniform sampler2D screenTexture;
+uniform float strength = 1.0;
+// Last texel center of screenTexture that holds the image, it may only fill part of the texture
+uniform vec2 uvMax = vec2(1.0);
 
 out vec4 FragColor;
 
+// Of the image, scaled to the part of the texture it fills when sampling
 const float offset = 1.0 / 300.0;
 
 void main()
@@ -32,12 +36,12 @@ void main()
     vec3 sampleTex[9];
     for (int i = 0; i < 9; ++i) 
     {
-        sampleTex[i] = texture(screenTexture, v_TexCoords.st + offsets[i]).xyz;
+        sampleTex[i] = texture(screenTexture, min(v_TexCoords.st + offsets[i] * uvMax, uvMax)).xyz;
     }
     vec3 col = vec3(0.0);
     for (int i = 0; i < 9; ++i)
     {
         col += sampleTex[i] * kernel[i];
     }
-    FragColor = vec4(col, 1.0);
+    FragColor = vec4(mix(sampleTex[4], col, strength), 1.0);
 }
\ No newline at end of file
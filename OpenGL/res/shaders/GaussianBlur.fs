@@ -0,0 +1,37 @@
+#version 330 core
+// One axis of a separable Gaussian blur, see GaussianBlurEffect
+
+in vec2 v_TexCoords;
+
+uniform sampler2D screenTexture;
+// The unblurred image, only differs from screenTexture on the second axis
+uniform sampler2D originalTexture;
+uniform float strength = 1.0;
+// One texel of screenTexture along the blur axis
+uniform vec2 direction;
+uniform int tapCount;
+// Tap 0 is the center, the others are sampled on both sides. Offsets are in texels and
+// mostly fall between two texels, so the bilinear filter weighs both with one fetch.
+uniform float offsets[32];
+uniform float weights[32];
+// Last texel center of screenTexture that holds the image, it may only fill part of the texture
+uniform vec2 uvMax = vec2(1.0);
+
+out vec4 FragColor;
+
+vec3 Fetch(vec2 position)
+{
+    return texture(screenTexture, min(position, uvMax)).rgb;
+}
+
+void main()
+{
+    vec3 color = Fetch(v_TexCoords) * weights[0];
+    for (int i = 1; i < tapCount; ++i)
+    {
+        vec2 offset = direction * offsets[i];
+        color += (Fetch(v_TexCoords + offset) + Fetch(v_TexCoords - offset)) * weights[i];
+    }
+    vec3 original = texture(originalTexture, v_TexCoords).rgb;
+    FragColor = vec4(mix(original, color, strength), 1.0);
+}
@@ -3,6 +3,7 @@
 in vec2 v_TexCoords;
 
 uniform sampler2D screenTexture;
+uniform float strength = 1.0;
 
 out vec4 FragColor;
 
@@ -11,5 +12,5 @@ void main()
     FragColor = texture(screenTexture, v_TexCoords);
     // https://learnopengl.com/Advanced-OpenGL/Framebuffers
     float average = 0.2126 * FragColor.r + 0.7152 * FragColor.g + 0.0722 * FragColor.b;
-    FragColor = vec4(average, average, average, 1.0);
+    FragColor = vec4(mix(FragColor.rgb, vec3(average), strength), 1.0);
 }
\ No newline at end of file
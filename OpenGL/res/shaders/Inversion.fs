@@ -2,10 +2,12 @@
 in vec2 v_TexCoords;
 
 uniform sampler2D screenTexture;
+uniform float strength = 1.0;
 
 out vec4 FragColor;
 
 void main()
 {
-    FragColor = vec4(1.0 - texture(screenTexture, v_TexCoords).xyz, 1.0);
+    vec3 color = texture(screenTexture, v_TexCoords).xyz;
+    FragColor = vec4(mix(color, 1.0 - color, strength), 1.0);
 }
\ No newline at end of file
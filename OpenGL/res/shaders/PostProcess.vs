@@ -5,8 +5,11 @@ layout (location = 2) in vec2 texCoords;
 
 out vec2 v_TexCoords;
 
+// Part of the input texture that holds the image, see PostProcessGraph
+uniform vec2 uvScale = vec2(1.0);
+
 void main()
 {
     gl_Position = vec4(position.x, position.y, 0.0, 1.0);
-    v_TexCoords = texCoords;
+    v_TexCoords = texCoords * uvScale;
 }
\ No newline at end of file
@@ -0,0 +1,50 @@
+#version 330 core
+// Catmull-Rom upscale of the dynamic resolution scene, which sits in the bottom left of a bigger
+// texture. The 4x4 bicubic kernel is folded into 9 bilinear fetches.
+// https://gist.github.com/TheRealMJP/c83b8c0f46b63f3a88a5986f4fa982b1
+
+in vec2 v_TexCoords;
+
+uniform sampler2D screenTexture;
+// Of the whole texture and of the part the scene was drawn into, in texels
+uniform vec2 textureSize;
+uniform vec2 sourceSize;
+
+out vec4 FragColor;
+
+vec3 Fetch(vec2 position)
+{
+    // Never reach past the scene into whatever the rest of the texture holds
+    position = clamp(position, vec2(0.5), sourceSize - 0.5);
+    return texture(screenTexture, position / textureSize).rgb;
+}
+
+void main()
+{
+    vec2 samplePosition = v_TexCoords * sourceSize;
+    vec2 texelCenter = floor(samplePosition - 0.5) + 0.5;
+    vec2 f = samplePosition - texelCenter;
+
+    vec2 w0 = f * (-0.5 + f * (1.0 - 0.5 * f));
+    vec2 w1 = 1.0 + f * f * (-2.5 + 1.5 * f);
+    vec2 w2 = f * (0.5 + f * (2.0 - 1.5 * f));
+    vec2 w3 = f * f * (-0.5 + 0.5 * f);
+
+    // The middle two taps share one fetch between them
+    vec2 w12 = w1 + w2;
+    vec2 position0 = texelCenter - 1.0;
+    vec2 position12 = texelCenter + w2 / w12;
+    vec2 position3 = texelCenter + 2.0;
+
+    vec3 color = Fetch(vec2(position0.x, position0.y)) * w0.x * w0.y;
+    color += Fetch(vec2(position12.x, position0.y)) * w12.x * w0.y;
+    color += Fetch(vec2(position3.x, position0.y)) * w3.x * w0.y;
+    color += Fetch(vec2(position0.x, position12.y)) * w0.x * w12.y;
+    color += Fetch(vec2(position12.x, position12.y)) * w12.x * w12.y;
+    color += Fetch(vec2(position3.x, position12.y)) * w3.x * w12.y;
+    color += Fetch(vec2(position0.x, position3.y)) * w0.x * w3.y;
+    color += Fetch(vec2(position12.x, position3.y)) * w12.x * w3.y;
+    color += Fetch(vec2(position3.x, position3.y)) * w3.x * w3.y;
+    // The negative lobes can overshoot around hard edges
+    FragColor = vec4(max(color, vec3(0.0)), 1.0);
+}
@@ -0,0 +1,45 @@
+#version 330 core
+in vec2 v_TexCoords;
+
+// VirtualTexture::SetUniforms()
+uniform sampler2D indirection;
+uniform float virtualSize;
+uniform float tilesPerSide;
+uniform float mipCount;
+uniform float mipBias;
+#ifndef FEEDBACK
+uniform sampler2D pageCache;
+// Page size and border in texels
+uniform vec2 pageLayout;
+uniform float cacheSize;
+#endif
+
+out vec4 FragColor;
+
+// The mip a regular texture lookup would pick, whole levels only
+int GetMip(vec2 uv)
+{
+    vec2 dx = dFdx(uv * virtualSize);
+    vec2 dy = dFdy(uv * virtualSize);
+    float lod = 0.5 * log2(max(dot(dx, dx), dot(dy, dy))) + mipBias;
+    return int(clamp(floor(lod), 0.0, mipCount - 1.0));
+}
+
+void main()
+{
+    // Tiles are stored top row first
+    vec2 uv = clamp(vec2(v_TexCoords.x, 1.0 - v_TexCoords.y), 0.0, 0.99999);
+    int mip = GetMip(uv);
+    ivec2 tile = ivec2(uv * floor(tilesPerSide / exp2(float(mip))));
+#ifdef FEEDBACK
+    // Decoded by VirtualTexture::CollectFeedback(), zero alpha is nothing drawn
+    FragColor = vec4(tile & 255, (tile.x >> 8) | ((tile.y >> 8) << 4), mip + 1) / 255.0;
+#else
+    // The finest resident page covering the tile, maybe a coarser mip than asked for
+    vec3 entry = floor(texelFetch(indirection, tile, mip).rgb * 255.0 + 0.5);
+    vec2 inTile = fract(uv * floor(tilesPerSide / exp2(entry.b)));
+    float tileSize = pageLayout.x - 2.0 * pageLayout.y;
+    vec2 texel = entry.rg * pageLayout.x + pageLayout.y + inTile * tileSize;
+    FragColor = vec4(texture(pageCache, texel / cacheSize).rgb, 1.0);
+#endif
+}
@@ -0,0 +1,122 @@
+#include "AllocationCounter.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#ifndef DISABLE_ALLOCATION_COUNTER
+
+namespace
+{
+	std::atomic<size_t> s_AllocationCount(0);
+	std::atomic<size_t> s_AllocatedBytes(0);
+
+	void* CountedAllocate(size_t size)
+	{
+		s_AllocationCount.fetch_add(1, std::memory_order_relaxed);
+		s_AllocatedBytes.fetch_add(size, std::memory_order_relaxed);
+		return std::malloc(size ? size : 1);
+	}
+
+	void* CountedAllocateAligned(size_t size, size_t alignment)
+	{
+		s_AllocationCount.fetch_add(1, std::memory_order_relaxed);
+		s_AllocatedBytes.fetch_add(size, std::memory_order_relaxed);
+#ifdef _MSC_VER
+		return _aligned_malloc(size ? size : 1, alignment);
+#else
+		// aligned_alloc wants the size to be a multiple of the alignment
+		size_t rounded = ((size ? size : 1) + alignment - 1) / alignment * alignment;
+		return std::aligned_alloc(alignment, rounded);
+#endif
+	}
+
+	void FreeAligned(void* ptr)
+	{
+#ifdef _MSC_VER
+		_aligned_free(ptr);
+#else
+		std::free(ptr);
+#endif
+	}
+}
+
+void* operator new(size_t size)
+{
+	void* ptr = CountedAllocate(size);
+	if (!ptr)
+		throw std::bad_alloc();
+	return ptr;
+}
+
+void* operator new[](size_t size)
+{
+	return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+	return CountedAllocate(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+	return CountedAllocate(size);
+}
+
+void* operator new(size_t size, std::align_val_t alignment)
+{
+	void* ptr = CountedAllocateAligned(size, (size_t)alignment);
+	if (!ptr)
+		throw std::bad_alloc();
+	return ptr;
+}
+
+void* operator new[](size_t size, std::align_val_t alignment)
+{
+	return operator new(size, alignment);
+}
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete[](void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, size_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { std::free(ptr); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::align_val_t) noexcept { FreeAligned(ptr); }
+void operator delete[](void* ptr, std::align_val_t) noexcept { FreeAligned(ptr); }
+void operator delete(void* ptr, size_t, std::align_val_t) noexcept { FreeAligned(ptr); }
+void operator delete[](void* ptr, size_t, std::align_val_t) noexcept { FreeAligned(ptr); }
+
+bool AllocationCounter::IsEnabled()
+{
+	return true;
+}
+
+size_t AllocationCounter::GetAllocationCount()
+{
+	return s_AllocationCount.load(std::memory_order_relaxed);
+}
+
+size_t AllocationCounter::GetAllocatedBytes()
+{
+	return s_AllocatedBytes.load(std::memory_order_relaxed);
+}
+
+#else
+
+bool AllocationCounter::IsEnabled()
+{
+	return false;
+}
+
+size_t AllocationCounter::GetAllocationCount()
+{
+	return 0;
+}
+
+size_t AllocationCounter::GetAllocatedBytes()
+{
+	return 0;
+}
+
+#endif
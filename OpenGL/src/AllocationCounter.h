@@ -0,0 +1,13 @@
+#pragma once
+#include <cstddef>
+
+// Counts every allocation made through the global operator new, which AllocationCounter.cpp
+// replaces. Compare the counts before and after a frame to catch heap allocations in code that
+// should only use the FrameArena. Define DISABLE_ALLOCATION_COUNTER to leave operator new alone.
+class AllocationCounter
+{
+public:
+	static bool IsEnabled();
+	static size_t GetAllocationCount();
+	static size_t GetAllocatedBytes();
+};
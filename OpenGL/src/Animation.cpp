@@ -0,0 +1,214 @@
+#include "Animation.h"
+#include "AnimationCompression.h"
+#include "CpuProfiler.h"
+#include "JobSystem.h"
+#include "TransformHierarchy.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace
+{
+	// Characters per job, a 64 joint character takes a few microseconds
+	const size_t ANIMATOR_GRAIN_SIZE = 8;
+
+	glm::vec3 Interpolate(const glm::vec3& a, const glm::vec3& b, float t)
+	{
+		return glm::mix(a, b, t);
+	}
+
+	glm::quat Interpolate(const glm::quat& a, const glm::quat& b, float t)
+	{
+		return BlendRotations(a, b, t);
+	}
+
+	template <typename T>
+	T SampleKeys(const Keyframes<T>& keys, float time, uint32_t& key, const T& bind)
+	{
+		size_t count = keys.times.size();
+		if (count == 0)
+			return bind;
+		const float* times = keys.times.data();
+		while (key + 1 < count && times[key + 1] <= time)
+			++key;
+		if (key + 1 >= count || time <= times[key])
+			return keys.values[key];
+		float t = (time - times[key]) / (times[key + 1] - times[key]);
+		return Interpolate(keys.values[key], keys.values[key + 1], t);
+	}
+}
+
+glm::quat BlendRotations(const glm::quat& a, const glm::quat& b, float t)
+{
+	float sign = glm::dot(a, b) < 0.0f ? -1.0f : 1.0f;
+	return glm::normalize(a * (1.0f - t) + b * (t * sign));
+}
+
+void Pose::Resize(size_t jointCount)
+{
+	translations.resize(jointCount, glm::vec3(0.0f));
+	rotations.resize(jointCount, glm::quat(1.0f, 0.0f, 0.0f, 0.0f));
+	scales.resize(jointCount, glm::vec3(1.0f));
+}
+
+size_t AnimationClip::GetKeyCount() const
+{
+	size_t count = 0;
+	for (const JointTrack& track : tracks)
+		count += track.translations.times.size() + track.rotations.times.size() + track.scales.times.size();
+	return count;
+}
+
+size_t AnimationClip::GetMemoryUsage() const
+{
+	size_t bytes = tracks.size() * sizeof(JointTrack);
+	for (const JointTrack& track : tracks)
+	{
+		bytes += track.translations.times.size() * (sizeof(float) + sizeof(glm::vec3));
+		bytes += track.rotations.times.size() * (sizeof(float) + sizeof(glm::quat));
+		bytes += track.scales.times.size() * (sizeof(float) + sizeof(glm::vec3));
+	}
+	return bytes;
+}
+
+uint32_t Skeleton::FindJoint(const std::string& name) const
+{
+	for (size_t i = 0; i < names.size(); ++i)
+	{
+		if (names[i] == name)
+			return (uint32_t)i;
+	}
+	return TransformHierarchy::NO_PARENT;
+}
+
+void SampleClip(const AnimationClip& clip, const Skeleton& skeleton, float time, ClipCursor& cursor, Pose& pose)
+{
+	size_t jointCount = skeleton.GetJointCount();
+	pose.Resize(jointCount);
+	if (cursor.keys.size() != jointCount * 3 || time < cursor.time)
+		cursor.keys.assign(jointCount * 3, 0);
+	cursor.time = time;
+
+	const Pose& bind = skeleton.bindPose;
+	size_t trackCount = std::min(clip.tracks.size(), jointCount);
+	uint32_t* keys = cursor.keys.data();
+	for (size_t joint = 0; joint < trackCount; ++joint)
+	{
+		const JointTrack& track = clip.tracks[joint];
+		pose.translations[joint] = SampleKeys(track.translations, time, keys[joint * 3], bind.translations[joint]);
+		pose.rotations[joint] = SampleKeys(track.rotations, time, keys[joint * 3 + 1], bind.rotations[joint]);
+		pose.scales[joint] = SampleKeys(track.scales, time, keys[joint * 3 + 2], bind.scales[joint]);
+	}
+	for (size_t joint = trackCount; joint < jointCount; ++joint)
+	{
+		pose.translations[joint] = bind.translations[joint];
+		pose.rotations[joint] = bind.rotations[joint];
+		pose.scales[joint] = bind.scales[joint];
+	}
+}
+
+void BlendPoses(const Pose& a, const Pose& b, float weight, Pose& out)
+{
+	size_t jointCount = std::min(a.GetJointCount(), b.GetJointCount());
+	out.Resize(jointCount);
+	for (size_t joint = 0; joint < jointCount; ++joint)
+	{
+		out.translations[joint] = glm::mix(a.translations[joint], b.translations[joint], weight);
+		out.rotations[joint] = Interpolate(a.rotations[joint], b.rotations[joint], weight);
+		out.scales[joint] = glm::mix(a.scales[joint], b.scales[joint], weight);
+	}
+}
+
+void BuildPalette(const Skeleton& skeleton, const Pose& pose, glm::mat4* worlds, glm::mat4* palette)
+{
+	size_t jointCount = skeleton.GetJointCount();
+	for (size_t joint = 0; joint < jointCount; ++joint)
+	{
+		glm::mat4 local = ComposeTransform(pose.translations[joint], pose.rotations[joint], pose.scales[joint]);
+		uint32_t parent = skeleton.parents[joint];
+		worlds[joint] = parent == TransformHierarchy::NO_PARENT ? local : worlds[parent] * local;
+	}
+	for (size_t bone = 0; bone < skeleton.GetBoneCount(); ++bone)
+		palette[bone] = worlds[skeleton.boneJoints[bone]] * skeleton.inverseBindMatrices[bone];
+}
+
+Animator::Animator(const Skeleton& skeleton) :
+	m_Skeleton(&skeleton), m_BlendWeight(0.0f)
+{
+	size_t jointCount = skeleton.GetJointCount();
+	for (unsigned int i = 0; i < MAX_LAYERS; ++i)
+	{
+		m_Poses[i].Resize(jointCount);
+		m_Layers[i].cursor.keys.assign(jointCount * 3, 0);
+	}
+	m_Worlds.resize(jointCount);
+	m_Palette.resize(skeleton.GetBoneCount(), glm::mat4(1.0f));
+}
+
+void Animator::SetLayer(unsigned int layer, const AnimationClip* clip, const CompressedClip* compressed, float time, float speed)
+{
+	m_Layers[layer].clip = clip;
+	m_Layers[layer].compressed = compressed;
+	m_Layers[layer].time = time;
+	m_Layers[layer].speed = speed;
+	// Rewinds the cursor on the next sample without giving up its memory
+	m_Layers[layer].cursor.time = std::numeric_limits<float>::max();
+}
+
+void Animator::SetClip(unsigned int layer, const AnimationClip* clip, float time, float speed)
+{
+	SetLayer(layer, clip, nullptr, time, speed);
+}
+
+void Animator::SetClip(unsigned int layer, const CompressedClip* clip, float time, float speed)
+{
+	SetLayer(layer, nullptr, clip, time, speed);
+}
+
+void Animator::SampleLayer(unsigned int layer)
+{
+	Layer& state = m_Layers[layer];
+	if (state.clip)
+		SampleClip(*state.clip, *m_Skeleton, state.time, state.cursor, m_Poses[layer]);
+	else if (state.compressed)
+		state.compressed->Sample(*m_Skeleton, state.time, state.cursor, m_Poses[layer]);
+	else
+		m_Poses[layer] = m_Skeleton->bindPose;
+}
+
+void Animator::Update(float deltaTime)
+{
+	for (unsigned int i = 0; i < MAX_LAYERS; ++i)
+	{
+		Layer& layer = m_Layers[i];
+		if (!layer.clip && !layer.compressed)
+			continue;
+		float duration = layer.clip ? layer.clip->duration : layer.compressed->GetDuration();
+		layer.time += deltaTime * layer.speed;
+		if (duration > 0.0f && (layer.time >= duration || layer.time < 0.0f))
+		{
+			layer.time = std::fmod(layer.time, duration);
+			if (layer.time < 0.0f)
+				layer.time += duration;
+		}
+	}
+
+	SampleLayer(0);
+	if ((m_Layers[1].clip || m_Layers[1].compressed) && m_BlendWeight > 0.0f)
+	{
+		SampleLayer(1);
+		BlendPoses(m_Poses[0], m_Poses[1], m_BlendWeight, m_Poses[0]);
+	}
+
+	BuildPalette(*m_Skeleton, m_Poses[0], m_Worlds.data(), m_Palette.data());
+}
+
+void Animator::UpdateAll(JobSystem& jobs, Animator* animators, size_t count, float deltaTime)
+{
+	PROFILE_SCOPE("Animator::UpdateAll");
+	jobs.ParallelFor(count, ANIMATOR_GRAIN_SIZE, [animators, deltaTime](size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; ++i)
+			animators[i].Update(deltaTime);
+	});
+}
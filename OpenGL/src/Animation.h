@@ -0,0 +1,136 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+class JobSystem;
+class CompressedClip;
+
+// Local transforms of every joint of a skeleton, one array per channel
+struct Pose
+{
+	std::vector<glm::vec3> translations;
+	std::vector<glm::quat> rotations;
+	std::vector<glm::vec3> scales;
+
+	void Resize(size_t jointCount);
+	size_t GetJointCount() const { return translations.size(); }
+};
+
+// Joints in the same parent-first order as a TransformHierarchy. Bones are the joints meshes are
+// skinned to, vertices refer to them by bone index, which is also the index into the palette.
+struct Skeleton
+{
+	// What BasicLitSkinned.vs has room for
+	static constexpr unsigned int MAX_BONES = 100;
+
+	// TransformHierarchy::NO_PARENT for roots
+	std::vector<uint32_t> parents;
+	std::vector<std::string> names;
+	// Joints without keys in a clip stay like this
+	Pose bindPose;
+	std::vector<uint32_t> boneJoints;
+	// Model space to bone space in the bind pose, assimp's offset matrix
+	std::vector<glm::mat4> inverseBindMatrices;
+
+	size_t GetJointCount() const { return parents.size(); }
+	size_t GetBoneCount() const { return boneJoints.size(); }
+	// TransformHierarchy::NO_PARENT if there's no joint with that name
+	uint32_t FindJoint(const std::string& name) const;
+};
+
+template <typename T>
+struct Keyframes
+{
+	// Seconds, ascending
+	std::vector<float> times;
+	std::vector<T> values;
+};
+
+struct JointTrack
+{
+	Keyframes<glm::vec3> translations;
+	Keyframes<glm::quat> rotations;
+	Keyframes<glm::vec3> scales;
+};
+
+struct AnimationClip
+{
+	std::string name;
+	float duration = 0.0f;
+	// By joint, channels without keys keep the bind pose
+	std::vector<JointTrack> tracks;
+
+	size_t GetKeyCount() const;
+	// Bytes of keys and tracks
+	size_t GetMemoryUsage() const;
+};
+
+// Where sampling a clip left off, three keys per joint. Playback moves forward, so the next sample
+// only has to step over the keys passed since the last one instead of searching for them.
+struct ClipCursor
+{
+	std::vector<uint32_t> keys;
+	float time = 0.0f;
+
+	void Reset() { keys.clear(); time = 0.0f; }
+};
+
+// Normalized lerp along the shorter arc, close enough to slerp between neighbouring keys
+glm::quat BlendRotations(const glm::quat& a, const glm::quat& b, float t);
+
+// Sampling is linear between keys, rotations are normalized lerps. Going backwards in time (a loop
+// wrapping around) rewinds the cursor.
+void SampleClip(const AnimationClip& clip, const Skeleton& skeleton, float time, ClipCursor& cursor, Pose& pose);
+// out = a with weight 0, b with weight 1, out may be a or b
+void BlendPoses(const Pose& a, const Pose& b, float weight, Pose& out);
+// worlds has to hold a matrix per joint, palette one per bone
+void BuildPalette(const Skeleton& skeleton, const Pose& pose, glm::mat4* worlds, glm::mat4* palette);
+
+// Plays up to two looping clips on one character and cross-fades between them, raw or compressed. Everything it
+// needs during Update() is allocated up front, so characters can be updated on any thread.
+class Animator
+{
+public:
+	static constexpr unsigned int MAX_LAYERS = 2;
+private:
+	struct Layer
+	{
+		const AnimationClip* clip = nullptr;
+		const CompressedClip* compressed = nullptr;
+		float time = 0.0f;
+		float speed = 1.0f;
+		ClipCursor cursor;
+	};
+
+	const Skeleton* m_Skeleton;
+	Layer m_Layers[MAX_LAYERS];
+	// Of the second layer
+	float m_BlendWeight;
+	Pose m_Poses[MAX_LAYERS];
+	std::vector<glm::mat4> m_Worlds;
+	std::vector<glm::mat4> m_Palette;
+private:
+	void SetLayer(unsigned int layer, const AnimationClip* clip, const CompressedClip* compressed, float time, float speed);
+	void SampleLayer(unsigned int layer);
+public:
+	explicit Animator(const Skeleton& skeleton);
+
+	// nullptr stops the layer, time is where the clip starts
+	void SetClip(unsigned int layer, const AnimationClip* clip, float time = 0.0f, float speed = 1.0f);
+	void SetClip(unsigned int layer, const CompressedClip* clip, float time = 0.0f, float speed = 1.0f);
+	// 0 plays the first layer only, 1 the second only
+	void SetBlendWeight(float weight) { m_BlendWeight = weight; }
+
+	// Advances the clips, samples and blends them and rebuilds the palette
+	void Update(float deltaTime);
+	// Update() on all of them as JobSystem jobs, a few characters per job
+	static void UpdateAll(JobSystem& jobs, Animator* animators, size_t count, float deltaTime);
+
+	const Pose& GetPose() const { return m_Poses[0]; }
+	// Skinning matrices by bone, model space like the mesh's vertices
+	const glm::mat4* GetPalette() const { return m_Palette.data(); }
+	unsigned int GetBoneCount() const { return (unsigned int)m_Palette.size(); }
+};
@@ -0,0 +1,331 @@
+#include "AnimationCompression.h"
+#include "BinaryIO.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <initializer_list>
+
+namespace
+{
+	const uint32_t CLIP_MAGIC = 0x50494c43; // "CLIP"
+	const uint32_t CLIP_VERSION = 1;
+	const float TIME_STEPS = 65535.0f;
+	const float VALUE_STEPS = 65535.0f;
+	const float ROTATION_STEPS = 32767.0f;
+	// The three smaller components of a unit quaternion are within +-1/sqrt(2)
+	const float ROTATION_RANGE = 0.70710678f;
+
+	float Distance(const glm::vec3& a, const glm::vec3& b)
+	{
+		return glm::length(a - b);
+	}
+
+	// Angle between the rotations
+	float Distance(const glm::quat& a, const glm::quat& b)
+	{
+		return 2.0f * std::acos(std::min(1.0f, std::abs(glm::dot(a, b))));
+	}
+
+	glm::vec3 Lerp(const glm::vec3& a, const glm::vec3& b, float t)
+	{
+		return glm::mix(a, b, t);
+	}
+
+	glm::quat Lerp(const glm::quat& a, const glm::quat& b, float t)
+	{
+		return BlendRotations(a, b, t);
+	}
+
+	// Indices of the keys worth keeping. Starting from the last kept key, the segment is stretched
+	// key by key until linear interpolation along it misses one of the keys it skips.
+	template <typename T>
+	std::vector<uint32_t> ReduceKeys(const Keyframes<T>& keys, float tolerance)
+	{
+		std::vector<uint32_t> kept;
+		uint32_t count = (uint32_t)keys.times.size();
+		if (count == 0)
+			return kept;
+		kept.push_back(0);
+
+		bool constant = true;
+		for (uint32_t i = 1; i < count && constant; ++i)
+			constant = Distance(keys.values[i], keys.values[0]) <= tolerance;
+		if (constant)
+			return kept;
+
+		uint32_t anchor = 0;
+		for (uint32_t end = anchor + 2; end < count; ++end)
+		{
+			float span = keys.times[end] - keys.times[anchor];
+			bool fits = true;
+			for (uint32_t i = anchor + 1; i < end && fits; ++i)
+			{
+				float t = span > 0.0f ? (keys.times[i] - keys.times[anchor]) / span : 0.0f;
+				fits = Distance(Lerp(keys.values[anchor], keys.values[end], t), keys.values[i]) <= tolerance;
+			}
+			if (!fits)
+			{
+				anchor = end - 1;
+				kept.push_back(anchor);
+			}
+		}
+		kept.push_back(count - 1);
+		return kept;
+	}
+
+	glm::vec3 DecodeVector(const CompressedChannel& channel, const uint16_t* value)
+	{
+		return channel.offset + glm::vec3(value[0], value[1], value[2]) * channel.scale;
+	}
+
+	// Smallest three: the largest component is dropped and rebuilt from the others, its index is
+	// in the top bits of the first two values
+	void EncodeRotation(const glm::quat& rotation, uint16_t* value)
+	{
+		glm::quat q = glm::normalize(rotation);
+		int largest = 0;
+		for (int i = 1; i < 4; ++i)
+		{
+			if (std::abs(q[i]) > std::abs(q[largest]))
+				largest = i;
+		}
+		// q and -q are the same rotation, this way the dropped component is positive
+		if (q[largest] < 0.0f)
+			q = -q;
+		for (int i = 0, j = 0; i < 4; ++i)
+		{
+			if (i == largest)
+				continue;
+			float normalized = glm::clamp(q[i] / ROTATION_RANGE * 0.5f + 0.5f, 0.0f, 1.0f);
+			value[j++] = (uint16_t)std::lround(normalized * ROTATION_STEPS);
+		}
+		value[0] |= (uint16_t)((largest & 1) << 15);
+		value[1] |= (uint16_t)((largest >> 1) << 15);
+	}
+
+	glm::quat DecodeRotation(const uint16_t* value)
+	{
+		// Where the three stored components go for each dropped one, no branches on the index
+		static const uint8_t STORED[4][3] = { { 1, 2, 3 }, { 0, 2, 3 }, { 0, 1, 3 }, { 0, 1, 2 } };
+		int largest = (value[0] >> 15) | ((value[1] >> 15) << 1);
+		const float step = 2.0f * ROTATION_RANGE / ROTATION_STEPS;
+		float a = (value[0] & 0x7fff) * step - ROTATION_RANGE;
+		float b = (value[1] & 0x7fff) * step - ROTATION_RANGE;
+		float c = (value[2] & 0x7fff) * step - ROTATION_RANGE;
+		float components[4];
+		components[STORED[largest][0]] = a;
+		components[STORED[largest][1]] = b;
+		components[STORED[largest][2]] = c;
+		components[largest] = std::sqrt(std::max(0.0f, 1.0f - a * a - b * b - c * c));
+		// glm's index order is x, y, z, w
+		return glm::quat(components[3], components[0], components[1], components[2]);
+	}
+
+	// time is in the same 16 bit steps as the keys
+	glm::vec3 SampleVector(const CompressedChannel& channel, const uint16_t* times, const uint16_t* values, float time, uint32_t& key, const glm::vec3& bind)
+	{
+		if (channel.keyCount == 0)
+			return bind;
+		times += channel.firstKey;
+		values += channel.firstKey * 3;
+		while (key + 1 < channel.keyCount && times[key + 1] <= time)
+			++key;
+		glm::vec3 value = DecodeVector(channel, values + key * 3);
+		if (key + 1 >= channel.keyCount || time <= times[key])
+			return value;
+		float t = (time - times[key]) / (float)(times[key + 1] - times[key]);
+		return glm::mix(value, DecodeVector(channel, values + key * 3 + 3), t);
+	}
+
+	glm::quat SampleRotation(const CompressedChannel& channel, const uint16_t* times, const uint16_t* values, float time, uint32_t& key, const glm::quat& bind)
+	{
+		if (channel.keyCount == 0)
+			return bind;
+		times += channel.firstKey;
+		values += channel.firstKey * 3;
+		while (key + 1 < channel.keyCount && times[key + 1] <= time)
+			++key;
+		glm::quat value = DecodeRotation(values + key * 3);
+		if (key + 1 >= channel.keyCount || time <= times[key])
+			return value;
+		float t = (time - times[key]) / (float)(times[key + 1] - times[key]);
+		return BlendRotations(value, DecodeRotation(values + key * 3 + 3), t);
+	}
+}
+
+uint16_t CompressedClip::QuantizeTime(float time) const
+{
+	if (m_Duration <= 0.0f)
+		return 0;
+	return (uint16_t)std::lround(glm::clamp(time / m_Duration, 0.0f, 1.0f) * TIME_STEPS);
+}
+
+void CompressedClip::AddChannel(const Keyframes<glm::vec3>& keys, float tolerance, const glm::vec3& bind, CompressedChannel& channel)
+{
+	std::vector<uint32_t> kept = ReduceKeys(keys, tolerance);
+	// A single key matching the bind pose does nothing
+	if (kept.size() == 1 && Distance(keys.values[kept[0]], bind) <= tolerance)
+		kept.clear();
+
+	glm::vec3 minimum(0.0f);
+	glm::vec3 maximum(0.0f);
+	if (!kept.empty())
+		minimum = maximum = keys.values[kept[0]];
+	for (uint32_t key : kept)
+	{
+		minimum = glm::min(minimum, keys.values[key]);
+		maximum = glm::max(maximum, keys.values[key]);
+	}
+	channel.firstKey = (uint32_t)m_Times.size();
+	channel.keyCount = (uint32_t)kept.size();
+	channel.offset = minimum;
+	channel.scale = (maximum - minimum) / VALUE_STEPS;
+
+	for (uint32_t key : kept)
+	{
+		m_Times.push_back(QuantizeTime(keys.times[key]));
+		for (int i = 0; i < 3; ++i)
+		{
+			float steps = channel.scale[i] > 0.0f ? (keys.values[key][i] - minimum[i]) / channel.scale[i] : 0.0f;
+			m_Values.push_back((uint16_t)std::lround(glm::clamp(steps, 0.0f, VALUE_STEPS)));
+		}
+	}
+}
+
+void CompressedClip::AddChannel(const Keyframes<glm::quat>& keys, float tolerance, const glm::quat& bind, CompressedChannel& channel)
+{
+	std::vector<uint32_t> kept = ReduceKeys(keys, tolerance);
+	if (kept.size() == 1 && Distance(keys.values[kept[0]], bind) <= tolerance)
+		kept.clear();
+
+	channel.firstKey = (uint32_t)m_Times.size();
+	channel.keyCount = (uint32_t)kept.size();
+	for (uint32_t key : kept)
+	{
+		m_Times.push_back(QuantizeTime(keys.times[key]));
+		m_Values.resize(m_Values.size() + 3);
+		EncodeRotation(keys.values[key], &m_Values[m_Values.size() - 3]);
+	}
+}
+
+CompressedClip CompressedClip::Compress(const AnimationClip& clip, const Skeleton& skeleton, const CompressionSettings& settings)
+{
+	CompressedClip result;
+	result.m_Name = clip.name;
+	result.m_Duration = clip.duration;
+	size_t jointCount = std::min(clip.tracks.size(), skeleton.GetJointCount());
+	result.m_Tracks.resize(jointCount);
+	for (size_t joint = 0; joint < jointCount; ++joint)
+	{
+		const JointTrack& track = clip.tracks[joint];
+		CompressedTrack& compressed = result.m_Tracks[joint];
+		result.AddChannel(track.translations, settings.translationTolerance, skeleton.bindPose.translations[joint], compressed.translations);
+		result.AddChannel(track.rotations, settings.rotationTolerance, skeleton.bindPose.rotations[joint], compressed.rotations);
+		result.AddChannel(track.scales, settings.scaleTolerance, skeleton.bindPose.scales[joint], compressed.scales);
+	}
+	return result;
+}
+
+bool CompressedClip::Save(const std::string& path) const
+{
+	std::ofstream file(path, std::ios::binary);
+	if (!file)
+		return false;
+	Write(file, CLIP_MAGIC);
+	Write(file, CLIP_VERSION);
+	Write(file, (uint32_t)m_Name.size());
+	file.write(m_Name.data(), m_Name.size());
+	Write(file, m_Duration);
+	WriteArray(file, m_Tracks);
+	WriteArray(file, m_Times);
+	WriteArray(file, m_Values);
+	return (bool)file;
+}
+
+bool CompressedClip::Load(const std::string& path, CompressedClip& result)
+{
+	std::ifstream file(path, std::ios::binary);
+	uint32_t magic, version, nameLength;
+	if (!file || !Read(file, magic) || !Read(file, version) || magic != CLIP_MAGIC || version != CLIP_VERSION)
+		return false;
+	if (!Read(file, nameLength))
+		return false;
+	CompressedClip clip;
+	clip.m_Name.resize(nameLength);
+	if (!file.read(&clip.m_Name[0], nameLength) || !Read(file, clip.m_Duration))
+		return false;
+	if (!ReadArray(file, clip.m_Tracks) || !ReadArray(file, clip.m_Times) || !ReadArray(file, clip.m_Values))
+		return false;
+
+	// Sampling trusts the channels, so don't let a broken file point them past the keys
+	if (clip.m_Values.size() != clip.m_Times.size() * 3)
+		return false;
+	for (const CompressedTrack& track : clip.m_Tracks)
+	{
+		for (const CompressedChannel* channel : { &track.translations, &track.rotations, &track.scales })
+		{
+			if ((uint64_t)channel->firstKey + channel->keyCount > clip.m_Times.size())
+				return false;
+		}
+	}
+	result = std::move(clip);
+	return true;
+}
+
+void CompressedClip::Sample(const Skeleton& skeleton, float time, ClipCursor& cursor, Pose& pose) const
+{
+	size_t jointCount = skeleton.GetJointCount();
+	pose.Resize(jointCount);
+	if (cursor.keys.size() != jointCount * 3 || time < cursor.time)
+		cursor.keys.assign(jointCount * 3, 0);
+	cursor.time = time;
+
+	// Compared against the quantized key times as they are
+	float steps = m_Duration > 0.0f ? time / m_Duration * TIME_STEPS : 0.0f;
+	const Pose& bind = skeleton.bindPose;
+	size_t trackCount = std::min(m_Tracks.size(), jointCount);
+	const uint16_t* times = m_Times.data();
+	const uint16_t* values = m_Values.data();
+	uint32_t* keys = cursor.keys.data();
+	for (size_t joint = 0; joint < trackCount; ++joint)
+	{
+		const CompressedTrack& track = m_Tracks[joint];
+		pose.translations[joint] = SampleVector(track.translations, times, values, steps, keys[joint * 3], bind.translations[joint]);
+		pose.rotations[joint] = SampleRotation(track.rotations, times, values, steps, keys[joint * 3 + 1], bind.rotations[joint]);
+		pose.scales[joint] = SampleVector(track.scales, times, values, steps, keys[joint * 3 + 2], bind.scales[joint]);
+	}
+	for (size_t joint = trackCount; joint < jointCount; ++joint)
+	{
+		pose.translations[joint] = bind.translations[joint];
+		pose.rotations[joint] = bind.rotations[joint];
+		pose.scales[joint] = bind.scales[joint];
+	}
+}
+
+size_t CompressedClip::GetMemoryUsage() const
+{
+	return m_Tracks.size() * sizeof(CompressedTrack) + (m_Times.size() + m_Values.size()) * sizeof(uint16_t);
+}
+
+CompressionError MeasureCompressionError(const AnimationClip& clip, const CompressedClip& compressed, const Skeleton& skeleton, float sampleRate)
+{
+	CompressionError error;
+	ClipCursor cursor;
+	ClipCursor compressedCursor;
+	Pose pose;
+	Pose compressedPose;
+	unsigned int samples = (unsigned int)std::ceil(clip.duration * sampleRate);
+	for (unsigned int sample = 0; sample <= samples; ++sample)
+	{
+		float time = std::min(sample / sampleRate, clip.duration);
+		SampleClip(clip, skeleton, time, cursor, pose);
+		compressed.Sample(skeleton, time, compressedCursor, compressedPose);
+		for (size_t joint = 0; joint < pose.GetJointCount(); ++joint)
+		{
+			error.translation = std::max(error.translation, Distance(pose.translations[joint], compressedPose.translations[joint]));
+			error.rotation = std::max(error.rotation, Distance(pose.rotations[joint], compressedPose.rotations[joint]));
+			error.scale = std::max(error.scale, Distance(pose.scales[joint], compressedPose.scales[joint]));
+		}
+	}
+	return error;
+}
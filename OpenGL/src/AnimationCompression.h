@@ -0,0 +1,78 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+#include "Animation.h"
+
+// How far the compressed clip may stray from the original before quantization. Keys that linear
+// interpolation between their neighbours reproduces within these are dropped.
+struct CompressionSettings
+{
+	float translationTolerance = 0.001f;
+	// Radians
+	float rotationTolerance = 0.001f;
+	float scaleTolerance = 0.001f;
+};
+
+// Where a channel's keys are, translations and scales also keep the range they're quantized to
+struct CompressedChannel
+{
+	uint32_t firstKey = 0;
+	uint32_t keyCount = 0;
+	glm::vec3 offset = glm::vec3(0.0f);
+	glm::vec3 scale = glm::vec3(0.0f);
+};
+
+struct CompressedTrack
+{
+	CompressedChannel translations;
+	CompressedChannel rotations;
+	CompressedChannel scales;
+};
+
+// An AnimationClip after key reduction and quantization, decompressed key by key while sampling.
+// Times are 16 bit fractions of the duration, translations and scales 16 bits per component within
+// the channel's range, rotations the smallest three components in 15 bits each plus the index of
+// the dropped one. A key costs 8 bytes instead of 16 to 20.
+class CompressedClip
+{
+private:
+	std::string m_Name;
+	float m_Duration;
+	std::vector<CompressedTrack> m_Tracks;
+	// By key, every channel's keys one after another
+	std::vector<uint16_t> m_Times;
+	// Three per key
+	std::vector<uint16_t> m_Values;
+private:
+	uint16_t QuantizeTime(float time) const;
+	void AddChannel(const Keyframes<glm::vec3>& keys, float tolerance, const glm::vec3& bind, CompressedChannel& channel);
+	void AddChannel(const Keyframes<glm::quat>& keys, float tolerance, const glm::quat& bind, CompressedChannel& channel);
+public:
+	CompressedClip() : m_Duration(0.0f) {}
+
+	static CompressedClip Compress(const AnimationClip& clip, const Skeleton& skeleton, const CompressionSettings& settings = CompressionSettings());
+	// Binary file, native byte order
+	bool Save(const std::string& path) const;
+	static bool Load(const std::string& path, CompressedClip& result);
+
+	// Same as SampleClip() on the original, within the tolerances
+	void Sample(const Skeleton& skeleton, float time, ClipCursor& cursor, Pose& pose) const;
+
+	const std::string& GetName() const { return m_Name; }
+	float GetDuration() const { return m_Duration; }
+	size_t GetKeyCount() const { return m_Times.size(); }
+	// Bytes of keys and tracks, comparable to AnimationClip::GetMemoryUsage()
+	size_t GetMemoryUsage() const;
+};
+
+// Largest difference between the local transforms of the two, sampled sampleRate times a second
+struct CompressionError
+{
+	float translation = 0.0f;
+	// Radians
+	float rotation = 0.0f;
+	float scale = 0.0f;
+};
+CompressionError MeasureCompressionError(const AnimationClip& clip, const CompressedClip& compressed, const Skeleton& skeleton, float sampleRate = 60.0f);
@@ -0,0 +1,77 @@
+#include "AnimationImport.h"
+#include <assimp/scene.h>
+#include "TransformHierarchy.h"
+
+namespace
+{
+	glm::vec3 ToVec3(const aiVector3D& v)
+	{
+		return glm::vec3(v.x, v.y, v.z);
+	}
+
+	glm::quat ToQuat(const aiQuaternion& q)
+	{
+		return glm::quat(q.w, q.x, q.y, q.z);
+	}
+
+	void ImportJoint(const aiNode* node, uint32_t parent, Skeleton& skeleton)
+	{
+		aiVector3D scaling;
+		aiQuaternion rotation;
+		aiVector3D position;
+		node->mTransformation.Decompose(scaling, rotation, position);
+		uint32_t index = (uint32_t)skeleton.parents.size();
+		skeleton.parents.push_back(parent);
+		skeleton.names.push_back(node->mName.C_Str());
+		skeleton.bindPose.translations.push_back(ToVec3(position));
+		skeleton.bindPose.rotations.push_back(ToQuat(rotation));
+		skeleton.bindPose.scales.push_back(ToVec3(scaling));
+		for (unsigned int i = 0; i < node->mNumChildren; ++i)
+			ImportJoint(node->mChildren[i], index, skeleton);
+	}
+}
+
+void ImportSkeleton(const aiNode* node, Skeleton& skeleton)
+{
+	ImportJoint(node, TransformHierarchy::NO_PARENT, skeleton);
+}
+
+void ImportAnimations(const aiScene* scene, const Skeleton& skeleton, std::vector<AnimationClip>& clips)
+{
+	for (unsigned int i = 0; i < scene->mNumAnimations; ++i)
+	{
+		const aiAnimation* animation = scene->mAnimations[i];
+		// Keys are in ticks, 0 ticks per second means the file didn't say
+		double ticksPerSecond = animation->mTicksPerSecond > 0.0 ? animation->mTicksPerSecond : 25.0;
+		AnimationClip clip;
+		clip.name = animation->mName.C_Str();
+		clip.duration = (float)(animation->mDuration / ticksPerSecond);
+		clip.tracks.resize(skeleton.GetJointCount());
+
+		for (unsigned int j = 0; j < animation->mNumChannels; ++j)
+		{
+			const aiNodeAnim* channel = animation->mChannels[j];
+			uint32_t joint = skeleton.FindJoint(channel->mNodeName.C_Str());
+			if (joint == TransformHierarchy::NO_PARENT)
+				continue;
+
+			JointTrack& track = clip.tracks[joint];
+			for (unsigned int k = 0; k < channel->mNumPositionKeys; ++k)
+			{
+				track.translations.times.push_back((float)(channel->mPositionKeys[k].mTime / ticksPerSecond));
+				track.translations.values.push_back(ToVec3(channel->mPositionKeys[k].mValue));
+			}
+			for (unsigned int k = 0; k < channel->mNumRotationKeys; ++k)
+			{
+				track.rotations.times.push_back((float)(channel->mRotationKeys[k].mTime / ticksPerSecond));
+				track.rotations.values.push_back(ToQuat(channel->mRotationKeys[k].mValue));
+			}
+			for (unsigned int k = 0; k < channel->mNumScalingKeys; ++k)
+			{
+				track.scales.times.push_back((float)(channel->mScalingKeys[k].mTime / ticksPerSecond));
+				track.scales.values.push_back(ToVec3(channel->mScalingKeys[k].mValue));
+			}
+		}
+		clips.push_back(clip);
+	}
+}
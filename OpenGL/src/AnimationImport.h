@@ -0,0 +1,13 @@
+#pragma once
+#include <vector>
+#include "Animation.h"
+
+struct aiNode;
+struct aiScene;
+
+// A joint for node and every node below it, parents first. That's the order Model adds the
+// nodes to its TransformHierarchy in, so joint and node indices are the same.
+void ImportSkeleton(const aiNode* node, Skeleton& skeleton);
+// Every animation of the scene, channels are matched to joints by node name. Key times are
+// converted from ticks to seconds.
+void ImportAnimations(const aiScene* scene, const Skeleton& skeleton, std::vector<AnimationClip>& clips);
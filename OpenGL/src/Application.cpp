@@ -1,12 +1,39 @@
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
+#include <cstdlib>
 #include <iostream>
 #include <fstream>
 #include <string>
 #include <sstream>
 
 #include "Shader.h"
+#include "Material.h"
 #include "Model.h"
+#include "RenderState.h"
+#include "RenderQueue.h"
+#include "FrameBuilder.h"
+#include "JobSystem.h"
+#include "FrameArena.h"
+#include "AllocationCounter.h"
+#include "GpuProfiler.h"
+#include "CpuProfiler.h"
+#include "HeadlessContext.h"
+#include "CameraPath.h"
+#include "SampleStats.h"
+#include "GoldenImages.h"
+#include "FrameCapture.h"
+#include "PostProcessGraph.h"
+#include "GaussianBlur.h"
+#include "DynamicResolution.h"
+#include "Scene.h"
+#include "TransformHierarchy.h"
+#include "Animation.h"
+#include "AnimationCompression.h"
+#include "Skinning.h"
+#include "VirtualTexture.h"
+#include "TextureStreamer.h"
+#include <chrono>
+#include <thread>
 
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
@@ -39,6 +66,14 @@ float deltaTime = 0.0f;	// Time between current frame and last frame
 float lastFrame = 0.0f; // Time of last frame
 int width = 960;
 int height = 540;
+// Latest framebuffer size from GLFW, only applied once per frame however many events came in
+int pendingWidth = 0;
+int pendingHeight = 0;
+bool resizePending = false;
+// Oversized render targets are trimmed once the size has stopped changing for a bit
+float lastResizeTime = 0.0f;
+bool trimPending = false;
+const float resizeSettleSeconds = 0.25f;
 bool firstMouse = true;
 float lastX = width / 2.0f;
 float lastY = height / 2.0f;
@@ -48,25 +83,88 @@ bool showOutline = false;
 bool drawTransparentWindows = false;
 bool usePostProcessing = false;
 bool showNormals = true;
+bool logRenderStats = false;
+// Extra cubes to load the frame builder with
+int stressCubeCount = 0;
+// Skinned actors play their first clip, on the GPU unless --cpu-skinning
+std::string actorPath = "res/models/nanosuit/nanosuit.obj";
+bool cpuSkinning = false;
+// Plays the clip through CompressedClip instead
+bool compressAnimations = false;
+// Meshes with a normal map use the NORMAL_MAP permutation of BasicLit unless --no-normal-maps
+bool useNormalMaps = true;
+bool packTangentFrames = false;
+// The actor's maps in texture arrays and its meshes merged, only the actor uses the lit shaders
+bool useTextureArrays = false;
+// Material maps as bindless handles if the driver has ARB_bindless_texture
+bool useBindless = false;
+// The actor's maps that have a .mips stream their finer levels in within a budget, in MB
+bool streamMips = false;
+float textureBudgetMB = 128.0f;
+// A .vtex shown on a ground slab under the scene, see VirtualTexture
+std::string virtualTexturePath;
 
 
 constexpr int NUM_LIGHTS = 4;
 glm::vec3 dirLightDirection(-0.2f, -1.0f, -0.3f);
 
-glm::vec3 pointLightPositions[NUM_LIGHTS] = {
-	glm::vec3(0.7f,  0.2f,  2.0f),
-	glm::vec3(2.3f, -3.3f, -4.0f),
-	glm::vec3(-4.0f,  2.0f, -12.0f),
-	glm::vec3(0.0f,  0.0f, -3.0f)
+// Where the point lights start out, they're entities once the scene is built
+struct PointLightSetup
+{
+	glm::vec3 position;
+	glm::vec3 color;
 };
 
-glm::vec3 pointLightColors[NUM_LIGHTS] = {
-	glm::vec3(1.0f, 1.0f, 1.0f),
-	glm::vec3(0.7f, 0.8f, 0.9f),
-	glm::vec3(1.0f, 0.0f, 0.2f),
-	glm::vec3(0.0f, 1.0f, 0.0f)
+const PointLightSetup pointLightSetups[NUM_LIGHTS] = {
+	{ glm::vec3(0.7f,  0.2f,  2.0f), glm::vec3(1.0f, 1.0f, 1.0f) },
+	{ glm::vec3(2.3f, -3.3f, -4.0f), glm::vec3(0.7f, 0.8f, 0.9f) },
+	{ glm::vec3(-4.0f,  2.0f, -12.0f), glm::vec3(1.0f, 0.0f, 0.2f) },
+	{ glm::vec3(0.0f,  0.0f, -3.0f), glm::vec3(0.0f, 1.0f, 0.0f) }
 };
 
+// Uniform names are built once up front. Building them from literals and std::to_string
+// every frame meant a heap allocation for almost every uniform.
+struct PointLightUniforms
+{
+	std::string position, ambient, diffuse, specular;
+	std::string constant, linear, quadratic;
+};
+
+struct LightingUniforms
+{
+	std::string directionalDirection, directionalAmbient, directionalDiffuse, directionalSpecular;
+	PointLightUniforms pointLights[NUM_LIGHTS];
+	std::string spotDirection, spotPosition, spotAmbient, spotDiffuse, spotSpecular;
+	std::string spotCutoff, spotOuterCutoff;
+
+	LightingUniforms()
+	{
+		directionalDirection = "directionalLight.direction";
+		directionalAmbient = "directionalLight.ambient";
+		directionalDiffuse = "directionalLight.diffuse";
+		directionalSpecular = "directionalLight.specular";
+		for (int i = 0; i < NUM_LIGHTS; ++i)
+		{
+			std::string prefix = "pointLights[" + std::to_string(i) + "].";
+			pointLights[i].position = prefix + "position";
+			pointLights[i].ambient = prefix + "ambient";
+			pointLights[i].diffuse = prefix + "diffuse";
+			pointLights[i].specular = prefix + "specular";
+			pointLights[i].constant = prefix + "constant";
+			pointLights[i].linear = prefix + "linear";
+			pointLights[i].quadratic = prefix + "quadratic";
+		}
+		spotDirection = "spotLight.direction";
+		spotPosition = "spotLight.position";
+		spotAmbient = "spotLight.ambient";
+		spotDiffuse = "spotLight.diffuse";
+		spotSpecular = "spotLight.specular";
+		spotCutoff = "spotLight.cutoff";
+		spotOuterCutoff = "spotLight.outerCutoff";
+	}
+};
+LightingUniforms lightingUniforms;
+
 std::vector<glm::vec3> windows = {
 	glm::vec3(-1.5f, 0.0f, -0.48f),
 	glm::vec3(1.5f, 0.0f, 0.51f),
@@ -94,19 +192,56 @@ glm::vec4 clearColor(0.1f, 0.1f, 0.1f, 1.0f);
 Shader* basicLitShader = nullptr;
 Shader* colorShader = nullptr;
 Shader* spriteShader = nullptr;
-Shader* postProcessShader = nullptr;
 Shader* skyboxShader = nullptr;
 Shader* normalShader = nullptr;
+Shader* skinnedLitShader = nullptr;
+Shader* skinnedColorShader = nullptr;
+Shader* normalMapLitShader = nullptr;
+Shader* skinnedNormalMapLitShader = nullptr;
+Shader* virtualTextureShader = nullptr;
+Shader* virtualTextureFeedbackShader = nullptr;
 
 Model* actor	= nullptr;
 Model* cube		= nullptr;
 Model* plane	= nullptr;
 
+// Only for skinned actors
+Animator* actorAnimator = nullptr;
+CompressedClip* actorClip = nullptr;
+std::vector<Vertex> skinnedVertices;
+
 Texture* windowTexture = nullptr;
 
+VirtualTexture* virtualTexture = nullptr;
+TextureStreamer* textureStreamer = nullptr;
+glm::mat4 groundTransform(1.0f);
+
 Mesh* screenQuad = nullptr;
 
-unsigned int fbo, fboColorBuffer, rbo, uboMatrices;
+// Passes in the order the render queue executes them
+enum ScenePass
+{
+	PASS_STENCIL,
+	PASS_OUTLINE,
+	PASS_OPAQUE,
+	PASS_NORMALS,
+	PASS_SKYBOX,
+	PASS_TRANSPARENT
+};
+FrameArena frameArena;
+RenderQueue renderQueue(frameArena);
+JobSystem* jobSystem = nullptr;
+FrameBuilder* frameBuilder = nullptr;
+GpuProfiler* gpuProfiler = nullptr;
+// Everything drawn through the frame builder and the point lights
+Scene scene;
+
+unsigned int uboMatrices;
+PostProcessGraph* postProcess = nullptr;
+// Only with --dynamic-resolution
+DynamicResolution* dynamicResolution = nullptr;
+// 0 unless we're drawing into a headless context
+unsigned int defaultFramebuffer = 0;
 
 unsigned int cubemap;
 std::vector<const char*> cubeMapPaths =
@@ -123,13 +258,16 @@ unsigned int loadCubemap(const std::vector<const char*>& paths)
 {
 	unsigned int cubemap;
 	glGenTextures(1, &cubemap);
-	glBindTexture(GL_TEXTURE_CUBE_MAP, cubemap);
+	RenderState::BindTexture(0, GL_TEXTURE_CUBE_MAP, cubemap);
 
 	int width, height, numChannels;
 	unsigned char* data;
 	for (unsigned int i = 0; i < cubeMapPaths.size(); ++i)
 	{
-		data = stbi_load(cubeMapPaths[i], &width, &height, &numChannels, 0);
+		{
+			PROFILE_SCOPE("Cubemap decode");
+			data = stbi_load(cubeMapPaths[i], &width, &height, &numChannels, 0);
+		}
 		if (data)
 		{
 			glTexImage2D(
@@ -210,6 +348,46 @@ void ScrollCallback(GLFWwindow* window, double xoff, double yoff)
 	}
 }
 
+// Dragging a window edge sends several of these a frame, so the size is only remembered here
+void FramebufferSizeCallback(GLFWwindow* window, int newWidth, int newHeight)
+{
+	pendingWidth = newWidth;
+	pendingHeight = newHeight;
+	resizePending = true;
+}
+
+// Resizes everything that depends on the framebuffer size
+void ApplyPendingResize(float time)
+{
+	resizePending = false;
+	// Minimized, everything stays as it was until the window comes back
+	if (pendingWidth <= 0 || pendingHeight <= 0 || (pendingWidth == width && pendingHeight == height))
+		return;
+	width = pendingWidth;
+	height = pendingHeight;
+	camera->SetViewportSize(width, height);
+	postProcess->Resize(width, height);
+	lastResizeTime = time;
+	trimPending = true;
+}
+
+// P toggles post-processing, 1-9 toggle the effects in the order they run
+void KeyCallback(GLFWwindow* window, int key, int scancode, int action, int mods)
+{
+	if (action != GLFW_PRESS || !postProcess)
+		return;
+	if (key == GLFW_KEY_P)
+	{
+		usePostProcessing = !usePostProcessing;
+	}
+	else if (key >= GLFW_KEY_1 && key <= GLFW_KEY_9 && (size_t)(key - GLFW_KEY_1) < postProcess->GetEffectCount())
+	{
+		PostProcessEffect& effect = postProcess->GetEffect(key - GLFW_KEY_1);
+		effect.SetEnabled(!effect.IsEnabled());
+		std::cout << effect.GetName() << (effect.IsEnabled() ? " on\n" : " off\n");
+	}
+}
+
 
 void ProcessInput(GLFWwindow* window)
 {
@@ -233,8 +411,164 @@ void ProcessInput(GLFWwindow* window)
 		camera->Translate(glm::normalize(glm::cross(camera->GetForward(), camera->GetUp())) * cameraSpeed);
 }
 
-void DrawScene()
+// Entities for everything drawn through the frame builder and the lights, built once after loading
+void BuildScene()
 {
+	scene.Clear();
+	const glm::quat noRotation(1.0f, 0.0f, 0.0f, 0.0f);
+
+	// Actor(s)
+	{
+		Entity entity = scene.CreateEntity(ComposeTransform(glm::vec3(0, -1.5f, 0), noRotation, glm::vec3(0.2f, 0.2, 0.2f)));
+		RenderableComponent renderable;
+		renderable.model = actor;
+		renderable.shader = basicLitShader;
+		renderable.params.skybox = cubemap;
+		renderable.normalMapShader = useNormalMaps ? normalMapLitShader : nullptr;
+		bool gpuSkinned = actorAnimator && !cpuSkinning;
+		// SkinVertices() leaves the tangents alone
+		if (actorAnimator && cpuSkinning)
+			renderable.normalMapShader = nullptr;
+		if (gpuSkinned)
+		{
+			renderable.shader = skinnedLitShader;
+			renderable.normalMapShader = useNormalMaps ? skinnedNormalMapLitShader : nullptr;
+			renderable.params.bones = actorAnimator->GetPalette();
+			renderable.params.boneCount = actorAnimator->GetBoneCount();
+		}
+		// The outline pass only draws where the actor wrote to the stencil buffer
+		renderable.pass = showOutline ? PASS_STENCIL : PASS_OPAQUE;
+		scene.AddRenderable(entity, renderable);
+
+		// Children, so they follow the actor around
+		if (showOutline)
+		{
+			RenderableComponent outline = renderable;
+			outline.shader = colorShader;
+			outline.normalMapShader = nullptr;
+			outline.pass = PASS_OUTLINE;
+			outline.params = DrawParams();
+			outline.params.flags = DrawParams::EMISSION;
+			outline.params.emission = glm::vec3(0.0f, 0.0f, 1.0f);
+			if (gpuSkinned)
+			{
+				outline.shader = skinnedColorShader;
+				outline.params.bones = renderable.params.bones;
+				outline.params.boneCount = renderable.params.boneCount;
+			}
+			scene.AddRenderable(scene.CreateEntity(glm::scale(glm::mat4(1.0f), glm::vec3(1.02f)), entity), outline);
+		}
+
+		// Normals.vs doesn't skin, they'd stick out of the bind pose
+		if (showNormals && !gpuSkinned)
+		{
+			RenderableComponent normals = renderable;
+			normals.shader = normalShader;
+			normals.normalMapShader = nullptr;
+			normals.pass = PASS_NORMALS;
+			normals.params = DrawParams();
+			scene.AddRenderable(scene.CreateEntity(glm::mat4(1.0f), entity), normals);
+		}
+	}
+
+	// Ground, a flattened cube with the virtual texture on top
+	if (virtualTexture)
+	{
+		groundTransform = ComposeTransform(glm::vec3(0.0f, -1.75f, 0.0f), noRotation, glm::vec3(10.0f, 0.05f, 10.0f));
+		RenderableComponent renderable;
+		renderable.model = cube;
+		renderable.shader = virtualTextureShader;
+		renderable.pass = PASS_OPAQUE;
+		scene.AddRenderable(scene.CreateEntity(groundTransform), renderable);
+	}
+
+	// Windows
+	if (drawTransparentWindows)
+	{
+		// The transparent pass is sorted furthest to nearest because the depth buffer can't help us there
+		for (unsigned int i = 0; i < windows.size(); ++i)
+		{
+			RenderableComponent renderable;
+			renderable.model = plane;
+			renderable.shader = spriteShader;
+			renderable.pass = PASS_TRANSPARENT;
+			renderable.params.texture = windowTexture->GetID();
+			scene.AddRenderable(scene.CreateEntity(glm::translate(glm::mat4(1.0f), windows[i])), renderable);
+		}
+	}
+
+	// Point lights, each with a cube to show where it is
+	for (int i = 0; i < NUM_LIGHTS; ++i)
+	{
+		Entity entity = scene.CreateEntity(ComposeTransform(pointLightSetups[i].position, noRotation, glm::vec3(0.2f, 0.2f, 0.2f)));
+		PointLightComponent light;
+		light.color = pointLightSetups[i].color;
+		scene.AddPointLight(entity, light);
+
+		RenderableComponent renderable;
+		renderable.model = cube;
+		renderable.shader = colorShader;
+		renderable.pass = PASS_OPAQUE;
+		renderable.params.flags = DrawParams::EMISSION;
+		renderable.params.emission = pointLightSetups[i].color;
+		scene.AddRenderable(entity, renderable);
+	}
+
+	// Stress test cubes on a grid below the scene
+	int side = (int)glm::ceil(glm::sqrt((float)stressCubeCount));
+	scene.Reserve(scene.GetEntityCount() + stressCubeCount);
+	for (int i = 0; i < stressCubeCount; ++i)
+	{
+		glm::vec3 position((i % side - side / 2) * 0.5f, -3.0f, -(i / side) * 0.5f);
+		RenderableComponent renderable;
+		renderable.model = cube;
+		renderable.shader = colorShader;
+		renderable.pass = PASS_OPAQUE;
+		renderable.params.flags = DrawParams::EMISSION;
+		renderable.params.emission = pointLightSetups[i % NUM_LIGHTS].color;
+		scene.AddRenderable(scene.CreateEntity(ComposeTransform(position, noRotation, glm::vec3(0.1f, 0.1f, 0.1f))), renderable);
+	}
+}
+
+// Phong shading information, the same for every lit shader
+void SetLightingUniforms(Shader& shader, const PointLightInstance* lights, unsigned int lightCount)
+{
+	shader.Bind();
+
+	const LightingUniforms& u = lightingUniforms;
+	shader.SetUniform3f(u.directionalDirection, dirLightDirection);
+	shader.SetUniform3f(u.directionalAmbient, 0.2f, 0.2f, 0.2f);
+	shader.SetUniform3f(u.directionalDiffuse, 0.5f, 0.5f, 0.5f);
+	shader.SetUniform3f(u.directionalSpecular, 1.0f, 1.0f, 1.0f);
+
+	for (unsigned int i = 0; i < NUM_LIGHTS; ++i)
+	{
+		const PointLightUniforms& pointLight = u.pointLights[i];
+		// Unused slots are black, they still go through the shader's loop
+		float on = i < lightCount ? 1.0f : 0.0f;
+		PointLightComponent light = i < lightCount ? lights[i].light : PointLightComponent();
+		shader.SetUniform3f(pointLight.position, i < lightCount ? lights[i].position : glm::vec3(0.0f));
+		shader.SetUniform3f(pointLight.ambient, glm::vec3(0.2f) * on);
+		shader.SetUniform3f(pointLight.diffuse, light.color * on);
+		shader.SetUniform3f(pointLight.specular, glm::vec3(1.0f) * on);
+
+		shader.SetUniform1f(pointLight.constant, light.constant);
+		shader.SetUniform1f(pointLight.linear, light.linear);
+		shader.SetUniform1f(pointLight.quadratic, light.quadratic);
+	}
+
+	shader.SetUniform3f(u.spotDirection, camera->GetForward());
+	shader.SetUniform3f(u.spotPosition, camera->GetPosition());
+	shader.SetUniform3f(u.spotAmbient, 0.2f, 0.2f, 0.2f);
+	shader.SetUniform3f(u.spotDiffuse, 0.5f, 0.5f, 0.5f);
+	shader.SetUniform3f(u.spotSpecular, 1.0f, 1.0f, 1.0f);
+	shader.SetUniform1f(u.spotCutoff, glm::cos(glm::radians(12.5f)));
+	shader.SetUniform1f(u.spotOuterCutoff, glm::cos(glm::radians(17.5f)));
+}
+
+void SetSceneUniforms()
+{
+	PROFILE_SCOPE("SetSceneUniforms");
 	// Set Uniform buffer object data
 	glBindBuffer(GL_UNIFORM_BUFFER, uboMatrices);
 
@@ -246,240 +580,510 @@ void DrawScene()
 	glBindBuffer(GL_UNIFORM_BUFFER, 0);
 
 
-	// Phong shading information
-	basicLitShader->Bind();
-				  
-	basicLitShader->SetUniform1f("material.shininess", 32.0f);
-				  
-	basicLitShader->SetUniform3f("directionalLight.direction", dirLightDirection);
-	basicLitShader->SetUniform3f("directionalLight.ambient", 0.2f, 0.2f, 0.2f);
-	basicLitShader->SetUniform3f("directionalLight.diffuse", 0.5f, 0.5f, 0.5f);
-	basicLitShader->SetUniform3f("directionalLight.specular", 1.0f, 1.0f, 1.0f);
+	// The shaders have room for NUM_LIGHTS, the nearest ones get them
+	PointLightInstance lights[NUM_LIGHTS];
+	unsigned int lightCount = scene.GatherPointLights(camera->GetPosition(), lights, NUM_LIGHTS);
+	Shader* litShaders[] = { basicLitShader, skinnedLitShader, normalMapLitShader, skinnedNormalMapLitShader };
+	for (Shader* shader : litShaders)
+		SetLightingUniforms(*shader, lights, lightCount);
 
-	for (int i = 0; i < NUM_LIGHTS; ++i)
+	skyboxShader->Bind();
+	skyboxShader->SetUniformMat4f("projection", camera->GetProjection());
+	glm::mat4 viewNoTranslation = glm::mat4(glm::mat3(camera->GetView()));
+	skyboxShader->SetUniformMat4f("view", viewNoTranslation);
+
+	normalShader->Bind();
+	normalShader->SetUniform1f("normalLength", normalLength);
+
+	spriteShader->Bind();
+	spriteShader->SetUniform1i("diffuse", 0);
+
+	if (virtualTexture)
 	{
-		std::string iStr = std::to_string(i);
-		basicLitShader->SetUniform3f("pointLights[" + iStr + "].position", pointLightPositions[i]);
-		basicLitShader->SetUniform3f("pointLights[" + iStr + "].ambient", 0.2f, 0.2f, 0.2f);
-		basicLitShader->SetUniform3f("pointLights[" + iStr + "].diffuse", pointLightColors[i]);
-		basicLitShader->SetUniform3f("pointLights[" + iStr + "].specular", 1.0f, 1.0f, 1.0f);
-					  
-		basicLitShader->SetUniform1f("pointLights[" + iStr + "].constant", 1.0f);
-		basicLitShader->SetUniform1f("pointLights[" + iStr + "].linear", 0.09f);
-		basicLitShader->SetUniform1f("pointLights[" + iStr + "].quadratic", 0.032f);
+		virtualTexture->SetUniforms(*virtualTextureShader, false, postProcess->GetSceneWidth());
+		virtualTexture->SetUniforms(*virtualTextureFeedbackShader, true, postProcess->GetSceneWidth());
 	}
+}
 
-	basicLitShader->SetUniform3f("spotLight.direction", camera->GetForward());
-	basicLitShader->SetUniform3f("spotLight.position", camera->GetPosition());
-	basicLitShader->SetUniform3f("spotLight.ambient", 0.2f, 0.2f, 0.2f);
-	basicLitShader->SetUniform3f("spotLight.diffuse", 0.5f, 0.5f, 0.5f);
-	basicLitShader->SetUniform3f("spotLight.specular", 1.0f, 1.0f, 1.0f);
-	basicLitShader->SetUniform1f("spotLight.cutoff", glm::cos(glm::radians(12.5f)));
-	basicLitShader->SetUniform1f("spotLight.outerCutoff", glm::cos(glm::radians(17.5f)));
+// The ground again at the feedback's resolution, for the tiles the next frames need
+void DrawVirtualTextureFeedback()
+{
+	PROFILE_SCOPE("Virtual texture feedback");
+	virtualTexture->BeginFeedback();
+	virtualTextureFeedbackShader->Bind();
+	virtualTextureFeedbackShader->SetUniformMat4f("model", groundTransform);
+	cube->Draw();
+	virtualTexture->EndFeedback();
+}
 
-	if (showOutline)
+// Poses the actor for this frame. With CPU skinning the vertex buffers are rewritten, so every
+// draw of the actor this frame shows the same pose.
+void UpdateAnimation(float deltaTime)
+{
+	if (!actorAnimator)
+		return;
+	PROFILE_SCOPE("UpdateAnimation");
+	actorAnimator->Update(deltaTime);
+	if (!cpuSkinning)
+		return;
+	for (Mesh& mesh : actor->GetMeshes())
 	{
-		// Outline effect!
-		glEnable(GL_STENCIL_TEST);
-		// glStencilOp determines what to do based on when the buffer test passes
-		glStencilOp(GL_KEEP, GL_KEEP, GL_REPLACE); // if the test passes, replace value with ref below in glStencilFunc(which is 1)
-		// glStencilFunc determines when a stencil buffer test passes
-		glStencilFunc(GL_ALWAYS, 1, 0xff); // the test always passes
-		// glStencilMask's argument is ANDed with the value of the stencil buffer
-		glStencilMask(0xff); // enable the stencil buffer
+		if (!mesh.IsSkinned())
+			continue;
+		skinnedVertices.resize(mesh.m_Vertices.size());
+		SkinVertices(mesh.m_Vertices.data(), mesh.m_Weights.data(), mesh.m_Vertices.size(), actorAnimator->GetPalette(), skinnedVertices.data());
+		mesh.UpdateVertices(skinnedVertices.data());
+	}
+}
+
+void DrawScene()
+{
+	PROFILE_SCOPE("DrawScene");
+	// Matrices and bounds of anything that moved, the lights' positions come from them too
+	scene.UpdateTransforms();
+	SetSceneUniforms();
+
+	// Everything below is only recorded, the queue decides the actual draw order
+	renderQueue.Begin(camera->GetPosition(), 100.0f);
+
+	// Culling and command recording for the renderables happen on the worker threads
+	frameBuilder->Build(scene, camera->GetProjection() * camera->GetView(), renderQueue);
+
+	// Skybox - its pass comes after the opaque ones to prevent overdraw
+	{
+		DrawParams params;
+		params.textureTarget = GL_TEXTURE_CUBE_MAP;
+		params.texture = cubemap;
+		cube->Submit(renderQueue, PASS_SKYBOX, *skyboxShader, nullptr, &params);
 	}
 
-	// Draw the actor(s)
+	// Levels the view needs now, planned from the bounds UpdateTransforms() just refreshed
+	if (textureStreamer)
+		textureStreamer->Update(scene, camera->GetPosition(), glm::radians(camera->GetFOV()), (float)postProcess->GetSceneHeight(),
+			camera->GetProjection() * camera->GetView());
+
+	// Tiles requested by earlier frames' feedback are in place before anything samples them
+	if (virtualTexture)
 	{
-		glm::mat4 model(1.0f);
-		model = glm::translate(model, glm::vec3(0, -1.5f, 0));
-		model = glm::scale(model, glm::vec3(0.2f, 0.2, 0.2f));
-		basicLitShader->SetUniformMat4f("model", model);
-		basicLitShader->SetUniform1f("material.reflectivity", 0.8f);
-		actor->Draw(*basicLitShader, cubemap);
+		virtualTexture->Update();
+		virtualTexture->Bind();
+	}
 
+	renderQueue.Execute();
 
-		if (showOutline)
-		{
-			// Finish the outline effect
-			glStencilFunc(GL_NOTEQUAL, 1, 0xff);
-			glStencilMask(0x00); // No writing to stencil buffer
-			glDisable(GL_DEPTH_TEST);
-			colorShader->Bind();
-			colorShader->SetUniformMat4f("model", glm::scale(model, glm::vec3(1.02f, 1.02f, 1.02f)));
-			colorShader->SetUniform3f("emission", 0.0f, 0.0, 1.0f);
-			actor->Draw(*colorShader);
+	if (virtualTexture)
+		DrawVirtualTextureFeedback();
+}
 
-			glEnable(GL_DEPTH_TEST);
-			glStencilMask(0xff);
-		}
+// Draws the scene, through the post-processing effects if enabled, into defaultFramebuffer
+void RenderFrame()
+{
+	// First Pass, straight to the screen if no effect would change anything and the scene isn't scaled
+	postProcess->SetEffectsEnabled(usePostProcessing);
+	unsigned int sceneFramebuffer = postProcess->BeginScene(defaultFramebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, sceneFramebuffer);
+	glClearColor(clearColor.r, clearColor.g, clearColor.b, clearColor.a);
+	RenderState::Enable(GL_DEPTH_TEST);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+	DrawScene();
+
+	// Upscaling and the effects, the last pass draws into defaultFramebuffer
+	postProcess->Execute(defaultFramebuffer);
+}
+
+// Enables the comma separated effects in that order, the rest are disabled and moved behind them
+void ConfigurePostProcess(const std::string& effects)
+{
+	for (size_t i = 0; i < postProcess->GetEffectCount(); ++i)
+		postProcess->GetEffect(i).SetEnabled(false);
 
-		if (showNormals)
+	size_t position = 0;
+	std::stringstream list(effects);
+	std::string name;
+	while (std::getline(list, name, ','))
+	{
+		PostProcessEffect* effect = postProcess->FindEffect(name);
+		if (!effect)
 		{
-			normalShader->Bind();
-			normalShader->SetUniformMat4f("model", model);
-			normalShader->SetUniform1f("normalLength", normalLength);
-			actor->Draw(*normalShader);
+			std::cout << "Unknown post-process effect " << name << "\n";
+			continue;
+		}
+		effect->SetEnabled(true);
+		for (size_t i = position; i < postProcess->GetEffectCount(); ++i)
+		{
+			if (&postProcess->GetEffect(i) == effect)
+				postProcess->MoveEffect(i, position++);
 		}
 	}
+}
 
-	// Windows
-	if (drawTransparentWindows)
+struct AppOptions
+{
+	// 0 runs until the window is closed
+	int frameCount = 0;
+	bool hidden = false;
+	// Prints the heap allocations made during every frame and fails if any happen after warm-up
+	bool reportAllocations = false;
+	// GPU pass timings are written here as JSON on exit, empty skips it
+	std::string gpuProfilePath;
+	// CPU zones are written here in Chrome's trace event format on exit
+	std::string cpuTracePath;
+	// Draws into an offscreen context instead of a window, see HeadlessContext
+	bool headless = false;
+	// Plays the camera path with a fixed timestep and writes frame times and GL call counts
+	// here as JSON, empty runs the app interactively
+	std::string benchmarkPath;
+	// Camera keys for the benchmark, the built-in loop if empty
+	std::string cameraPathFile;
+	// Renders the golden image cases and compares them against the references in this directory
+	std::string goldenDirectory;
+	std::string goldenOutputDirectory = "golden_output";
+	// Replaces the reference images and timings instead of comparing against them
+	bool updateGolden = false;
+	// Records every frame to <path>_00000.png... or a .y4m stream, see FrameCapture
+	std::string capturePath;
+	CaptureFormat captureFormat = CaptureFormat::PngSequence;
+	int capturePngLevel = 0;
+	// Post-processing effects in order, comma separated, while post-processing is on
+	std::string postProcessEffects = "EdgeDetection";
+	// Of the GaussianBlur effect, in pixels
+	float blurRadius = 8.0f;
+	// Fraction of the width and height the scene is drawn at before it's upscaled
+	float renderScale = 1.0f;
+	// GPU frame time in ms the render scale adapts to, 0 keeps renderScale fixed
+	float dynamicResolutionMs = 0.0f;
+};
+
+// Everything is measured after these frames, they compile shaders and fill caches
+const int benchmarkWarmupFrames = 10;
+const float benchmarkTimestep = 1.0f / 60.0f;
+
+struct BenchmarkResults
+{
+	// Whole frame including waiting for the GPU to finish it
+	SampleStats frameMs;
+	// Up to the point the frame is handed to the GPU
+	SampleStats cpuMs;
+	SampleStats drawCalls;
+	SampleStats stateCallsIssued;
+	SampleStats stateCallsElided;
+	SampleStats programSwitches;
+	SampleStats materialSwitches;
+	SampleStats textureBinds;
+	SampleStats renderScale;
+
+	void Reserve(size_t frames)
 	{
-		glDisable(GL_CULL_FACE); // We want windows visible from both angles!
+		for (SampleStats* stats : { &frameMs, &cpuMs, &drawCalls, &stateCallsIssued, &stateCallsElided, &programSwitches, &materialSwitches, &textureBinds, &renderScale })
+			stats->Reserve(frames);
+	}
+};
 
-		spriteShader->Bind();
-		spriteShader->SetUniform1i("diffuse", 0);
-		windowTexture->Bind(0);
+void WriteStats(std::ostream& stream, const char* name, const SampleStats& stats, bool percentiles)
+{
+	stream << "  \"" << name << "\": { \"mean\": " << stats.GetMean() << ", \"min\": " << stats.GetMin();
+	if (percentiles)
+	{
+		stream << ", \"p50\": " << stats.GetPercentile(50.0) << ", \"p90\": " << stats.GetPercentile(90.0)
+			<< ", \"p95\": " << stats.GetPercentile(95.0) << ", \"p99\": " << stats.GetPercentile(99.0);
+	}
+	stream << ", \"max\": " << stats.GetMax() << " },\n";
+}
 
-		// We need to draw transparent objects from furthest away to nearest because
-		// the depth buffer can't help us here
-		std::map<float, glm::vec3> sortedWindows;
-		for (int i = 0; i < windows.size(); ++i)
-		{
-			float distance = glm::length(camera->GetPosition() - windows[i]);
-			sortedWindows[distance] = windows[i];
-		}
+void WriteBenchmarkReport(const AppOptions& options, const BenchmarkResults& results)
+{
+	std::ofstream report(options.benchmarkPath);
+	report << "{\n";
+	report << "  \"context\": \"" << (options.headless ? HeadlessContext::GetBackendName() : "GLFW") << "\",\n";
+	report << "  \"renderer\": \"" << glGetString(GL_RENDERER) << "\",\n";
+	report << "  \"version\": \"" << glGetString(GL_VERSION) << "\",\n";
+	report << "  \"width\": " << width << ",\n";
+	report << "  \"height\": " << height << ",\n";
+	report << "  \"frames\": " << results.frameMs.GetCount() << ",\n";
+	report << "  \"warmupFrames\": " << benchmarkWarmupFrames << ",\n";
+	report << "  \"timestep\": " << benchmarkTimestep << ",\n";
+	report << "  \"sceneObjects\": " << scene.GetRenderables().GetSize() << ",\n";
+	report << "  \"bindless\": " << (MaterialLibrary::IsBindless() ? "true" : "false") << ",\n";
+	WriteStats(report, "frameMs", results.frameMs, true);
+	WriteStats(report, "cpuMs", results.cpuMs, true);
+	WriteStats(report, "drawCalls", results.drawCalls, false);
+	WriteStats(report, "glStateCallsIssued", results.stateCallsIssued, false);
+	WriteStats(report, "glStateCallsElided", results.stateCallsElided, false);
+	WriteStats(report, "programSwitches", results.programSwitches, false);
+	WriteStats(report, "materialSwitches", results.materialSwitches, false);
+	WriteStats(report, "textureBinds", results.textureBinds, false);
+	WriteStats(report, "renderScale", results.renderScale, true);
+	if (dynamicResolution)
+	{
+		report << "  \"dynamicResolution\": { \"targetMs\": " << dynamicResolution->GetTargetMs()
+			<< ", \"changes\": " << dynamicResolution->GetChangeCount() << " },\n";
+	}
+	report << "  \"gpu\": ";
+	gpuProfiler->WriteJson(report);
+	report << "}\n";
+}
 
-		for (std::map<float, glm::vec3>::reverse_iterator it = sortedWindows.rbegin(); it != sortedWindows.rend(); ++it)
-		{
-			glm::mat4 model(1.0f);
-			model = glm::translate(model, it->second);
-			spriteShader->SetUniformMat4f("model", model);
-			plane->Draw(*spriteShader);
-		}
+// Canonical views for the golden image suite, every case starts from the plain scene
+struct GoldenCase
+{
+	const char* name;
+	bool outline;
+	bool normals;
+	bool windows;
+	// Post-processing effects in order, see ConfigurePostProcess(). nullptr draws straight to the screen.
+	const char* postProcess;
+	float renderScale;
+};
 
-		glEnable(GL_CULL_FACE);
+const GoldenCase goldenCases[] = {
+	{ "scene", false, false, false, nullptr, 1.0f },
+	{ "scene_outline", true, false, false, nullptr, 1.0f },
+	{ "scene_normals", false, true, false, nullptr, 1.0f },
+	{ "scene_windows", false, false, true, nullptr, 1.0f },
+	{ "scene_upscaled", false, false, false, nullptr, 0.5f },
+	{ "post_edge_detection", false, false, false, "EdgeDetection", 1.0f },
+	{ "post_blur", false, false, false, "Blur", 1.0f },
+	{ "post_sharpen", false, false, false, "Sharpen", 1.0f },
+	{ "post_grayscale", false, false, false, "Grayscale", 1.0f },
+	{ "post_inversion", false, false, false, "Inversion", 1.0f },
+	{ "post_chain", false, false, false, "Blur,Sharpen,Grayscale", 1.0f },
+	{ "post_gaussian", false, false, false, "GaussianBlur", 1.0f },
+	{ "post_wide_blur", false, false, false, "WideBlur", 1.0f }
+};
+const int goldenWarmupFrames = 3;
+const int goldenTimedFrames = 20;
 
+bool RunGoldenSuite(const AppOptions& options, GLFWwindow* window)
+{
+	GoldenSuite suite(options.goldenDirectory, options.goldenOutputDirectory, options.updateGolden);
+
+	bool savedOutline = showOutline, savedNormals = showNormals, savedWindows = drawTransparentWindows;
+	bool savedPostProcessing = usePostProcessing;
+	float savedRenderScale = postProcess->GetRenderScale();
+	// Order and on/off of every effect
+	std::string savedEffects;
+	for (size_t i = 0; i < postProcess->GetEffectCount(); ++i)
+	{
+		if (postProcess->GetEffect(i).IsEnabled())
+			savedEffects += std::string(savedEffects.empty() ? "" : ",") + postProcess->GetEffect(i).GetName();
 	}
 
+	// The start position, looking down -z at the actor
+	camera->SetPosition(glm::vec3(0.0f, 0.0f, 3.0f));
+	camera->SetYaw(0.0f);
+	camera->SetPitch(0.0f);
 
-	// Light visualizers
+	for (const GoldenCase& goldenCase : goldenCases)
 	{
-		colorShader->Bind();
-		for (int i = 0; i < NUM_LIGHTS; ++i)
+		showOutline = goldenCase.outline;
+		showNormals = goldenCase.normals;
+		drawTransparentWindows = goldenCase.windows;
+		BuildScene();
+
+		usePostProcessing = goldenCase.postProcess != nullptr;
+		if (usePostProcessing)
+			ConfigurePostProcess(goldenCase.postProcess);
+		postProcess->SetRenderScale(goldenCase.renderScale);
+		glBindFramebuffer(GL_FRAMEBUFFER, defaultFramebuffer);
+		glClearColor(clearColor.r, clearColor.g, clearColor.b, clearColor.a);
+
+		SampleStats frameMs;
+		frameMs.Reserve(goldenTimedFrames);
+		for (int i = 0; i < goldenWarmupFrames + goldenTimedFrames; ++i)
 		{
-			glm::mat4 model(1.0f);
-			model = glm::translate(model, pointLightPositions[i]);
-			model = glm::scale(model, glm::vec3(0.2f, 0.2f, 0.2f));
-			colorShader->SetUniformMat4f("model", model);
-			colorShader->SetUniform3f("emission", pointLightColors[i]);
-			cube->Draw(*colorShader);
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			frameArena.BeginFrame();
+			gpuProfiler->BeginFrame();
+			RenderState::ResetStats();
+			RenderFrame();
+			gpuProfiler->EndFrame();
+			glFinish();
+			if (i >= goldenWarmupFrames)
+				frameMs.Add(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
 		}
+
+		// Read what would have been presented, the back buffer if there's a window
+		Image image(width, height, 3);
+		glBindFramebuffer(GL_FRAMEBUFFER, defaultFramebuffer);
+		if (window)
+			glReadBuffer(GL_BACK);
+		glPixelStorei(GL_PACK_ALIGNMENT, 1);
+		glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, image.pixels.data());
+		image.FlipVertically();
+		suite.Check(goldenCase.name, image, frameMs);
 	}
 
-	// Skybox - render last to prevent overdraw
+	showOutline = savedOutline;
+	showNormals = savedNormals;
+	drawTransparentWindows = savedWindows;
+	usePostProcessing = savedPostProcessing;
+	ConfigurePostProcess(savedEffects);
+	postProcess->SetRenderScale(savedRenderScale);
+	BuildScene();
+	return suite.Finish();
+}
+
+// At the current size. Segment 0 goes to the capture path itself, the ones started after a resize
+// get _1, _2... before the extension since a stream can't change its size.
+FrameCapture* CreateFrameCapture(const AppOptions& options, unsigned int segment)
+{
+	std::string path = options.capturePath;
+	if (segment > 0)
 	{
-		glDisable(GL_CULL_FACE);
-		glDepthFunc(GL_LEQUAL);
-		skyboxShader->Bind();
-		skyboxShader->SetUniformMat4f("projection", camera->GetProjection());
-		glm::mat4 viewNoTranslation = glm::mat4(glm::mat3(camera->GetView()));
-		skyboxShader->SetUniformMat4f("view", viewNoTranslation);
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_CUBE_MAP, cubemap);
-		cube->Draw(*skyboxShader);
-		glDepthFunc(GL_LESS);
-		glEnable(GL_CULL_FACE);
+		size_t extension = path.find_last_of('.');
+		size_t directory = path.find_last_of("/\\");
+		if (extension == std::string::npos || (directory != std::string::npos && extension < directory))
+			extension = path.size();
+		path.insert(extension, "_" + std::to_string(segment));
 	}
+	FrameCapture* capture = new FrameCapture(width, height, options.captureFormat, path);
+	capture->GetEncoder().SetPngLevel(options.capturePngLevel);
+	if (!capture->GetEncoder().IsOpen())
+		std::cout << "Could not open " << path << " for capturing\n";
+	return capture;
 }
 
-int RunApp()
+GLFWwindow* CreateAppWindow(const AppOptions& options)
 {
 	GLFWwindow* window;
 
 	/* Initialize the library */
 	if (!glfwInit())
-		return -1;
+		return nullptr;
 
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
 	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+	if (options.hidden)
+		glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
 
 	/* Create a windowed mode window and its OpenGL context */
-	window = glfwCreateWindow(960, 540, "Hello World", NULL, NULL);
+	window = glfwCreateWindow(width, height, "Hello World", NULL, NULL);
 	if (!window)
 	{
 		glfwTerminate();
-		return -1;
+		return nullptr;
 	}
 
 	/* Make the window's context current */
 	glfwMakeContextCurrent(window);
 	glfwSwapInterval(0);
 
-	glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
-	glfwSetCursorPosCallback(window, MouseCallback);
-	glfwSetScrollCallback(window, ScrollCallback);
+	// Not the window size on high DPI displays
+	glfwGetFramebufferSize(window, &width, &height);
+	glfwSetFramebufferSizeCallback(window, FramebufferSizeCallback);
+
+	// Benchmarks are driven by the camera path alone
+	if (options.benchmarkPath.empty())
+	{
+		glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+		glfwSetCursorPosCallback(window, MouseCallback);
+		glfwSetScrollCallback(window, ScrollCallback);
+		glfwSetKeyCallback(window, KeyCallback);
+	}
 
 	// OpenGL context must have been created before initializing GLEW!
 	if (glewInit() != GLEW_OK)
 		std::cout << "Error!\n";
+	return window;
+}
+
+int RunApp(const AppOptions& options)
+{
+	PROFILE_THREAD_NAME("Main");
+	GLFWwindow* window = nullptr;
+	HeadlessContext headlessContext;
+	if (options.headless)
+	{
+		if (!headlessContext.Create(width, height))
+			return -1;
+		defaultFramebuffer = headlessContext.GetFramebuffer();
+	}
+	else
+	{
+		window = CreateAppWindow(options);
+		if (!window)
+			return -1;
+	}
+	bool benchmarking = !options.benchmarkPath.empty();
 
 	glEnable(GL_DEBUG_OUTPUT);
 	glDebugMessageCallback(MessageCallback, 0);
 
 	std::cout << glGetString(GL_VERSION) << "\n";
 
-	glEnable(GL_DEPTH_TEST);
+	RenderState::Invalidate();
 
-	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-	glEnable(GL_BLEND);
+	RenderState::Enable(GL_DEPTH_TEST);
 
+	RenderState::BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	RenderState::Enable(GL_BLEND);
 
-	glEnable(GL_CULL_FACE);
 
-	// Frame buffer
-	glGenFramebuffers(1, &fbo);
-	glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+	RenderState::Enable(GL_CULL_FACE);
 
-	// Create an empty texture and attach it to the frame buffer as a color buffer
-	glGenTextures(1, &fboColorBuffer);
-	glBindTexture(GL_TEXTURE_2D, fboColorBuffer);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, nullptr);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, fboColorBuffer, 0);
-
-	// Render buffers - like textures but faster (and write-only)
-	// Create a render buffer and attach it as a combo depth/stencil buffer
-	glGenRenderbuffers(1, &rbo);
-	glBindRenderbuffer(GL_RENDERBUFFER, rbo);
-	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
-	glBindRenderbuffer(GL_RENDERBUFFER, 0);
-	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, rbo);
-
-	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+	// Create the fullscreen quad resources
+	screenQuad = new Mesh(quadVertices, quadIndices, MaterialLibrary::NO_MATERIAL);
+
+	// Post-processing, render targets are created on first use
+	postProcess = new PostProcessGraph(*screenQuad, width, height);
+	postProcess->AddEffect(std::unique_ptr<PostProcessEffect>(new ShaderEffect("EdgeDetection", "res/shaders/EdgeDetection.fs")));
+	postProcess->AddEffect(std::unique_ptr<PostProcessEffect>(new ShaderEffect("Blur", "res/shaders/Blur.fs")));
+	postProcess->AddEffect(std::unique_ptr<PostProcessEffect>(new ShaderEffect("Sharpen", "res/shaders/Sharpen.fs")));
+	postProcess->AddEffect(std::unique_ptr<PostProcessEffect>(new ShaderEffect("Grayscale", "res/shaders/Grayscale.fs")));
+	postProcess->AddEffect(std::unique_ptr<PostProcessEffect>(new ShaderEffect("Inversion", "res/shaders/Inversion.fs")));
+	postProcess->AddEffect(std::unique_ptr<PostProcessEffect>(new GaussianBlurEffect("GaussianBlur", options.blurRadius)));
+	// Far past the separable range, always takes the pyramid
+	postProcess->AddEffect(std::unique_ptr<PostProcessEffect>(new GaussianBlurEffect("WideBlur", 48.0f)));
+	ConfigurePostProcess(options.postProcessEffects);
+	postProcess->SetRenderScale(options.renderScale);
+	if (options.dynamicResolutionMs > 0.0f)
 	{
-		std::cout << "ERROR::FRAMEBUFFER:: Framebuffer is not complete";
-		return -1;
+		dynamicResolution = new DynamicResolution(options.dynamicResolutionMs, PostProcessGraph::MIN_RENDER_SCALE * 2.0f, 1.0f, GpuProfiler::FRAME_LATENCY);
+		postProcess->ReserveSceneTarget();
 	}
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
-
-	// Create the fullscreen quad resources
-	screenQuad = new Mesh(quadVertices, quadIndices, std::vector<Texture*>());
 
 	cubemap = loadCubemap(cubeMapPaths);
 
 
-	basicLitShader = new Shader("res/shaders/BasicLit.vs", "res/shaders/BasicLit.fs");
+	std::string litDefines = useTextureArrays ? "#define TEXTURE_ARRAY\n" : "";
+	if (useBindless && !MaterialLibrary::EnableBindless())
+		std::cout << "ARB_bindless_texture or GL 4.0 isn't supported, binding textures to units\n";
+	// The extension isn't allowed in a 330 shader
+	if (MaterialLibrary::IsBindless())
+		litDefines += "#version 400 core\n#define BINDLESS\n";
+	basicLitShader = new Shader("res/shaders/BasicLit.vs", "res/shaders/BasicLit.fs", "", litDefines);
 	colorShader = new Shader("res/shaders/BasicLit.vs", "res/shaders/Color.fs");
 	spriteShader = new Shader("res/shaders/BasicLit.vs", "res/shaders/Sprite.fs");
-	postProcessShader = new Shader("res/shaders/PostProcess.vs", "res/shaders/EdgeDetection.fs");
 	skyboxShader = new Shader("res/shaders/Skybox.vs", "res/shaders/Skybox.fs");
 	// This one uses a geometry shader
 	normalShader = new Shader("res/shaders/Normals.vs", "res/shaders/Normals.fs", "res/shaders/Normals.gs");
+	skinnedLitShader = new Shader("res/shaders/BasicLitSkinned.vs", "res/shaders/BasicLit.fs", "", litDefines);
+	skinnedColorShader = new Shader("res/shaders/BasicLitSkinned.vs", "res/shaders/Color.fs");
+	std::string normalMapDefines = litDefines + (packTangentFrames ? "#define NORMAL_MAP\n#define PACKED_TANGENT_FRAME\n" : "#define NORMAL_MAP\n");
+	normalMapLitShader = new Shader("res/shaders/BasicLit.vs", "res/shaders/BasicLit.fs", "", normalMapDefines);
+	skinnedNormalMapLitShader = new Shader("res/shaders/BasicLitSkinned.vs", "res/shaders/BasicLit.fs", "", normalMapDefines);
 
 	// Uniform Buffer Object Setup
 	unsigned int ubiBasicLit = glGetUniformBlockIndex(basicLitShader->GetID(), "Matrices");
 	unsigned int ubiColor = glGetUniformBlockIndex(colorShader->GetID(), "Matrices");
 	unsigned int ubiSprite = glGetUniformBlockIndex(spriteShader->GetID(), "Matrices");
 	unsigned int ubiNormal = glGetUniformBlockIndex(normalShader->GetID(), "Matrices");
+	unsigned int ubiSkinnedLit = glGetUniformBlockIndex(skinnedLitShader->GetID(), "Matrices");
+	unsigned int ubiSkinnedColor = glGetUniformBlockIndex(skinnedColorShader->GetID(), "Matrices");
+	unsigned int ubiNormalMapLit = glGetUniformBlockIndex(normalMapLitShader->GetID(), "Matrices");
+	unsigned int ubiSkinnedNormalMapLit = glGetUniformBlockIndex(skinnedNormalMapLitShader->GetID(), "Matrices");
 
 	glUniformBlockBinding(basicLitShader->GetID(), ubiBasicLit, 0);
 	glUniformBlockBinding(colorShader->GetID(), ubiColor, 0);
 	glUniformBlockBinding(spriteShader->GetID(), ubiSprite, 0);
 	glUniformBlockBinding(normalShader->GetID(), ubiNormal, 0);
+	glUniformBlockBinding(skinnedLitShader->GetID(), ubiSkinnedLit, 0);
+	glUniformBlockBinding(skinnedColorShader->GetID(), ubiSkinnedColor, 0);
+	glUniformBlockBinding(normalMapLitShader->GetID(), ubiNormalMapLit, 0);
+	glUniformBlockBinding(skinnedNormalMapLitShader->GetID(), ubiSkinnedNormalMapLit, 0);
+	for (Shader* shader : { basicLitShader, skinnedLitShader, normalMapLitShader, skinnedNormalMapLitShader })
+		MaterialLibrary::SetupShader(*shader);
 
 
 	glGenBuffers(1, &uboMatrices);
@@ -491,63 +1095,496 @@ int RunApp()
 	glBindBufferRange(GL_UNIFORM_BUFFER, 0, uboMatrices, 0, 2 * sizeof(glm::mat4));
 
 
-	actor = new Model("res/models/nanosuit/nanosuit.obj");
+	// Bindless handles would pin the base level, and arrays are loaded whole
+	if (streamMips && (MaterialLibrary::IsBindless() || useTextureArrays))
+		std::cout << "Mip streaming doesn't work with bindless textures or texture arrays, loading the maps whole\n";
+	else if (streamMips)
+		textureStreamer = new TextureStreamer((uint64_t)(textureBudgetMB * 1024.0f * 1024.0f));
+
+	ModelSettings actorSettings;
+	actorSettings.packTangentFrames = packTangentFrames;
+	actorSettings.textureArrays = useTextureArrays;
+	actorSettings.mipStreamer = textureStreamer;
+	actor = new Model(actorPath.c_str(), actorSettings);
+	std::cout << "Actor: " << actor->GetImportedMeshCount() << " meshes, " << actor->GetMeshes().size() << " draws, "
+		<< actor->GetMaterials().size() << " materials in " << MaterialLibrary::GetCount() - 1 << " distinct\n";
+	// Nothing in an OBJ says how much of the skybox the suit reflects
+	for (unsigned int material : actor->GetMaterials())
+	{
+		MaterialParameters parameters = MaterialLibrary::Get(material).parameters;
+		parameters.reflectivity = 0.8f;
+		MaterialLibrary::SetParameters(material, parameters);
+	}
+	if (actor->IsSkinned())
+	{
+		actorAnimator = new Animator(actor->GetSkeleton());
+		if (!actor->GetClips().empty() && compressAnimations)
+		{
+			actorClip = new CompressedClip(CompressedClip::Compress(actor->GetClips()[0], actor->GetSkeleton()));
+			std::cout << "Compressed clip '" << actorClip->GetName() << "' from " << actor->GetClips()[0].GetMemoryUsage()
+				<< " to " << actorClip->GetMemoryUsage() << " bytes\n";
+			actorAnimator->SetClip(0, actorClip);
+		}
+		else if (!actor->GetClips().empty())
+		{
+			actorAnimator->SetClip(0, &actor->GetClips()[0]);
+		}
+		// The first frame's pose, golden runs don't advance time
+		UpdateAnimation(0.0f);
+	}
 	cube = new Model("res/models/cube/cube.obj");
 	plane = new Model("res/models/plane/plane.obj");
 
 	windowTexture = new Texture("res/textures/blending_transparent_window.png", aiTextureType_DIFFUSE);
 
+	if (!virtualTexturePath.empty())
+	{
+		virtualTexture = new VirtualTexture(virtualTexturePath);
+		if (virtualTexture->IsValid())
+		{
+			virtualTextureShader = new Shader("res/shaders/BasicLit.vs", "res/shaders/VirtualTexture.fs");
+			virtualTextureFeedbackShader = new Shader("res/shaders/BasicLit.vs", "res/shaders/VirtualTexture.fs", "", "#define FEEDBACK\n");
+			for (Shader* shader : { virtualTextureShader, virtualTextureFeedbackShader })
+				glUniformBlockBinding(shader->GetID(), glGetUniformBlockIndex(shader->GetID(), "Matrices"), 0);
+		}
+		else
+		{
+			delete virtualTexture;
+			virtualTexture = nullptr;
+		}
+	}
+
 	camera = new Camera(glm::vec3(0, 0, 3), 2.5f, width, height);
 
-	while (!glfwWindowShouldClose(window))
+	// The render thread helps out while it waits, so leave it a core
+	unsigned int hardwareThreads = std::thread::hardware_concurrency();
+	jobSystem = new JobSystem(hardwareThreads > 1 ? hardwareThreads - 1 : 0);
+	frameBuilder = new FrameBuilder(*jobSystem);
+	BuildScene();
+
+	gpuProfiler = new GpuProfiler();
+	renderQueue.SetProfiler(gpuProfiler);
+	postProcess->SetProfiler(gpuProfiler);
+
+	// Render queue passes
 	{
+		// Outline effect!
+		PassState stencil;
+		stencil.stencilTest = true;
+		// glStencilOp determines what to do based on when the buffer test passes
+		stencil.stencilDepthPass = GL_REPLACE; // if the test passes, replace value with ref below in glStencilFunc(which is 1)
+		// glStencilFunc determines when a stencil buffer test passes
+		stencil.stencilFunc = GL_ALWAYS; // the test always passes
+		stencil.stencilRef = 1;
+		// glStencilMask's argument is ANDed with the value of the stencil buffer
+		stencil.stencilWriteMask = 0xff; // enable the stencil buffer
+		stencil.name = "Stencil";
+		renderQueue.SetPassState(PASS_STENCIL, stencil);
+
+		// Finish the outline effect
+		PassState outline;
+		outline.depthTest = false;
+		outline.stencilTest = true;
+		outline.stencilFunc = GL_NOTEQUAL;
+		outline.stencilRef = 1;
+		outline.stencilWriteMask = 0x00; // No writing to stencil buffer
+		outline.name = "Outline";
+		renderQueue.SetPassState(PASS_OUTLINE, outline);
+
+		PassState opaque;
+		opaque.name = "Scene";
+		renderQueue.SetPassState(PASS_OPAQUE, opaque);
+
+		PassState normals;
+		normals.name = "Normals";
+		renderQueue.SetPassState(PASS_NORMALS, normals);
+
+		PassState skybox;
+		skybox.cullFace = false;
+		skybox.depthFunc = GL_LEQUAL;
+		skybox.name = "Skybox";
+		renderQueue.SetPassState(PASS_SKYBOX, skybox);
+
+		PassState transparent;
+		transparent.cullFace = false; // We want windows visible from both angles!
+		transparent.translucent = true;
+		transparent.name = "Transparent";
+		renderQueue.SetPassState(PASS_TRANSPARENT, transparent);
+	}
+
+	int result = 0;
+	bool goldenRun = !options.goldenDirectory.empty();
+	if (goldenRun && !RunGoldenSuite(options, window))
+		result = 1;
+
+	// Frames that may still grow containers and caches before allocations are counted against us
+	const int allocationWarmupFrames = 5;
+	int steadyStateAllocations = 0;
+
+	CameraPath cameraPath;
+	BenchmarkResults benchmarkResults;
+	if (benchmarking)
+	{
+		if (options.cameraPathFile.empty() || !CameraPath::LoadFromFile(options.cameraPathFile, cameraPath))
+		{
+			if (!options.cameraPathFile.empty())
+				std::cout << "Could not load camera path " << options.cameraPathFile << ", using the default one\n";
+			cameraPath = CameraPath::Default();
+		}
+		benchmarkResults.Reserve(options.frameCount);
+	}
+	// Without a window there's no GLFW timer, and benchmarks have to be repeatable anyway
+	bool fixedTimestep = benchmarking || !window;
+
+	FrameCapture* frameCapture = nullptr;
+	unsigned int captureSegment = 0;
+	if (!goldenRun && !options.capturePath.empty())
+		frameCapture = CreateFrameCapture(options, captureSegment);
+
+	float lastStatsLog = 0.0f;
+	unsigned int measuredFrames = 0;
+	int frame = 0;
+	while (!goldenRun && (!window || !glfwWindowShouldClose(window)) && (options.frameCount == 0 || frame < options.frameCount))
+	{
+		PROFILE_SCOPE("Frame");
+		std::chrono::steady_clock::time_point frameStart = std::chrono::steady_clock::now();
+		size_t allocationsBefore = AllocationCounter::GetAllocationCount();
+		frameArena.BeginFrame();
+		gpuProfiler->BeginFrame();
 
-		ProcessInput(window);
+		if (window && !benchmarking)
+			ProcessInput(window);
 
-		float currentFrame = glfwGetTime();
+		float currentFrame = fixedTimestep ? frame * benchmarkTimestep : (float)glfwGetTime();
 		deltaTime = currentFrame - lastFrame;
 		lastFrame = currentFrame;
+		if (benchmarking)
+			cameraPath.Apply(*camera, currentFrame);
 
-		// First Pass
-		if (usePostProcessing)
+		if (logRenderStats && currentFrame - lastStatsLog >= 1.0f)
 		{
-			glBindFramebuffer(GL_FRAMEBUFFER, fbo);
-			glClearColor(clearColor.r, clearColor.g, clearColor.b, clearColor.a);
-			glEnable(GL_DEPTH_TEST);
+			// Stats of the previous frame
+			const RenderStateStats& stats = RenderState::GetStats();
+			const RenderQueueStats& queueStats = renderQueue.GetStats();
+			std::stringstream line;
+			line << "visible " << frameBuilder->GetStats().visible << " | culled " << frameBuilder->GetStats().culled
+				<< " | draws " << queueStats.draws << " | post passes " << postProcess->GetStats().passes
+				<< " | scene " << postProcess->GetSceneWidth() << "x" << postProcess->GetSceneHeight()
+				<< " | program switches " << queueStats.programSwitches << " | material switches " << queueStats.materialSwitches << " | texture binds " << queueStats.textureBinds << " | GL state calls " << stats.TotalIssued()
+				<< " issued, " << stats.TotalElided() << " elided";
+			std::cout << line.str() << "\n";
+			std::cout << gpuProfiler->GetSummary() << "\n";
+			if (virtualTexture)
+				std::cout << virtualTexture->GetSummary() << "\n";
+			if (textureStreamer)
+				std::cout << textureStreamer->GetSummary() << "\n";
+			if (window)
+				glfwSetWindowTitle(window, line.str().c_str());
+			lastStatsLog = currentFrame;
 		}
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
-		DrawScene();
+		RenderState::ResetStats();
 
-		if (usePostProcessing)
+		if (resizePending)
+			ApplyPendingResize(currentFrame);
+		if (trimPending && currentFrame - lastResizeTime >= resizeSettleSeconds)
+		{
+			postProcess->Trim();
+			if (dynamicResolution)
+				postProcess->ReserveSceneTarget();
+			trimPending = false;
+			std::cout << "Resized to " << width << "x" << height << ", " << postProcess->GetStats().reallocations
+				<< " render target reallocations so far\n";
+			if (frameCapture && (frameCapture->GetWidth() != width || frameCapture->GetHeight() != height))
+			{
+				frameCapture->Finish();
+				std::cout << frameCapture->GetSummary();
+				delete frameCapture;
+				frameCapture = CreateFrameCapture(options, ++captureSegment);
+			}
+		}
+
+		// Only once per measured frame, the same one would otherwise be counted several times
+		if (dynamicResolution && gpuProfiler->GetFramesMeasured() != measuredFrames)
 		{
-			// Second Pass
-			glBindFramebuffer(GL_FRAMEBUFFER, 0); // use the regular frame buffer now
-			glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
-			glClear(GL_COLOR_BUFFER_BIT); // As we're just rendering a quad, color is the only thing that needs to be cleared!
-			postProcessShader->Bind();
-			glDisable(GL_DEPTH_TEST);
-			glActiveTexture(GL_TEXTURE0);
-			glBindTexture(GL_TEXTURE_2D, fboColorBuffer);
-			screenQuad->Draw(*postProcessShader, 0);
+			measuredFrames = gpuProfiler->GetFramesMeasured();
+			postProcess->SetRenderScale(dynamicResolution->Update(gpuProfiler->GetLastFrameMs()));
 		}
 
+		UpdateAnimation(deltaTime);
+		RenderFrame();
+		if (frameCapture && frameCapture->GetWidth() == width && frameCapture->GetHeight() == height)
+		{
+			frameCapture->Capture(defaultFramebuffer);
+		}
+		else if (frameCapture)
+		{
+			// Until the resize settles and the next segment starts
+			if (frameCapture->GetStats().skipped == 0)
+				std::cout << "Capture: the window is " << width << "x" << height << ", not " << frameCapture->GetWidth()
+					<< "x" << frameCapture->GetHeight() << ", skipping frames until it's done resizing\n";
+			frameCapture->Skip();
+		}
 
+		gpuProfiler->EndFrame();
+		std::chrono::steady_clock::time_point submitted = std::chrono::steady_clock::now();
 
 		/* Swap front and back buffers */
-		glfwSwapBuffers(window);
+		if (window)
+		{
+			PROFILE_SCOPE("SwapBuffers");
+			glfwSwapBuffers(window);
+		}
 
 		/* Poll for and process events */
-		glfwPollEvents();
+		if (window)
+			glfwPollEvents();
+
+		if (benchmarking && frame >= benchmarkWarmupFrames)
+		{
+			// Wait for the GPU so its share of the frame is measured too, not just queued up
+			glFinish();
+			std::chrono::steady_clock::time_point finished = std::chrono::steady_clock::now();
+			const RenderStateStats& stats = RenderState::GetStats();
+			const RenderQueueStats& queueStats = renderQueue.GetStats();
+			benchmarkResults.frameMs.Add(std::chrono::duration<double, std::milli>(finished - frameStart).count());
+			benchmarkResults.cpuMs.Add(std::chrono::duration<double, std::milli>(submitted - frameStart).count());
+			benchmarkResults.drawCalls.Add(queueStats.draws + postProcess->GetStats().passes);
+			benchmarkResults.stateCallsIssued.Add(stats.TotalIssued());
+			benchmarkResults.stateCallsElided.Add(stats.TotalElided());
+			benchmarkResults.programSwitches.Add(queueStats.programSwitches);
+			benchmarkResults.materialSwitches.Add(queueStats.materialSwitches);
+			benchmarkResults.textureBinds.Add(queueStats.textureBinds);
+			benchmarkResults.renderScale.Add(postProcess->GetRenderScale());
+		}
+
+		if (options.reportAllocations)
+		{
+			size_t allocations = AllocationCounter::GetAllocationCount() - allocationsBefore;
+			std::cout << "frame " << frame << ": " << allocations << " heap allocations, "
+				<< frameArena.GetBytesAllocated() << " bytes from the frame arena\n";
+			if (frame >= allocationWarmupFrames)
+				steadyStateAllocations += (int)allocations;
+		}
+		++frame;
+	}
+	if (frameCapture)
+	{
+		frameCapture->Finish();
+		std::cout << frameCapture->GetSummary();
+		delete frameCapture;
+	}
+	if (benchmarking)
+		WriteBenchmarkReport(options, benchmarkResults);
+	if (!options.gpuProfilePath.empty())
+	{
+		std::ofstream profile(options.gpuProfilePath);
+		gpuProfiler->WriteJson(profile);
 	}
+
 	delete camera;
+	renderQueue.SetProfiler(nullptr);
+	postProcess->SetProfiler(nullptr);
+	delete gpuProfiler;
+	delete frameBuilder;
+	delete jobSystem;
+
+	// The workers are gone, so every thread's zones are final
+	if (!options.cpuTracePath.empty())
+	{
+		std::ofstream trace(options.cpuTracePath);
+		CpuProfiler::WriteChromeTrace(trace);
+	}
 
 	// TODO delete all buffers and heap allocated memory!
-	glDeleteFramebuffers(1, &fbo);
+	delete postProcess;
+	delete dynamicResolution;
+	delete virtualTexture;
+	delete textureStreamer;
+
+	if (options.reportAllocations)
+	{
+		if (!AllocationCounter::IsEnabled())
+		{
+			std::cout << "Allocation counting is disabled in this build\n";
+		}
+		else if (steadyStateAllocations > 0)
+		{
+			std::cout << steadyStateAllocations << " heap allocations after " << allocationWarmupFrames << " warm-up frames\n";
+			return 1;
+		}
+	}
+	return result;
 }
 
-int main(void)
+int main(int argc, char** argv)
 {
-	int result = RunApp();
+	AppOptions options;
+	for (int i = 1; i < argc; ++i)
+	{
+		std::string arg = argv[i];
+		if (arg == "--frames" && i + 1 < argc)
+		{
+			options.frameCount = std::atoi(argv[++i]);
+		}
+		else if (arg == "--report-allocations")
+		{
+			options.reportAllocations = true;
+			options.hidden = true;
+			if (options.frameCount == 0)
+				options.frameCount = 100;
+		}
+		else if (arg == "--hidden")
+		{
+			options.hidden = true;
+		}
+		else if (arg == "--log-stats")
+		{
+			logRenderStats = true;
+		}
+		else if (arg == "--gpu-profile" && i + 1 < argc)
+		{
+			options.gpuProfilePath = argv[++i];
+		}
+		else if (arg == "--cpu-trace" && i + 1 < argc)
+		{
+			options.cpuTracePath = argv[++i];
+		}
+		else if (arg == "--headless")
+		{
+			options.headless = true;
+		}
+		else if (arg == "--benchmark" && i + 1 < argc)
+		{
+			options.benchmarkPath = argv[++i];
+			options.hidden = true;
+		}
+		else if (arg == "--camera-path" && i + 1 < argc)
+		{
+			options.cameraPathFile = argv[++i];
+		}
+		else if (arg == "--golden" && i + 1 < argc)
+		{
+			// Software GL in CI, a hidden window where there's no headless backend
+			options.goldenDirectory = argv[++i];
+			options.headless = HeadlessContext::IsAvailable();
+			options.hidden = true;
+		}
+		else if (arg == "--golden-output" && i + 1 < argc)
+		{
+			options.goldenOutputDirectory = argv[++i];
+		}
+		else if (arg == "--update-golden")
+		{
+			options.updateGolden = true;
+		}
+		else if (arg == "--capture" && i + 1 < argc)
+		{
+			options.capturePath = argv[++i];
+		}
+		else if (arg == "--capture-format" && i + 1 < argc)
+		{
+			std::string format = argv[++i];
+			if (format == "y4m")
+			{
+				options.captureFormat = CaptureFormat::Y4m;
+			}
+			else
+			{
+				// png, png1... picks the compression level, plain png is the fastest
+				options.captureFormat = CaptureFormat::PngSequence;
+				options.capturePngLevel = format.size() > 3 ? std::atoi(format.c_str() + 3) : 0;
+			}
+		}
+		else if (arg == "--size" && i + 1 < argc)
+		{
+			// WxH, e.g. 1920x1080
+			std::string size = argv[++i];
+			size_t separator = size.find('x');
+			if (separator != std::string::npos)
+			{
+				width = std::atoi(size.c_str());
+				height = std::atoi(size.c_str() + separator + 1);
+			}
+		}
+		else if (arg == "--post-process" && i + 1 < argc)
+		{
+			// e.g. Blur,Sharpen,Grayscale
+			options.postProcessEffects = argv[++i];
+			usePostProcessing = true;
+		}
+		else if (arg == "--blur-radius" && i + 1 < argc)
+		{
+			options.blurRadius = (float)std::atof(argv[++i]);
+		}
+		else if (arg == "--render-scale" && i + 1 < argc)
+		{
+			options.renderScale = (float)std::atof(argv[++i]);
+		}
+		else if (arg == "--dynamic-resolution" && i + 1 < argc)
+		{
+			// GPU frame time budget in ms, e.g. 16.6
+			options.dynamicResolutionMs = (float)std::atof(argv[++i]);
+		}
+		else if (arg == "--stress-cubes" && i + 1 < argc)
+		{
+			stressCubeCount = std::atoi(argv[++i]);
+		}
+		else if (arg == "--actor" && i + 1 < argc)
+		{
+			// Any model assimp reads, skinned ones are animated
+			actorPath = argv[++i];
+		}
+		else if (arg == "--cpu-skinning")
+		{
+			cpuSkinning = true;
+		}
+		else if (arg == "--compress-animations")
+		{
+			compressAnimations = true;
+		}
+		else if (arg == "--no-normal-maps")
+		{
+			useNormalMaps = false;
+		}
+		else if (arg == "--pack-tangents")
+		{
+			// Normal and tangent as one quaternion, 8 bytes of tangent stream per vertex instead of 16
+			packTangentFrames = true;
+		}
+		else if (arg == "--texture-arrays")
+		{
+			useTextureArrays = true;
+		}
+		else if (arg == "--bindless")
+		{
+			useBindless = true;
+		}
+		else if (arg == "--stream-mips")
+		{
+			streamMips = true;
+		}
+		else if (arg == "--texture-budget" && i + 1 < argc)
+		{
+			// MB for all streamed levels together, implies --stream-mips
+			textureBudgetMB = (float)std::atof(argv[++i]);
+			streamMips = true;
+		}
+		else if (arg == "--virtual-texture" && i + 1 < argc)
+		{
+			// Made with AssetTool vt
+			virtualTexturePath = argv[++i];
+		}
+		else
+		{
+			std::cout << "Unknown argument " << arg << "\n";
+		}
+	}
+
+	// Neither a benchmark nor a window nobody can close should run forever
+	if (options.frameCount == 0 && (options.headless || !options.benchmarkPath.empty()))
+		options.frameCount = 600;
+
+	int result = RunApp(options);
 	glfwTerminate();
 	return result;
 }
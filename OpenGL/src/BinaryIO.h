@@ -0,0 +1,36 @@
+#pragma once
+#include <cstdint>
+#include <fstream>
+#include <vector>
+
+// Raw values in native byte order, for the binary asset formats (.clip, .vtex, .mips). Only for
+// trivially copyable types.
+template <typename T>
+void Write(std::ofstream& file, const T& value)
+{
+	file.write((const char*)&value, sizeof(T));
+}
+
+// A uint32 count, then the elements
+template <typename T>
+void WriteArray(std::ofstream& file, const std::vector<T>& values)
+{
+	Write(file, (uint32_t)values.size());
+	file.write((const char*)values.data(), values.size() * sizeof(T));
+}
+
+template <typename T>
+bool Read(std::ifstream& file, T& value)
+{
+	return (bool)file.read((char*)&value, sizeof(T));
+}
+
+template <typename T>
+bool ReadArray(std::ifstream& file, std::vector<T>& values)
+{
+	uint32_t count;
+	if (!Read(file, count))
+		return false;
+	values.resize(count);
+	return (bool)file.read((char*)values.data(), count * sizeof(T));
+}
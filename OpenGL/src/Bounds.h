@@ -0,0 +1,41 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <cfloat>
+
+// Axis aligned bounding box
+struct Bounds {
+	glm::vec3 min = glm::vec3(FLT_MAX);
+	glm::vec3 max = glm::vec3(-FLT_MAX);
+
+	bool IsValid() const { return min.x <= max.x; }
+	glm::vec3 GetCenter() const { return (min + max) * 0.5f; }
+	glm::vec3 GetExtents() const { return (max - min) * 0.5f; }
+
+	void Expand(const glm::vec3& point)
+	{
+		min = glm::min(min, point);
+		max = glm::max(max, point);
+	}
+
+	void Expand(const Bounds& other)
+	{
+		min = glm::min(min, other.min);
+		max = glm::max(max, other.max);
+	}
+
+	// Box around the transformed box, transforms the center and projects the extents (Arvo)
+	Bounds Transformed(const glm::mat4& transform) const
+	{
+		glm::vec3 center = glm::vec3(transform * glm::vec4(GetCenter(), 1.0f));
+		glm::vec3 extents = GetExtents();
+		glm::vec3 newExtents(
+			glm::abs(transform[0][0]) * extents.x + glm::abs(transform[1][0]) * extents.y + glm::abs(transform[2][0]) * extents.z,
+			glm::abs(transform[0][1]) * extents.x + glm::abs(transform[1][1]) * extents.y + glm::abs(transform[2][1]) * extents.z,
+			glm::abs(transform[0][2]) * extents.x + glm::abs(transform[1][2]) * extents.y + glm::abs(transform[2][2]) * extents.z
+		);
+		Bounds result;
+		result.min = center - newExtents;
+		result.max = center + newExtents;
+		return result;
+	}
+};
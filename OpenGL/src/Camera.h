@@ -27,7 +27,7 @@ public:
 	glm::mat4 GetView() { return m_View; }
 
 	glm::vec3 GetPosition() { return m_Position; }
-	glm::vec3 SetPosition(glm::vec3 pos) 
+	void SetPosition(glm::vec3 pos) 
 	{ 
 		m_Position = pos; 
 		RecalculateDirection(); 
@@ -64,12 +64,22 @@ public:
 
 	void RecalculateDirection()
 	{
-		glm::quat q(glm::vec3(glm::radians(m_Pitch), glm::radians(m_Yaw), 0.0f));
-		m_Forward = glm::normalize(q * glm::vec3(0, 0, -1.0f));
-		m_Up = glm::normalize(q * glm::vec3(0, 1.0f, 0));
+		// Yaw around the world up, then pitch around the turned right axis
+		glm::mat4 rotation = glm::rotate(glm::mat4(1.0f), glm::radians(m_Yaw), glm::vec3(0, 1.0f, 0));
+		rotation = glm::rotate(rotation, glm::radians(m_Pitch), glm::vec3(1.0f, 0, 0));
+		m_Forward = glm::normalize(glm::vec3(rotation * glm::vec4(0, 0, -1.0f, 0)));
+		m_Up = glm::normalize(glm::vec3(rotation * glm::vec4(0, 1.0f, 0, 0)));
 		m_View = glm::lookAt(m_Position, m_Position + m_Forward, m_Up);
 	}
 
+	// Framebuffer size, only the aspect ratio matters
+	void SetViewportSize(int width, int height)
+	{
+		m_Width = width;
+		m_Height = height;
+		RecalculateProjection();
+	}
+
 	void RecalculateProjection()
 	{
 		m_Projection = glm::perspective(glm::radians(m_Fov), (float)m_Width / m_Height, 0.01f, 100.0f);
@@ -0,0 +1,107 @@
+#include "CameraPath.h"
+#include <glm/gtc/constants.hpp>
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+
+namespace
+{
+	glm::vec3 CatmullRom(const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& p2, const glm::vec3& p3, float t)
+	{
+		float t2 = t * t;
+		float t3 = t2 * t;
+		return 0.5f * ((2.0f * p1) + (p2 - p0) * t +
+			(2.0f * p0 - 5.0f * p1 + 4.0f * p2 - p3) * t2 +
+			(3.0f * p1 - p0 - 3.0f * p2 + p3) * t3);
+	}
+}
+
+CameraPath::CameraPath(std::vector<CameraKey> keys) :
+	m_Keys(std::move(keys))
+{
+	std::stable_sort(m_Keys.begin(), m_Keys.end(), [](const CameraKey& a, const CameraKey& b) { return a.time < b.time; });
+}
+
+bool CameraPath::LoadFromFile(const std::string& path, CameraPath& result)
+{
+	std::ifstream file(path);
+	if (!file)
+		return false;
+
+	std::vector<CameraKey> keys;
+	std::string line;
+	while (std::getline(file, line))
+	{
+		size_t comment = line.find('#');
+		if (comment != std::string::npos)
+			line.erase(comment);
+		std::stringstream stream(line);
+		CameraKey key;
+		if (stream >> key.time >> key.position.x >> key.position.y >> key.position.z >> key.yaw >> key.pitch)
+			keys.push_back(key);
+	}
+	if (keys.empty())
+		return false;
+	result = CameraPath(std::move(keys));
+	return true;
+}
+
+CameraPath CameraPath::Default()
+{
+	// Circles the actor at the origin while looking at it, then swings past the windows
+	std::vector<CameraKey> keys;
+	const int steps = 8;
+	const float radius = 4.0f;
+	for (int i = 0; i <= steps; ++i)
+	{
+		float angle = glm::two_pi<float>() * i / steps;
+		CameraKey key;
+		key.time = 1.5f * i;
+		key.position = glm::vec3(radius * std::sin(angle), 0.5f + 0.5f * std::sin(2.0f * angle), radius * std::cos(angle));
+		// Yaw is counter-clockwise around +y, 0 looks down -z
+		key.yaw = glm::degrees(angle);
+		key.pitch = -5.0f;
+		keys.push_back(key);
+	}
+	return CameraPath(std::move(keys));
+}
+
+CameraKey CameraPath::Evaluate(float time) const
+{
+	if (m_Keys.size() < 2)
+		return m_Keys.empty() ? CameraKey() : m_Keys[0];
+
+	float start = m_Keys.front().time;
+	float duration = m_Keys.back().time - start;
+	float local = duration > 0.0f ? start + std::fmod(std::max(time - start, 0.0f), duration) : start;
+
+	size_t next = 1;
+	while (next < m_Keys.size() - 1 && m_Keys[next].time < local)
+		++next;
+	size_t current = next - 1;
+
+	const CameraKey& a = m_Keys[current];
+	const CameraKey& b = m_Keys[next];
+	float span = b.time - a.time;
+	float t = span > 0.0f ? glm::clamp((local - a.time) / span, 0.0f, 1.0f) : 0.0f;
+
+	// End points are repeated so the spline still passes through the first and last key
+	const glm::vec3& before = m_Keys[current > 0 ? current - 1 : current].position;
+	const glm::vec3& after = m_Keys[next + 1 < m_Keys.size() ? next + 1 : next].position;
+
+	CameraKey result;
+	result.time = time;
+	result.position = CatmullRom(before, a.position, b.position, after, t);
+	result.yaw = glm::mix(a.yaw, b.yaw, t);
+	result.pitch = glm::mix(a.pitch, b.pitch, t);
+	return result;
+}
+
+void CameraPath::Apply(Camera& camera, float time) const
+{
+	CameraKey key = Evaluate(time);
+	camera.SetPosition(key.position);
+	camera.SetYaw(key.yaw);
+	camera.SetPitch(key.pitch);
+}
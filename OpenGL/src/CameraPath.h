@@ -0,0 +1,35 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <string>
+#include <vector>
+#include "Camera.h"
+
+struct CameraKey
+{
+	float time;
+	glm::vec3 position;
+	float yaw;
+	float pitch;
+};
+
+// Scripted camera movement for benchmarks and captures. Positions follow a Catmull-Rom spline
+// through the keys, yaw and pitch are interpolated linearly. Past the last key the path loops.
+class CameraPath
+{
+private:
+	std::vector<CameraKey> m_Keys;
+public:
+	CameraPath() = default;
+	explicit CameraPath(std::vector<CameraKey> keys);
+
+	// Text file with one "time x y z yaw pitch" key per line, # starts a comment
+	static bool LoadFromFile(const std::string& path, CameraPath& result);
+	// A slow loop around the default scene
+	static CameraPath Default();
+
+	CameraKey Evaluate(float time) const;
+	void Apply(Camera& camera, float time) const;
+
+	float GetDuration() const { return m_Keys.empty() ? 0.0f : m_Keys.back().time; }
+	bool IsEmpty() const { return m_Keys.empty(); }
+};
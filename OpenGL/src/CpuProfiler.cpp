@@ -0,0 +1,136 @@
+#include "CpuProfiler.h"
+#include <algorithm>
+#include <atomic>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace
+{
+	struct Event
+	{
+		const char* name;
+		uint64_t start;
+		uint64_t end;
+	};
+
+	struct ThreadBuffer
+	{
+		unsigned int id;
+		std::string name;
+		// Total number of events ever recorded, the slot is this modulo EVENTS_PER_THREAD
+		std::atomic<uint64_t> written;
+		Event events[CpuProfiler::EVENTS_PER_THREAD];
+	};
+
+	// Buffers outlive their threads so zones of finished threads still make it into the trace
+	std::mutex& BuffersMutex()
+	{
+		static std::mutex mutex;
+		return mutex;
+	}
+
+	std::vector<std::unique_ptr<ThreadBuffer>>& Buffers()
+	{
+		static std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+		return buffers;
+	}
+
+	thread_local ThreadBuffer* t_Buffer = nullptr;
+
+	ThreadBuffer& GetThreadBuffer()
+	{
+		if (!t_Buffer)
+		{
+			std::unique_ptr<ThreadBuffer> buffer(new ThreadBuffer());
+			buffer->written = 0;
+			std::lock_guard<std::mutex> lock(BuffersMutex());
+			buffer->id = (unsigned int)Buffers().size();
+			buffer->name = "Thread " + std::to_string(buffer->id);
+			t_Buffer = buffer.get();
+			Buffers().push_back(std::move(buffer));
+		}
+		return *t_Buffer;
+	}
+
+	void WriteEscaped(std::ostream& stream, const char* text)
+	{
+		for (const char* c = text; *c; ++c)
+		{
+			if (*c == '"' || *c == '\\')
+				stream << '\\';
+			stream << *c;
+		}
+	}
+
+	// Trace timestamps are microseconds
+	void WriteMicroseconds(std::ostream& stream, uint64_t nanoseconds)
+	{
+		char fill = stream.fill('0');
+		stream << nanoseconds / 1000 << "." << std::setw(3) << nanoseconds % 1000;
+		stream.fill(fill);
+	}
+}
+
+void CpuProfiler::Record(const char* name, uint64_t start, uint64_t end)
+{
+	ThreadBuffer& buffer = GetThreadBuffer();
+	uint64_t index = buffer.written.load(std::memory_order_relaxed);
+	Event& event = buffer.events[index % EVENTS_PER_THREAD];
+	event.name = name;
+	event.start = start;
+	event.end = end;
+	buffer.written.store(index + 1, std::memory_order_release);
+}
+
+void CpuProfiler::SetThreadName(const char* name)
+{
+	ThreadBuffer& buffer = GetThreadBuffer();
+	std::lock_guard<std::mutex> lock(BuffersMutex());
+	buffer.name = name;
+}
+
+void CpuProfiler::WriteChromeTrace(std::ostream& stream)
+{
+	std::lock_guard<std::mutex> lock(BuffersMutex());
+
+	// Start the trace at the oldest zone we still have instead of the clock's epoch
+	uint64_t origin = UINT64_MAX;
+	for (const std::unique_ptr<ThreadBuffer>& buffer : Buffers())
+	{
+		uint64_t written = buffer->written.load(std::memory_order_acquire);
+		uint64_t count = std::min<uint64_t>(written, EVENTS_PER_THREAD);
+		for (uint64_t i = written - count; i < written; ++i)
+			origin = std::min(origin, buffer->events[i % EVENTS_PER_THREAD].start);
+	}
+	if (origin == UINT64_MAX)
+		origin = 0;
+
+	stream << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+	bool first = true;
+	for (const std::unique_ptr<ThreadBuffer>& buffer : Buffers())
+	{
+		stream << (first ? "\n" : ",\n");
+		first = false;
+		stream << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":" << buffer->id << ",\"args\":{\"name\":\"";
+		WriteEscaped(stream, buffer->name.c_str());
+		stream << "\"}}";
+
+		uint64_t written = buffer->written.load(std::memory_order_acquire);
+		uint64_t count = std::min<uint64_t>(written, EVENTS_PER_THREAD);
+		for (uint64_t i = written - count; i < written; ++i)
+		{
+			const Event& event = buffer->events[i % EVENTS_PER_THREAD];
+			stream << ",\n{\"ph\":\"X\",\"name\":\"";
+			WriteEscaped(stream, event.name);
+			stream << "\",\"pid\":1,\"tid\":" << buffer->id << ",\"ts\":";
+			WriteMicroseconds(stream, event.start - origin);
+			stream << ",\"dur\":";
+			WriteMicroseconds(stream, event.end - event.start);
+			stream << "}";
+		}
+	}
+	stream << "\n]}\n";
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+
+// Scoped CPU zones, recorded into a fixed size ring buffer per thread so recording never locks or
+// allocates once a thread has its buffer. Only the newest EVENTS_PER_THREAD zones of each thread
+// are kept. Export with WriteChromeTrace() and open the file in chrome://tracing or Perfetto.
+//
+// Use the PROFILE_ macros rather than the classes: defining DISABLE_PROFILING compiles every zone
+// away, and defining TRACY_ENABLE forwards them to Tracy instead.
+class CpuProfiler
+{
+public:
+	static constexpr unsigned int EVENTS_PER_THREAD = 1 << 14;
+public:
+	// Nanoseconds, steady_clock is a vDSO call on Linux and QueryPerformanceCounter on Windows
+	static uint64_t Now()
+	{
+		return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	static void Record(const char* name, uint64_t start, uint64_t end);
+	// Shown instead of the thread's number in the trace, the name is copied
+	static void SetThreadName(const char* name);
+
+	// Threads may keep recording while this runs, but their newest zones could come out garbled.
+	// Best called once the other threads are idle or joined.
+	static void WriteChromeTrace(std::ostream& stream);
+};
+
+// The name has to outlive the profiler, use string literals
+class CpuProfileScope
+{
+private:
+	const char* m_Name;
+	uint64_t m_Start;
+public:
+	explicit CpuProfileScope(const char* name) : m_Name(name), m_Start(CpuProfiler::Now()) {}
+	~CpuProfileScope() { CpuProfiler::Record(m_Name, m_Start, CpuProfiler::Now()); }
+	CpuProfileScope(const CpuProfileScope&) = delete;
+	CpuProfileScope& operator=(const CpuProfileScope&) = delete;
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+
+#if defined(TRACY_ENABLE)
+#include <tracy/Tracy.hpp>
+#define PROFILE_SCOPE(name) ZoneScopedN(name)
+#define PROFILE_THREAD_NAME(name) tracy::SetThreadName(name)
+#elif !defined(DISABLE_PROFILING)
+#define PROFILE_SCOPE(name) CpuProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name)
+#define PROFILE_THREAD_NAME(name) CpuProfiler::SetThreadName(name)
+#else
+#define PROFILE_SCOPE(name) ((void)0)
+#define PROFILE_THREAD_NAME(name) ((void)0)
+#endif
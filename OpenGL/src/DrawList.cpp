@@ -0,0 +1,17 @@
+#include "DrawList.h"
+
+DrawList::DrawList() :
+	m_Storage(256 * 1024)
+{
+}
+
+void DrawList::Clear()
+{
+	m_Commands.clear();
+	m_Storage.Reset();
+}
+
+void DrawList::Record(const RenderQueue& queue, unsigned int pass, Mesh& mesh, Shader& shader, const glm::mat4* model, const DrawParams* params)
+{
+	m_Commands.push_back(queue.MakeCommand(pass, mesh, shader, model, params));
+}
@@ -0,0 +1,24 @@
+#pragma once
+#include <vector>
+#include "RenderQueue.h"
+#include "LinearAllocator.h"
+
+// Commands recorded off the render thread. Transforms live in the list's own linear allocator,
+// so recording doesn't touch the heap once the list has warmed up. Params are referenced as is.
+// One list per thread, they're merged into the RenderQueue with RenderQueue::Append().
+class DrawList
+{
+private:
+	std::vector<DrawCommand> m_Commands;
+	LinearAllocator m_Storage;
+public:
+	DrawList();
+
+	void Clear();
+	// Copies a transform into the list so every mesh of a model can share it
+	const glm::mat4* StoreTransform(const glm::mat4& model) { return m_Storage.New<glm::mat4>(model); }
+	void Record(const RenderQueue& queue, unsigned int pass, Mesh& mesh, Shader& shader, const glm::mat4* model, const DrawParams* params);
+
+	const std::vector<DrawCommand>& GetCommands() const { return m_Commands; }
+	size_t GetCommandCount() const { return m_Commands.size(); }
+};
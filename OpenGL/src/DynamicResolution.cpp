@@ -0,0 +1,46 @@
+#include "DynamicResolution.h"
+#include <algorithm>
+#include <cmath>
+
+DynamicResolution::DynamicResolution(float targetMs, float minScale, float maxScale, unsigned int settleFrames) :
+	m_TargetMs(targetMs), m_MinScale(minScale), m_MaxScale(maxScale), m_SettleFrames(settleFrames),
+	m_Scale(maxScale), m_FilteredMs(0.0f), m_FramesSinceChange(0), m_Changes(0)
+{
+}
+
+void DynamicResolution::Reset(float scale)
+{
+	m_Scale = std::max(m_MinScale, std::min(scale, m_MaxScale));
+	m_FilteredMs = 0.0f;
+	m_FramesSinceChange = 0;
+}
+
+float DynamicResolution::Update(float gpuMs)
+{
+	if (gpuMs <= 0.0f)
+		return m_Scale;
+	// Frames measured before the last change still show the old resolution
+	if (++m_FramesSinceChange <= m_SettleFrames)
+		return m_Scale;
+	m_FilteredMs = m_FilteredMs == 0.0f ? gpuMs : m_FilteredMs + (gpuMs - m_FilteredMs) * 0.2f;
+
+	float budget = m_TargetMs * HEADROOM;
+	float desired;
+	if (gpuMs > m_TargetMs)
+		desired = m_Scale * std::sqrt(budget / gpuMs);
+	else
+		desired = std::min(m_Scale * std::sqrt(budget / m_FilteredMs), m_Scale + MAX_GROWTH);
+	desired = std::max(m_MinScale, std::min(desired, m_MaxScale));
+
+	// Always allow reaching the limits, otherwise we could stop just short of them
+	bool atLimit = desired == m_MinScale || desired == m_MaxScale;
+	if (std::fabs(desired - m_Scale) >= MIN_STEP || (atLimit && desired != m_Scale))
+	{
+		m_Scale = desired;
+		m_FramesSinceChange = 0;
+		// The smoothed time was measured at the old scale
+		m_FilteredMs = 0.0f;
+		++m_Changes;
+	}
+	return m_Scale;
+}
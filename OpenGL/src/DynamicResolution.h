@@ -0,0 +1,39 @@
+#pragma once
+
+// Picks the resolution scale for the next frame so GPU time stays under a budget. Pixel count, and
+// roughly GPU time, goes with the square of the scale. Going over budget is corrected right away,
+// coming back up happens in small steps on the smoothed time so a single cheap frame doesn't
+// bounce the resolution around. GPU times arrive a few frames late, after a change the controller
+// waits that long before reacting again so it doesn't correct the same spike twice.
+class DynamicResolution
+{
+public:
+	// Aim this far below the budget so normal variance doesn't push us over
+	static constexpr float HEADROOM = 0.9f;
+	// Changes smaller than this aren't worth it
+	static constexpr float MIN_STEP = 0.02f;
+	// At most this much higher per step, dropping is unlimited
+	static constexpr float MAX_GROWTH = 0.05f;
+private:
+	float m_TargetMs;
+	float m_MinScale;
+	float m_MaxScale;
+	unsigned int m_SettleFrames;
+	float m_Scale;
+	float m_FilteredMs;
+	unsigned int m_FramesSinceChange;
+	unsigned int m_Changes;
+public:
+	// settleFrames is how many frames old the GPU times are
+	DynamicResolution(float targetMs, float minScale = 0.5f, float maxScale = 1.0f, unsigned int settleFrames = 4);
+
+	// Takes the GPU time of a measured frame, returns the scale to draw the next one at
+	float Update(float gpuMs);
+	void Reset(float scale = 1.0f);
+
+	void SetTargetMs(float targetMs) { m_TargetMs = targetMs; }
+	float GetTargetMs() const { return m_TargetMs; }
+	float GetScale() const { return m_Scale; }
+	float GetFilteredMs() const { return m_FilteredMs; }
+	unsigned int GetChangeCount() const { return m_Changes; }
+};
@@ -0,0 +1,138 @@
+#pragma once
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// Handle to an entity. The low 24 bits are the index into the pools' sparse arrays, which is reused
+// once the entity has been destroyed. The high 8 are the index's generation, bumped on every
+// destroy, so a handle kept around afterwards doesn't find the index's next occupant. The last
+// index is never handed out, at generation 255 it would be NO_ENTITY.
+using Entity = uint32_t;
+constexpr Entity NO_ENTITY = 0xffffffffu;
+constexpr uint32_t ENTITY_INDEX_BITS = 24;
+constexpr uint32_t ENTITY_INDEX_MASK = (1u << ENTITY_INDEX_BITS) - 1;
+
+inline uint32_t GetEntityIndex(Entity entity) { return entity & ENTITY_INDEX_MASK; }
+
+// Components of one type in dense arrays, so a system touching one component type streams through
+// nothing else. A sparse array maps entities to slots. Removing moves the last component into the
+// gap, which keeps the arrays hole free but means slots change. Systems iterating the intersection
+// of two pools walk one and Find() in the other, which is sequential too when both were filled in
+// the same order.
+template <typename T>
+class ComponentPool
+{
+private:
+	static constexpr uint32_t NO_SLOT = 0xffffffffu;
+
+	// By entity index
+	std::vector<uint32_t> m_Slots;
+	// By slot
+	std::vector<Entity> m_Entities;
+	std::vector<T> m_Components;
+public:
+	void Reserve(size_t count)
+	{
+		m_Entities.reserve(count);
+		m_Components.reserve(count);
+	}
+
+	void Clear()
+	{
+		m_Slots.clear();
+		m_Entities.clear();
+		m_Components.clear();
+	}
+
+	// Replaces the entity's component if it already has one
+	T& Add(Entity entity, const T& component)
+	{
+		uint32_t index = GetEntityIndex(entity);
+		if (index >= m_Slots.size())
+			m_Slots.resize(index + 1, NO_SLOT);
+		if (m_Slots[index] != NO_SLOT)
+		{
+			// Whatever an older handle of the index left behind is replaced too
+			m_Entities[m_Slots[index]] = entity;
+			return m_Components[m_Slots[index]] = component;
+		}
+		m_Slots[index] = (uint32_t)m_Entities.size();
+		m_Entities.push_back(entity);
+		m_Components.push_back(component);
+		return m_Components.back();
+	}
+
+	void Remove(Entity entity)
+	{
+		if (!Has(entity))
+			return;
+		uint32_t slot = m_Slots[GetEntityIndex(entity)];
+		Entity last = m_Entities.back();
+		m_Entities[slot] = last;
+		m_Components[slot] = std::move(m_Components.back());
+		m_Slots[GetEntityIndex(last)] = slot;
+		m_Entities.pop_back();
+		m_Components.pop_back();
+		m_Slots[GetEntityIndex(entity)] = NO_SLOT;
+	}
+
+	bool Has(Entity entity) const
+	{
+		uint32_t index = GetEntityIndex(entity);
+		return index < m_Slots.size() && m_Slots[index] != NO_SLOT && m_Entities[m_Slots[index]] == entity;
+	}
+	T* Find(Entity entity) { return Has(entity) ? &m_Components[m_Slots[GetEntityIndex(entity)]] : nullptr; }
+	const T* Find(Entity entity) const { return Has(entity) ? &m_Components[m_Slots[GetEntityIndex(entity)]] : nullptr; }
+
+	size_t GetSize() const { return m_Entities.size(); }
+	Entity GetEntity(size_t slot) const { return m_Entities[slot]; }
+	T& operator[](size_t slot) { return m_Components[slot]; }
+	const T& operator[](size_t slot) const { return m_Components[slot]; }
+};
+
+// Hands out entities, the indices of destroyed ones first. Components are added to and removed from
+// the pools by whoever owns them.
+class EntityAllocator
+{
+private:
+	std::vector<uint32_t> m_Free;
+	// By index, wraps after 256 reuses of the same index
+	std::vector<uint8_t> m_Generations;
+	uint32_t m_Next = 0;
+public:
+	// NO_ENTITY once every index is alive
+	Entity Create()
+	{
+		if (m_Free.empty())
+		{
+			assert(m_Next < ENTITY_INDEX_MASK);
+			if (m_Next >= ENTITY_INDEX_MASK)
+				return NO_ENTITY;
+			m_Generations.push_back(0);
+			return m_Next++;
+		}
+		uint32_t index = m_Free.back();
+		m_Free.pop_back();
+		return (Entity)m_Generations[index] << ENTITY_INDEX_BITS | index;
+	}
+	// Stale handles are ignored
+	void Destroy(Entity entity)
+	{
+		if (!IsAlive(entity))
+			return;
+		++m_Generations[GetEntityIndex(entity)];
+		m_Free.push_back(GetEntityIndex(entity));
+	}
+	bool IsAlive(Entity entity) const
+	{
+		uint32_t index = GetEntityIndex(entity);
+		return index < m_Next && m_Generations[index] == entity >> ENTITY_INDEX_BITS;
+	}
+	void Clear() { m_Free.clear(); m_Generations.clear(); m_Next = 0; }
+
+	// Highest index handed out so far plus one, for arrays indexed by entity index
+	uint32_t GetCapacity() const { return m_Next; }
+	size_t GetAliveCount() const { return m_Next - m_Free.size(); }
+};
@@ -0,0 +1,21 @@
+#include "FrameArena.h"
+
+FrameArena::FrameArena(size_t blockSize) :
+	m_Frames{ LinearAllocator(blockSize), LinearAllocator(blockSize) }, m_Current(0)
+{
+	static_assert(FRAMES_IN_FLIGHT == 2, "Update the initializer list above");
+}
+
+void FrameArena::BeginFrame()
+{
+	m_Current = (m_Current + 1) % FRAMES_IN_FLIGHT;
+	m_Frames[m_Current].Reset();
+}
+
+size_t FrameArena::GetCapacity() const
+{
+	size_t capacity = 0;
+	for (const LinearAllocator& frame : m_Frames)
+		capacity += frame.GetCapacity();
+	return capacity;
+}
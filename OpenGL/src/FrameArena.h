@@ -0,0 +1,30 @@
+#pragma once
+#include <cstddef>
+#include <utility>
+#include "LinearAllocator.h"
+
+// Linear allocator for data that only lives for a frame. There's one allocator per frame in
+// flight, BeginFrame() moves on to the next and rewinds it, so data from the previous frame
+// stays valid while that frame is still being consumed.
+class FrameArena
+{
+public:
+	static constexpr unsigned int FRAMES_IN_FLIGHT = 2;
+private:
+	LinearAllocator m_Frames[FRAMES_IN_FLIGHT];
+	unsigned int m_Current;
+public:
+	explicit FrameArena(size_t blockSize = 256 * 1024);
+	FrameArena(const FrameArena&) = delete;
+	FrameArena& operator=(const FrameArena&) = delete;
+
+	void BeginFrame();
+
+	void* Allocate(size_t size, size_t alignment = alignof(std::max_align_t)) { return m_Frames[m_Current].Allocate(size, alignment); }
+
+	template<typename T, typename... Args>
+	T* New(Args&&... args) { return m_Frames[m_Current].New<T>(std::forward<Args>(args)...); }
+
+	size_t GetBytesAllocated() const { return m_Frames[m_Current].GetBytesAllocated(); }
+	size_t GetCapacity() const;
+};
@@ -0,0 +1,87 @@
+#include "FrameBuilder.h"
+#include <cassert>
+#include "Model.h"
+#include "CpuProfiler.h"
+
+FrameBuilder::FrameBuilder(JobSystem& jobs) :
+	m_Jobs(jobs), m_Lists(jobs.GetThreadCount()), m_ThreadStats(jobs.GetThreadCount())
+{
+}
+
+void FrameBuilder::RecordRange(const Scene& scene, size_t begin, size_t end, const Frustum& frustum, const RenderQueue& queue)
+{
+	PROFILE_SCOPE("FrameBuilder::RecordRange");
+	// Workers of our job system have a list each, slot 0 belongs to the thread that called Record()
+	unsigned int threadIndex = m_Jobs.GetThreadIndex();
+	assert(threadIndex < m_Lists.size());
+	assert(threadIndex != 0 || std::this_thread::get_id() == m_RecordingThread);
+	DrawList& list = m_Lists[threadIndex];
+	FrameBuilderStats& stats = m_ThreadStats[threadIndex];
+	const ComponentPool<RenderableComponent>& renderables = scene.GetRenderables();
+	const ComponentPool<Bounds>& bounds = scene.GetWorldBounds();
+
+	for (size_t slot = begin; slot < end; ++slot)
+	{
+		Entity entity = renderables.GetEntity(slot);
+		// Bounds are added with the renderable, so this walks their pool in order as well
+		if (!frustum.Intersects(*bounds.Find(entity)))
+		{
+			++stats.culled;
+			continue;
+		}
+		++stats.visible;
+
+		const RenderableComponent& object = renderables[slot];
+		const glm::mat4& model = scene.GetWorldTransform(entity);
+
+		std::vector<Mesh>& meshes = object.model->GetMeshes();
+		for (size_t mesh = 0; mesh < meshes.size(); ++mesh)
+		{
+			// Only meshes with a node transform of their own need a matrix stored
+			const glm::mat4* transform = &model;
+			if (object.model->HasMeshTransforms())
+				transform = list.StoreTransform(model * object.model->GetMeshTransform(mesh));
+			Shader* shader = object.normalMapShader && meshes[mesh].HasNormalMap() ? object.normalMapShader : object.shader;
+			list.Record(queue, object.pass, meshes[mesh], *shader, transform, &object.params);
+			++stats.commands;
+		}
+	}
+}
+
+void FrameBuilder::Record(const Scene& scene, const glm::mat4& viewProjection, const RenderQueue& queue)
+{
+	PROFILE_SCOPE("FrameBuilder::Record");
+	for (size_t i = 0; i < m_Lists.size(); ++i)
+	{
+		m_Lists[i].Clear();
+		m_ThreadStats[i] = FrameBuilderStats();
+	}
+
+	m_RecordingThread = std::this_thread::get_id();
+	Frustum frustum(viewProjection);
+	m_Jobs.ParallelFor(scene.GetRenderables().GetSize(), GRAIN_SIZE, [&](size_t begin, size_t end)
+	{
+		RecordRange(scene, begin, end, frustum, queue);
+	});
+
+	m_Stats = FrameBuilderStats();
+	for (const FrameBuilderStats& stats : m_ThreadStats)
+	{
+		m_Stats.visible += stats.visible;
+		m_Stats.culled += stats.culled;
+		m_Stats.commands += stats.commands;
+	}
+}
+
+void FrameBuilder::Merge(RenderQueue& queue) const
+{
+	PROFILE_SCOPE("FrameBuilder::Merge");
+	for (const DrawList& list : m_Lists)
+		queue.Append(list);
+}
+
+void FrameBuilder::Build(const Scene& scene, const glm::mat4& viewProjection, RenderQueue& queue)
+{
+	Record(scene, viewProjection, queue);
+	Merge(queue);
+}
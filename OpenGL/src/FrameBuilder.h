@@ -0,0 +1,51 @@
+#pragma once
+#include <thread>
+#include <vector>
+#include <glm/glm.hpp>
+#include "DrawList.h"
+#include "Frustum.h"
+#include "JobSystem.h"
+#include "RenderQueue.h"
+#include "Scene.h"
+
+struct FrameBuilderStats
+{
+	unsigned int visible = 0;
+	unsigned int culled = 0;
+	unsigned int commands = 0;
+};
+
+// Frustum culls and records draw commands for the renderables of a scene as JobSystem jobs. The
+// scene's transforms have to be up to date (Scene::UpdateTransforms()) and stay untouched until
+// the queue has executed, commands point straight at its world matrices. Each thread records into
+// its own DrawList, the calling thread helps out and then merges the lists into the RenderQueue.
+// No other thread may be waiting on the same JobSystem meanwhile, it could pick up a range too.
+// Only the merge and the queue's execution need GL.
+class FrameBuilder
+{
+private:
+	// Renderables are handed out in ranges of at least this many so jobs aren't dominated by overhead
+	static constexpr unsigned int GRAIN_SIZE = 256;
+
+	JobSystem& m_Jobs;
+	std::vector<DrawList> m_Lists;
+	std::vector<FrameBuilderStats> m_ThreadStats;
+	FrameBuilderStats m_Stats;
+	// Slot 0 is the one of the thread calling Record(), workers have the others
+	std::thread::id m_RecordingThread;
+private:
+	void RecordRange(const Scene& scene, size_t begin, size_t end, const Frustum& frustum, const RenderQueue& queue);
+public:
+	explicit FrameBuilder(JobSystem& jobs);
+	FrameBuilder(const FrameBuilder&) = delete;
+	FrameBuilder& operator=(const FrameBuilder&) = delete;
+
+	// Records into the per-thread lists without touching the queue's contents
+	void Record(const Scene& scene, const glm::mat4& viewProjection, const RenderQueue& queue);
+	// Appends everything recorded by the last Record() to the queue
+	void Merge(RenderQueue& queue) const;
+	// Record() followed by Merge()
+	void Build(const Scene& scene, const glm::mat4& viewProjection, RenderQueue& queue);
+
+	const FrameBuilderStats& GetStats() const { return m_Stats; }
+};
@@ -0,0 +1,126 @@
+#include "FrameCapture.h"
+#include "CpuProfiler.h"
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+
+FrameCapture::FrameCapture(int width, int height, CaptureFormat format, const std::string& path, unsigned int latency) :
+	m_Width(width), m_Height(height), m_Slots(latency ? latency : 1), m_Oldest(0), m_Pending(0),
+	// A couple more buffers than readbacks so a slow frame on the encoder doesn't drop one right away
+	m_Encoder(width, height, format, path, (latency ? latency : 1) + 2)
+{
+	size_t size = (size_t)width * height * 4;
+	for (Slot& slot : m_Slots)
+	{
+		glGenBuffers(1, &slot.buffer);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+		glBufferData(GL_PIXEL_PACK_BUFFER, size, nullptr, GL_STREAM_READ);
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
+
+FrameCapture::~FrameCapture()
+{
+	Finish();
+	for (Slot& slot : m_Slots)
+		glDeleteBuffers(1, &slot.buffer);
+}
+
+void FrameCapture::Capture(unsigned int framebuffer)
+{
+	PROFILE_SCOPE("FrameCapture::Capture");
+	auto start = CpuProfiler::Now();
+
+	while (m_Pending > 0 && Collect(false))
+		;
+
+	if (m_Pending == m_Slots.size())
+	{
+		++m_Stats.droppedReadbacks;
+	}
+	else
+	{
+		Slot& slot = m_Slots[(m_Oldest + m_Pending) % m_Slots.size()];
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+		// RGBA bytes with 4 byte aligned rows is the format drivers copy without converting
+		glPixelStorei(GL_PACK_ALIGNMENT, 4);
+		glReadPixels(0, 0, m_Width, m_Height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+		slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		++m_Pending;
+	}
+
+	m_Stats.captureMs += (CpuProfiler::Now() - start) / 1e6;
+}
+
+bool FrameCapture::Collect(bool wait)
+{
+	Slot& slot = m_Slots[m_Oldest];
+	// Flushing makes sure the fence actually reaches the GPU, a zero timeout only polls it
+	GLuint64 timeout = wait ? 1000000000ull : 0;
+	GLenum status = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, timeout);
+	if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+	{
+		if (!wait)
+			return false;
+		// Draining at the end, keep waiting. A failed wait falls through to the map, which synchronizes anyway.
+		while (glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, timeout) == GL_TIMEOUT_EXPIRED)
+			;
+	}
+	glDeleteSync(slot.fence);
+	slot.fence = nullptr;
+
+	size_t size = (size_t)m_Width * m_Height * 4;
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+	const void* pixels = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, size, GL_MAP_READ_BIT);
+	if (pixels)
+	{
+		unsigned char* frame = m_Encoder.AcquireBuffer();
+		if (frame)
+		{
+			std::memcpy(frame, pixels, size);
+			m_Encoder.Submit(frame);
+			++m_Stats.captured;
+		}
+		else
+		{
+			++m_Stats.droppedEncodes;
+		}
+		glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	m_Oldest = (m_Oldest + 1) % m_Slots.size();
+	--m_Pending;
+	return true;
+}
+
+void FrameCapture::Finish()
+{
+	while (m_Pending > 0)
+		Collect(true);
+	m_Encoder.Finish();
+}
+
+std::string FrameCapture::GetSummary() const
+{
+	FrameEncoderStats encoder = m_Encoder.GetStats();
+	unsigned int attempted = m_Stats.captured + m_Stats.droppedReadbacks + m_Stats.droppedEncodes;
+	unsigned int frames = attempted + m_Stats.skipped;
+	std::ostringstream summary;
+	summary << std::fixed << std::setprecision(2);
+	summary << "Capture: " << m_Stats.captured << " of " << frames << " frames captured ("
+		<< m_Stats.droppedReadbacks << " dropped waiting on the GPU, " << m_Stats.droppedEncodes << " on the encoder, "
+		<< m_Stats.skipped << " skipped at another size)\n";
+	if (attempted > 0)
+		summary << "  render thread: " << m_Stats.captureMs / attempted << " ms/frame\n";
+	if (encoder.encoded > 0 && encoder.encodeSeconds > 0.0)
+	{
+		double megabytes = encoder.bytesWritten / (1024.0 * 1024.0);
+		summary << "  encoder: " << encoder.encodeSeconds * 1000.0 / encoder.encoded << " ms/frame, "
+			<< encoder.encoded / encoder.encodeSeconds << " frames/s per thread, "
+			<< megabytes / encoder.encoded << " MB/frame\n";
+	}
+	return summary.str();
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include <GL/glew.h>
+#include <string>
+#include <vector>
+#include "FrameEncoder.h"
+
+struct FrameCaptureStats
+{
+	unsigned int captured = 0;
+	// Every pixel buffer was still in flight, the GPU is more than the ring behind
+	unsigned int droppedReadbacks = 0;
+	// The readback arrived but the encoder had no free buffer for it
+	unsigned int droppedEncodes = 0;
+	// The framebuffer had another size than the stream, see Skip()
+	unsigned int skipped = 0;
+	// Time the render thread spent issuing readbacks and copying mapped buffers
+	double captureMs = 0.0;
+};
+
+// Reads frames back through a ring of pixel pack buffers. The glReadPixels into a PBO returns
+// right away and a fence marks when the copy is done; the buffer is only mapped once the fence has
+// signalled, usually a frame or two later, so the render thread never waits on the GPU.
+// Finished frames go to a FrameEncoder running on its own threads.
+class FrameCapture
+{
+private:
+	struct Slot
+	{
+		unsigned int buffer = 0;
+		GLsync fence = nullptr;
+	};
+
+	int m_Width;
+	int m_Height;
+	std::vector<Slot> m_Slots;
+	// Slots [m_Oldest, m_Oldest + m_Pending) have a readback in flight, oldest first
+	unsigned int m_Oldest;
+	unsigned int m_Pending;
+	FrameEncoder m_Encoder;
+	FrameCaptureStats m_Stats;
+private:
+	// Hands the oldest readback to the encoder if it's done, or waits for it when wait is set
+	bool Collect(bool wait);
+public:
+	// latency is the number of readbacks that can be in flight
+	FrameCapture(int width, int height, CaptureFormat format, const std::string& path, unsigned int latency = 3);
+	~FrameCapture();
+	FrameCapture(const FrameCapture&) = delete;
+	FrameCapture& operator=(const FrameCapture&) = delete;
+
+	// Call after the frame has been drawn into framebuffer, before swapping
+	void Capture(unsigned int framebuffer);
+	// Counts a frame that can't go into the stream, e.g. while a window resize settles
+	void Skip() { ++m_Stats.skipped; }
+	// Waits for the readbacks still in flight and for the encoder, only for the end of a run
+	void Finish();
+
+	FrameEncoder& GetEncoder() { return m_Encoder; }
+	// The stream's size is fixed, frames of any other size can't go into it. Start a new
+	// FrameCapture for those.
+	int GetWidth() const { return m_Width; }
+	int GetHeight() const { return m_Height; }
+	const FrameCaptureStats& GetStats() const { return m_Stats; }
+	std::string GetSummary() const;
+};
@@ -0,0 +1,218 @@
+#include "FrameEncoder.h"
+#include "CpuProfiler.h"
+#include "Image.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+namespace
+{
+	// BT.601 limited range, what players assume for Y4M without a colorspace tag
+	inline unsigned char Luma(int r, int g, int b)
+	{
+		return (unsigned char)(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+	}
+
+	inline unsigned char Cb(int r, int g, int b)
+	{
+		return (unsigned char)(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+	}
+
+	inline unsigned char Cr(int r, int g, int b)
+	{
+		return (unsigned char)(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+	}
+}
+
+FrameEncoder::FrameEncoder(int width, int height, CaptureFormat format, const std::string& path,
+	unsigned int bufferCount, unsigned int threadCount, unsigned int framesPerSecond) :
+	m_Width(width), m_Height(height), m_Format(format), m_Path(path), m_FramesPerSecond(framesPerSecond),
+	m_PngLevel(0), m_QueueHead(0), m_Quit(false)
+{
+	for (unsigned int i = 0; i < std::max(bufferCount, 1u); ++i)
+	{
+		m_Buffers.emplace_back(new unsigned char[GetFrameSize()]);
+		m_FreeBuffers.push_back(m_Buffers.back().get());
+	}
+	m_Queue.reserve(m_Buffers.size());
+
+	if (m_Format == CaptureFormat::Y4m)
+	{
+		// Chroma is subsampled 2x2, so an odd last row or column is dropped
+		m_Stream.open(m_Path, std::ios::binary);
+		m_Stream << "YUV4MPEG2 W" << (m_Width & ~1) << " H" << (m_Height & ~1) << " F" << m_FramesPerSecond << ":1 Ip A1:1 C420jpeg\n";
+		threadCount = 1;
+	}
+
+	for (unsigned int i = 0; i < std::max(threadCount, 1u); ++i)
+		m_Threads.emplace_back(&FrameEncoder::EncoderLoop, this);
+}
+
+FrameEncoder::~FrameEncoder()
+{
+	Finish();
+}
+
+bool FrameEncoder::IsOpen() const
+{
+	return m_Format != CaptureFormat::Y4m || m_Stream.is_open();
+}
+
+unsigned char* FrameEncoder::AcquireBuffer()
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	if (m_FreeBuffers.empty())
+	{
+		++m_Stats.dropped;
+		return nullptr;
+	}
+	unsigned char* buffer = m_FreeBuffers.back();
+	m_FreeBuffers.pop_back();
+	return buffer;
+}
+
+void FrameEncoder::Submit(unsigned char* buffer)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Queue.emplace_back(m_Stats.submitted++, buffer);
+	}
+	m_WakeUp.notify_one();
+}
+
+void FrameEncoder::Release(unsigned char* buffer)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	m_FreeBuffers.push_back(buffer);
+}
+
+void FrameEncoder::Finish()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Quit = true;
+	}
+	m_WakeUp.notify_all();
+	for (std::thread& thread : m_Threads)
+		thread.join();
+	m_Threads.clear();
+	if (m_Stream.is_open())
+		m_Stream.close();
+}
+
+FrameEncoderStats FrameEncoder::GetStats() const
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	return m_Stats;
+}
+
+void FrameEncoder::EncoderLoop()
+{
+	PROFILE_THREAD_NAME("Frame encoder");
+	std::vector<unsigned char> scratch;
+	std::unique_lock<std::mutex> lock(m_Mutex);
+	while (true)
+	{
+		m_WakeUp.wait(lock, [this]() { return m_QueueHead < m_Queue.size() || m_Quit; });
+		// Quitting still drains the queue
+		if (m_QueueHead == m_Queue.size())
+			break;
+
+		std::pair<unsigned int, unsigned char*> item = m_Queue[m_QueueHead++];
+		if (m_QueueHead == m_Queue.size())
+		{
+			m_Queue.clear();
+			m_QueueHead = 0;
+		}
+		lock.unlock();
+
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		uint64_t bytes = Encode(item.first, item.second, scratch);
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		lock.lock();
+		m_FreeBuffers.push_back(item.second);
+		++m_Stats.encoded;
+		m_Stats.bytesWritten += bytes;
+		m_Stats.encodeSeconds += seconds;
+	}
+}
+
+uint64_t FrameEncoder::Encode(unsigned int frame, const unsigned char* rgba, std::vector<unsigned char>& scratch)
+{
+	PROFILE_SCOPE("FrameEncoder::Encode");
+	if (m_Format == CaptureFormat::Y4m)
+		return EncodeY4m(rgba, scratch);
+	return EncodePng(frame, rgba, scratch);
+}
+
+uint64_t FrameEncoder::EncodePng(unsigned int frame, const unsigned char* rgba, std::vector<unsigned char>& scratch)
+{
+	Image image(m_Width, m_Height, 3);
+	for (int y = 0; y < m_Height; ++y)
+	{
+		const unsigned char* source = rgba + (size_t)(m_Height - 1 - y) * m_Width * 4;
+		unsigned char* destination = image.GetRow(y);
+		for (int x = 0; x < m_Width; ++x)
+		{
+			destination[x * 3 + 0] = source[x * 4 + 0];
+			destination[x * 3 + 1] = source[x * 4 + 1];
+			destination[x * 3 + 2] = source[x * 4 + 2];
+		}
+	}
+
+	::EncodePng(image, m_PngLevel, scratch);
+	char suffix[32];
+	snprintf(suffix, sizeof(suffix), "_%05u.png", frame);
+	std::ofstream file(m_Path + suffix, std::ios::binary);
+	file.write((const char*)scratch.data(), scratch.size());
+	return scratch.size();
+}
+
+uint64_t FrameEncoder::EncodeY4m(const unsigned char* rgba, std::vector<unsigned char>& scratch)
+{
+	int width = m_Width & ~1;
+	int height = m_Height & ~1;
+	size_t stride = (size_t)m_Width * 4;
+	size_t lumaSize = (size_t)width * height;
+	size_t chromaSize = lumaSize / 4;
+	scratch.resize(lumaSize + chromaSize * 2);
+	unsigned char* lumaPlane = scratch.data();
+	unsigned char* cbPlane = lumaPlane + lumaSize;
+	unsigned char* crPlane = cbPlane + chromaSize;
+
+	for (int y = 0; y < height; y += 2)
+	{
+		// Output rows y and y + 1 come from the bottom-up source
+		const unsigned char* top = rgba + (size_t)(m_Height - 1 - y) * stride;
+		const unsigned char* bottom = top - stride;
+		unsigned char* lumaTop = lumaPlane + (size_t)y * width;
+		unsigned char* lumaBottom = lumaTop + width;
+		for (int x = 0; x < width; x += 2)
+		{
+			const unsigned char* p00 = top + x * 4;
+			const unsigned char* p01 = p00 + 4;
+			const unsigned char* p10 = bottom + x * 4;
+			const unsigned char* p11 = p10 + 4;
+			lumaTop[x] = Luma(p00[0], p00[1], p00[2]);
+			lumaTop[x + 1] = Luma(p01[0], p01[1], p01[2]);
+			lumaBottom[x] = Luma(p10[0], p10[1], p10[2]);
+			lumaBottom[x + 1] = Luma(p11[0], p11[1], p11[2]);
+
+			int r = (p00[0] + p01[0] + p10[0] + p11[0] + 2) >> 2;
+			int g = (p00[1] + p01[1] + p10[1] + p11[1] + 2) >> 2;
+			int b = (p00[2] + p01[2] + p10[2] + p11[2] + 2) >> 2;
+			size_t chroma = (size_t)(y / 2) * (width / 2) + x / 2;
+			cbPlane[chroma] = Cb(r, g, b);
+			crPlane[chroma] = Cr(r, g, b);
+		}
+	}
+
+	// Only ever one thread writes the stream
+	static const char FRAME_HEADER[] = "FRAME\n";
+	m_Stream.write(FRAME_HEADER, sizeof(FRAME_HEADER) - 1);
+	m_Stream.write((const char*)scratch.data(), scratch.size());
+	return scratch.size() + sizeof(FRAME_HEADER) - 1;
+}
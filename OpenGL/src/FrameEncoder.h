@@ -0,0 +1,83 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+enum class CaptureFormat
+{
+	// <path>_00000.png, <path>_00001.png, ...
+	PngSequence,
+	// One raw 4:2:0 YUV4MPEG2 stream at <path>, plays in ffplay/mpv and converts with ffmpeg
+	Y4m
+};
+
+struct FrameEncoderStats
+{
+	unsigned int submitted = 0;
+	unsigned int encoded = 0;
+	// Frames that found every buffer still waiting to be encoded
+	unsigned int dropped = 0;
+	uint64_t bytesWritten = 0;
+	// Summed over all encoder threads
+	double encodeSeconds = 0.0;
+};
+
+// Encodes captured frames on background threads. Frames come in as RGBA with the bottom row
+// first, straight from a glReadPixels, and go out as RGB top to bottom. There's a fixed pool
+// of frame buffers, when the encoder falls behind AcquireBuffer() returns nullptr instead of
+// waiting, so the render thread never blocks on it.
+class FrameEncoder
+{
+private:
+	int m_Width;
+	int m_Height;
+	CaptureFormat m_Format;
+	std::string m_Path;
+	unsigned int m_FramesPerSecond;
+	int m_PngLevel;
+	std::ofstream m_Stream;
+
+	std::vector<std::unique_ptr<unsigned char[]>> m_Buffers;
+	std::vector<unsigned char*> m_FreeBuffers;
+	// Frame number and buffer, in submission order
+	std::vector<std::pair<unsigned int, unsigned char*>> m_Queue;
+	size_t m_QueueHead;
+	std::vector<std::thread> m_Threads;
+	mutable std::mutex m_Mutex;
+	std::condition_variable m_WakeUp;
+	bool m_Quit;
+	FrameEncoderStats m_Stats;
+private:
+	void EncoderLoop();
+	uint64_t Encode(unsigned int frame, const unsigned char* rgba, std::vector<unsigned char>& scratch);
+	uint64_t EncodePng(unsigned int frame, const unsigned char* rgba, std::vector<unsigned char>& scratch);
+	uint64_t EncodeY4m(const unsigned char* rgba, std::vector<unsigned char>& scratch);
+public:
+	// PNG frames are independent and spread over threadCount threads, Y4M always uses one to keep the order
+	FrameEncoder(int width, int height, CaptureFormat format, const std::string& path,
+		unsigned int bufferCount = 4, unsigned int threadCount = 2, unsigned int framesPerSecond = 60);
+	~FrameEncoder();
+	FrameEncoder(const FrameEncoder&) = delete;
+	FrameEncoder& operator=(const FrameEncoder&) = delete;
+
+	// PNG compression level, see EncodePng()
+	void SetPngLevel(int level) { m_PngLevel = level; }
+
+	// GetFrameSize() bytes to fill, nullptr if the encoder is behind (the frame counts as dropped)
+	unsigned char* AcquireBuffer();
+	void Submit(unsigned char* buffer);
+	// Gives a buffer back without encoding it
+	void Release(unsigned char* buffer);
+
+	// Encodes everything still queued and stops the threads
+	void Finish();
+
+	bool IsOpen() const;
+	size_t GetFrameSize() const { return (size_t)m_Width * m_Height * 4; }
+	FrameEncoderStats GetStats() const;
+};
@@ -0,0 +1,43 @@
+#include "Frustum.h"
+
+Frustum::Frustum()
+{
+	// Accepts everything
+	for (int i = 0; i < 6; ++i)
+		m_Planes[i] = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+}
+
+Frustum::Frustum(const glm::mat4& viewProjection)
+{
+	// glm is column major, so row i of the matrix is (m[0][i], m[1][i], m[2][i], m[3][i])
+	glm::vec4 row0(viewProjection[0][0], viewProjection[1][0], viewProjection[2][0], viewProjection[3][0]);
+	glm::vec4 row1(viewProjection[0][1], viewProjection[1][1], viewProjection[2][1], viewProjection[3][1]);
+	glm::vec4 row2(viewProjection[0][2], viewProjection[1][2], viewProjection[2][2], viewProjection[3][2]);
+	glm::vec4 row3(viewProjection[0][3], viewProjection[1][3], viewProjection[2][3], viewProjection[3][3]);
+
+	m_Planes[0] = row3 + row0;
+	m_Planes[1] = row3 - row0;
+	m_Planes[2] = row3 + row1;
+	m_Planes[3] = row3 - row1;
+	m_Planes[4] = row3 + row2;
+	m_Planes[5] = row3 - row2;
+
+	for (int i = 0; i < 6; ++i)
+		m_Planes[i] /= glm::length(glm::vec3(m_Planes[i]));
+}
+
+bool Frustum::Intersects(const Bounds& bounds) const
+{
+	glm::vec3 center = bounds.GetCenter();
+	glm::vec3 extents = bounds.GetExtents();
+	for (int i = 0; i < 6; ++i)
+	{
+		const glm::vec4& plane = m_Planes[i];
+		// Distance of the box's most positive corner along the plane normal
+		float radius = glm::dot(extents, glm::abs(glm::vec3(plane)));
+		float distance = glm::dot(glm::vec3(plane), center) + plane.w;
+		if (distance + radius < 0.0f)
+			return false;
+	}
+	return true;
+}
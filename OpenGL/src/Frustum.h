@@ -0,0 +1,16 @@
+#pragma once
+#include <glm/glm.hpp>
+#include "Bounds.h"
+
+class Frustum
+{
+private:
+	// left, right, bottom, top, near, far. xyz is the inward facing normal, w the distance
+	glm::vec4 m_Planes[6];
+public:
+	Frustum();
+	// Extracts the planes from a combined projection * view matrix (Gribb & Hartmann)
+	explicit Frustum(const glm::mat4& viewProjection);
+
+	bool Intersects(const Bounds& bounds) const;
+};
@@ -0,0 +1,198 @@
+#include "GaussianBlur.h"
+#include "RenderState.h"
+#include "Shader.h"
+#include <GL/glew.h>
+#include <algorithm>
+#include <cmath>
+#include <string>
+
+namespace
+{
+	const std::string SCREEN_TEXTURE_UNIFORM = "screenTexture";
+	const std::string ORIGINAL_TEXTURE_UNIFORM = "originalTexture";
+	const std::string STRENGTH_UNIFORM = "strength";
+	const std::string DIRECTION_UNIFORM = "direction";
+	const std::string TAP_COUNT_UNIFORM = "tapCount";
+	const std::string OFFSETS_UNIFORM = "offsets";
+	const std::string WEIGHTS_UNIFORM = "weights";
+	const std::string HALF_PIXEL_UNIFORM = "halfPixel";
+	const std::string UV_MAX_UNIFORM = "uvMax";
+
+	void BindInput(Shader& shader, const PostProcessGraph& graph, const RenderTarget& source)
+	{
+		shader.Bind();
+		shader.SetUniform1i(SCREEN_TEXTURE_UNIFORM, 0);
+		// Wide kernels would otherwise reach into whatever the unused part of an oversized target holds
+		shader.SetUniform2f(UV_MAX_UNIFORM, (graph.GetUsedWidth(source) - 0.5f) / source.width,
+			(graph.GetUsedHeight(source) - 0.5f) / source.height);
+		RenderState::BindTexture(0, GL_TEXTURE_2D, source.colorTexture);
+	}
+
+	// For passes that write the final image and blend the unblurred one back in
+	void BindInputs(Shader& shader, const PostProcessGraph& graph, const RenderTarget& source, unsigned int original, float strength)
+	{
+		BindInput(shader, graph, source);
+		shader.SetUniform1i(ORIGINAL_TEXTURE_UNIFORM, 1);
+		shader.SetUniform1f(STRENGTH_UNIFORM, strength);
+		RenderState::BindTexture(1, GL_TEXTURE_2D, original);
+	}
+}
+
+GaussianKernel ComputeGaussianKernel(int radius, bool linearSampling)
+{
+	GaussianKernel kernel;
+	// What fits in the shader's arrays
+	radius = std::max(0, std::min(radius, linearSampling ? (GaussianKernel::MAX_TAPS - 1) * 2 : GaussianKernel::MAX_TAPS - 1));
+
+	float sigma = std::max(radius / 3.0f, 0.5f);
+	float discrete[GaussianKernel::MAX_TAPS * 2 + 1];
+	float total = 0.0f;
+	for (int i = 0; i <= radius; ++i)
+	{
+		discrete[i] = std::exp(-(float)(i * i) / (2.0f * sigma * sigma));
+		total += i == 0 ? discrete[i] : discrete[i] * 2.0f;
+	}
+	for (int i = 0; i <= radius; ++i)
+		discrete[i] /= total;
+	discrete[radius + 1] = 0.0f;
+
+	kernel.offsets[0] = 0.0f;
+	kernel.weights[0] = discrete[0];
+	kernel.tapCount = 1;
+	if (!linearSampling)
+	{
+		for (int i = 1; i <= radius; ++i)
+		{
+			kernel.offsets[kernel.tapCount] = (float)i;
+			kernel.weights[kernel.tapCount] = discrete[i];
+			++kernel.tapCount;
+		}
+		return kernel;
+	}
+
+	// Texels i and i + 1 from one fetch at their weighted center
+	for (int i = 1; i <= radius; i += 2)
+	{
+		float weight = discrete[i] + discrete[i + 1];
+		kernel.offsets[kernel.tapCount] = (i * discrete[i] + (i + 1) * discrete[i + 1]) / weight;
+		kernel.weights[kernel.tapCount] = weight;
+		++kernel.tapCount;
+	}
+	return kernel;
+}
+
+GaussianBlurEffect::GaussianBlurEffect(const char* name, float radius) :
+	PostProcessEffect(name),
+	m_SeparableShader(new Shader("res/shaders/PostProcess.vs", "res/shaders/GaussianBlur.fs")),
+	m_DownShader(new Shader("res/shaders/PostProcess.vs", "res/shaders/DualKawaseDown.fs")),
+	m_UpShader(new Shader("res/shaders/PostProcess.vs", "res/shaders/DualKawaseUp.fs")),
+	m_Radius(radius), m_Method(BlurMethod::Auto), m_PyramidThreshold(16.0f), m_LinearSampling(true),
+	m_KernelRadius(-1), m_KernelLinear(true)
+{
+}
+
+GaussianBlurEffect::~GaussianBlurEffect()
+{
+}
+
+bool GaussianBlurEffect::UsesPyramid() const
+{
+	if (m_Method == BlurMethod::Auto)
+		return m_Radius > m_PyramidThreshold;
+	return m_Method == BlurMethod::Pyramid;
+}
+
+void GaussianBlurEffect::GetPyramidLayout(float radius, int& levels, float& spread)
+{
+	// Every level roughly doubles the reach, the spread makes up the rest
+	levels = std::max(1, std::min((int)std::floor(std::log2(std::max(radius, 1.0f))) - 1, MAX_PYRAMID_LEVELS));
+	spread = std::max(radius / (float)(1 << (levels + 1)), 0.5f);
+}
+
+void GaussianBlurEffect::Apply(PostProcessGraph& graph, const RenderTarget& input, unsigned int outputFramebuffer)
+{
+	if (UsesPyramid())
+		ApplyPyramid(graph, input, outputFramebuffer);
+	else
+		ApplySeparable(graph, input, outputFramebuffer);
+}
+
+void GaussianBlurEffect::ApplySeparable(PostProcessGraph& graph, const RenderTarget& input, unsigned int outputFramebuffer)
+{
+	int radius = (int)std::lround(m_Radius);
+	if (radius != m_KernelRadius || m_LinearSampling != m_KernelLinear)
+	{
+		m_Kernel = ComputeGaussianKernel(radius, m_LinearSampling);
+		m_KernelRadius = radius;
+		m_KernelLinear = m_LinearSampling;
+	}
+
+	Shader& shader = *m_SeparableShader;
+	shader.Bind();
+	shader.SetUniform1i(TAP_COUNT_UNIFORM, m_Kernel.tapCount);
+	shader.SetUniform1fv(OFFSETS_UNIFORM, m_Kernel.tapCount, m_Kernel.offsets);
+	shader.SetUniform1fv(WEIGHTS_UNIFORM, m_Kernel.tapCount, m_Kernel.weights);
+
+	// Horizontal into a scratch target
+	RenderTarget& horizontal = graph.AcquireTarget(input.width, input.height);
+	glBindFramebuffer(GL_FRAMEBUFFER, horizontal.framebuffer);
+	graph.SetViewport(horizontal);
+	BindInputs(shader, graph, input, input.colorTexture, 1.0f);
+	shader.SetUniform2f(DIRECTION_UNIFORM, 1.0f / input.width, 0.0f);
+	graph.DrawQuad(shader, input);
+
+	// Vertical into the output, which is also where strength blends the original back in
+	glBindFramebuffer(GL_FRAMEBUFFER, outputFramebuffer);
+	BindInputs(shader, graph, horizontal, input.colorTexture, GetStrength());
+	shader.SetUniform2f(DIRECTION_UNIFORM, 0.0f, 1.0f / input.height);
+	graph.DrawQuad(shader, horizontal);
+	graph.ReleaseTarget(horizontal);
+}
+
+void GaussianBlurEffect::ApplyPyramid(PostProcessGraph& graph, const RenderTarget& input, unsigned int outputFramebuffer)
+{
+	int levels;
+	float spread;
+	GetPyramidLayout(m_Radius, levels, spread);
+
+	RenderTarget* pyramid[MAX_PYRAMID_LEVELS];
+	const RenderTarget* source = &input;
+	int count = 0;
+	for (; count < levels; ++count)
+	{
+		int width = std::max(input.width >> (count + 1), 1);
+		int height = std::max(input.height >> (count + 1), 1);
+		if (width == source->width && height == source->height)
+			break;
+		pyramid[count] = &graph.AcquireTarget(width, height);
+		glBindFramebuffer(GL_FRAMEBUFFER, pyramid[count]->framebuffer);
+		graph.SetViewport(*pyramid[count]);
+		BindInput(*m_DownShader, graph, *source);
+		m_DownShader->SetUniform2f(HALF_PIXEL_UNIFORM, 0.5f * spread / width, 0.5f * spread / height);
+		graph.DrawQuad(*m_DownShader, *source);
+		source = pyramid[count];
+	}
+	// Too small to shrink
+	if (count == 0)
+	{
+		ApplySeparable(graph, input, outputFramebuffer);
+		return;
+	}
+
+	// Back up, every level's downsampled image has been read by now so it's drawn over
+	for (int level = count - 1; level >= 0; --level)
+	{
+		bool last = level == 0;
+		const RenderTarget& target = last ? input : *pyramid[level - 1];
+		int width = target.width;
+		int height = target.height;
+		glBindFramebuffer(GL_FRAMEBUFFER, last ? outputFramebuffer : target.framebuffer);
+		graph.SetViewport(target);
+		BindInputs(*m_UpShader, graph, *pyramid[level], input.colorTexture, last ? GetStrength() : 1.0f);
+		m_UpShader->SetUniform2f(HALF_PIXEL_UNIFORM, 0.5f * spread / width, 0.5f * spread / height);
+		graph.DrawQuad(*m_UpShader, *pyramid[level]);
+	}
+
+	for (int level = 0; level < count; ++level)
+		graph.ReleaseTarget(*pyramid[level]);
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include <memory>
+#include "PostProcessGraph.h"
+
+class Shader;
+
+// Taps of one axis of a separable Gaussian. Tap 0 is the center, the rest are mirrored.
+struct GaussianKernel
+{
+	static constexpr int MAX_TAPS = 32;
+	int tapCount = 0;
+	// In texels from the center
+	float offsets[MAX_TAPS];
+	float weights[MAX_TAPS];
+};
+
+// Weights for a kernel reaching radius texels out, sigma is a third of the radius. With linear
+// sampling every pair of neighbouring taps becomes one fetch between them, which the bilinear
+// filter splits back into the two weights, so radius r costs r / 2 + 1 fetches instead of r + 1.
+GaussianKernel ComputeGaussianKernel(int radius, bool linearSampling = true);
+
+enum class BlurMethod
+{
+	// Separable up to the pyramid threshold, the pyramid beyond it
+	Auto,
+	Separable,
+	Pyramid
+};
+
+// Gaussian blur of a given radius in pixels. Small radii run as two separable passes, large ones
+// as a dual Kawase down/up pyramid whose cost barely depends on the radius. Texel offsets come from
+// the size of the target each pass reads or writes, so the blur looks the same at any resolution.
+class GaussianBlurEffect : public PostProcessEffect
+{
+public:
+	static constexpr int MAX_PYRAMID_LEVELS = 6;
+private:
+	std::unique_ptr<Shader> m_SeparableShader;
+	std::unique_ptr<Shader> m_DownShader;
+	std::unique_ptr<Shader> m_UpShader;
+	float m_Radius;
+	BlurMethod m_Method;
+	float m_PyramidThreshold;
+	bool m_LinearSampling;
+	GaussianKernel m_Kernel;
+	int m_KernelRadius;
+	bool m_KernelLinear;
+private:
+	void ApplySeparable(PostProcessGraph& graph, const RenderTarget& input, unsigned int outputFramebuffer);
+	void ApplyPyramid(PostProcessGraph& graph, const RenderTarget& input, unsigned int outputFramebuffer);
+public:
+	explicit GaussianBlurEffect(const char* name, float radius = 8.0f);
+	~GaussianBlurEffect();
+
+	float GetRadius() const { return m_Radius; }
+	void SetRadius(float radius) { m_Radius = radius; }
+	void SetMethod(BlurMethod method) { m_Method = method; }
+	// Radii above this use the pyramid when the method is Auto
+	void SetPyramidThreshold(float radius) { m_PyramidThreshold = radius; }
+	// Only there to measure what the bilinear tap merging saves
+	void SetLinearSampling(bool linearSampling) { m_LinearSampling = linearSampling; }
+
+	bool UsesPyramid() const;
+	// How many levels and how far apart the pyramid samples to come close to radius
+	static void GetPyramidLayout(float radius, int& levels, float& spread);
+
+	bool IsNoOp() const override { return PostProcessEffect::IsNoOp() || m_Radius < 0.5f; }
+	void Apply(PostProcessGraph& graph, const RenderTarget& input, unsigned int outputFramebuffer) override;
+};
@@ -0,0 +1,129 @@
+#include "GoldenImages.h"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+GoldenSuite::GoldenSuite(const std::string& referenceDirectory, const std::string& outputDirectory, bool update) :
+	m_ReferenceDirectory(referenceDirectory), m_OutputDirectory(outputDirectory), m_Update(update)
+{
+	std::filesystem::create_directories(m_OutputDirectory);
+	if (m_Update)
+		std::filesystem::create_directories(m_ReferenceDirectory);
+	LoadReferenceTimes();
+}
+
+void GoldenSuite::LoadReferenceTimes()
+{
+	std::ifstream file(m_ReferenceDirectory + "/timings.txt");
+	std::string line;
+	while (std::getline(file, line))
+	{
+		std::stringstream stream(line);
+		std::string name;
+		double milliseconds;
+		if (stream >> name >> milliseconds)
+			m_ReferenceTimes[name] = milliseconds;
+	}
+}
+
+void GoldenSuite::SaveReferenceTimes() const
+{
+	std::ofstream file(m_ReferenceDirectory + "/timings.txt");
+	for (const std::pair<const std::string, double>& entry : m_ReferenceTimes)
+		file << entry.first << " " << entry.second << "\n";
+}
+
+const GoldenResult& GoldenSuite::Check(const std::string& name, const Image& image, const SampleStats& frameMs)
+{
+	GoldenResult result;
+	result.name = name;
+	result.medianMs = frameMs.GetPercentile(50.0);
+	std::string referencePath = m_ReferenceDirectory + "/" + name + ".png";
+
+	if (m_Update)
+	{
+		WritePng(referencePath, image);
+		m_ReferenceTimes[name] = result.medianMs;
+		result.referenceMs = result.medianMs;
+		result.imagePassed = result.timePassed = true;
+		m_Results.push_back(result);
+		return m_Results.back();
+	}
+
+	Image reference;
+	if (!LoadImage(referencePath, image.channels, reference))
+	{
+		result.missingReference = true;
+	}
+	else
+	{
+		Image difference;
+		result.difference = CompareImages(image, reference, PIXEL_THRESHOLD, &difference);
+		result.imagePassed = !result.difference.sizeMismatch &&
+			result.difference.GetDifferingFraction(image) <= MAX_DIFFERING_FRACTION;
+		if (!result.imagePassed && !result.difference.sizeMismatch)
+			WritePng(m_OutputDirectory + "/" + name + ".diff.png", difference);
+	}
+	if (!result.imagePassed)
+		WritePng(m_OutputDirectory + "/" + name + ".actual.png", image);
+
+	std::map<std::string, double>::const_iterator referenceTime = m_ReferenceTimes.find(name);
+	if (referenceTime != m_ReferenceTimes.end())
+	{
+		result.referenceMs = referenceTime->second;
+		double allowed = std::max(result.referenceMs * (1.0 + TIME_TOLERANCE), result.referenceMs + TIME_SLACK_MS);
+		result.timePassed = result.medianMs <= allowed;
+	}
+	else
+	{
+		// Nothing to compare against yet, that's not a regression
+		result.timePassed = true;
+	}
+
+	m_Results.push_back(result);
+	return m_Results.back();
+}
+
+bool GoldenSuite::Finish()
+{
+	if (m_Update)
+		SaveReferenceTimes();
+
+	bool passed = true;
+	std::ofstream report(m_OutputDirectory + "/report.json");
+	report << "{\n  \"updated\": " << (m_Update ? "true" : "false") << ",\n  \"cases\": [";
+	for (size_t i = 0; i < m_Results.size(); ++i)
+	{
+		const GoldenResult& result = m_Results[i];
+		bool casePassed = result.imagePassed && result.timePassed;
+		passed = passed && casePassed;
+
+		std::cout << (casePassed ? "PASS " : "FAIL ") << result.name << ": ";
+		if (result.missingReference)
+			std::cout << "no reference image";
+		else if (result.difference.sizeMismatch)
+			std::cout << "size differs from the reference";
+		else
+			std::cout << result.difference.differingPixels << " pixels differ (max " << result.difference.maxDifference
+				<< ", rms " << result.difference.rootMeanSquare << ")";
+		std::cout << ", " << result.medianMs << " ms";
+		if (result.referenceMs > 0.0)
+			std::cout << " (reference " << result.referenceMs << " ms)";
+		std::cout << "\n";
+
+		report << (i ? ",\n" : "\n");
+		report << "    { \"name\": \"" << result.name << "\", \"passed\": " << (casePassed ? "true" : "false")
+			<< ", \"imagePassed\": " << (result.imagePassed ? "true" : "false")
+			<< ", \"timePassed\": " << (result.timePassed ? "true" : "false")
+			<< ", \"missingReference\": " << (result.missingReference ? "true" : "false")
+			<< ", \"differingPixels\": " << result.difference.differingPixels
+			<< ", \"maxDifference\": " << result.difference.maxDifference
+			<< ", \"rms\": " << result.difference.rootMeanSquare
+			<< ", \"medianMs\": " << result.medianMs
+			<< ", \"referenceMs\": " << result.referenceMs << " }";
+	}
+	report << "\n  ]\n}\n";
+	return passed;
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include <map>
+#include <string>
+#include <vector>
+#include "Image.h"
+#include "SampleStats.h"
+
+struct GoldenResult
+{
+	std::string name;
+	bool missingReference = false;
+	bool imagePassed = false;
+	bool timePassed = false;
+	ImageDifference difference;
+	double medianMs = 0.0;
+	// 0 when there's no reference time yet
+	double referenceMs = 0.0;
+};
+
+// Compares rendered images against reference PNGs and frame times against reference times,
+// so one run gates both correctness and speed. References live in one directory, as
+// <name>.png plus a timings.txt with a "name milliseconds" line per case. Failing cases
+// leave <name>.actual.png and <name>.diff.png in the output directory next to report.json.
+class GoldenSuite
+{
+public:
+	// A channel may be off by this much before the pixel counts as different, which absorbs
+	// rounding differences between drivers
+	static constexpr int PIXEL_THRESHOLD = 8;
+	static constexpr double MAX_DIFFERING_FRACTION = 0.001;
+	// Allowed slowdown over the reference, both have to be exceeded to fail
+	static constexpr double TIME_TOLERANCE = 0.25;
+	static constexpr double TIME_SLACK_MS = 0.5;
+private:
+	std::string m_ReferenceDirectory;
+	std::string m_OutputDirectory;
+	bool m_Update;
+	std::map<std::string, double> m_ReferenceTimes;
+	std::vector<GoldenResult> m_Results;
+private:
+	void LoadReferenceTimes();
+	void SaveReferenceTimes() const;
+public:
+	// With update set every case is written as the new reference and passes
+	GoldenSuite(const std::string& referenceDirectory, const std::string& outputDirectory, bool update);
+
+	const GoldenResult& Check(const std::string& name, const Image& image, const SampleStats& frameMs);
+
+	// Prints a summary, writes the report and returns whether every case passed
+	bool Finish();
+	const std::vector<GoldenResult>& GetResults() const { return m_Results; }
+};
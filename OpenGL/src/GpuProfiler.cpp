@@ -0,0 +1,227 @@
+#include "GpuProfiler.h"
+#include <cfloat>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+
+namespace
+{
+	const char* FRAME_ZONE_NAME = "Frame";
+	constexpr unsigned int NO_ZONE = 0xffffffff;
+}
+
+GpuProfiler::GpuProfiler() :
+	m_ZoneCount(0), m_CurrentFrame(0), m_Depth(0), m_Overflow(0), m_FrameZone(NO_ZONE),
+	m_FramesMeasured(0), m_FramesDropped(0), m_InFrame(false)
+{
+	for (FrameQueries& frame : m_Frames)
+	{
+		glGenQueries(MAX_ZONES_PER_FRAME * 2, frame.queries);
+		frame.count = 0;
+		frame.lastIssued = 0;
+		frame.pending = false;
+	}
+	m_FrameZone = FindZone(FRAME_ZONE_NAME);
+}
+
+GpuProfiler::~GpuProfiler()
+{
+	for (FrameQueries& frame : m_Frames)
+		glDeleteQueries(MAX_ZONES_PER_FRAME * 2, frame.queries);
+}
+
+unsigned int GpuProfiler::FindZone(const char* name)
+{
+	for (unsigned int i = 0; i < m_ZoneCount; ++i)
+	{
+		if (m_Zones[i].name == name)
+			return i;
+	}
+	for (unsigned int i = 0; i < m_ZoneCount; ++i)
+	{
+		if (std::strcmp(m_Zones[i].name, name) == 0)
+			return i;
+	}
+	if (m_ZoneCount == MAX_ZONES)
+		return NO_ZONE;
+
+	Zone& zone = m_Zones[m_ZoneCount];
+	zone.name = name;
+	zone.samples = 0;
+	zone.next = 0;
+	return m_ZoneCount++;
+}
+
+void GpuProfiler::Collect(FrameQueries& frame)
+{
+	if (!frame.pending)
+		return;
+	frame.pending = false;
+	if (frame.count == 0)
+		return;
+
+	// Timestamps complete in the order they were issued, if the last one is there they all are.
+	// That's the frame zone's end, not the last zone's, as zones end innermost first.
+	GLint available = 0;
+	glGetQueryObjectiv(frame.queries[frame.lastIssued], GL_QUERY_RESULT_AVAILABLE, &available);
+	if (!available)
+	{
+		++m_FramesDropped;
+		return;
+	}
+
+	float totals[MAX_ZONES] = {};
+	bool seen[MAX_ZONES] = {};
+	for (unsigned int i = 0; i < frame.count; ++i)
+	{
+		GLuint64 start = 0, end = 0;
+		glGetQueryObjectui64v(frame.queries[i * 2], GL_QUERY_RESULT, &start);
+		glGetQueryObjectui64v(frame.queries[i * 2 + 1], GL_QUERY_RESULT, &end);
+		unsigned int zone = frame.zones[i];
+		totals[zone] += (float)((end - start) / 1.0e6);
+		seen[zone] = true;
+	}
+
+	for (unsigned int i = 0; i < m_ZoneCount; ++i)
+	{
+		if (!seen[i])
+			continue;
+		Zone& zone = m_Zones[i];
+		zone.history[zone.next] = totals[i];
+		zone.next = (zone.next + 1) % HISTORY;
+		if (zone.samples < HISTORY)
+			++zone.samples;
+	}
+	++m_FramesMeasured;
+}
+
+void GpuProfiler::BeginFrame()
+{
+	m_CurrentFrame = (m_CurrentFrame + 1) % FRAME_LATENCY;
+	// This slot was last used FRAME_LATENCY frames ago
+	Collect(m_Frames[m_CurrentFrame]);
+	m_Frames[m_CurrentFrame].count = 0;
+	m_Depth = 0;
+	m_Overflow = 0;
+	m_InFrame = true;
+	BeginZone(FRAME_ZONE_NAME);
+}
+
+void GpuProfiler::EndFrame()
+{
+	m_Overflow = 0;
+	while (m_Depth > 0)
+		EndZone();
+	m_Frames[m_CurrentFrame].pending = true;
+	m_InFrame = false;
+}
+
+void GpuProfiler::BeginZone(const char* name)
+{
+	FrameQueries& frame = m_Frames[m_CurrentFrame];
+	unsigned int zone = FindZone(name);
+	if (m_Depth == MAX_DEPTH)
+	{
+		++m_Overflow;
+		return;
+	}
+	if (!m_InFrame || zone == NO_ZONE || frame.count == MAX_ZONES_PER_FRAME)
+	{
+		// Still push something so the matching EndZone() has something to pop
+		m_OpenZones[m_Depth++] = NO_ZONE;
+		return;
+	}
+
+	unsigned int instance = frame.count++;
+	frame.zones[instance] = zone;
+	glQueryCounter(frame.queries[instance * 2], GL_TIMESTAMP);
+	frame.lastIssued = instance * 2;
+	m_OpenZones[m_Depth++] = instance;
+}
+
+void GpuProfiler::EndZone()
+{
+	if (m_Overflow > 0)
+	{
+		--m_Overflow;
+		return;
+	}
+	if (m_Depth == 0)
+		return;
+	unsigned int instance = m_OpenZones[--m_Depth];
+	if (instance == NO_ZONE)
+		return;
+	glQueryCounter(m_Frames[m_CurrentFrame].queries[instance * 2 + 1], GL_TIMESTAMP);
+	m_Frames[m_CurrentFrame].lastIssued = instance * 2 + 1;
+}
+
+GpuZoneStats GpuProfiler::GetZoneStats(unsigned int index) const
+{
+	const Zone& zone = m_Zones[index];
+	GpuZoneStats stats;
+	stats.name = zone.name;
+	stats.samples = zone.samples;
+	stats.min = stats.avg = stats.max = stats.last = 0.0f;
+	if (zone.samples == 0)
+		return stats;
+
+	stats.min = FLT_MAX;
+	stats.max = 0.0f;
+	float total = 0.0f;
+	for (unsigned int i = 0; i < zone.samples; ++i)
+	{
+		float sample = zone.history[i];
+		stats.min = sample < stats.min ? sample : stats.min;
+		stats.max = sample > stats.max ? sample : stats.max;
+		total += sample;
+	}
+	stats.avg = total / zone.samples;
+	stats.last = zone.history[(zone.next + HISTORY - 1) % HISTORY];
+	return stats;
+}
+
+float GpuProfiler::GetLastFrameMs() const
+{
+	if (m_FrameZone == NO_ZONE || m_Zones[m_FrameZone].samples == 0)
+		return 0.0f;
+	const Zone& zone = m_Zones[m_FrameZone];
+	return zone.history[(zone.next + HISTORY - 1) % HISTORY];
+}
+
+std::string GpuProfiler::GetSummary() const
+{
+	std::stringstream line;
+	line << std::fixed << std::setprecision(3) << "GPU ms:";
+	for (unsigned int i = 0; i < m_ZoneCount; ++i)
+	{
+		GpuZoneStats stats = GetZoneStats(i);
+		if (stats.samples == 0)
+			continue;
+		line << " " << stats.name << " " << stats.avg << " (" << stats.min << "-" << stats.max << ")";
+	}
+	if (m_FramesDropped > 0)
+		line << " | " << m_FramesDropped << " frames dropped";
+	return line.str();
+}
+
+void GpuProfiler::WriteJson(std::ostream& stream) const
+{
+	stream << "{\n";
+	stream << "  \"framesMeasured\": " << m_FramesMeasured << ",\n";
+	stream << "  \"framesDropped\": " << m_FramesDropped << ",\n";
+	stream << "  \"historyFrames\": " << HISTORY << ",\n";
+	stream << "  \"zones\": [";
+	bool first = true;
+	for (unsigned int i = 0; i < m_ZoneCount; ++i)
+	{
+		GpuZoneStats stats = GetZoneStats(i);
+		if (stats.samples == 0)
+			continue;
+		stream << (first ? "\n" : ",\n");
+		stream << "    { \"name\": \"" << stats.name << "\", \"samples\": " << stats.samples
+			<< ", \"minMs\": " << stats.min << ", \"avgMs\": " << stats.avg
+			<< ", \"maxMs\": " << stats.max << ", \"lastMs\": " << stats.last << " }";
+		first = false;
+	}
+	stream << "\n  ]\n}\n";
+}
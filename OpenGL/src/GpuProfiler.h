@@ -0,0 +1,109 @@
+#pragma once
+#include <GL/glew.h>
+#include <ostream>
+#include <string>
+
+// Rolling statistics of one named zone, in milliseconds
+struct GpuZoneStats
+{
+	const char* name;
+	float min;
+	float avg;
+	float max;
+	float last;
+	unsigned int samples;
+};
+
+// Measures GPU time of named zones with GL_TIMESTAMP queries. Queries of a frame are read back
+// FRAME_LATENCY frames later, and only if they're already available, so the CPU never waits on
+// the GPU. If the GPU falls that far behind the frame's results are dropped instead.
+// Zones can nest and the same name can be used several times per frame, the times add up.
+// Zone names are compared by pointer first, pass string literals or other long lived strings.
+class GpuProfiler
+{
+public:
+	static constexpr unsigned int MAX_ZONES = 32;
+	static constexpr unsigned int MAX_ZONES_PER_FRAME = 64;
+	static constexpr unsigned int MAX_DEPTH = 8;
+	static constexpr unsigned int FRAME_LATENCY = 4;
+	static constexpr unsigned int HISTORY = 120;
+private:
+	struct FrameQueries
+	{
+		// Start and end timestamp per zone instance
+		unsigned int queries[MAX_ZONES_PER_FRAME * 2];
+		unsigned int zones[MAX_ZONES_PER_FRAME];
+		unsigned int count;
+		// Index into queries of the timestamp issued last, the frame zone's end
+		unsigned int lastIssued;
+		bool pending;
+	};
+
+	struct Zone
+	{
+		const char* name;
+		float history[HISTORY];
+		unsigned int samples;
+		unsigned int next;
+	};
+
+	FrameQueries m_Frames[FRAME_LATENCY];
+	Zone m_Zones[MAX_ZONES];
+	unsigned int m_ZoneCount;
+	unsigned int m_CurrentFrame;
+	unsigned int m_OpenZones[MAX_DEPTH];
+	unsigned int m_Depth;
+	// Zones begun with m_OpenZones full, their EndZone() calls come first and have nothing to pop
+	unsigned int m_Overflow;
+	unsigned int m_FrameZone;
+	unsigned int m_FramesMeasured;
+	unsigned int m_FramesDropped;
+	bool m_InFrame;
+private:
+	unsigned int FindZone(const char* name);
+	void Collect(FrameQueries& frame);
+public:
+	GpuProfiler();
+	~GpuProfiler();
+	GpuProfiler(const GpuProfiler&) = delete;
+	GpuProfiler& operator=(const GpuProfiler&) = delete;
+
+	// Also opens a zone called "Frame" spanning everything until EndFrame()
+	void BeginFrame();
+	void EndFrame();
+
+	void BeginZone(const char* name);
+	void EndZone();
+
+	unsigned int GetZoneCount() const { return m_ZoneCount; }
+	GpuZoneStats GetZoneStats(unsigned int index) const;
+	unsigned int GetFramesMeasured() const { return m_FramesMeasured; }
+	// GPU time of the most recently measured frame, FRAME_LATENCY frames old or more
+	float GetLastFrameMs() const;
+	unsigned int GetFramesDropped() const { return m_FramesDropped; }
+
+	// One line with avg (min-max) per zone, for the console
+	std::string GetSummary() const;
+	// Everything as JSON for dashboards
+	void WriteJson(std::ostream& stream) const;
+};
+
+// Opens a zone for the lifetime of the object
+class GpuProfileScope
+{
+private:
+	GpuProfiler* m_Profiler;
+public:
+	GpuProfileScope(GpuProfiler* profiler, const char* name) : m_Profiler(profiler)
+	{
+		if (m_Profiler)
+			m_Profiler->BeginZone(name);
+	}
+	~GpuProfileScope()
+	{
+		if (m_Profiler)
+			m_Profiler->EndZone();
+	}
+	GpuProfileScope(const GpuProfileScope&) = delete;
+	GpuProfileScope& operator=(const GpuProfileScope&) = delete;
+};
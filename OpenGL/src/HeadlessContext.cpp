@@ -0,0 +1,232 @@
+#include "HeadlessContext.h"
+#include <GL/glew.h>
+#include <iostream>
+
+#if defined(USE_EGL)
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#elif defined(USE_OSMESA)
+#include <GL/osmesa.h>
+#endif
+
+HeadlessContext::HeadlessContext() :
+	m_Width(0), m_Height(0), m_Framebuffer(0), m_ColorBuffer(0), m_DepthStencilBuffer(0),
+	m_Display(nullptr), m_Context(nullptr), m_Surface(nullptr), m_Buffer(nullptr)
+{
+}
+
+HeadlessContext::~HeadlessContext()
+{
+	Destroy();
+}
+
+bool HeadlessContext::IsAvailable()
+{
+#if defined(USE_EGL) || defined(USE_OSMESA)
+	return true;
+#else
+	return false;
+#endif
+}
+
+const char* HeadlessContext::GetBackendName()
+{
+#if defined(USE_EGL)
+	return "EGL";
+#elif defined(USE_OSMESA)
+	return "OSMesa";
+#else
+	return "none";
+#endif
+}
+
+#if defined(USE_EGL)
+
+bool HeadlessContext::CreateContext()
+{
+	EGLDisplay display = EGL_NO_DISPLAY;
+	// Surfaceless doesn't need a display server or a GPU, llvmpipe will do
+	PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+		(PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+	if (getPlatformDisplay)
+		display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+	if (display == EGL_NO_DISPLAY)
+		display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+
+	EGLint major, minor;
+	if (display == EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor))
+	{
+		std::cout << "ERROR::HEADLESS:: No EGL display\n";
+		return false;
+	}
+	m_Display = display;
+
+	if (!eglBindAPI(EGL_OPENGL_API))
+	{
+		std::cout << "ERROR::HEADLESS:: No desktop GL support\n";
+		return false;
+	}
+
+	// A surface type of 0 matches every config. The surfaceless platform doesn't list any,
+	// its contexts are created without one (EGL_KHR_no_config_context).
+	const EGLint configAttributes[] = {
+		EGL_SURFACE_TYPE, 0,
+		EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+		EGL_NONE
+	};
+	EGLConfig config = EGL_NO_CONFIG_KHR;
+	EGLint configCount = 0;
+	if (!eglChooseConfig(display, configAttributes, &config, 1, &configCount) || configCount == 0)
+		config = EGL_NO_CONFIG_KHR;
+
+	const EGLint contextAttributes[] = {
+		EGL_CONTEXT_MAJOR_VERSION_KHR, 3,
+		EGL_CONTEXT_MINOR_VERSION_KHR, 3,
+		EGL_CONTEXT_OPENGL_PROFILE_MASK_KHR, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT_KHR,
+		EGL_NONE
+	};
+	EGLContext context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttributes);
+	if (context == EGL_NO_CONTEXT)
+	{
+		std::cout << "ERROR::HEADLESS:: Could not create a 3.3 core context\n";
+		return false;
+	}
+	m_Context = context;
+
+	if (eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context))
+		return true;
+
+	// No EGL_KHR_surfaceless_context, a tiny pbuffer keeps the context happy
+	const EGLint surfaceAttributes[] = { EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE };
+	EGLSurface surface = config != EGL_NO_CONFIG_KHR ? eglCreatePbufferSurface(display, config, surfaceAttributes) : EGL_NO_SURFACE;
+	if (surface == EGL_NO_SURFACE || !eglMakeCurrent(display, surface, surface, context))
+	{
+		std::cout << "ERROR::HEADLESS:: Could not make the context current\n";
+		return false;
+	}
+	m_Surface = surface;
+	return true;
+}
+
+void HeadlessContext::DestroyContext()
+{
+	if (!m_Display)
+		return;
+	eglMakeCurrent(m_Display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+	if (m_Surface)
+		eglDestroySurface(m_Display, m_Surface);
+	if (m_Context)
+		eglDestroyContext(m_Display, m_Context);
+	eglTerminate(m_Display);
+	m_Display = m_Context = m_Surface = nullptr;
+}
+
+#elif defined(USE_OSMESA)
+
+bool HeadlessContext::CreateContext()
+{
+	const int attributes[] = {
+		OSMESA_FORMAT, OSMESA_RGBA,
+		OSMESA_DEPTH_BITS, 24,
+		OSMESA_STENCIL_BITS, 8,
+		OSMESA_PROFILE, OSMESA_CORE_PROFILE,
+		OSMESA_CONTEXT_MAJOR_VERSION, 3,
+		OSMESA_CONTEXT_MINOR_VERSION, 3,
+		0
+	};
+	OSMesaContext context = OSMesaCreateContextAttribs(attributes, nullptr);
+	if (!context)
+	{
+		std::cout << "ERROR::HEADLESS:: Could not create a 3.3 core OSMesa context\n";
+		return false;
+	}
+	m_Context = context;
+
+	// Everything is drawn into our own framebuffer, OSMesa's only has to exist
+	m_Buffer = new unsigned char[4];
+	if (!OSMesaMakeCurrent(context, m_Buffer, GL_UNSIGNED_BYTE, 1, 1))
+	{
+		std::cout << "ERROR::HEADLESS:: Could not make the context current\n";
+		return false;
+	}
+	return true;
+}
+
+void HeadlessContext::DestroyContext()
+{
+	if (m_Context)
+		OSMesaDestroyContext((OSMesaContext)m_Context);
+	delete[] m_Buffer;
+	m_Context = nullptr;
+	m_Buffer = nullptr;
+}
+
+#else
+
+bool HeadlessContext::CreateContext()
+{
+	std::cout << "ERROR::HEADLESS:: Built without USE_EGL or USE_OSMESA\n";
+	return false;
+}
+
+void HeadlessContext::DestroyContext()
+{
+}
+
+#endif
+
+bool HeadlessContext::Create(int width, int height)
+{
+	if (!CreateContext())
+	{
+		DestroyContext();
+		return false;
+	}
+
+	// GLEW also looks for GLX, which isn't there without a display. The GL entry points are loaded by then.
+	GLenum result = glewInit();
+	if (result != GLEW_OK && result != GLEW_ERROR_NO_GLX_DISPLAY)
+	{
+		std::cout << "ERROR::HEADLESS:: " << glewGetErrorString(result) << "\n";
+		DestroyContext();
+		return false;
+	}
+
+	m_Width = width;
+	m_Height = height;
+
+	glGenFramebuffers(1, &m_Framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, m_Framebuffer);
+
+	glGenRenderbuffers(1, &m_ColorBuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, m_ColorBuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_ColorBuffer);
+
+	glGenRenderbuffers(1, &m_DepthStencilBuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, m_DepthStencilBuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, m_DepthStencilBuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+	{
+		std::cout << "ERROR::HEADLESS:: Framebuffer is not complete\n";
+		Destroy();
+		return false;
+	}
+	glViewport(0, 0, width, height);
+	return true;
+}
+
+void HeadlessContext::Destroy()
+{
+	if (m_Framebuffer)
+	{
+		glDeleteFramebuffers(1, &m_Framebuffer);
+		glDeleteRenderbuffers(1, &m_ColorBuffer);
+		glDeleteRenderbuffers(1, &m_DepthStencilBuffer);
+		m_Framebuffer = m_ColorBuffer = m_DepthStencilBuffer = 0;
+	}
+	DestroyContext();
+}
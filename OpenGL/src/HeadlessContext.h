@@ -0,0 +1,40 @@
+#pragma once
+
+// An OpenGL 3.3 core context without a window, for benchmarks and CI machines without a display.
+// Backed by EGL (Mesa's surfaceless platform, or the default display) when built with USE_EGL,
+// or by OSMesa when built with USE_OSMESA, so it runs on llvmpipe without a GPU.
+// There's no usable default framebuffer, render into GetFramebuffer() instead of 0.
+class HeadlessContext
+{
+private:
+	int m_Width;
+	int m_Height;
+	unsigned int m_Framebuffer;
+	unsigned int m_ColorBuffer;
+	unsigned int m_DepthStencilBuffer;
+	// EGLDisplay/EGLContext/EGLSurface or OSMesaContext and its buffer, depending on the backend
+	void* m_Display;
+	void* m_Context;
+	void* m_Surface;
+	unsigned char* m_Buffer;
+private:
+	bool CreateContext();
+	void DestroyContext();
+public:
+	HeadlessContext();
+	~HeadlessContext();
+	HeadlessContext(const HeadlessContext&) = delete;
+	HeadlessContext& operator=(const HeadlessContext&) = delete;
+
+	// False if this build has no headless backend or context creation failed
+	static bool IsAvailable();
+	static const char* GetBackendName();
+
+	// Makes the context current, initializes GLEW and creates a width x height framebuffer
+	bool Create(int width, int height);
+	void Destroy();
+
+	unsigned int GetFramebuffer() const { return m_Framebuffer; }
+	int GetWidth() const { return m_Width; }
+	int GetHeight() const { return m_Height; }
+};
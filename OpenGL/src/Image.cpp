@@ -0,0 +1,411 @@
+#include "Image.h"
+#include "vendor/stb_image/stb_image.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+
+namespace
+{
+	const uint16_t LENGTH_BASE[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+	const uint8_t LENGTH_EXTRA[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+	const uint16_t DISTANCE_BASE[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+	const uint8_t DISTANCE_EXTRA[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+	constexpr size_t WINDOW_SIZE = 32768;
+	constexpr size_t MIN_MATCH = 3;
+	constexpr size_t MAX_MATCH = 258;
+	constexpr unsigned int HASH_BITS = 15;
+
+	struct CrcTable
+	{
+		uint32_t values[256];
+
+		CrcTable()
+		{
+			for (uint32_t n = 0; n < 256; ++n)
+			{
+				uint32_t c = n;
+				for (int k = 0; k < 8; ++k)
+					c = (c & 1) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+				values[n] = c;
+			}
+		}
+	};
+
+	uint32_t Crc32(const unsigned char* data, size_t size, uint32_t crc = 0)
+	{
+		// Encoding may happen on several threads, a local static is initialized exactly once
+		static const CrcTable table;
+		crc = ~crc;
+		for (size_t i = 0; i < size; ++i)
+			crc = table.values[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+		return ~crc;
+	}
+
+	uint32_t Adler32(const unsigned char* data, size_t size)
+	{
+		uint32_t a = 1, b = 0;
+		while (size > 0)
+		{
+			// Largest block that can't overflow before the modulo
+			size_t block = std::min<size_t>(size, 5552);
+			for (size_t i = 0; i < block; ++i)
+			{
+				a += data[i];
+				b += a;
+			}
+			a %= 65521;
+			b %= 65521;
+			data += block;
+			size -= block;
+		}
+		return (b << 16) | a;
+	}
+
+	void PutBigEndian(std::vector<unsigned char>& output, uint32_t value)
+	{
+		output.push_back((unsigned char)(value >> 24));
+		output.push_back((unsigned char)(value >> 16));
+		output.push_back((unsigned char)(value >> 8));
+		output.push_back((unsigned char)value);
+	}
+
+	// Deflate writes bits starting at the least significant one
+	class BitWriter
+	{
+	private:
+		std::vector<unsigned char>& m_Output;
+		uint32_t m_Buffer;
+		int m_Count;
+	public:
+		explicit BitWriter(std::vector<unsigned char>& output) : m_Output(output), m_Buffer(0), m_Count(0) {}
+
+		void Write(uint32_t bits, int count)
+		{
+			m_Buffer |= bits << m_Count;
+			m_Count += count;
+			while (m_Count >= 8)
+			{
+				m_Output.push_back((unsigned char)m_Buffer);
+				m_Buffer >>= 8;
+				m_Count -= 8;
+			}
+		}
+
+		// Huffman codes go most significant bit first
+		void WriteCode(uint32_t code, int length)
+		{
+			uint32_t reversed = 0;
+			for (int i = 0; i < length; ++i)
+				reversed |= ((code >> i) & 1) << (length - 1 - i);
+			Write(reversed, length);
+		}
+
+		void Flush()
+		{
+			if (m_Count > 0)
+				m_Output.push_back((unsigned char)m_Buffer);
+			m_Buffer = 0;
+			m_Count = 0;
+		}
+	};
+
+	void WriteLiteral(BitWriter& writer, unsigned int value)
+	{
+		if (value < 144)
+			writer.WriteCode(0x30 + value, 8);
+		else if (value < 256)
+			writer.WriteCode(0x190 + value - 144, 9);
+		else if (value < 280)
+			writer.WriteCode(value - 256, 7);
+		else
+			writer.WriteCode(0xc0 + value - 280, 8);
+	}
+
+	void WriteMatch(BitWriter& writer, size_t length, size_t distance)
+	{
+		int lengthCode = 28;
+		while (LENGTH_BASE[lengthCode] > length)
+			--lengthCode;
+		WriteLiteral(writer, 257 + lengthCode);
+		writer.Write((uint32_t)(length - LENGTH_BASE[lengthCode]), LENGTH_EXTRA[lengthCode]);
+
+		int distanceCode = 29;
+		while (DISTANCE_BASE[distanceCode] > distance)
+			--distanceCode;
+		writer.WriteCode(distanceCode, 5);
+		writer.Write((uint32_t)(distance - DISTANCE_BASE[distanceCode]), DISTANCE_EXTRA[distanceCode]);
+	}
+
+	void DeflateStored(const unsigned char* data, size_t size, std::vector<unsigned char>& output)
+	{
+		size_t offset = 0;
+		do
+		{
+			size_t block = std::min<size_t>(size - offset, 65535);
+			output.push_back(offset + block == size ? 1 : 0);
+			output.push_back((unsigned char)block);
+			output.push_back((unsigned char)(block >> 8));
+			output.push_back((unsigned char)~block);
+			output.push_back((unsigned char)(~block >> 8));
+			output.insert(output.end(), data + offset, data + offset + block);
+			offset += block;
+		} while (offset < size);
+	}
+
+	// Greedy LZ77 with a single candidate per hash, quick rather than small
+	void DeflateFixed(const unsigned char* data, size_t size, std::vector<unsigned char>& output)
+	{
+		BitWriter writer(output);
+		writer.Write(1, 1); // last block
+		writer.Write(1, 2); // fixed Huffman codes
+
+		std::vector<int64_t> head((size_t)1 << HASH_BITS, -1);
+		size_t i = 0;
+		while (i < size)
+		{
+			size_t bestLength = 0;
+			size_t bestDistance = 0;
+			if (i + MIN_MATCH <= size)
+			{
+				uint32_t hash = ((data[i] << 16) | (data[i + 1] << 8) | data[i + 2]) * 2654435761u >> (32 - HASH_BITS);
+				int64_t candidate = head[hash];
+				head[hash] = (int64_t)i;
+				if (candidate >= 0 && i - (size_t)candidate <= WINDOW_SIZE)
+				{
+					size_t maxLength = std::min(MAX_MATCH, size - i);
+					size_t length = 0;
+					while (length < maxLength && data[candidate + length] == data[i + length])
+						++length;
+					if (length >= MIN_MATCH)
+					{
+						bestLength = length;
+						bestDistance = i - (size_t)candidate;
+					}
+				}
+			}
+
+			if (bestLength > 0)
+			{
+				WriteMatch(writer, bestLength, bestDistance);
+				i += bestLength;
+			}
+			else
+			{
+				WriteLiteral(writer, data[i]);
+				++i;
+			}
+		}
+		WriteLiteral(writer, 256); // end of block
+		writer.Flush();
+	}
+
+	unsigned char Paeth(int a, int b, int c)
+	{
+		int p = a + b - c;
+		int pa = std::abs(p - a), pb = std::abs(p - b), pc = std::abs(p - c);
+		if (pa <= pb && pa <= pc)
+			return (unsigned char)a;
+		return (unsigned char)(pb <= pc ? b : c);
+	}
+
+	// Picks the filter with the smallest sum of absolute values per row, the usual heuristic
+	void FilterRows(const Image& image, bool filter, std::vector<unsigned char>& filtered)
+	{
+		size_t rowSize = image.GetRowSize();
+		int bpp = image.channels;
+		filtered.resize((rowSize + 1) * image.height);
+		std::vector<unsigned char> candidates[5];
+		for (std::vector<unsigned char>& candidate : candidates)
+			candidate.resize(rowSize);
+
+		for (int y = 0; y < image.height; ++y)
+		{
+			const unsigned char* row = image.GetRow(y);
+			const unsigned char* previous = y > 0 ? image.GetRow(y - 1) : nullptr;
+			unsigned char* out = filtered.data() + y * (rowSize + 1);
+			if (!filter)
+			{
+				out[0] = 0;
+				std::memcpy(out + 1, row, rowSize);
+				continue;
+			}
+
+			for (size_t x = 0; x < rowSize; ++x)
+			{
+				int left = x >= (size_t)bpp ? row[x - bpp] : 0;
+				int up = previous ? previous[x] : 0;
+				int upLeft = previous && x >= (size_t)bpp ? previous[x - bpp] : 0;
+				candidates[0][x] = row[x];
+				candidates[1][x] = (unsigned char)(row[x] - left);
+				candidates[2][x] = (unsigned char)(row[x] - up);
+				candidates[3][x] = (unsigned char)(row[x] - ((left + up) >> 1));
+				candidates[4][x] = (unsigned char)(row[x] - Paeth(left, up, upLeft));
+			}
+
+			int best = 0;
+			uint64_t bestSum = UINT64_MAX;
+			for (int f = 0; f < 5; ++f)
+			{
+				uint64_t sum = 0;
+				for (size_t x = 0; x < rowSize; ++x)
+					sum += (uint64_t)std::abs((int)(signed char)candidates[f][x]);
+				if (sum < bestSum)
+				{
+					bestSum = sum;
+					best = f;
+				}
+			}
+			out[0] = (unsigned char)best;
+			std::memcpy(out + 1, candidates[best].data(), rowSize);
+		}
+	}
+
+	void WriteChunk(std::vector<unsigned char>& output, const char* type, const unsigned char* data, size_t size)
+	{
+		PutBigEndian(output, (uint32_t)size);
+		size_t start = output.size();
+		output.insert(output.end(), type, type + 4);
+		if (size > 0)
+			output.insert(output.end(), data, data + size);
+		PutBigEndian(output, Crc32(output.data() + start, size + 4));
+	}
+}
+
+void Image::FlipVertically()
+{
+	size_t rowSize = GetRowSize();
+	std::vector<unsigned char> temp(rowSize);
+	for (int y = 0; y < height / 2; ++y)
+	{
+		unsigned char* top = GetRow(y);
+		unsigned char* bottom = GetRow(height - 1 - y);
+		std::memcpy(temp.data(), top, rowSize);
+		std::memcpy(top, bottom, rowSize);
+		std::memcpy(bottom, temp.data(), rowSize);
+	}
+}
+
+Image Downsample(const Image& image)
+{
+	Image result(std::max(image.width / 2, 1), std::max(image.height / 2, 1), image.channels);
+	int channels = image.channels;
+	for (int y = 0; y < result.height; ++y)
+	{
+		// Source rows and columns this texel covers, 3 on the last one of an odd size
+		int firstY = std::min(y * 2, image.height - 1);
+		int lastY = y == result.height - 1 ? image.height - 1 : std::min(y * 2 + 1, image.height - 1);
+		unsigned char* row = result.GetRow(y);
+		for (int x = 0; x < result.width; ++x)
+		{
+			int firstX = std::min(x * 2, image.width - 1);
+			int lastX = x == result.width - 1 ? image.width - 1 : std::min(x * 2 + 1, image.width - 1);
+			int count = (lastY - firstY + 1) * (lastX - firstX + 1);
+			for (int c = 0; c < channels; ++c)
+			{
+				int sum = 0;
+				for (int sourceY = firstY; sourceY <= lastY; ++sourceY)
+				{
+					const unsigned char* source = image.GetRow(sourceY);
+					for (int sourceX = firstX; sourceX <= lastX; ++sourceX)
+						sum += source[sourceX * channels + c];
+				}
+				row[x * channels + c] = (unsigned char)((sum + count / 2) / count);
+			}
+		}
+	}
+	return result;
+}
+
+bool LoadImage(const std::string& path, int channels, Image& image)
+{
+	// Textures are flipped on load for GL, images compared here aren't
+	stbi_set_flip_vertically_on_load(0);
+	int width, height, fileChannels;
+	unsigned char* data = stbi_load(path.c_str(), &width, &height, &fileChannels, channels);
+	stbi_set_flip_vertically_on_load(1);
+	if (!data)
+		return false;
+	image = Image(width, height, channels);
+	std::memcpy(image.pixels.data(), data, image.pixels.size());
+	stbi_image_free(data);
+	return true;
+}
+
+void EncodePng(const Image& image, int level, std::vector<unsigned char>& output)
+{
+	static const unsigned char SIGNATURE[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+	output.clear();
+	output.insert(output.end(), SIGNATURE, SIGNATURE + 8);
+
+	static const unsigned char COLOR_TYPES[5] = { 0, 0, 4, 2, 6 }; // gray, gray + alpha, RGB, RGBA
+	std::vector<unsigned char> header;
+	PutBigEndian(header, (uint32_t)image.width);
+	PutBigEndian(header, (uint32_t)image.height);
+	header.push_back(8);
+	header.push_back(COLOR_TYPES[image.channels]);
+	header.push_back(0); // deflate
+	header.push_back(0); // adaptive filtering
+	header.push_back(0); // no interlacing
+	WriteChunk(output, "IHDR", header.data(), header.size());
+
+	std::vector<unsigned char> filtered;
+	FilterRows(image, level > 0, filtered);
+
+	std::vector<unsigned char> compressed;
+	compressed.reserve(level > 0 ? filtered.size() / 2 : filtered.size() + filtered.size() / 65535 * 5 + 16);
+	compressed.push_back(0x78);
+	compressed.push_back(0x01);
+	if (level > 0)
+		DeflateFixed(filtered.data(), filtered.size(), compressed);
+	else
+		DeflateStored(filtered.data(), filtered.size(), compressed);
+	PutBigEndian(compressed, Adler32(filtered.data(), filtered.size()));
+	WriteChunk(output, "IDAT", compressed.data(), compressed.size());
+
+	WriteChunk(output, "IEND", nullptr, 0);
+}
+
+bool WritePng(const std::string& path, const Image& image, int level)
+{
+	std::vector<unsigned char> png;
+	EncodePng(image, level, png);
+	std::ofstream file(path, std::ios::binary);
+	file.write((const char*)png.data(), png.size());
+	return (bool)file;
+}
+
+ImageDifference CompareImages(const Image& a, const Image& b, int threshold, Image* difference)
+{
+	ImageDifference result;
+	if (a.width != b.width || a.height != b.height || a.channels != b.channels)
+	{
+		result.sizeMismatch = true;
+		return result;
+	}
+	if (difference)
+		*difference = Image(a.width, a.height, 1);
+
+	double squares = 0.0;
+	size_t pixelCount = (size_t)a.width * a.height;
+	for (size_t p = 0; p < pixelCount; ++p)
+	{
+		int largest = 0;
+		for (int c = 0; c < a.channels; ++c)
+		{
+			int delta = std::abs((int)a.pixels[p * a.channels + c] - (int)b.pixels[p * a.channels + c]);
+			largest = std::max(largest, delta);
+			squares += (double)delta * delta;
+		}
+		if (largest > threshold)
+			++result.differingPixels;
+		result.maxDifference = std::max(result.maxDifference, largest);
+		if (difference)
+			difference->pixels[p] = (unsigned char)std::min(255, largest * 8);
+	}
+	result.rootMeanSquare = pixelCount ? std::sqrt(squares / (pixelCount * a.channels)) : 0.0;
+	return result;
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include <string>
+#include <vector>
+
+// 8 bits per channel, rows top to bottom, tightly packed
+struct Image
+{
+	int width = 0;
+	int height = 0;
+	int channels = 0;
+	std::vector<unsigned char> pixels;
+
+	Image() = default;
+	Image(int width, int height, int channels) :
+		width(width), height(height), channels(channels), pixels((size_t)width * height * channels) {}
+
+	size_t GetRowSize() const { return (size_t)width * channels; }
+	unsigned char* GetRow(int y) { return pixels.data() + y * GetRowSize(); }
+	const unsigned char* GetRow(int y) const { return pixels.data() + y * GetRowSize(); }
+
+	// glReadPixels returns the bottom row first
+	void FlipVertically();
+};
+
+struct ImageDifference
+{
+	// Pixels where any channel differs by more than the threshold
+	size_t differingPixels = 0;
+	int maxDifference = 0;
+	double rootMeanSquare = 0.0;
+	bool sizeMismatch = false;
+
+	double GetDifferingFraction(const Image& image) const
+	{
+		size_t total = (size_t)image.width * image.height;
+		return total ? (double)differingPixels / total : 0.0;
+	}
+};
+
+// Half the size with a 2x2 box filter, for building mips. Odd sizes round down like GL's mip
+// sizes do, the last row or column is averaged into the one before it. Never below 1x1.
+Image Downsample(const Image& image);
+
+// Loads any format stb_image understands, converted to the given channel count
+bool LoadImage(const std::string& path, int channels, Image& image);
+
+// Level 0 stores the pixels uncompressed, which is the fastest. Level 1 filters every row and
+// compresses with LZ77 and the fixed Huffman codes, typically a few times smaller for renders.
+void EncodePng(const Image& image, int level, std::vector<unsigned char>& output);
+bool WritePng(const std::string& path, const Image& image, int level = 1);
+
+// Compares channel by channel. If difference is given it receives a grayscale image of the
+// largest channel difference per pixel, scaled up so small errors are visible.
+ImageDifference CompareImages(const Image& a, const Image& b, int threshold, Image* difference = nullptr);
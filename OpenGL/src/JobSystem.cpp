@@ -0,0 +1,176 @@
+#include "JobSystem.h"
+#include "CpuProfiler.h"
+#include <cstdio>
+
+namespace
+{
+	thread_local unsigned int t_ThreadIndex = 0;
+	// The system t_ThreadIndex belongs to, nullptr outside of workers
+	thread_local const JobSystem* t_Owner = nullptr;
+}
+
+void JobSystem::JobQueue::Push(const Job& job)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	if (size == jobs.size())
+	{
+		// Unroll the ring into a bigger buffer
+		std::vector<Job> grown(std::max<size_t>(64, jobs.size() * 2));
+		for (size_t i = 0; i < size; ++i)
+			grown[i] = jobs[(head + i) % jobs.size()];
+		jobs.swap(grown);
+		head = 0;
+	}
+	jobs[(head + size) % jobs.size()] = job;
+	++size;
+}
+
+bool JobSystem::JobQueue::PopBack(Job& job)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	if (size == 0)
+		return false;
+	--size;
+	job = jobs[(head + size) % jobs.size()];
+	return true;
+}
+
+bool JobSystem::JobQueue::PopFront(Job& job)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	if (size == 0)
+		return false;
+	job = jobs[head];
+	head = (head + 1) % jobs.size();
+	--size;
+	return true;
+}
+
+JobSystem::JobSystem(unsigned int workerCount) :
+	m_QueuedJobs(0), m_SleepingWorkers(0), m_Quit(false)
+{
+	// Queue 0 is shared by every thread outside the pool
+	for (unsigned int i = 0; i <= workerCount; ++i)
+		m_Queues.emplace_back(new JobQueue());
+	for (unsigned int i = 0; i < workerCount; ++i)
+		m_Workers.emplace_back(&JobSystem::WorkerLoop, this, i + 1);
+}
+
+JobSystem::~JobSystem()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_SleepMutex);
+		m_Quit = true;
+	}
+	m_WakeUp.notify_all();
+	for (std::thread& worker : m_Workers)
+		worker.join();
+}
+
+unsigned int JobSystem::GetThreadIndex() const
+{
+	return t_Owner == this ? t_ThreadIndex : 0;
+}
+
+void JobSystem::Schedule(const Job& job)
+{
+	m_Queues[GetThreadIndex()]->Push(job);
+	m_QueuedJobs.fetch_add(1);
+
+	// Both sides use sequentially consistent operations, so either we see the sleeper
+	// or the sleeper sees our job before it goes to sleep
+	if (m_SleepingWorkers.load() > 0)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_SleepMutex);
+		}
+		m_WakeUp.notify_one();
+	}
+}
+
+bool JobSystem::TryGetJob(Job& job)
+{
+	unsigned int self = GetThreadIndex();
+	bool found = m_Queues[self]->PopBack(job);
+
+	// Steal the oldest job from someone else, starting with our neighbour so thieves spread out
+	for (size_t i = 1; !found && i < m_Queues.size(); ++i)
+		found = m_Queues[(self + i) % m_Queues.size()]->PopFront(job);
+
+	if (found)
+		m_QueuedJobs.fetch_sub(1);
+	return found;
+}
+
+void JobSystem::Execute(Job& job)
+{
+	job.execute(job.storage);
+	Finish(job.counter);
+}
+
+void JobSystem::Finish(JobCounter* counter)
+{
+	if (!counter)
+		return;
+
+	counter->m_Finishing.fetch_add(1);
+	std::vector<Job> continuations;
+	if (counter->m_Count.fetch_sub(1) == 1)
+	{
+		// Last one out schedules the continuations. The lock pairs with the one in RunAfter(),
+		// anything added after this point sees a count of zero and schedules itself.
+		std::lock_guard<std::mutex> lock(counter->m_Mutex);
+		continuations.swap(counter->m_Continuations);
+	}
+	// The counter may be gone after this
+	counter->m_Finishing.fetch_sub(1);
+
+	for (const Job& continuation : continuations)
+		Schedule(continuation);
+}
+
+void JobSystem::Wait(const JobCounter& counter)
+{
+	Job job;
+	while (!counter.IsDone())
+	{
+		if (TryGetJob(job))
+			Execute(job);
+		else
+			std::this_thread::yield();
+	}
+}
+
+void JobSystem::WorkerLoop(unsigned int threadIndex)
+{
+	t_ThreadIndex = threadIndex;
+	t_Owner = this;
+	char name[32];
+	snprintf(name, sizeof(name), "Worker %u", threadIndex);
+	PROFILE_THREAD_NAME(name);
+
+	Job job;
+	while (!m_Quit.load())
+	{
+		if (TryGetJob(job))
+		{
+			Execute(job);
+			continue;
+		}
+
+		// Spin a little before sleeping, jobs tend to come in bursts
+		bool found = false;
+		for (int spin = 0; spin < 64 && !found; ++spin)
+		{
+			std::this_thread::yield();
+			found = m_QueuedJobs.load() > 0;
+		}
+		if (found)
+			continue;
+
+		std::unique_lock<std::mutex> lock(m_SleepMutex);
+		m_SleepingWorkers.fetch_add(1);
+		m_WakeUp.wait(lock, [this] { return m_Quit.load() || m_QueuedJobs.load() > 0; });
+		m_SleepingWorkers.fetch_sub(1);
+	}
+}
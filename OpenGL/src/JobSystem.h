@@ -0,0 +1,174 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+class JobSystem;
+class JobCounter;
+
+// A callable stored inline. Small trivially copyable callables (most lambdas capturing
+// pointers, references and numbers) don't allocate, anything else is moved to the heap.
+struct Job
+{
+	static constexpr size_t STORAGE_SIZE = 48;
+
+	void (*execute)(void* storage) = nullptr;
+	JobCounter* counter = nullptr;
+	alignas(16) unsigned char storage[STORAGE_SIZE];
+
+	template<typename F>
+	static Job Make(F&& function, JobCounter* counter)
+	{
+		using Function = typename std::decay<F>::type;
+		Job job;
+		job.counter = counter;
+		if (sizeof(Function) <= STORAGE_SIZE && alignof(Function) <= 16 && std::is_trivially_copyable<Function>::value)
+		{
+			new (job.storage) Function(std::forward<F>(function));
+			job.execute = [](void* storage) { (*static_cast<Function*>(storage))(); };
+		}
+		else
+		{
+			Function* heapFunction = new Function(std::forward<F>(function));
+			std::memcpy(job.storage, &heapFunction, sizeof(heapFunction));
+			job.execute = [](void* storage)
+			{
+				Function* function;
+				std::memcpy(&function, storage, sizeof(function));
+				(*function)();
+				delete function;
+			};
+		}
+		return job;
+	}
+};
+
+// Counts outstanding jobs. Jobs can be chained onto a counter with JobSystem::RunAfter(),
+// they're scheduled as soon as the counter drops to zero.
+class JobCounter
+{
+	friend class JobSystem;
+private:
+	std::atomic<int> m_Count;
+	// Jobs still touching the counter after decrementing it. The counter usually lives on
+	// the waiter's stack, so it can't count as done until they've all let go of it.
+	std::atomic<int> m_Finishing;
+	std::mutex m_Mutex;
+	std::vector<Job> m_Continuations;
+public:
+	JobCounter() : m_Count(0), m_Finishing(0) {}
+	JobCounter(const JobCounter&) = delete;
+	JobCounter& operator=(const JobCounter&) = delete;
+
+	int GetCount() const { return m_Count.load(); }
+	bool IsDone() const { return m_Count.load() == 0 && m_Finishing.load() == 0; }
+};
+
+// Work-stealing scheduler. Every worker owns a deque, it pushes and pops its own end (LIFO, so
+// nested work stays cache warm) and steals from the other end of everyone else's when it runs dry.
+// Threads that aren't workers share one extra deque. Waiting on a counter executes other jobs
+// instead of blocking, so jobs may spawn and wait on their own jobs.
+class JobSystem
+{
+private:
+	// Growable ring buffer, guarded by a mutex that's almost only ever taken by its owner
+	struct JobQueue
+	{
+		std::mutex mutex;
+		std::vector<Job> jobs;
+		size_t head = 0; // steal end
+		size_t size = 0;
+
+		void Push(const Job& job);
+		bool PopBack(Job& job);
+		bool PopFront(Job& job);
+	};
+
+	std::vector<std::thread> m_Workers;
+	std::vector<std::unique_ptr<JobQueue>> m_Queues;
+	std::atomic<int> m_QueuedJobs;
+	std::atomic<int> m_SleepingWorkers;
+	std::mutex m_SleepMutex;
+	std::condition_variable m_WakeUp;
+	std::atomic<bool> m_Quit;
+private:
+	void WorkerLoop(unsigned int threadIndex);
+	void Schedule(const Job& job);
+	bool TryGetJob(Job& job);
+	void Execute(Job& job);
+	void Finish(JobCounter* counter);
+public:
+	// workerCount threads are started, 0 runs every job on the thread that waits for it
+	explicit JobSystem(unsigned int workerCount);
+	~JobSystem();
+	JobSystem(const JobSystem&) = delete;
+	JobSystem& operator=(const JobSystem&) = delete;
+
+	template<typename F>
+	void Run(F&& function, JobCounter* counter = nullptr)
+	{
+		if (counter)
+			counter->m_Count.fetch_add(1, std::memory_order_relaxed);
+		Schedule(Job::Make(std::forward<F>(function), counter));
+	}
+
+	// Runs the function once dependency has dropped to zero, counter is incremented right away
+	template<typename F>
+	void RunAfter(JobCounter& dependency, F&& function, JobCounter* counter = nullptr)
+	{
+		if (counter)
+			counter->m_Count.fetch_add(1, std::memory_order_relaxed);
+		Job job = Job::Make(std::forward<F>(function), counter);
+		{
+			std::lock_guard<std::mutex> lock(dependency.m_Mutex);
+			if (dependency.GetCount() != 0)
+			{
+				dependency.m_Continuations.push_back(job);
+				return;
+			}
+		}
+		Schedule(job);
+	}
+
+	// Helps out with other jobs until counter reaches zero
+	void Wait(const JobCounter& counter);
+
+	// Calls body(begin, end) over [0, count) in ranges of at least grainSize and waits for all of them
+	template<typename F>
+	void ParallelFor(size_t count, size_t grainSize, F&& body)
+	{
+		if (count == 0)
+			return;
+		if (grainSize == 0)
+			grainSize = 1;
+		// A few ranges per thread leaves room for stealing to even out uneven ranges
+		size_t maxRanges = (size_t)GetThreadCount() * 4;
+		size_t rangeSize = std::max(grainSize, (count + maxRanges - 1) / maxRanges);
+
+		JobCounter counter;
+		typename std::remove_reference<F>::type* bodyPtr = &body;
+		for (size_t begin = rangeSize; begin < count; begin += rangeSize)
+		{
+			size_t end = std::min(begin + rangeSize, count);
+			Run([bodyPtr, begin, end]() { (*bodyPtr)(begin, end); }, &counter);
+		}
+		// The first range is ours
+		body((size_t)0, std::min(rangeSize, count));
+		Wait(counter);
+	}
+
+	// Workers plus the threads outside the pool
+	unsigned int GetThreadCount() const { return (unsigned int)m_Workers.size() + 1; }
+	unsigned int GetWorkerCount() const { return (unsigned int)m_Workers.size(); }
+	// 1..workerCount on this system's workers, 0 on any other thread, including the workers of
+	// other JobSystems
+	unsigned int GetThreadIndex() const;
+};
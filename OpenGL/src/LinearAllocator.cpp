@@ -0,0 +1,43 @@
+#include "LinearAllocator.h"
+#include <algorithm>
+
+LinearAllocator::LinearAllocator(size_t blockSize) :
+	m_BlockSize(blockSize), m_CurrentBlock(0), m_Offset(0), m_BytesAllocated(0)
+{
+}
+
+void* LinearAllocator::AllocateSlow(size_t size, size_t alignment)
+{
+	// Move on to the next block that's big enough, keeping the ones we skip for the next frame
+	while (++m_CurrentBlock < m_Blocks.size())
+	{
+		if (size + alignment <= m_Blocks[m_CurrentBlock].size)
+			break;
+	}
+	if (m_CurrentBlock >= m_Blocks.size())
+	{
+		// Padding the size by the alignment guarantees the allocation fits wherever the block lands
+		Block block;
+		block.size = std::max(m_BlockSize, size + alignment);
+		block.data.reset(new char[block.size]);
+		m_Blocks.push_back(std::move(block));
+		m_CurrentBlock = m_Blocks.size() - 1;
+	}
+	m_Offset = 0;
+	return Allocate(size, alignment);
+}
+
+void LinearAllocator::Reset()
+{
+	m_CurrentBlock = 0;
+	m_Offset = 0;
+	m_BytesAllocated = 0;
+}
+
+size_t LinearAllocator::GetCapacity() const
+{
+	size_t capacity = 0;
+	for (const Block& block : m_Blocks)
+		capacity += block.size;
+	return capacity;
+}
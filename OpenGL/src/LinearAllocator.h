@@ -0,0 +1,61 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <vector>
+
+// Bump allocator over a list of blocks. Nothing is freed individually, Reset() rewinds
+// everything at once and keeps the blocks around, so a steady workload stops allocating
+// after the first few frames. Destructors of allocated objects are never run.
+// Not thread safe, give every thread its own.
+class LinearAllocator
+{
+private:
+	struct Block
+	{
+		std::unique_ptr<char[]> data;
+		size_t size;
+	};
+	std::vector<Block> m_Blocks;
+	size_t m_BlockSize;
+	size_t m_CurrentBlock;
+	size_t m_Offset;
+	size_t m_BytesAllocated;
+private:
+	void* AllocateSlow(size_t size, size_t alignment);
+public:
+	explicit LinearAllocator(size_t blockSize = 64 * 1024);
+	LinearAllocator(const LinearAllocator&) = delete;
+	LinearAllocator& operator=(const LinearAllocator&) = delete;
+	LinearAllocator(LinearAllocator&&) = default;
+	LinearAllocator& operator=(LinearAllocator&&) = default;
+
+	void* Allocate(size_t size, size_t alignment = alignof(std::max_align_t))
+	{
+		if (m_CurrentBlock < m_Blocks.size())
+		{
+			Block& block = m_Blocks[m_CurrentBlock];
+			uintptr_t base = (uintptr_t)block.data.get();
+			size_t aligned = ((base + m_Offset + alignment - 1) & ~(uintptr_t)(alignment - 1)) - base;
+			if (aligned + size <= block.size)
+			{
+				m_Offset = aligned + size;
+				m_BytesAllocated += size;
+				return block.data.get() + aligned;
+			}
+		}
+		return AllocateSlow(size, alignment);
+	}
+
+	template<typename T, typename... Args>
+	T* New(Args&&... args)
+	{
+		return new (Allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+	}
+
+	void Reset();
+
+	size_t GetBytesAllocated() const { return m_BytesAllocated; }
+	size_t GetCapacity() const;
+};
@@ -0,0 +1,201 @@
+#include "Material.h"
+#include <GL/glew.h>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "RenderState.h"
+#include "Shader.h"
+#include "Texture.h"
+#include "TextureArray.h"
+
+namespace
+{
+	// What follows MaterialParameters in a slot, mapHandles in BasicLit.fs. One uvec2 per map,
+	// padded to whole uvec4s.
+	struct MaterialHandles
+	{
+		uint64_t maps[(Material::SLOT_COUNT + 1) / 2 * 2] = {};
+	};
+	const size_t SLOT_SIZE = sizeof(MaterialParameters) + sizeof(MaterialHandles);
+
+	struct LibraryState
+	{
+		// NO_MATERIAL is the first one
+		std::vector<Material> materials = std::vector<Material>(1);
+		unsigned int buffer = 0;
+		// Slots start at multiples of GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT
+		size_t stride = 0;
+		// The buffer is rebuilt on the next Bind()
+		bool dirty = true;
+		bool bindless = false;
+		// 1x1 black, what a missing map samples when there's no unit to leave empty
+		unsigned int missing2D = 0;
+		unsigned int missingArray = 0;
+	};
+	LibraryState s_Library;
+
+	const std::string SAMPLER_UNIFORMS[Material::SLOT_COUNT] = { "material.diffuse", "material.specular", "material.normal" };
+	const std::string SKYBOX_UNIFORM = "skybox";
+
+	// The TEXTURE_ARRAY permutation samples every slot as an array
+	bool UsesArrays(const Material& material)
+	{
+		for (unsigned int slot = 0; slot < Material::SLOT_COUNT; ++slot)
+		{
+			if (material.arrays[slot])
+				return true;
+		}
+		return false;
+	}
+
+	unsigned int CreateMissingMap(GLenum target)
+	{
+		const unsigned char black[4] = { 0, 0, 0, 255 };
+		unsigned int texture = 0;
+		glGenTextures(1, &texture);
+		RenderState::BindTexture(RenderState::GetActiveTextureUnit(), target, texture);
+		if (target == GL_TEXTURE_2D_ARRAY)
+			glTexImage3D(target, 0, GL_RGBA8, 1, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, black);
+		else
+			glTexImage2D(target, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, black);
+		glTexParameteri(target, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(target, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glMakeTextureHandleResidentARB(glGetTextureHandleARB(texture));
+		return texture;
+	}
+
+	bool Equal(const Material& a, const Material& b)
+	{
+		return std::memcmp(a.textures, b.textures, sizeof(a.textures)) == 0
+			&& std::memcmp(a.arrays, b.arrays, sizeof(a.arrays)) == 0
+			&& std::memcmp(&a.parameters, &b.parameters, sizeof(MaterialParameters)) == 0;
+	}
+
+	void Upload()
+	{
+		if (s_Library.buffer == 0)
+		{
+			glGenBuffers(1, &s_Library.buffer);
+			int alignment = 0;
+			glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+			size_t align = alignment > 0 ? (size_t)alignment : 256;
+			s_Library.stride = (SLOT_SIZE + align - 1) / align * align;
+		}
+		std::vector<char> data(s_Library.materials.size() * s_Library.stride, 0);
+		for (size_t i = 0; i < s_Library.materials.size(); ++i)
+		{
+			Material& material = s_Library.materials[i];
+			std::memcpy(&data[i * s_Library.stride], &material.parameters, sizeof(MaterialParameters));
+			if (!s_Library.bindless || i == MaterialLibrary::NO_MATERIAL)
+				continue;
+			MaterialHandles handles;
+			bool arrays = UsesArrays(material);
+			for (unsigned int slot = 0; slot < Material::SLOT_COUNT; ++slot)
+			{
+				if (material.arrays[slot])
+					handles.maps[slot] = material.arrays[slot]->GetHandle();
+				else if (material.textures[slot] && !arrays)
+					handles.maps[slot] = material.textures[slot]->GetHandle();
+				else
+					handles.maps[slot] = glGetTextureHandleARB(arrays ? s_Library.missingArray : s_Library.missing2D);
+			}
+			std::memcpy(&data[i * s_Library.stride + sizeof(MaterialParameters)], &handles, sizeof(MaterialHandles));
+		}
+		glBindBuffer(GL_UNIFORM_BUFFER, s_Library.buffer);
+		glBufferData(GL_UNIFORM_BUFFER, data.size(), data.data(), GL_STATIC_DRAW);
+		glBindBuffer(GL_UNIFORM_BUFFER, 0);
+		s_Library.dirty = false;
+	}
+}
+
+unsigned int MaterialLibrary::Add(const Material& material)
+{
+	// Models have a handful of materials each, a linear search is fine
+	for (size_t i = 1; i < s_Library.materials.size(); ++i)
+	{
+		if (Equal(s_Library.materials[i], material))
+			return (unsigned int)i;
+	}
+	s_Library.materials.push_back(material);
+	s_Library.dirty = true;
+	return (unsigned int)s_Library.materials.size() - 1;
+}
+
+void MaterialLibrary::SetParameters(unsigned int id, const MaterialParameters& parameters)
+{
+	s_Library.materials[id].parameters = parameters;
+	s_Library.dirty = true;
+}
+
+const Material& MaterialLibrary::Get(unsigned int id)
+{
+	return s_Library.materials[id];
+}
+
+unsigned int MaterialLibrary::GetCount()
+{
+	return (unsigned int)s_Library.materials.size();
+}
+
+void MaterialLibrary::Bind(unsigned int id)
+{
+	if (id == NO_MATERIAL)
+		return;
+	if (s_Library.dirty)
+		Upload();
+	// Bindless handles are in the slot already
+	if (!s_Library.bindless)
+	{
+		const Material& material = s_Library.materials[id];
+		// The TEXTURE_ARRAY permutation samples every slot from the array target, a missing map has
+		// to be unbound there and not left over from the last material
+		bool arrays = UsesArrays(material);
+		for (unsigned int slot = 0; slot < Material::SLOT_COUNT; ++slot)
+		{
+			if (arrays)
+				RenderState::BindTexture(slot, GL_TEXTURE_2D_ARRAY, material.arrays[slot] ? material.arrays[slot]->GetID() : 0);
+			else
+				RenderState::BindTexture(slot, GL_TEXTURE_2D, material.textures[slot] ? material.textures[slot]->GetID() : 0);
+		}
+	}
+	glBindBufferRange(GL_UNIFORM_BUFFER, BLOCK_BINDING, s_Library.buffer, id * s_Library.stride, SLOT_SIZE);
+}
+
+void MaterialLibrary::SetupShader(Shader& shader)
+{
+	shader.Bind();
+	// Straight to GL, permutations without a normal map don't have its sampler and that's fine
+	for (unsigned int slot = 0; slot < Material::SLOT_COUNT; ++slot)
+	{
+		int location = glGetUniformLocation(shader.GetID(), SAMPLER_UNIFORMS[slot].c_str());
+		if (location != -1)
+			glUniform1i(location, slot);
+	}
+	int skybox = glGetUniformLocation(shader.GetID(), SKYBOX_UNIFORM.c_str());
+	if (skybox != -1)
+		glUniform1i(skybox, SKYBOX_UNIT);
+	unsigned int block = glGetUniformBlockIndex(shader.GetID(), "MaterialBlock");
+	if (block != GL_INVALID_INDEX)
+		glUniformBlockBinding(shader.GetID(), block, BLOCK_BINDING);
+}
+
+bool MaterialLibrary::EnableBindless()
+{
+	// The extension needs GLSL 4.00, see the BINDLESS shader permutation
+	if (!GLEW_ARB_bindless_texture || !GLEW_VERSION_4_0)
+		return false;
+	if (!s_Library.bindless)
+	{
+		s_Library.missing2D = CreateMissingMap(GL_TEXTURE_2D);
+		s_Library.missingArray = CreateMissingMap(GL_TEXTURE_2D_ARRAY);
+		s_Library.bindless = true;
+		s_Library.dirty = true;
+	}
+	return true;
+}
+
+bool MaterialLibrary::IsBindless()
+{
+	return s_Library.bindless;
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include <glm/glm.hpp>
+
+class Shader;
+class Texture;
+class TextureArray;
+
+// The MaterialBlock of BasicLit.fs, std140
+struct MaterialParameters
+{
+	// Kd and Ks, multiplied with the maps
+	glm::vec4 diffuse = glm::vec4(1.0f);
+	glm::vec4 specular = glm::vec4(1.0f);
+	// Ns
+	float shininess = 32.0f;
+	float reflectivity = 0.0f;
+	float padding[2] = {};
+};
+
+struct Material
+{
+	// Also the texture unit each map is bound to
+	enum Slot
+	{
+		DIFFUSE,
+		SPECULAR,
+		NORMAL,
+		SLOT_COUNT
+	};
+
+	// Owned by the model that loaded them, missing maps are nullptr and their unit gets texture 0
+	Texture* textures[SLOT_COUNT] = {};
+	// Instead of textures, for maps packed into arrays. Which layer is up to the vertices, see
+	// VertexLayers, so materials that only differ in layers are the same material.
+	TextureArray* arrays[SLOT_COUNT] = {};
+	MaterialParameters parameters;
+};
+
+// Every material of every model, each distinct one stored once. Meshes and draws refer to them by
+// ID. Parameters live in one uniform buffer, a slot per material, so switching materials is a few
+// texture binds and a glBindBufferRange(). With bindless textures the slot also has the maps'
+// handles and it's only the glBindBufferRange().
+class MaterialLibrary
+{
+public:
+	static constexpr unsigned int NO_MATERIAL = 0;
+	// Uniform buffer binding point of MaterialBlock, Matrices is 0
+	static constexpr unsigned int BLOCK_BINDING = 1;
+	// BasicLit.fs' environment map goes after the material's maps
+	static constexpr unsigned int SKYBOX_UNIT = Material::SLOT_COUNT;
+public:
+	// ID of an equal material if there already is one
+	static unsigned int Add(const Material& material);
+	// Affects everything using the material, equal ones were merged
+	static void SetParameters(unsigned int id, const MaterialParameters& parameters);
+	static const Material& Get(unsigned int id);
+	// Including NO_MATERIAL
+	static unsigned int GetCount();
+
+	// Binds the maps and the parameter slot. NO_MATERIAL binds nothing.
+	static void Bind(unsigned int id);
+	// Sampler units and the block binding, once per program that draws materials
+	static void SetupShader(Shader& shader);
+
+	// Switches to handles for programs built with BINDLESS and #version 400, before anything is
+	// drawn. False without ARB_bindless_texture or GL 4.0, then the maps keep being bound to units.
+	static bool EnableBindless();
+	static bool IsBindless();
+};
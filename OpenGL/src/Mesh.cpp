@@ -1,10 +1,13 @@
 #include "Mesh.h"
+#include "RenderState.h"
+#include "TangentSpace.h"
+#include <cmath>
 
 void Mesh::SetupMesh()
 {
 	// Setup the vertex array
 	glGenVertexArrays(1, &m_VAO);
-	glBindVertexArray(m_VAO);
+	RenderState::BindVertexArray(m_VAO);
 
 	// Setup the vertex buffer
 	glGenBuffers(1, &m_VBO);
@@ -13,7 +16,7 @@ void Mesh::SetupMesh()
 		GL_ARRAY_BUFFER,
 		m_Vertices.size() * sizeof(Vertex),
 		(const void*)&m_Vertices[0],
-		GL_STATIC_DRAW
+		IsSkinned() ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW
 	);
 
 	// Setup the index buffer
@@ -36,43 +39,84 @@ void Mesh::SetupMesh()
 	// Vertex Texture Coordinates
 	glEnableVertexAttribArray(2);
 	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (const void*)offsetof(Vertex, texCoords));
+
+	if (HasNormalMap())
+	{
+		glGenBuffers(1, &m_TangentVBO);
+		glBindBuffer(GL_ARRAY_BUFFER, m_TangentVBO);
+		glEnableVertexAttribArray(5);
+		if (m_PackedTangents)
+		{
+			// The whole tangent frame in 8 bytes, the shader ignores the normal attribute
+			std::vector<PackedTangentFrame> frames(m_Tangents.size());
+			for (size_t i = 0; i < frames.size(); ++i)
+				frames[i] = PackTangentFrame(m_Vertices[i].normal, m_Tangents[i]);
+			glBufferData(GL_ARRAY_BUFFER, frames.size() * sizeof(PackedTangentFrame), (const void*)&frames[0], GL_STATIC_DRAW);
+			glVertexAttribPointer(5, 4, GL_SHORT, GL_TRUE, sizeof(PackedTangentFrame), (const void*)0);
+		}
+		else
+		{
+			glBufferData(GL_ARRAY_BUFFER, m_Tangents.size() * sizeof(glm::vec4), (const void*)&m_Tangents[0], GL_STATIC_DRAW);
+			glVertexAttribPointer(5, 4, GL_FLOAT, GL_FALSE, sizeof(glm::vec4), (const void*)0);
+		}
+	}
+
+	if (!m_Layers.empty())
+	{
+		glGenBuffers(1, &m_LayerVBO);
+		glBindBuffer(GL_ARRAY_BUFFER, m_LayerVBO);
+		glBufferData(GL_ARRAY_BUFFER, m_Layers.size() * sizeof(VertexLayers), (const void*)&m_Layers[0], GL_STATIC_DRAW);
+		glEnableVertexAttribArray(6);
+		glVertexAttribIPointer(6, Material::SLOT_COUNT, GL_UNSIGNED_BYTE, sizeof(VertexLayers), (const void*)0);
+	}
+
+	if (!IsSkinned())
+		return;
+	glGenBuffers(1, &m_WeightVBO);
+	glBindBuffer(GL_ARRAY_BUFFER, m_WeightVBO);
+	glBufferData(GL_ARRAY_BUFFER, m_Weights.size() * sizeof(VertexWeights), (const void*)&m_Weights[0], GL_STATIC_DRAW);
+	// Bone indices, integers in the shader
+	glEnableVertexAttribArray(3);
+	glVertexAttribIPointer(3, 4, GL_UNSIGNED_BYTE, sizeof(VertexWeights), (const void*)offsetof(VertexWeights, bones));
+	// Bone weights
+	glEnableVertexAttribArray(4);
+	glVertexAttribPointer(4, 4, GL_FLOAT, GL_FALSE, sizeof(VertexWeights), (const void*)offsetof(VertexWeights, weights));
 }
 
-Mesh::Mesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices, std::vector<Texture*> textures) :
-	m_Vertices(vertices), m_Indices(indices), m_Textures(textures)
+Mesh::Mesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices, unsigned int material, std::vector<VertexWeights> weights,
+	std::vector<glm::vec4> tangents, bool packTangents, std::vector<VertexLayers> layers) :
+	m_WeightVBO(0), m_TangentVBO(0), m_PackedTangents(packTangents && !tangents.empty()), m_LayerVBO(0), m_MaterialID(material),
+	m_UvDensity(0.0f), m_Vertices(vertices), m_Indices(indices), m_Weights(weights), m_Tangents(tangents), m_Layers(layers)
 {
+	m_UvDensity = ComputeUvDensity();
 	SetupMesh();
 }
 
-void Mesh::Draw(Shader& shader, unsigned int skybox)
+float Mesh::ComputeUvDensity() const
 {
-	unsigned int diffuseNum = 0;
-	unsigned int specNum = 0;
-	unsigned int maxTextureTypes = 2;
-	for (unsigned int i = 0; i < m_Textures.size(); ++i)
-	{
-		std::string typeName = m_Textures[i]->GetTypeString();
-		shader.SetUniform1i("material." + typeName, i);
-		m_Textures[i]->Bind(i);
-	}
-	if (skybox != 0)
+	// Ratio of the total areas, so tiny or degenerate triangles barely count
+	double worldArea = 0.0, uvArea = 0.0;
+	for (size_t i = 0; i + 2 < m_Indices.size(); i += 3)
 	{
-		// We use maxTextureTypes rather than m_Textures.size()
-		// If there were 0 textures, diffuse and specular would be assigned to slot 0, but so would 
-		// the skybox! In that case, we'd have multiple texture types in the same texture slot!
-		glActiveTexture(GL_TEXTURE0 + maxTextureTypes);
-		glBindTexture(GL_TEXTURE_CUBE_MAP, skybox);
+		const Vertex& a = m_Vertices[m_Indices[i]];
+		const Vertex& b = m_Vertices[m_Indices[i + 1]];
+		const Vertex& c = m_Vertices[m_Indices[i + 2]];
+		worldArea += glm::length(glm::cross(b.position - a.position, c.position - a.position));
+		glm::vec2 uvB = b.texCoords - a.texCoords, uvC = c.texCoords - a.texCoords;
+		uvArea += std::abs(uvB.x * uvC.y - uvB.y * uvC.x);
 	}
-	shader.SetUniform1i("skybox", maxTextureTypes);
-
-
-	glActiveTexture(GL_TEXTURE0);
+	return worldArea > 0.0 ? (float)std::sqrt(uvArea / worldArea) : 0.0f;
+}
 
-	// Draw Mesh
-	glBindVertexArray(m_VAO);
+void Mesh::Draw()
+{
+	// The VAO is left bound, RenderState skips the rebind if the next draw uses the same mesh
+	RenderState::BindVertexArray(m_VAO);
 	glDrawElements(GL_TRIANGLES, m_Indices.size(), GL_UNSIGNED_INT, 0);
-	glBindVertexArray(0);
 }
 
-
-
+void Mesh::UpdateVertices(const Vertex* vertices)
+{
+	glBindBuffer(GL_ARRAY_BUFFER, m_VBO);
+	glBufferSubData(GL_ARRAY_BUFFER, 0, m_Vertices.size() * sizeof(Vertex), (const void*)vertices);
+}
@@ -4,23 +4,51 @@
 #include <glm/glm.hpp>
 #include <string>
 #include <vector>
-#include "Shader.h"
 #include "Vertex.h"
-#include "assimp/material.h"
-#include "Texture.h"
 
 class Mesh {
 private:
 	unsigned int m_VBO;
 	unsigned int m_VAO;
 	unsigned int m_EBO;
+	// Bone weights, only for skinned meshes
+	unsigned int m_WeightVBO;
+	// Tangents, only for meshes with a normal map
+	unsigned int m_TangentVBO;
+	bool m_PackedTangents;
+	// Texture array layers, only for meshes whose material has its maps in arrays
+	unsigned int m_LayerVBO;
+	// MaterialLibrary ID, draws are sorted by it
+	unsigned int m_MaterialID;
+	// Texture coordinate units per model space unit, averaged over the triangles by area
+	float m_UvDensity;
 public:
 	std::vector<Vertex> m_Vertices;
 	std::vector<unsigned int> m_Indices;
-	std::vector<Texture*> m_Textures;
+	// Empty unless the mesh is skinned, one per vertex otherwise
+	std::vector<VertexWeights> m_Weights;
+	// Empty unless the mesh has a normal map, see OrthogonalizeTangent() for what w is
+	std::vector<glm::vec4> m_Tangents;
+	// Empty unless the material's maps are in arrays
+	std::vector<VertexLayers> m_Layers;
 private:
 	void SetupMesh();
+	float ComputeUvDensity() const;
 public:
-	Mesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices, std::vector<Texture*> textures);
-	void Draw(Shader& shader, unsigned int skybox);
+	Mesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices, unsigned int material,
+		std::vector<VertexWeights> weights = std::vector<VertexWeights>(), std::vector<glm::vec4> tangents = std::vector<glm::vec4>(),
+		bool packTangents = false, std::vector<VertexLayers> layers = std::vector<VertexLayers>());
+	// Only the draw itself, the material and uniforms are up to the caller, see RenderQueue::Execute()
+	void Draw();
+	// Replaces the vertex buffer's contents, for skinning on the CPU. Draws already recorded use the
+	// new vertices too, so it only works for one pose per frame.
+	void UpdateVertices(const Vertex* vertices);
+
+	bool IsSkinned() const { return !m_Weights.empty(); }
+	// Needs a shader built with NORMAL_MAP, and PACKED_TANGENT_FRAME if the tangents were packed
+	bool HasNormalMap() const { return !m_Tangents.empty(); }
+	bool HasPackedTangents() const { return m_PackedTangents; }
+	unsigned int GetMaterialID() const { return m_MaterialID; }
+	// Times a map's size, the texels per model unit its finest level has on this mesh
+	float GetUvDensity() const { return m_UvDensity; }
 };
\ No newline at end of file
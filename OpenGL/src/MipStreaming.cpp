@@ -0,0 +1,182 @@
+#include "MipStreaming.h"
+#include "BinaryIO.h"
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+	const uint32_t MIPS_MAGIC = 0x5350494d; // "MIPS"
+	const uint32_t MIPS_VERSION = 1;
+	const uint32_t MAX_LEVELS = 32;
+
+	uint32_t LevelSize(uint32_t size, uint32_t level)
+	{
+		return std::max(size >> level, 1u);
+	}
+}
+
+MipChainFile::MipChainFile() :
+	m_Header()
+{
+}
+
+bool MipChainFile::Build(const Image& image, const std::string& path)
+{
+	if (image.channels != 4 || image.width <= 0 || image.height <= 0)
+		return false;
+	MipChainHeader header = { MIPS_MAGIC, MIPS_VERSION, (uint32_t)image.width, (uint32_t)image.height,
+		GetMipLevelCount((uint32_t)image.width, (uint32_t)image.height) };
+
+	std::ofstream file(path, std::ios::binary);
+	if (!file)
+		return false;
+	Write(file, header);
+	uint64_t offset = sizeof(MipChainHeader) + header.levelCount * sizeof(uint64_t);
+	for (uint32_t level = 0; level < header.levelCount; ++level)
+	{
+		Write(file, offset);
+		offset += GetMipChainBytes(header.width, header.height, level) - GetMipChainBytes(header.width, header.height, level + 1);
+	}
+
+	Image level = image;
+	for (uint32_t i = 0; i < header.levelCount; ++i)
+	{
+		if (i > 0)
+			level = Downsample(level);
+		Image flipped = level;
+		flipped.FlipVertically();
+		file.write((const char*)flipped.pixels.data(), flipped.pixels.size());
+	}
+	return (bool)file;
+}
+
+bool MipChainFile::Open(const std::string& path)
+{
+	m_File.close();
+	m_File.open(path, std::ios::binary);
+	if (!m_File || !Read(m_File, m_Header) || m_Header.magic != MIPS_MAGIC || m_Header.version != MIPS_VERSION
+		|| m_Header.width == 0 || m_Header.height == 0 || m_Header.levelCount != GetMipLevelCount(m_Header.width, m_Header.height))
+	{
+		m_File.close();
+		m_Header = MipChainHeader();
+		return false;
+	}
+	m_Offsets.resize(m_Header.levelCount);
+	if (!m_File.read((char*)m_Offsets.data(), m_Offsets.size() * sizeof(uint64_t)))
+	{
+		m_File.close();
+		return false;
+	}
+	return true;
+}
+
+bool MipChainFile::ReadLevel(uint32_t level, unsigned char* pixels)
+{
+	if (!m_File.is_open() || level >= m_Header.levelCount)
+		return false;
+	m_File.clear();
+	m_File.seekg((std::streamoff)m_Offsets[level]);
+	return (bool)m_File.read((char*)pixels, (std::streamsize)GetLevelBytes(level));
+}
+
+uint32_t MipChainFile::GetLevelWidth(uint32_t level) const
+{
+	return LevelSize(m_Header.width, level);
+}
+
+uint32_t MipChainFile::GetLevelHeight(uint32_t level) const
+{
+	return LevelSize(m_Header.height, level);
+}
+
+uint64_t MipChainFile::GetLevelBytes(uint32_t level) const
+{
+	return (uint64_t)GetLevelWidth(level) * GetLevelHeight(level) * 4;
+}
+
+uint32_t GetMipLevelCount(uint32_t width, uint32_t height)
+{
+	uint32_t levels = 1;
+	while ((std::max(width, height) >> levels) > 0 && levels < MAX_LEVELS)
+		++levels;
+	return levels;
+}
+
+uint64_t GetMipChainBytes(uint32_t width, uint32_t height, uint32_t first)
+{
+	uint64_t bytes = 0;
+	for (uint32_t level = first; level < GetMipLevelCount(width, height); ++level)
+		bytes += (uint64_t)LevelSize(width, level) * LevelSize(height, level) * 4;
+	return bytes;
+}
+
+uint64_t PlanMipResidency(const MipRequest* requests, size_t count, uint64_t budgetBytes, uint32_t* levels, MipPlanScratch& scratch)
+{
+	std::vector<uint32_t>& coarsest = scratch.coarsest;
+	std::vector<double>& scores = scratch.scores;
+	std::vector<MipPlanScratch::DropCandidate>& candidates = scratch.candidates;
+	coarsest.resize(count);
+	scores.resize(count);
+	candidates.clear();
+	candidates.reserve(count);
+	uint64_t residentBytes = 0;
+	for (size_t i = 0; i < count; ++i)
+	{
+		const MipRequest& request = requests[i];
+		uint32_t levelCount = GetMipLevelCount(request.width, request.height);
+		coarsest[i] = levelCount - std::min(std::max(request.minResident, 1u), levelCount);
+		levels[i] = std::min(request.wanted, coarsest[i]);
+		scores[i] = std::max(request.priority, 0.0f);
+		residentBytes += GetMipChainBytes(request.width, request.height, levels[i]);
+	}
+	if (residentBytes <= budgetBytes)
+		return residentBytes;
+
+	auto candidate = [&](size_t i)
+	{
+		const MipRequest& request = requests[i];
+		MipPlanScratch::DropCandidate drop = { scores[i], (uint64_t)LevelSize(request.width, levels[i]) * LevelSize(request.height, levels[i]) * 4, i };
+		return drop;
+	};
+	for (size_t i = 0; i < count; ++i)
+	{
+		if (levels[i] < coarsest[i])
+			candidates.push_back(candidate(i));
+	}
+	std::make_heap(candidates.begin(), candidates.end());
+	while (residentBytes > budgetBytes && !candidates.empty())
+	{
+		std::pop_heap(candidates.begin(), candidates.end());
+		MipPlanScratch::DropCandidate drop = candidates.back();
+		candidates.pop_back();
+		residentBytes -= drop.bytes;
+		++levels[drop.index];
+		scores[drop.index] *= 4.0;
+		if (levels[drop.index] < coarsest[drop.index])
+		{
+			candidates.push_back(candidate(drop.index));
+			std::push_heap(candidates.begin(), candidates.end());
+		}
+	}
+	return residentBytes;
+}
+
+float PixelsPerWorldUnit(const Bounds& bounds, const glm::vec3& cameraPosition, float fovYRadians, float screenHeight)
+{
+	if (!bounds.IsValid())
+		return 0.0f;
+	// Inside the box counts as very close rather than infinitely close
+	glm::vec3 nearest = glm::clamp(cameraPosition, bounds.min, bounds.max);
+	float distance = std::max(glm::length(nearest - cameraPosition), 0.01f);
+	return screenHeight / (2.0f * std::tan(fovYRadians * 0.5f) * distance);
+}
+
+uint32_t WantedMip(float texelsPerUnit, float pixelsPerUnit)
+{
+	if (!(pixelsPerUnit > 0.0f))
+		return MAX_LEVELS - 1;
+	float ratio = texelsPerUnit / pixelsPerUnit;
+	if (!(ratio > 1.0f))
+		return 0;
+	return std::min((uint32_t)std::floor(std::log2(ratio)), MAX_LEVELS - 1);
+}
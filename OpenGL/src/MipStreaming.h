@@ -0,0 +1,104 @@
+#pragma once
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+#include "Bounds.h"
+#include "Image.h"
+
+// The GL-free side of TextureStreamer: the file the mip chains are read from, the decision which
+// levels each texture keeps within a memory budget, and the texel density math that decides which
+// levels it wants. MipStreamingBenchmark drives the planning on its own.
+//
+// A .mips holds every level of an RGBA image down to 1x1. Layout, native byte order: header, one
+// uint64 file offset per level (level 0 first), then the levels as tightly packed RGBA rows,
+// bottom row first so they go to glTexImage2D as they are.
+struct MipChainHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	// Of level 0
+	uint32_t width;
+	uint32_t height;
+	uint32_t levelCount;
+};
+
+class MipChainFile
+{
+private:
+	MipChainHeader m_Header;
+	std::vector<uint64_t> m_Offsets;
+	std::ifstream m_File;
+public:
+	MipChainFile();
+
+	// Writes the mips of a 4 channel image, top row first like LoadImage() gives them
+	static bool Build(const Image& image, const std::string& path);
+
+	bool Open(const std::string& path);
+	bool IsOpen() const { return m_File.is_open(); }
+	// GetLevelBytes(level) bytes
+	bool ReadLevel(uint32_t level, unsigned char* pixels);
+
+	uint32_t GetWidth() const { return m_Header.width; }
+	uint32_t GetHeight() const { return m_Header.height; }
+	uint32_t GetLevelCount() const { return m_Header.levelCount; }
+	uint32_t GetLevelWidth(uint32_t level) const;
+	uint32_t GetLevelHeight(uint32_t level) const;
+	uint64_t GetLevelBytes(uint32_t level) const;
+};
+
+// Levels in a mip chain of that size down to 1x1
+uint32_t GetMipLevelCount(uint32_t width, uint32_t height);
+// RGBA8 bytes of levels [first, GetMipLevelCount()) together
+uint64_t GetMipChainBytes(uint32_t width, uint32_t height, uint32_t first);
+
+// What one texture would like to have resident. Levels are GL's, 0 is the finest.
+struct MipRequest
+{
+	uint32_t width = 0;
+	uint32_t height = 0;
+	// Finest level the view needs
+	uint32_t wanted = 0;
+	// The coarsest levels that always stay, the texture never goes below them
+	uint32_t minResident = 1;
+	// How much the texture matters on screen, those with less lose levels first. 0 for textures
+	// nobody looks at.
+	float priority = 0.0f;
+};
+
+// Working memory of PlanMipResidency(). Keep one around, once it has grown to the texture count
+// planning doesn't allocate.
+struct MipPlanScratch
+{
+	// Next texture to lose a level, the one losing the least. Equal ones give up the bigger level.
+	struct DropCandidate
+	{
+		double score;
+		uint64_t bytes;
+		size_t index;
+
+		bool operator<(const DropCandidate& other) const
+		{
+			return score != other.score ? score > other.score : bytes < other.bytes;
+		}
+	};
+
+	std::vector<uint32_t> coarsest;
+	std::vector<double> scores;
+	// A heap, at most one candidate per texture
+	std::vector<DropCandidate> candidates;
+};
+
+// Finest resident level for each of the count requests, written to levels. Starts from what each
+// wants and, while the total is over budget, drops the top level of whichever texture loses the
+// least by it. Every drop halves a texture's resolution, so a texture's cost of giving up another
+// level goes up by 4 with each. If the minimum levels alone don't fit, that's what's planned.
+// Returns the bytes the planned levels take.
+uint64_t PlanMipResidency(const MipRequest* requests, size_t count, uint64_t budgetBytes, uint32_t* levels, MipPlanScratch& scratch);
+
+// Screen pixels a world unit covers at the point of bounds nearest to the camera
+float PixelsPerWorldUnit(const Bounds& bounds, const glm::vec3& cameraPosition, float fovYRadians, float screenHeight);
+// Level at which a texel covers about a pixel, texelsPerUnit is level 0's texels per world unit
+uint32_t WantedMip(float texelsPerUnit, float pixelsPerUnit);
@@ -1,38 +1,218 @@
 #include "Model.h"
+#include "AnimationImport.h"
+#include <algorithm>
+#include <fstream>
 #include <iostream>
+#include "CpuProfiler.h"
+#include "RenderState.h"
+#include "TangentSpace.h"
+#include "TextureBatching.h"
+#include "TextureStreamer.h"
 #include "vendor/stb_image/stb_image.h"
 
+namespace
+{
+	// Assimp's matrices are row major
+	glm::mat4 ToMat4(const aiMatrix4x4& m)
+	{
+		return glm::mat4(
+			m.a1, m.b1, m.c1, m.d1,
+			m.a2, m.b2, m.c2, m.d2,
+			m.a3, m.b3, m.c3, m.d3,
+			m.a4, m.b4, m.c4, m.d4);
+	}
+
+	// Where each Material::Slot's map comes from. OBJ's map_Bump comes in as a height map, the ones
+	// we have are normal maps.
+	aiTextureType GetSlotType(const aiMaterial* material, unsigned int slot)
+	{
+		switch (slot)
+		{
+		case Material::DIFFUSE: return aiTextureType_DIFFUSE;
+		case Material::SPECULAR: return aiTextureType_SPECULAR;
+		default: return material->GetTextureCount(aiTextureType_NORMALS) > 0 ? aiTextureType_NORMALS : aiTextureType_HEIGHT;
+		}
+	}
+
+	MaterialParameters ReadParameters(const aiMaterial* material)
+	{
+		MaterialParameters parameters;
+		aiColor3D color;
+		if (material->Get(AI_MATKEY_COLOR_DIFFUSE, color) == AI_SUCCESS)
+			parameters.diffuse = glm::vec4(color.r, color.g, color.b, 1.0f);
+		if (material->Get(AI_MATKEY_COLOR_SPECULAR, color) == AI_SUCCESS)
+			parameters.specular = glm::vec4(color.r, color.g, color.b, 1.0f);
+		float shininess = 0.0f;
+		// pow(x, 0) lights up everything, keep the default for that
+		if (material->Get(AI_MATKEY_SHININESS, shininess) == AI_SUCCESS && shininess > 0.0f)
+			parameters.shininess = shininess;
+		return parameters;
+	}
+
+	// Keeps the strongest influences if there are more than fit
+	void AddInfluence(VertexWeights& vertex, uint8_t bone, float weight)
+	{
+		unsigned int weakest = 0;
+		for (unsigned int i = 1; i < VertexWeights::MAX_INFLUENCES; ++i)
+		{
+			if (vertex.weights[i] < vertex.weights[weakest])
+				weakest = i;
+		}
+		if (weight <= vertex.weights[weakest])
+			return;
+		vertex.bones[weakest] = bone;
+		vertex.weights[weakest] = weight;
+	}
+}
+
 void Model::LoadModel(std::string path)
 {
+	PROFILE_SCOPE("Model::LoadModel");
 	Assimp::Importer importer;
-	const aiScene* scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_FlipUVs);
+	const aiScene* scene;
+	{
+		PROFILE_SCOPE("Assimp::ReadFile");
+		scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_FlipUVs | aiProcess_LimitBoneWeights
+			| aiProcess_CalcTangentSpace);
+	}
 	if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)
 	{
 		std::cout << "ERROR::ASSIMP::" << importer.GetErrorString() << std::endl;
 		return;
 	}
 	m_Directory = path.substr(0, path.find_last_of('/'));
-	ProcessNode(scene->mRootNode, scene);
+	ImportSkeleton(scene->mRootNode, m_Skeleton);
+	if (m_Settings.textureArrays)
+		ProcessMaterialArrays(scene);
+	else
+		ProcessMaterials(scene);
+	std::vector<ImportedMesh> meshes;
+	ProcessNode(scene->mRootNode, scene, TransformHierarchy::NO_PARENT, meshes);
+	CreateMeshes(meshes);
+
+	// Bones are found by name while the meshes are loaded, before all nodes are known
+	m_Skeleton.boneJoints.resize(m_Skeleton.inverseBindMatrices.size(), 0);
+	for (const auto& bone : m_BoneIndices)
+	{
+		uint32_t joint = m_Skeleton.FindJoint(bone.first);
+		if (joint == TransformHierarchy::NO_PARENT)
+			std::cout << "WARNING::MODEL::bone " << bone.first << " has no node in " << path << std::endl;
+		else
+			m_Skeleton.boneJoints[bone.second] = joint;
+	}
+	ImportAnimations(scene, m_Skeleton, m_Clips);
+
+	m_HasMeshTransforms = false;
+	for (uint32_t node : m_MeshNodes)
+		m_HasMeshTransforms |= m_Nodes.GetWorld(node) != glm::mat4(1.0f);
+}
+
+void Model::ProcessMaterials(const aiScene* scene)
+{
+	for (unsigned int i = 0; i < scene->mNumMaterials; ++i)
+	{
+		aiMaterial* source = scene->mMaterials[i];
+		Material material;
+		// Only the first map of each kind
+		for (unsigned int slot = 0; slot < Material::SLOT_COUNT; ++slot)
+		{
+			std::vector<Texture*> maps = LoadMaterialTextures(source, GetSlotType(source, slot));
+			material.textures[slot] = maps.empty() ? nullptr : maps[0];
+		}
+		material.parameters = ReadParameters(source);
+		m_Materials.push_back(MaterialLibrary::Add(material));
+	}
+}
+
+void Model::ProcessMaterialArrays(const aiScene* scene)
+{
+	// Every map once, only their sizes are read up front
+	const uint32_t NO_IMAGE = 0xffffffff;
+	std::map<std::string, uint32_t> imageIndices;
+	std::vector<std::string> paths;
+	std::vector<int> widths, heights;
+	std::vector<uint32_t> materialImages(scene->mNumMaterials * Material::SLOT_COUNT, NO_IMAGE);
+	for (unsigned int i = 0; i < scene->mNumMaterials; ++i)
+	{
+		aiMaterial* source = scene->mMaterials[i];
+		for (unsigned int slot = 0; slot < Material::SLOT_COUNT; ++slot)
+		{
+			aiString name;
+			if (source->GetTexture(GetSlotType(source, slot), 0, &name) != AI_SUCCESS)
+				continue;
+			std::string path = m_Directory + "/" + name.C_Str();
+			auto found = imageIndices.find(path);
+			if (found == imageIndices.end())
+			{
+				int width = 0, height = 0, components = 0;
+				if (!stbi_info(path.c_str(), &width, &height, &components))
+				{
+					std::cout << "WARNING::MODEL::couldn't read " << path << std::endl;
+					continue;
+				}
+				found = imageIndices.insert(std::make_pair(path, (uint32_t)paths.size())).first;
+				paths.push_back(path);
+				widths.push_back(width);
+				heights.push_back(height);
+			}
+			materialImages[i * Material::SLOT_COUNT + slot] = found->second;
+		}
+	}
+
+	TextureArrayPlan plan = TextureArrayPlan::Plan(widths, heights);
+	for (const TextureArrayPlan::Array& array : plan.arrays)
+	{
+		std::vector<std::string> layerPaths;
+		for (uint32_t image : array.images)
+			layerPaths.push_back(paths[image]);
+		m_TextureArrays.push_back(new TextureArray(array.width, array.height, layerPaths));
+	}
+
+	for (unsigned int i = 0; i < scene->mNumMaterials; ++i)
+	{
+		Material material;
+		VertexLayers layers = {};
+		for (unsigned int slot = 0; slot < Material::SLOT_COUNT; ++slot)
+		{
+			uint32_t image = materialImages[i * Material::SLOT_COUNT + slot];
+			if (image == NO_IMAGE)
+				continue;
+			material.arrays[slot] = m_TextureArrays[plan.placements[image].array];
+			layers.layers[slot] = (uint8_t)plan.placements[image].layer;
+		}
+		material.parameters = ReadParameters(scene->mMaterials[i]);
+		m_Materials.push_back(MaterialLibrary::Add(material));
+		m_MaterialLayers.push_back(layers);
+	}
 }
 
-void Model::ProcessNode(aiNode* node, const aiScene* scene)
+unsigned int Model::GetMaterialID(unsigned int material) const
 {
+	return material < m_Materials.size() ? m_Materials[material] : MaterialLibrary::NO_MATERIAL;
+}
+
+void Model::ProcessNode(aiNode* node, const aiScene* scene, uint32_t parent, std::vector<ImportedMesh>& meshes)
+{
+	uint32_t index = m_Nodes.AddNode(parent, ToMat4(node->mTransformation));
+	// Only this node is dirty, its parent was updated when it was added
+	m_Nodes.Update();
 	for (unsigned int i = 0; i < node->mNumMeshes; ++i)
 	{
 		aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
-		m_Meshes.push_back(ProcessMesh(mesh, scene));
+		meshes.push_back(ProcessMesh(mesh, m_Nodes.GetWorld(index)));
+		meshes.back().node = index;
 	}
 	for (unsigned int i = 0; i < node->mNumChildren; ++i)
 	{
-		ProcessNode(node->mChildren[i], scene);
+		ProcessNode(node->mChildren[i], scene, index, meshes);
 	}
 }
 
-Mesh Model::ProcessMesh(aiMesh* mesh, const aiScene* scene)
+Model::ImportedMesh Model::ProcessMesh(aiMesh* mesh, const glm::mat4& transform)
 {
-	std::vector<Vertex> vertices;
-	std::vector<unsigned int> indices;
-	std::vector<Texture*> textures;
+	ImportedMesh result;
+	std::vector<Vertex>& vertices = result.vertices;
+	std::vector<unsigned int>& indices = result.indices;
 
 	for (unsigned int i = 0; i < mesh->mNumVertices; ++i)
 	{
@@ -41,6 +221,7 @@ Mesh Model::ProcessMesh(aiMesh* mesh, const aiScene* scene)
 		vertex.position.x = mesh->mVertices[i].x;
 		vertex.position.y = mesh->mVertices[i].y;
 		vertex.position.z = mesh->mVertices[i].z;
+		m_Bounds.Expand(glm::vec3(transform * glm::vec4(vertex.position, 1.0f)));
 
 		vertex.normal.x = mesh->mNormals[i].x;
 		vertex.normal.y = mesh->mNormals[i].y;
@@ -67,18 +248,135 @@ Mesh Model::ProcessMesh(aiMesh* mesh, const aiScene* scene)
 			indices.push_back(face.mIndices[j]);
 		}
 	}
-	// process materials
-	if (mesh->mMaterialIndex >= 0)
+	result.material = mesh->mMaterialIndex;
+	// Tangents are only worth their bandwidth with a map to go with them
+	const Material& material = MaterialLibrary::Get(GetMaterialID(mesh->mMaterialIndex));
+	if ((material.textures[Material::NORMAL] || material.arrays[Material::NORMAL]) && mesh->HasTangentsAndBitangents())
+		result.tangents = ProcessTangents(mesh);
+	result.weights = ProcessBones(mesh);
+	return result;
+}
+
+void Model::CreateMeshes(std::vector<ImportedMesh>& meshes)
+{
+	m_ImportedMeshCount = (unsigned int)meshes.size();
+	if (!m_Settings.textureArrays)
+	{
+		for (ImportedMesh& mesh : meshes)
+		{
+			m_Meshes.push_back(Mesh(std::move(mesh.vertices), std::move(mesh.indices), GetMaterialID(mesh.material),
+				std::move(mesh.weights), std::move(mesh.tangents), m_Settings.packTangentFrames));
+			m_MeshNodes.push_back(mesh.node);
+		}
+		return;
+	}
+
+	std::vector<BatchKey> keys(meshes.size());
+	std::vector<glm::mat4> transforms;
+	for (size_t i = 0; i < meshes.size(); ++i)
 	{
-		aiMaterial* material = scene->mMaterials[mesh->mMaterialIndex];
+		const glm::mat4& world = m_Nodes.GetWorld(meshes[i].node);
+		size_t transform = std::find(transforms.begin(), transforms.end(), world) - transforms.begin();
+		if (transform == transforms.size())
+			transforms.push_back(world);
+		keys[i].material = GetMaterialID(meshes[i].material);
+		keys[i].transform = (uint32_t)transform;
+		keys[i].streams = (meshes[i].weights.empty() ? 0 : 1) | (meshes[i].tangents.empty() ? 0 : 2);
+	}
+	uint32_t batchCount = 0;
+	std::vector<uint32_t> batches = GroupBatches(keys, batchCount);
 
-		std::vector<Texture*> diffuseMaps = LoadMaterialTextures(material, aiTextureType_DIFFUSE);
-		textures.insert(textures.end(), diffuseMaps.begin(), diffuseMaps.end());
+	std::vector<ImportedMesh> merged(batchCount);
+	std::vector<std::vector<VertexLayers>> layers(batchCount);
+	for (size_t i = 0; i < meshes.size(); ++i)
+	{
+		ImportedMesh& mesh = meshes[i];
+		ImportedMesh& batch = merged[batches[i]];
+		if (batch.vertices.empty())
+		{
+			batch.material = mesh.material;
+			batch.node = mesh.node;
+		}
+		unsigned int base = (unsigned int)batch.vertices.size();
+		batch.vertices.insert(batch.vertices.end(), mesh.vertices.begin(), mesh.vertices.end());
+		batch.weights.insert(batch.weights.end(), mesh.weights.begin(), mesh.weights.end());
+		batch.tangents.insert(batch.tangents.end(), mesh.tangents.begin(), mesh.tangents.end());
+		for (unsigned int index : mesh.indices)
+			batch.indices.push_back(base + index);
+		// Layer 0 for a mesh without a material, like GetMaterialID() gives it none
+		VertexLayers meshLayers = mesh.material < m_MaterialLayers.size() ? m_MaterialLayers[mesh.material] : VertexLayers();
+		layers[batches[i]].resize(batch.vertices.size(), meshLayers);
+	}
+	for (uint32_t i = 0; i < batchCount; ++i)
+	{
+		ImportedMesh& batch = merged[i];
+		m_Meshes.push_back(Mesh(std::move(batch.vertices), std::move(batch.indices), GetMaterialID(batch.material),
+			std::move(batch.weights), std::move(batch.tangents), m_Settings.packTangentFrames, std::move(layers[i])));
+		m_MeshNodes.push_back(batch.node);
+	}
+}
 
-		std::vector<Texture*> specMaps = LoadMaterialTextures(material, aiTextureType_SPECULAR);
-		textures.insert(textures.end(), specMaps.begin(), specMaps.end());
+std::vector<glm::vec4> Model::ProcessTangents(aiMesh* mesh)
+{
+	std::vector<glm::vec4> tangents(mesh->mNumVertices);
+	for (unsigned int i = 0; i < mesh->mNumVertices; ++i)
+	{
+		const aiVector3D& normal = mesh->mNormals[i];
+		const aiVector3D& tangent = mesh->mTangents[i];
+		const aiVector3D& bitangent = mesh->mBitangents[i];
+		tangents[i] = OrthogonalizeTangent(glm::vec3(normal.x, normal.y, normal.z), glm::vec3(tangent.x, tangent.y, tangent.z),
+			glm::vec3(bitangent.x, bitangent.y, bitangent.z));
 	}
-	return Mesh(vertices, indices, textures);
+	return tangents;
+}
+
+std::vector<VertexWeights> Model::ProcessBones(aiMesh* mesh)
+{
+	std::vector<VertexWeights> weights;
+	if (!mesh->HasBones())
+		return weights;
+
+	weights.resize(mesh->mNumVertices, VertexWeights());
+	for (unsigned int i = 0; i < mesh->mNumBones; ++i)
+	{
+		const aiBone* bone = mesh->mBones[i];
+		auto found = m_BoneIndices.find(bone->mName.C_Str());
+		uint32_t index;
+		if (found != m_BoneIndices.end())
+		{
+			index = found->second;
+		}
+		else
+		{
+			index = (uint32_t)m_Skeleton.inverseBindMatrices.size();
+			if (index >= Skeleton::MAX_BONES)
+			{
+				std::cout << "WARNING::MODEL::more than " << Skeleton::MAX_BONES << " bones, ignoring " << bone->mName.C_Str() << std::endl;
+				continue;
+			}
+			m_BoneIndices[bone->mName.C_Str()] = index;
+			m_Skeleton.inverseBindMatrices.push_back(ToMat4(bone->mOffsetMatrix));
+		}
+
+		for (unsigned int j = 0; j < bone->mNumWeights; ++j)
+			AddInfluence(weights[bone->mWeights[j].mVertexId], (uint8_t)index, bone->mWeights[j].mWeight);
+	}
+
+	for (VertexWeights& vertex : weights)
+	{
+		float total = 0.0f;
+		for (unsigned int i = 0; i < VertexWeights::MAX_INFLUENCES; ++i)
+			total += vertex.weights[i];
+		// Vertices no bone cares about follow the first bone
+		if (total <= 0.0f)
+		{
+			vertex.weights[0] = 1.0f;
+			continue;
+		}
+		for (unsigned int i = 0; i < VertexWeights::MAX_INFLUENCES; ++i)
+			vertex.weights[i] /= total;
+	}
+	return weights;
 }
 
 std::vector<Texture*> Model::LoadMaterialTextures(aiMaterial* mat, aiTextureType type)
@@ -97,21 +395,46 @@ std::vector<Texture*> Model::LoadMaterialTextures(aiMaterial* mat, aiTextureType
 		}
 		if (skip) continue;
 
-		Texture* texture = new Texture(m_Directory + "/" + str.C_Str(), type);
+		std::string path = m_Directory + "/" + str.C_Str();
+		Texture* texture = nullptr;
+		if (m_Settings.mipStreamer && std::ifstream(path + ".mips"))
+			texture = m_Settings.mipStreamer->Load(path + ".mips", type);
+		if (!texture)
+			texture = new Texture(path, type);
 		textures.push_back(texture);
 		m_LoadedTextures[str.C_Str()] = texture;
 	}
 	return textures;
 }
 
-Model::Model(const char* path)
+Model::Model(const char* path, const ModelSettings& settings) :
+	m_ImportedMeshCount(0), m_HasMeshTransforms(false), m_Settings(settings)
 {
 	LoadModel(path);
 }
 
-void Model::Draw(Shader& shader, unsigned int skybox)
+void Model::Draw(unsigned int skybox)
 {
+	if (skybox != 0)
+		RenderState::BindTexture(MaterialLibrary::SKYBOX_UNIT, GL_TEXTURE_CUBE_MAP, skybox);
 	for (unsigned int i = 0; i < m_Meshes.size(); ++i) {
-		m_Meshes[i].Draw(shader, skybox);
+		MaterialLibrary::Bind(m_Meshes[i].GetMaterialID());
+		m_Meshes[i].Draw();
+	}
+}
+
+void Model::Submit(RenderQueue& queue, unsigned int pass, Shader& shader, const glm::mat4* model, const DrawParams* params)
+{
+	for (unsigned int i = 0; i < m_Meshes.size(); ++i) {
+		// Without a model matrix the shader doesn't take one either, like the skybox's. The bones
+		// of skinned meshes already include the node transforms.
+		if (!m_HasMeshTransforms || !model || m_Meshes[i].IsSkinned())
+		{
+			queue.Submit(pass, m_Meshes[i], shader, model, params);
+			continue;
+		}
+		// The queue keeps a copy, so a temporary is fine
+		glm::mat4 transform = *model * GetMeshTransform(i);
+		queue.Submit(pass, m_Meshes[i], shader, &transform, params);
 	}
 }
@@ -6,21 +6,97 @@
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
 #include "Texture.h"
+#include "RenderQueue.h"
+#include "Bounds.h"
+#include "TransformHierarchy.h"
+#include "Animation.h"
+#include "Material.h"
+#include "TextureArray.h"
 #include <map>
 
+class TextureStreamer;
+
+// Choices made while importing
+struct ModelSettings
+{
+	// Meshes with a normal map get their tangent frames as one quaternion, see PackedTangentFrame
+	bool packTangentFrames = false;
+	// Material maps go into texture arrays by size, and meshes that end up with the same material,
+	// node transform and vertex streams are merged into one draw. Needs the TEXTURE_ARRAY
+	// permutation of BasicLit.
+	bool textureArrays = false;
+	// Maps with a .mips next to them (AssetTool mips) start out coarse and stream in their finer
+	// levels through it. Not for maps packed into arrays.
+	TextureStreamer* mipStreamer = nullptr;
+};
+
 class Model {
 private:
 	std::vector<Mesh> m_Meshes;
 	std::map<std::string, Texture*> m_LoadedTextures;
+	// MaterialLibrary IDs by aiMaterial index
+	std::vector<unsigned int> m_Materials;
+	// Only with ModelSettings::textureArrays, the layers of each aiMaterial's maps in the arrays
+	std::vector<TextureArray*> m_TextureArrays;
+	std::vector<VertexLayers> m_MaterialLayers;
+	// Before merging
+	unsigned int m_ImportedMeshCount;
 	std::string m_Directory;
+	Bounds m_Bounds;
+	// The file's node tree, each mesh hangs off one of the nodes
+	TransformHierarchy m_Nodes;
+	std::vector<uint32_t> m_MeshNodes;
+	bool m_HasMeshTransforms;
+	// Every node is a joint, the bones are the nodes some mesh is weighted to
+	Skeleton m_Skeleton;
+	std::map<std::string, uint32_t> m_BoneIndices;
+	std::vector<AnimationClip> m_Clips;
+	ModelSettings m_Settings;
+private:
+	// A mesh as it's read, before it's uploaded or merged with others
+	struct ImportedMesh
+	{
+		std::vector<Vertex> vertices;
+		std::vector<unsigned int> indices;
+		std::vector<VertexWeights> weights;
+		std::vector<glm::vec4> tangents;
+		// aiMaterial index
+		unsigned int material = 0;
+		uint32_t node = 0;
+	};
 private:
 	void LoadModel(std::string path);
-	void ProcessNode(aiNode* node, const aiScene* scene);
-	Mesh ProcessMesh(aiMesh* mesh, const aiScene* scene);
+	void ProcessMaterials(const aiScene* scene);
+	void ProcessMaterialArrays(const aiScene* scene);
+	void ProcessNode(aiNode* node, const aiScene* scene, uint32_t parent, std::vector<ImportedMesh>& meshes);
+	ImportedMesh ProcessMesh(aiMesh* mesh, const glm::mat4& transform);
+	void CreateMeshes(std::vector<ImportedMesh>& meshes);
+	unsigned int GetMaterialID(unsigned int material) const;
+	std::vector<VertexWeights> ProcessBones(aiMesh* mesh);
+	std::vector<glm::vec4> ProcessTangents(aiMesh* mesh);
 	std::vector<Texture*> LoadMaterialTextures(aiMaterial* mat, aiTextureType type);
 public:
-	Model(const char* path);
-	void Draw(Shader& shader, unsigned int skybox = 0);
+	Model(const char* path, const ModelSettings& settings = ModelSettings());
+	// Straight away with whatever program is bound, which MaterialLibrary::SetupShader() has seen
+	void Draw(unsigned int skybox = 0);
+	// Records one command per mesh instead of drawing immediately
+	void Submit(RenderQueue& queue, unsigned int pass, Shader& shader, const glm::mat4* model = nullptr, const DrawParams* params = nullptr);
+
+	std::vector<Mesh>& GetMeshes() { return m_Meshes; }
+	// Meshes in the file, more than GetMeshes().size() if some were merged
+	unsigned int GetImportedMeshCount() const { return m_ImportedMeshCount; }
+	const std::vector<unsigned int>& GetMaterials() const { return m_Materials; }
+	// Where a mesh sits in model space, from the transforms of its node and the ones above it
+	const glm::mat4& GetMeshTransform(size_t mesh) const { return m_Nodes.GetWorld(m_MeshNodes[mesh]); }
+	// False when every node is an identity (OBJ files), then the object's matrix is used as is
+	bool HasMeshTransforms() const { return m_HasMeshTransforms; }
+	// Model space bounds of all meshes, skinned ones in their bind pose
+	const Bounds& GetBounds() const { return m_Bounds; }
+
+	const Skeleton& GetSkeleton() const { return m_Skeleton; }
+	const std::vector<AnimationClip>& GetClips() const { return m_Clips; }
+	// Skinned meshes need a palette, see DrawParams::bones, and a skinning shader like BasicLitSkinned.vs
+	bool IsSkinned() const { return m_Skeleton.GetBoneCount() > 0; }
 
 	// TODO implement proper destructor!
 };
\ No newline at end of file
@@ -0,0 +1,193 @@
+#include "PageResidency.h"
+#include <algorithm>
+
+PageResidency::PageResidency(uint32_t tilesPerSide, uint32_t pagesPerSide) :
+	m_TilesPerSide(std::min(std::max(tilesPerSide, 1u), MAX_TILES_PER_SIDE)), m_MipCount(1),
+	m_PagesPerSide(std::min(std::max(pagesPerSide, 1u), MAX_PAGES_PER_SIDE)), m_Frame(1), m_RootPending(true),
+	m_IndirectionDirty(true)
+{
+	while ((m_TilesPerSide >> m_MipCount) > 0)
+		++m_MipCount;
+
+	uint32_t pageCount = m_PagesPerSide * m_PagesPerSide;
+	m_PageTiles.assign(pageCount, NO_TILE);
+	m_PageFrames.assign(pageCount, 0);
+	m_LruPositions.resize(pageCount);
+	// Page 0 is the root's for good, it's never in the LRU
+	for (uint32_t page = 1; page < pageCount; ++page)
+		m_LruPositions[page] = m_Lru.insert(m_Lru.end(), page);
+
+	uint32_t root = Key(m_MipCount - 1, 0, 0);
+	m_PageTiles[0] = root;
+	m_Resident[root] = 0;
+	IndirectionEntry rootEntry = { 0, 0, (uint8_t)(m_MipCount - 1), 0 };
+	m_Indirection.resize(m_MipCount);
+	for (uint32_t mip = 0; mip < m_MipCount; ++mip)
+		m_Indirection[mip].assign((size_t)GetTiles(mip) * GetTiles(mip), rootEntry);
+}
+
+void PageResidency::Touch(uint32_t page)
+{
+	m_PageFrames[page] = m_Frame;
+	if (page != 0)
+		m_Lru.splice(m_Lru.end(), m_Lru, m_LruPositions[page]);
+}
+
+IndirectionEntry PageResidency::FindResident(uint32_t mip, uint32_t x, uint32_t y) const
+{
+	for (uint32_t level = mip; level < m_MipCount; ++level)
+	{
+		uint32_t shift = level - mip;
+		auto found = m_Resident.find(Key(level, x >> shift, y >> shift));
+		if (found != m_Resident.end())
+		{
+			IndirectionEntry entry = { (uint8_t)(found->second % m_PagesPerSide), (uint8_t)(found->second / m_PagesPerSide), (uint8_t)level, 0 };
+			return entry;
+		}
+	}
+	// The root is always resident
+	return IndirectionEntry();
+}
+
+void PageResidency::Place(uint32_t mip, uint32_t x, uint32_t y, uint32_t page)
+{
+	IndirectionEntry placed = { (uint8_t)(page % m_PagesPerSide), (uint8_t)(page / m_PagesPerSide), (uint8_t)mip, 0 };
+	for (uint32_t level = 0; level <= mip; ++level)
+	{
+		uint32_t span = 1u << (mip - level);
+		uint32_t tiles = GetTiles(level);
+		for (uint32_t tileY = y * span; tileY < (y + 1) * span; ++tileY)
+		{
+			for (uint32_t tileX = x * span; tileX < (x + 1) * span; ++tileX)
+			{
+				// Finer pages already there stay
+				IndirectionEntry& entry = m_Indirection[level][(size_t)tileY * tiles + tileX];
+				if (entry.mip > mip)
+					entry = placed;
+			}
+		}
+	}
+	m_IndirectionDirty = true;
+}
+
+void PageResidency::Remove(uint32_t mip, uint32_t x, uint32_t y)
+{
+	m_Resident.erase(Key(mip, x, y));
+	IndirectionEntry replacement = FindResident(mip, x, y);
+	for (uint32_t level = 0; level <= mip; ++level)
+	{
+		uint32_t span = 1u << (mip - level);
+		uint32_t tiles = GetTiles(level);
+		for (uint32_t tileY = y * span; tileY < (y + 1) * span; ++tileY)
+		{
+			for (uint32_t tileX = x * span; tileX < (x + 1) * span; ++tileX)
+			{
+				// Only the entries that pointed at the removed page
+				IndirectionEntry& entry = m_Indirection[level][(size_t)tileY * tiles + tileX];
+				if (entry.mip == mip)
+					entry = replacement;
+			}
+		}
+	}
+	m_IndirectionDirty = true;
+}
+
+void PageResidency::Request(uint32_t mip, uint32_t x, uint32_t y)
+{
+	if (mip >= m_MipCount || x >= GetTiles(mip) || y >= GetTiles(mip))
+		return;
+	uint32_t key = Key(mip, x, y);
+	auto found = m_Resident.find(key);
+	if (found != m_Resident.end())
+	{
+		++m_Current.hits;
+		Touch(found->second);
+		return;
+	}
+	++m_Current.misses;
+	m_Requested.insert(key);
+	const IndirectionEntry& fallback = m_Indirection[mip][(size_t)y * GetTiles(mip) + x];
+	Touch(fallback.pageY * m_PagesPerSide + fallback.pageX);
+}
+
+std::vector<PageLoad> PageResidency::Update(uint32_t maxLoads)
+{
+	std::vector<PageLoad> loads;
+	if (m_RootPending)
+	{
+		PageLoad root = { m_MipCount - 1, 0, 0, 0 };
+		loads.push_back(root);
+		m_RootPending = false;
+	}
+
+	// Coarse tiles first, they stand in for everything under them
+	std::vector<uint32_t> wanted(m_Requested.begin(), m_Requested.end());
+	std::sort(wanted.begin(), wanted.end(), [](uint32_t a, uint32_t b) { return (a >> 24) != (b >> 24) ? (a >> 24) > (b >> 24) : a < b; });
+	uint32_t loaded = 0;
+	for (uint32_t key : wanted)
+	{
+		uint32_t page = m_Lru.empty() ? 0 : m_Lru.front();
+		// Everything left was used this frame, evicting it would only bring it back next frame
+		if (loaded >= maxLoads || m_Lru.empty() || (m_PageTiles[page] != NO_TILE && m_PageFrames[page] == m_Frame))
+		{
+			++m_Current.deferred;
+			continue;
+		}
+		uint32_t old = m_PageTiles[page];
+		if (old != NO_TILE)
+		{
+			Remove(old >> 24, old & 0xfff, (old >> 12) & 0xfff);
+			++m_Current.evictions;
+		}
+		PageLoad load = { key >> 24, key & 0xfff, (key >> 12) & 0xfff, page };
+		m_PageTiles[page] = key;
+		m_Resident[key] = page;
+		Place(load.mip, load.x, load.y, page);
+		Touch(page);
+		loads.push_back(load);
+		++loaded;
+	}
+	m_Current.loads = loaded;
+	m_Requested.clear();
+	m_Stats = m_Current;
+	m_Current = PageResidencyStats();
+	++m_Frame;
+	return loads;
+}
+
+bool PageResidency::IsResident(uint32_t mip, uint32_t x, uint32_t y) const
+{
+	return m_Resident.count(Key(mip, x, y)) > 0;
+}
+
+bool PageResidency::Validate() const
+{
+	if (m_Lru.size() != m_PageTiles.size() - 1)
+		return false;
+	for (const auto& resident : m_Resident)
+	{
+		if (resident.second >= m_PageTiles.size() || m_PageTiles[resident.second] != resident.first)
+			return false;
+	}
+	size_t used = 0;
+	for (uint32_t tile : m_PageTiles)
+		used += tile != NO_TILE;
+	if (used != m_Resident.size())
+		return false;
+
+	for (uint32_t mip = 0; mip < m_MipCount; ++mip)
+	{
+		uint32_t tiles = GetTiles(mip);
+		for (uint32_t y = 0; y < tiles; ++y)
+		{
+			for (uint32_t x = 0; x < tiles; ++x)
+			{
+				IndirectionEntry expected = FindResident(mip, x, y);
+				const IndirectionEntry& entry = m_Indirection[mip][(size_t)y * tiles + x];
+				if (entry.pageX != expected.pageX || entry.pageY != expected.pageY || entry.mip != expected.mip)
+					return false;
+			}
+		}
+	}
+	return true;
+}
@@ -0,0 +1,105 @@
+#pragma once
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// Which tiles of a virtual texture are in which page of the physical cache, without any GL so it
+// can be driven and checked on its own (VirtualTextureBenchmark does). Pages are recycled least
+// recently used first. The single tile of the coarsest mip is pinned, so every texel always has
+// something resident to fall back to.
+//
+// The indirection table has a level per mip with an entry per tile, each pointing at the finest
+// resident page covering that tile. It's what VirtualTexture uploads and the shader looks up.
+struct PageLoad
+{
+	uint32_t mip;
+	uint32_t x;
+	uint32_t y;
+	uint32_t page;
+};
+
+// One RGBA8 texel of the indirection texture
+struct IndirectionEntry
+{
+	uint8_t pageX;
+	uint8_t pageY;
+	uint8_t mip;
+	uint8_t unused;
+};
+
+struct PageResidencyStats
+{
+	// Requests for resident tiles and for missing ones, since the last Update()
+	uint32_t hits = 0;
+	uint32_t misses = 0;
+	uint32_t loads = 0;
+	uint32_t evictions = 0;
+	// Missing tiles left for later because of the load limit or because every page was in use
+	uint32_t deferred = 0;
+};
+
+class PageResidency
+{
+public:
+	// Up to 256 pages along each side of the cache and 4096 tiles along each side of the texture
+	static constexpr uint32_t MAX_PAGES_PER_SIDE = 256;
+	static constexpr uint32_t MAX_TILES_PER_SIDE = 4096;
+private:
+	static constexpr uint32_t NO_TILE = 0xffffffff;
+
+	uint32_t m_TilesPerSide;
+	uint32_t m_MipCount;
+	uint32_t m_PagesPerSide;
+	// Tile key by page, NO_TILE if free
+	std::vector<uint32_t> m_PageTiles;
+	std::vector<uint32_t> m_PageFrames;
+	// Evictable pages, least recently used first
+	std::list<uint32_t> m_Lru;
+	std::vector<std::list<uint32_t>::iterator> m_LruPositions;
+	std::unordered_map<uint32_t, uint32_t> m_Resident;
+	std::unordered_set<uint32_t> m_Requested;
+	std::vector<std::vector<IndirectionEntry>> m_Indirection;
+	uint32_t m_Frame;
+	// The root tile's page is handed out by the first Update()
+	bool m_RootPending;
+	bool m_IndirectionDirty;
+	// Counting up to the next Update()
+	PageResidencyStats m_Current;
+	PageResidencyStats m_Stats;
+private:
+	static uint32_t Key(uint32_t mip, uint32_t x, uint32_t y) { return mip << 24 | y << 12 | x; }
+	uint32_t GetTiles(uint32_t mip) const { return m_TilesPerSide >> mip; }
+	void Touch(uint32_t page);
+	// Best resident page for a tile, looking at the tile's own mip and up
+	IndirectionEntry FindResident(uint32_t mip, uint32_t x, uint32_t y) const;
+	// Update the entries of the tile and of the finer tiles under it
+	void Place(uint32_t mip, uint32_t x, uint32_t y, uint32_t page);
+	void Remove(uint32_t mip, uint32_t x, uint32_t y);
+public:
+	// tilesPerSide of mip 0 has to be a power of two, the mips go down to a single tile
+	PageResidency(uint32_t tilesPerSide, uint32_t pagesPerSide);
+
+	// A tile the feedback saw. If it isn't resident the page the shader falls back to is kept alive.
+	void Request(uint32_t mip, uint32_t x, uint32_t y);
+	// Missing requested tiles get pages, coarsest first, at most maxLoads of them. The caller has to
+	// fill the returned pages before the next draw, the indirection already points at them.
+	std::vector<PageLoad> Update(uint32_t maxLoads);
+
+	bool IsResident(uint32_t mip, uint32_t x, uint32_t y) const;
+	uint32_t GetMipCount() const { return m_MipCount; }
+	uint32_t GetTilesPerSide() const { return m_TilesPerSide; }
+	uint32_t GetPagesPerSide() const { return m_PagesPerSide; }
+	uint32_t GetResidentCount() const { return (uint32_t)m_Resident.size(); }
+	// GetTilesPerSide() >> mip squared entries, rows in tile order
+	const std::vector<IndirectionEntry>& GetIndirection(uint32_t mip) const { return m_Indirection[mip]; }
+	bool IsIndirectionDirty() const { return m_IndirectionDirty; }
+	void ClearIndirectionDirty() { m_IndirectionDirty = false; }
+	// Of the last Update()
+	const PageResidencyStats& GetStats() const { return m_Stats; }
+
+	// Every entry points at the finest resident page covering it and the pages and LRU agree.
+	// Slow, for checking the bookkeeping.
+	bool Validate() const;
+};
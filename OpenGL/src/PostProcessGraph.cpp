@@ -0,0 +1,320 @@
+#include "PostProcessGraph.h"
+#include "CpuProfiler.h"
+#include "GpuProfiler.h"
+#include "Mesh.h"
+#include "RenderState.h"
+#include "Shader.h"
+#include <GL/glew.h>
+#include <algorithm>
+#include <iostream>
+
+namespace
+{
+	const std::string SCREEN_TEXTURE_UNIFORM = "screenTexture";
+	const std::string STRENGTH_UNIFORM = "strength";
+	const std::string TEXTURE_SIZE_UNIFORM = "textureSize";
+	const std::string SOURCE_SIZE_UNIFORM = "sourceSize";
+	const std::string UV_SCALE_UNIFORM = "uvScale";
+	const std::string UV_MAX_UNIFORM = "uvMax";
+
+	size_t GetTargetBytes(const RenderTarget& target)
+	{
+		// RGB8 is padded to 4 bytes by pretty much every driver, plus 4 for depth/stencil
+		return (size_t)target.width * target.height * (target.depthStencil ? 8 : 4);
+	}
+}
+
+ShaderEffect::ShaderEffect(const char* name, const std::string& fragmentShader) :
+	PostProcessEffect(name), m_Shader(new Shader("res/shaders/PostProcess.vs", fragmentShader)),
+	m_HasUvMax(glGetUniformLocation(m_Shader->GetID(), UV_MAX_UNIFORM.c_str()) != -1)
+{
+}
+
+ShaderEffect::~ShaderEffect()
+{
+}
+
+void ShaderEffect::Apply(PostProcessGraph& graph, const RenderTarget& input, unsigned int outputFramebuffer)
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, outputFramebuffer);
+	m_Shader->Bind();
+	m_Shader->SetUniform1i(SCREEN_TEXTURE_UNIFORM, 0);
+	m_Shader->SetUniform1f(STRENGTH_UNIFORM, GetStrength());
+	if (m_HasUvMax)
+		m_Shader->SetUniform2f(UV_MAX_UNIFORM, (graph.GetUsedWidth(input) - 0.5f) / input.width,
+			(graph.GetUsedHeight(input) - 0.5f) / input.height);
+	RenderState::BindTexture(0, GL_TEXTURE_2D, input.colorTexture);
+	graph.DrawQuad(*m_Shader, input);
+}
+
+PostProcessGraph::PostProcessGraph(Mesh& quad, int width, int height) :
+	m_SceneTarget(nullptr), m_Quad(quad), m_Width(width), m_Height(height), m_TargetWidth(width),
+	m_TargetHeight(height), m_RenderScale(1.0f),
+	m_EffectsEnabled(true), m_SceneWidth(width), m_SceneHeight(height), m_Profiler(nullptr)
+{
+}
+
+PostProcessGraph::~PostProcessGraph()
+{
+	DestroyTargets();
+}
+
+PostProcessEffect& PostProcessGraph::AddEffect(std::unique_ptr<PostProcessEffect> effect)
+{
+	m_Effects.push_back(std::move(effect));
+	return *m_Effects.back();
+}
+
+PostProcessEffect* PostProcessGraph::FindEffect(const std::string& name)
+{
+	for (std::unique_ptr<PostProcessEffect>& effect : m_Effects)
+	{
+		if (name == effect->GetName())
+			return effect.get();
+	}
+	return nullptr;
+}
+
+void PostProcessGraph::MoveEffect(size_t from, size_t to)
+{
+	if (from >= m_Effects.size() || to >= m_Effects.size() || from == to)
+		return;
+	std::unique_ptr<PostProcessEffect> effect = std::move(m_Effects[from]);
+	m_Effects.erase(m_Effects.begin() + from);
+	m_Effects.insert(m_Effects.begin() + to, std::move(effect));
+}
+
+void PostProcessGraph::Resize(int width, int height)
+{
+	if (width == m_Width && height == m_Height)
+		return;
+	if (width > m_TargetWidth || height > m_TargetHeight)
+	{
+		// Leave room for the next few frames of a drag, it's unlikely to stop here
+		if (!m_Targets.empty())
+			++m_Stats.reallocations;
+		DestroyTargets();
+		if (width > m_TargetWidth)
+			m_TargetWidth = std::max(width, (int)(m_TargetWidth * TARGET_GROWTH));
+		if (height > m_TargetHeight)
+			m_TargetHeight = std::max(height, (int)(m_TargetHeight * TARGET_GROWTH));
+	}
+	m_Width = width;
+	m_Height = height;
+	UpdateSceneSize();
+}
+
+void PostProcessGraph::Trim()
+{
+	if (m_TargetWidth == m_Width && m_TargetHeight == m_Height)
+		return;
+	if (!m_Targets.empty())
+		++m_Stats.reallocations;
+	DestroyTargets();
+	m_TargetWidth = m_Width;
+	m_TargetHeight = m_Height;
+}
+
+void PostProcessGraph::SetRenderScale(float scale)
+{
+	m_RenderScale = scale < MIN_RENDER_SCALE ? MIN_RENDER_SCALE : (scale > 1.0f ? 1.0f : scale);
+	UpdateSceneSize();
+}
+
+void PostProcessGraph::ReserveSceneTarget()
+{
+	ReleaseTarget(AcquireTarget(m_TargetWidth, m_TargetHeight, true));
+}
+
+void PostProcessGraph::UpdateSceneSize()
+{
+	m_SceneWidth = (int)(m_Width * m_RenderScale + 0.5f);
+	m_SceneHeight = (int)(m_Height * m_RenderScale + 0.5f);
+	m_SceneWidth = m_SceneWidth < 1 ? 1 : m_SceneWidth;
+	m_SceneHeight = m_SceneHeight < 1 ? 1 : m_SceneHeight;
+}
+
+void PostProcessGraph::DestroyTargets()
+{
+	for (std::unique_ptr<RenderTarget>& target : m_Targets)
+	{
+		glDeleteFramebuffers(1, &target->framebuffer);
+		RenderState::ForgetTexture(target->colorTexture);
+		glDeleteTextures(1, &target->colorTexture);
+		if (target->depthStencil)
+			glDeleteRenderbuffers(1, &target->depthStencil);
+	}
+	m_Targets.clear();
+	m_SceneTarget = nullptr;
+	m_Stats.targets = 0;
+	m_Stats.targetBytes = 0;
+}
+
+RenderTarget& PostProcessGraph::AcquireTarget(int width, int height, bool depthStencil)
+{
+	// A free target of the right size, one with a depth buffer only if nothing else fits
+	RenderTarget* fallback = nullptr;
+	for (std::unique_ptr<RenderTarget>& target : m_Targets)
+	{
+		if (target->inUse || target->width != width || target->height != height || (depthStencil && !target->depthStencil))
+			continue;
+		if (!depthStencil && target->depthStencil)
+		{
+			fallback = target.get();
+			continue;
+		}
+		target->inUse = true;
+		return *target;
+	}
+	if (fallback)
+	{
+		fallback->inUse = true;
+		return *fallback;
+	}
+
+	std::unique_ptr<RenderTarget> target(new RenderTarget());
+	target->width = width;
+	target->height = height;
+	target->inUse = true;
+	glGenFramebuffers(1, &target->framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, target->framebuffer);
+
+	glGenTextures(1, &target->colorTexture);
+	RenderState::BindTexture(0, GL_TEXTURE_2D, target->colorTexture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, nullptr);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	// Kernels reaching past the border should see the edge, not the other side of the image
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, target->colorTexture, 0);
+
+	if (depthStencil)
+	{
+		glGenRenderbuffers(1, &target->depthStencil);
+		glBindRenderbuffer(GL_RENDERBUFFER, target->depthStencil);
+		glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+		glBindRenderbuffer(GL_RENDERBUFFER, 0);
+		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, target->depthStencil);
+	}
+
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+		std::cout << "ERROR::POSTPROCESS:: Render target " << width << "x" << height << " is not complete\n";
+
+	++m_Stats.targets;
+	m_Stats.targetBytes += GetTargetBytes(*target);
+	m_Targets.push_back(std::move(target));
+	return *m_Targets.back();
+}
+
+void PostProcessGraph::ReleaseTarget(RenderTarget& target)
+{
+	target.inUse = false;
+}
+
+int PostProcessGraph::GetUsedWidth(const RenderTarget& target) const
+{
+	// Rounded up so a halved target still covers the edge of the image
+	return (target.width * m_Width + m_TargetWidth - 1) / m_TargetWidth;
+}
+
+int PostProcessGraph::GetUsedHeight(const RenderTarget& target) const
+{
+	return (target.height * m_Height + m_TargetHeight - 1) / m_TargetHeight;
+}
+
+void PostProcessGraph::SetViewport(const RenderTarget& target)
+{
+	glViewport(0, 0, GetUsedWidth(target), GetUsedHeight(target));
+}
+
+void PostProcessGraph::DrawQuad(Shader& shader, const RenderTarget& source)
+{
+	// Rounding makes halved targets a little off the full size ones, so it's per target
+	shader.SetUniform2f(UV_SCALE_UNIFORM, (float)GetUsedWidth(source) / source.width, (float)GetUsedHeight(source) / source.height);
+	m_Quad.Draw();
+}
+
+unsigned int PostProcessGraph::BeginScene(unsigned int output)
+{
+	m_ActiveEffects.clear();
+	m_Stats.passes = 0;
+	m_Stats.skipped = 0;
+	for (std::unique_ptr<PostProcessEffect>& effect : m_Effects)
+	{
+		if (!m_EffectsEnabled || effect->IsNoOp())
+			++m_Stats.skipped;
+		else
+			m_ActiveEffects.push_back(effect.get());
+	}
+
+	bool scaled = m_SceneWidth != m_Width || m_SceneHeight != m_Height;
+	glViewport(0, 0, m_SceneWidth, m_SceneHeight);
+	if (m_ActiveEffects.empty() && !scaled)
+		return output;
+	// Always full size, a smaller scene only uses part of it
+	m_SceneTarget = &AcquireTarget(m_TargetWidth, m_TargetHeight, true);
+	return m_SceneTarget->framebuffer;
+}
+
+void PostProcessGraph::Upscale(const RenderTarget& scene, unsigned int outputFramebuffer)
+{
+	if (!m_UpscaleShader)
+		m_UpscaleShader.reset(new Shader("res/shaders/PostProcess.vs", "res/shaders/Upscale.fs"));
+
+	glBindFramebuffer(GL_FRAMEBUFFER, outputFramebuffer);
+	glViewport(0, 0, m_Width, m_Height);
+	m_UpscaleShader->Bind();
+	m_UpscaleShader->SetUniform1i(SCREEN_TEXTURE_UNIFORM, 0);
+	m_UpscaleShader->SetUniform2f(TEXTURE_SIZE_UNIFORM, (float)scene.width, (float)scene.height);
+	m_UpscaleShader->SetUniform2f(SOURCE_SIZE_UNIFORM, (float)m_SceneWidth, (float)m_SceneHeight);
+	RenderState::BindTexture(0, GL_TEXTURE_2D, scene.colorTexture);
+	// Works out where the scene is itself, the coordinates have to cover the whole output
+	m_UpscaleShader->SetUniform2f(UV_SCALE_UNIFORM, 1.0f, 1.0f);
+	m_Quad.Draw();
+}
+
+void PostProcessGraph::Execute(unsigned int output)
+{
+	PROFILE_SCOPE("PostProcessGraph::Execute");
+	if (!m_SceneTarget)
+		return;
+
+	// Every pass covers the whole target, nothing to test or blend against
+	RenderState::Disable(GL_DEPTH_TEST);
+	RenderState::Disable(GL_BLEND);
+
+	RenderTarget* input = m_SceneTarget;
+	if (m_SceneWidth != m_Width || m_SceneHeight != m_Height)
+	{
+		// Effects always see a full size image
+		RenderTarget* target = m_ActiveEffects.empty() ? nullptr : &AcquireTarget(m_TargetWidth, m_TargetHeight);
+		{
+			GpuProfileScope zone(m_Profiler, "Upscale");
+			Upscale(*input, target ? target->framebuffer : output);
+		}
+		ReleaseTarget(*input);
+		input = target;
+		++m_Stats.passes;
+	}
+
+	for (size_t i = 0; i < m_ActiveEffects.size(); ++i)
+	{
+		PostProcessEffect& effect = *m_ActiveEffects[i];
+		bool last = i + 1 == m_ActiveEffects.size();
+		RenderTarget* target = last ? nullptr : &AcquireTarget(m_TargetWidth, m_TargetHeight);
+		{
+			GpuProfileScope zone(m_Profiler, effect.GetName());
+			// Effects drawing into smaller targets of their own set the viewport themselves
+			glViewport(0, 0, m_Width, m_Height);
+			effect.Apply(*this, *input, last ? output : target->framebuffer);
+		}
+		ReleaseTarget(*input);
+		input = target;
+		++m_Stats.passes;
+	}
+	m_SceneTarget = nullptr;
+
+	glViewport(0, 0, m_Width, m_Height);
+	RenderState::Enable(GL_BLEND);
+}
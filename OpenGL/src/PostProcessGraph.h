@@ -0,0 +1,167 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <vector>
+
+class GpuProfiler;
+class Mesh;
+class PostProcessGraph;
+class Shader;
+
+// A color texture to draw into, optionally with a depth/stencil buffer for the scene pass.
+// width and height are the texture's, while a resize settles only part of it may be in use.
+struct RenderTarget
+{
+	unsigned int framebuffer = 0;
+	unsigned int colorTexture = 0;
+	unsigned int depthStencil = 0;
+	int width = 0;
+	int height = 0;
+	bool inUse = false;
+};
+
+// One step of the post-processing chain
+class PostProcessEffect
+{
+private:
+	const char* m_Name;
+	bool m_Enabled;
+	float m_Strength;
+public:
+	// name is also the GPU zone the effect is timed under, so it has to outlive the profiler
+	explicit PostProcessEffect(const char* name) : m_Name(name), m_Enabled(true), m_Strength(1.0f) {}
+	virtual ~PostProcessEffect() = default;
+
+	const char* GetName() const { return m_Name; }
+	bool IsEnabled() const { return m_Enabled; }
+	void SetEnabled(bool enabled) { m_Enabled = enabled; }
+	// Blends the result with the input, 0 leaves the image untouched
+	float GetStrength() const { return m_Strength; }
+	void SetStrength(float strength) { m_Strength = strength; }
+
+	// Effects that wouldn't change the image are skipped without touching the GPU
+	virtual bool IsNoOp() const { return !m_Enabled || m_Strength <= 0.0f; }
+	// Reads input and draws outputFramebuffer, which is input-sized. The viewport is already set.
+	virtual void Apply(PostProcessGraph& graph, const RenderTarget& input, unsigned int outputFramebuffer) = 0;
+};
+
+// A single fullscreen pass. The shader samples screenTexture and blends by the strength uniform.
+class ShaderEffect : public PostProcessEffect
+{
+private:
+	std::unique_ptr<Shader> m_Shader;
+	// Shaders that sample neighbours declare uvMax to stay inside the part of the input in use
+	bool m_HasUvMax;
+public:
+	ShaderEffect(const char* name, const std::string& fragmentShader);
+	~ShaderEffect();
+
+	void Apply(PostProcessGraph& graph, const RenderTarget& input, unsigned int outputFramebuffer) override;
+};
+
+struct PostProcessStats
+{
+	unsigned int passes = 0;
+	unsigned int skipped = 0;
+	unsigned int targets = 0;
+	size_t targetBytes = 0;
+	// Times every target was dropped because the output outgrew them
+	unsigned int reallocations = 0;
+};
+
+// Runs an ordered list of effects between the scene and the screen. Intermediate images live in a
+// pool of render targets that are handed out and returned as the chain runs, so a chain of any
+// length ping-pongs between two full size targets, and effects needing scratch targets of their
+// own reuse whatever is free. Targets are only created the first time they're needed.
+//
+// With a render scale below 1 the scene is drawn into the bottom left of the full size scene
+// target and upscaled before the effects run. The target itself never changes size, so the scale
+// can change every frame without reallocating anything.
+//
+// Resizing works the same way. Targets are only dropped when the output outgrows them, and then
+// grow by half again so dragging a window edge reallocates a handful of times rather than every
+// frame. Smaller outputs use the bottom left of the targets, PostProcess.vs scales the texture
+// coordinates to match. Trim() shrinks them back to fit once the size has settled.
+class PostProcessGraph
+{
+public:
+	static constexpr float MIN_RENDER_SCALE = 0.25f;
+	static constexpr float TARGET_GROWTH = 1.5f;
+private:
+	std::vector<std::unique_ptr<PostProcessEffect>> m_Effects;
+	std::vector<std::unique_ptr<RenderTarget>> m_Targets;
+	std::vector<PostProcessEffect*> m_ActiveEffects;
+	RenderTarget* m_SceneTarget;
+	Mesh& m_Quad;
+	std::unique_ptr<Shader> m_UpscaleShader;
+	int m_Width;
+	int m_Height;
+	// Size of the full size targets, at least the output's
+	int m_TargetWidth;
+	int m_TargetHeight;
+	float m_RenderScale;
+	bool m_EffectsEnabled;
+	int m_SceneWidth;
+	int m_SceneHeight;
+	GpuProfiler* m_Profiler;
+	PostProcessStats m_Stats;
+private:
+	void DestroyTargets();
+	void UpdateSceneSize();
+	void Upscale(const RenderTarget& scene, unsigned int outputFramebuffer);
+public:
+	// quad is a fullscreen quad in the layout PostProcess.vs expects
+	PostProcessGraph(Mesh& quad, int width, int height);
+	~PostProcessGraph();
+	PostProcessGraph(const PostProcessGraph&) = delete;
+	PostProcessGraph& operator=(const PostProcessGraph&) = delete;
+
+	// Effects run in the order they were added
+	PostProcessEffect& AddEffect(std::unique_ptr<PostProcessEffect> effect);
+	size_t GetEffectCount() const { return m_Effects.size(); }
+	PostProcessEffect& GetEffect(size_t index) { return *m_Effects[index]; }
+	PostProcessEffect* FindEffect(const std::string& name);
+	void MoveEffect(size_t from, size_t to);
+	// Skips every effect without changing their own settings, scaling still happens
+	void SetEffectsEnabled(bool enabled) { m_EffectsEnabled = enabled; }
+	bool AreEffectsEnabled() const { return m_EffectsEnabled; }
+
+	void SetProfiler(GpuProfiler* profiler) { m_Profiler = profiler; }
+	// Keeps the targets if they're big enough, otherwise they're recreated larger as they're needed
+	void Resize(int width, int height);
+	// Recreates the targets at exactly the output size if they're bigger, for when resizing has stopped
+	void Trim();
+	int GetWidth() const { return m_Width; }
+	int GetHeight() const { return m_Height; }
+	int GetTargetWidth() const { return m_TargetWidth; }
+	int GetTargetHeight() const { return m_TargetHeight; }
+
+	// Fraction of the width and height the scene is drawn at, clamped to [MIN_RENDER_SCALE, 1]
+	void SetRenderScale(float scale);
+	// Creates the scene target now rather than on the first scaled frame, which would hitch
+	void ReserveSceneTarget();
+	float GetRenderScale() const { return m_RenderScale; }
+	int GetSceneWidth() const { return m_SceneWidth; }
+	int GetSceneHeight() const { return m_SceneHeight; }
+
+	// Framebuffer the scene has to be drawn into, output itself when every effect is a no-op and
+	// the scene isn't scaled. Sets the viewport to the scene's size.
+	unsigned int BeginScene(unsigned int output);
+	// Runs the effects and leaves the result in output
+	void Execute(unsigned int output);
+
+	// For effects. Released targets go back to the pool right away, the next pass may draw over them.
+	// Sizes are texture sizes, halving the input's gives a target with half of its area in use.
+	RenderTarget& AcquireTarget(int width, int height, bool depthStencil = false);
+	void ReleaseTarget(RenderTarget& target);
+	// Texels of target holding the image
+	int GetUsedWidth(const RenderTarget& target) const;
+	int GetUsedHeight(const RenderTarget& target) const;
+	// Limits drawing to the part of target that's in use, the whole of it unless a resize is settling
+	void SetViewport(const RenderTarget& target);
+	// Texture coordinates cover the part of source in use. Other inputs the shader samples at the
+	// same coordinates should be about the same fraction of their target, a texel off at most.
+	void DrawQuad(Shader& shader, const RenderTarget& source);
+
+	const PostProcessStats& GetStats() const { return m_Stats; }
+};
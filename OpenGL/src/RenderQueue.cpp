@@ -0,0 +1,221 @@
+#include "RenderQueue.h"
+#include "RenderState.h"
+#include "Material.h"
+#include "Mesh.h"
+#include "Shader.h"
+#include "DrawList.h"
+#include "GpuProfiler.h"
+#include "CpuProfiler.h"
+#include <string>
+
+namespace
+{
+	constexpr uint64_t DEPTH_MAX = (1u << 24) - 1;
+	constexpr unsigned int UNKNOWN_MATERIAL = 0xffffffff;
+
+	// The uniform setters take a const std::string&, passing literals would build one every draw
+	const std::string MODEL_UNIFORM = "model";
+	const std::string EMISSION_UNIFORM = "emission";
+	const std::string BONES_UNIFORM = "bones";
+
+	uint64_t QuantizeDepth(float distance, float farPlane)
+	{
+		float normalized = glm::clamp(distance / farPlane, 0.0f, 1.0f);
+		return (uint64_t)(normalized * DEPTH_MAX);
+	}
+}
+
+RenderQueue::RenderQueue(FrameArena& arena) :
+	m_Arena(arena), m_ViewPosition(0.0f), m_FarPlane(100.0f), m_Profiler(nullptr)
+{
+}
+
+void RenderQueue::SetPassState(unsigned int pass, const PassState& state)
+{
+	m_Passes[pass] = state;
+}
+
+void RenderQueue::Begin(const glm::vec3& viewPosition, float farPlane)
+{
+	// The arena is rewound by its owner at the start of the frame
+	m_Commands.clear();
+	m_ViewPosition = viewPosition;
+	m_FarPlane = farPlane;
+}
+
+DrawCommand RenderQueue::MakeCommand(unsigned int pass, Mesh& mesh, Shader& shader, const glm::mat4* model, const DrawParams* params) const
+{
+	// GL hands out program names sequentially, so the low 8 bits are unique for any
+	// realistic number of programs. A collision would only cost an extra switch.
+	uint64_t program = shader.GetID() & 0xff;
+	uint64_t material = mesh.GetMaterialID();
+	if (params && params->texture != 0)
+		material = material * 31 + params->texture;
+	material &= 0xffff;
+	uint64_t depth = 0;
+	if (model)
+		depth = QuantizeDepth(glm::length(glm::vec3((*model)[3]) - m_ViewPosition), m_FarPlane);
+
+	uint64_t key = (uint64_t)(pass & 0xf) << 60;
+	if (m_Passes[pass].translucent)
+	{
+		key |= 1ull << 59;
+		key |= (DEPTH_MAX - depth) << 35;
+		key |= program << 27;
+		key |= material << 11;
+	}
+	else
+	{
+		key |= program << 51;
+		key |= material << 35;
+		key |= depth << 11;
+	}
+
+	DrawCommand command;
+	command.key = key;
+	command.mesh = &mesh;
+	command.shader = &shader;
+	command.transform = model;
+	command.params = params;
+	return command;
+}
+
+void RenderQueue::Submit(unsigned int pass, Mesh& mesh, Shader& shader, const glm::mat4* model, const DrawParams* params)
+{
+	const glm::mat4* storedModel = model ? m_Arena.New<glm::mat4>(*model) : nullptr;
+	const DrawParams* storedParams = params ? m_Arena.New<DrawParams>(*params) : nullptr;
+	m_Commands.push_back(MakeCommand(pass, mesh, shader, storedModel, storedParams));
+}
+
+void RenderQueue::Append(const DrawList& list)
+{
+	const std::vector<DrawCommand>& commands = list.GetCommands();
+	m_Commands.insert(m_Commands.end(), commands.begin(), commands.end());
+}
+
+void RenderQueue::RadixSort()
+{
+	PROFILE_SCOPE("RenderQueue::RadixSort");
+	// LSD radix sort on 8 bit digits. It's stable, so draws with equal keys keep submission order.
+	// Digits every key agrees on are skipped, which is most of them for a typical frame.
+	size_t count = m_Commands.size();
+	m_SortBuffer.resize(count);
+	DrawCommand* src = m_Commands.data();
+	DrawCommand* dst = m_SortBuffer.data();
+
+	for (unsigned int shift = 0; shift < 64; shift += 8)
+	{
+		size_t histogram[256] = {};
+		for (size_t i = 0; i < count; ++i)
+			++histogram[(src[i].key >> shift) & 0xff];
+
+		if (histogram[(src[0].key >> shift) & 0xff] == count)
+			continue;
+
+		size_t offset = 0;
+		for (unsigned int digit = 0; digit < 256; ++digit)
+		{
+			size_t bucketSize = histogram[digit];
+			histogram[digit] = offset;
+			offset += bucketSize;
+		}
+		for (size_t i = 0; i < count; ++i)
+			dst[histogram[(src[i].key >> shift) & 0xff]++] = src[i];
+
+		std::swap(src, dst);
+	}
+
+	if (src != m_Commands.data())
+		m_Commands.swap(m_SortBuffer);
+}
+
+void RenderQueue::ApplyPassState(const PassState& state)
+{
+	RenderState::SetEnabled(GL_DEPTH_TEST, state.depthTest);
+	RenderState::DepthFunc(state.depthFunc);
+	RenderState::SetEnabled(GL_CULL_FACE, state.cullFace);
+	RenderState::SetEnabled(GL_BLEND, state.blend);
+	RenderState::SetEnabled(GL_STENCIL_TEST, state.stencilTest);
+	if (state.stencilTest)
+	{
+		RenderState::StencilFunc(state.stencilFunc, state.stencilRef, state.stencilFuncMask);
+		RenderState::StencilOp(state.stencilFail, state.stencilDepthFail, state.stencilDepthPass);
+	}
+	// The write mask also applies to glClear, so it's always restored
+	RenderState::StencilMask(state.stencilWriteMask);
+}
+
+void RenderQueue::Execute()
+{
+	PROFILE_SCOPE("RenderQueue::Execute");
+	m_Stats = RenderQueueStats();
+	if (m_Commands.empty())
+		return;
+
+	RadixSort();
+
+	unsigned int textureBindsBefore = RenderState::GetStats().Issued(StateCall::Texture);
+	unsigned int currentPass = MAX_PASSES;
+	bool timingPass = false;
+	Shader* currentShader = nullptr;
+	// Textures may have been bound to the material units since the last frame
+	unsigned int currentMaterial = UNKNOWN_MATERIAL;
+	for (const DrawCommand& command : m_Commands)
+	{
+		unsigned int pass = (unsigned int)(command.key >> 60);
+		if (pass != currentPass)
+		{
+			if (timingPass)
+				m_Profiler->EndZone();
+			timingPass = m_Profiler && m_Passes[pass].name;
+			if (timingPass)
+				m_Profiler->BeginZone(m_Passes[pass].name);
+			ApplyPassState(m_Passes[pass]);
+			currentPass = pass;
+			++m_Stats.passes;
+		}
+		if (command.shader != currentShader)
+		{
+			command.shader->Bind();
+			currentShader = command.shader;
+			++m_Stats.programSwitches;
+		}
+
+		unsigned int material = command.mesh->GetMaterialID();
+		if (material != currentMaterial)
+		{
+			MaterialLibrary::Bind(material);
+			currentMaterial = material;
+			++m_Stats.materialSwitches;
+		}
+
+		if (command.transform)
+			currentShader->SetUniformMat4f(MODEL_UNIFORM, *command.transform);
+		if (command.params)
+		{
+			const DrawParams& params = *command.params;
+			if (params.flags & DrawParams::EMISSION)
+				currentShader->SetUniform3f(EMISSION_UNIFORM, params.emission);
+			if (params.skybox != 0)
+				RenderState::BindTexture(MaterialLibrary::SKYBOX_UNIT, GL_TEXTURE_CUBE_MAP, params.skybox);
+			if (params.texture != 0)
+			{
+				// Takes the diffuse map's unit, the next draw has to bind its material again
+				RenderState::BindTexture(0, params.textureTarget, params.texture);
+				currentMaterial = UNKNOWN_MATERIAL;
+			}
+			if (params.bones)
+				currentShader->SetUniformMat4fv(BONES_UNIFORM, params.boneCount, params.bones);
+		}
+
+		command.mesh->Draw();
+		++m_Stats.draws;
+	}
+
+	if (timingPass)
+		m_Profiler->EndZone();
+
+	// Leave the default state behind for anything drawn outside the queue
+	ApplyPassState(PassState());
+	m_Stats.textureBinds = RenderState::GetStats().Issued(StateCall::Texture) - textureBindsBefore;
+}
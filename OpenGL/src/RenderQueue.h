@@ -0,0 +1,117 @@
+#pragma once
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+#include "FrameArena.h"
+
+class Mesh;
+class GpuProfiler;
+class Shader;
+class DrawList;
+
+// Fixed-function state a pass is drawn with, applied through RenderState when the pass begins
+struct PassState
+{
+	bool depthTest = true;
+	GLenum depthFunc = GL_LESS;
+	bool cullFace = true;
+	bool blend = true;
+	bool stencilTest = false;
+	GLenum stencilFunc = GL_ALWAYS;
+	int stencilRef = 0;
+	unsigned int stencilFuncMask = 0xff;
+	unsigned int stencilWriteMask = 0xff;
+	GLenum stencilFail = GL_KEEP;
+	GLenum stencilDepthFail = GL_KEEP;
+	GLenum stencilDepthPass = GL_KEEP;
+	// Translucent passes are sorted back to front instead of by state
+	bool translucent = false;
+	// Zone the pass is timed under if the queue has a profiler, unnamed passes aren't timed
+	const char* name = nullptr;
+};
+
+// Per-draw uniforms that don't belong to the mesh itself
+struct DrawParams
+{
+	enum Flags
+	{
+		EMISSION = 1 << 0
+	};
+	unsigned int flags = 0;
+	glm::vec3 emission = glm::vec3(0.0f);
+	// Environment map, bound to MaterialLibrary::SKYBOX_UNIT
+	unsigned int skybox = 0;
+	// Bound to unit 0 before the mesh's own textures, for meshes that come without a material
+	GLenum textureTarget = GL_TEXTURE_2D;
+	unsigned int texture = 0;
+	// Skinning palette for skinned meshes (Animator::GetPalette()), referenced like the transform
+	const glm::mat4* bones = nullptr;
+	unsigned int boneCount = 0;
+};
+
+struct DrawCommand
+{
+	uint64_t key;
+	Mesh* mesh;
+	Shader* shader;
+	// Owned by whoever recorded the command and must stay alive until the queue has executed
+	const glm::mat4* transform;
+	const DrawParams* params;
+};
+
+struct RenderQueueStats
+{
+	unsigned int draws = 0;
+	unsigned int passes = 0;
+	unsigned int programSwitches = 0;
+	// Draws that bound a different material than the one before
+	unsigned int materialSwitches = 0;
+	unsigned int textureBinds = 0;
+};
+
+// Collects draws for a frame, sorts them by a 64-bit key and executes them in that order
+// so program and material changes are grouped together.
+//
+// Key layout, most significant bits first:
+//   opaque:      pass(4) | translucent(1) = 0 | program(8) | material(16) | depth(24) | unused(11)
+//   translucent: pass(4) | translucent(1) = 1 | inverted depth(24) | program(8) | material(16) | unused(11)
+class RenderQueue
+{
+public:
+	static constexpr unsigned int MAX_PASSES = 16;
+private:
+	std::vector<DrawCommand> m_Commands;
+	std::vector<DrawCommand> m_SortBuffer;
+	// Holds transforms and params of commands submitted directly
+	FrameArena& m_Arena;
+	PassState m_Passes[MAX_PASSES];
+	glm::vec3 m_ViewPosition;
+	float m_FarPlane;
+	RenderQueueStats m_Stats;
+	GpuProfiler* m_Profiler;
+private:
+	void ApplyPassState(const PassState& state);
+	void RadixSort();
+public:
+	explicit RenderQueue(FrameArena& arena);
+
+	void SetPassState(unsigned int pass, const PassState& state);
+	const PassState& GetPassState(unsigned int pass) const { return m_Passes[pass]; }
+	// Times every named pass on the GPU, nullptr turns it off
+	void SetProfiler(GpuProfiler* profiler) { m_Profiler = profiler; }
+
+	// Clears last frame's commands, depth is measured from viewPosition and normalized by farPlane
+	void Begin(const glm::vec3& viewPosition, float farPlane);
+	void Submit(unsigned int pass, Mesh& mesh, Shader& shader, const glm::mat4* model = nullptr, const DrawParams* params = nullptr);
+	// Adds commands recorded elsewhere, the list has to outlive Execute()
+	void Append(const DrawList& list);
+	void Execute();
+
+	// Builds a command without storing anything, model and params are referenced, not copied.
+	// Only reads the pass table and view position so it's safe to call from several threads.
+	DrawCommand MakeCommand(unsigned int pass, Mesh& mesh, Shader& shader, const glm::mat4* model, const DrawParams* params) const;
+
+	size_t GetCommandCount() const { return m_Commands.size(); }
+	const RenderQueueStats& GetStats() const { return m_Stats; }
+};
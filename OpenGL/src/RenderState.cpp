@@ -0,0 +1,324 @@
+#include "RenderState.h"
+
+namespace
+{
+	constexpr unsigned int UNKNOWN = 0xffffffff;
+
+	// Texture targets we shadow per unit, anything else is passed straight through
+	enum TextureTarget
+	{
+		TARGET_2D,
+		TARGET_CUBE_MAP,
+		TARGET_2D_ARRAY,
+		TARGET_COUNT
+	};
+
+	enum Capability
+	{
+		CAP_BLEND,
+		CAP_DEPTH_TEST,
+		CAP_STENCIL_TEST,
+		CAP_CULL_FACE,
+		CAP_COUNT
+	};
+
+	struct ShadowState
+	{
+		unsigned int program;
+		unsigned int vao;
+		unsigned int activeUnit;
+		unsigned int textures[RenderState::MAX_TEXTURE_UNITS][TARGET_COUNT];
+		unsigned int capabilities[CAP_COUNT]; // 0, 1 or UNKNOWN
+		unsigned int depthFunc;
+		unsigned int blendSrc, blendDst;
+		unsigned int stencilFunc, stencilFuncMask;
+		int stencilRef;
+		unsigned int stencilFail, stencilDepthFail, stencilDepthPass;
+		unsigned int stencilMask;
+		unsigned int cullFace;
+		// Every value is a valid mask or reference, so these can't use UNKNOWN
+		bool stencilFuncKnown;
+		bool stencilMaskKnown;
+	};
+
+	ShadowState s_State;
+	RenderStateStats s_Stats;
+	bool s_Initialized = false;
+
+	int TargetIndex(GLenum target)
+	{
+		switch (target)
+		{
+		case GL_TEXTURE_2D: return TARGET_2D;
+		case GL_TEXTURE_CUBE_MAP: return TARGET_CUBE_MAP;
+		case GL_TEXTURE_2D_ARRAY: return TARGET_2D_ARRAY;
+		default: return -1;
+		}
+	}
+
+	int CapabilityIndex(GLenum cap)
+	{
+		switch (cap)
+		{
+		case GL_BLEND: return CAP_BLEND;
+		case GL_DEPTH_TEST: return CAP_DEPTH_TEST;
+		case GL_STENCIL_TEST: return CAP_STENCIL_TEST;
+		case GL_CULL_FACE: return CAP_CULL_FACE;
+		default: return -1;
+		}
+	}
+
+	// Returns true if the call has to reach the driver, and records it either way
+	bool Track(StateCall call, bool changed)
+	{
+		if (changed)
+			++s_Stats.issued[(int)call];
+		else
+			++s_Stats.elided[(int)call];
+		return changed;
+	}
+
+	void EnsureInitialized()
+	{
+		if (!s_Initialized)
+			RenderState::Invalidate();
+	}
+}
+
+unsigned int RenderStateStats::TotalIssued() const
+{
+	unsigned int total = 0;
+	for (int i = 0; i < (int)StateCall::Count; ++i)
+		total += issued[i];
+	return total;
+}
+
+unsigned int RenderStateStats::TotalElided() const
+{
+	unsigned int total = 0;
+	for (int i = 0; i < (int)StateCall::Count; ++i)
+		total += elided[i];
+	return total;
+}
+
+void RenderState::UseProgram(unsigned int program)
+{
+	EnsureInitialized();
+	if (Track(StateCall::Program, s_State.program != program))
+	{
+		glUseProgram(program);
+		s_State.program = program;
+	}
+}
+
+void RenderState::BindVertexArray(unsigned int vao)
+{
+	EnsureInitialized();
+	if (Track(StateCall::VertexArray, s_State.vao != vao))
+	{
+		glBindVertexArray(vao);
+		s_State.vao = vao;
+	}
+}
+
+void RenderState::ActiveTexture(unsigned int unit)
+{
+	EnsureInitialized();
+	if (Track(StateCall::ActiveTexture, s_State.activeUnit != unit))
+	{
+		glActiveTexture(GL_TEXTURE0 + unit);
+		s_State.activeUnit = unit;
+	}
+}
+
+void RenderState::BindTexture(unsigned int unit, GLenum target, unsigned int texture)
+{
+	EnsureInitialized();
+	int targetIndex = TargetIndex(target);
+	if (unit >= MAX_TEXTURE_UNITS || targetIndex < 0)
+	{
+		ActiveTexture(unit);
+		Track(StateCall::Texture, true);
+		glBindTexture(target, texture);
+		return;
+	}
+
+	if (Track(StateCall::Texture, s_State.textures[unit][targetIndex] != texture))
+	{
+		ActiveTexture(unit);
+		glBindTexture(target, texture);
+		s_State.textures[unit][targetIndex] = texture;
+	}
+}
+
+unsigned int RenderState::GetActiveTextureUnit()
+{
+	EnsureInitialized();
+	if (s_State.activeUnit == UNKNOWN)
+		ActiveTexture(0);
+	return s_State.activeUnit;
+}
+
+void RenderState::Enable(GLenum cap)
+{
+	SetEnabled(cap, true);
+}
+
+void RenderState::Disable(GLenum cap)
+{
+	SetEnabled(cap, false);
+}
+
+void RenderState::SetEnabled(GLenum cap, bool enabled)
+{
+	EnsureInitialized();
+	int index = CapabilityIndex(cap);
+	unsigned int value = enabled ? 1 : 0;
+	if (Track(StateCall::Capability, index < 0 || s_State.capabilities[index] != value))
+	{
+		if (enabled)
+			glEnable(cap);
+		else
+			glDisable(cap);
+		if (index >= 0)
+			s_State.capabilities[index] = value;
+	}
+}
+
+bool RenderState::IsEnabled(GLenum cap)
+{
+	EnsureInitialized();
+	int index = CapabilityIndex(cap);
+	if (index >= 0 && s_State.capabilities[index] != UNKNOWN)
+		return s_State.capabilities[index] == 1;
+	bool enabled = glIsEnabled(cap) == GL_TRUE;
+	if (index >= 0)
+		s_State.capabilities[index] = enabled ? 1 : 0;
+	return enabled;
+}
+
+void RenderState::DepthFunc(GLenum func)
+{
+	EnsureInitialized();
+	if (Track(StateCall::DepthFunc, s_State.depthFunc != func))
+	{
+		glDepthFunc(func);
+		s_State.depthFunc = func;
+	}
+}
+
+void RenderState::BlendFunc(GLenum src, GLenum dst)
+{
+	EnsureInitialized();
+	if (Track(StateCall::BlendFunc, s_State.blendSrc != src || s_State.blendDst != dst))
+	{
+		glBlendFunc(src, dst);
+		s_State.blendSrc = src;
+		s_State.blendDst = dst;
+	}
+}
+
+void RenderState::StencilFunc(GLenum func, int ref, unsigned int mask)
+{
+	EnsureInitialized();
+	bool changed = !s_State.stencilFuncKnown || s_State.stencilFunc != func ||
+		s_State.stencilRef != ref || s_State.stencilFuncMask != mask;
+	if (Track(StateCall::Stencil, changed))
+	{
+		glStencilFunc(func, ref, mask);
+		s_State.stencilFunc = func;
+		s_State.stencilRef = ref;
+		s_State.stencilFuncMask = mask;
+		s_State.stencilFuncKnown = true;
+	}
+}
+
+void RenderState::StencilOp(GLenum stencilFail, GLenum depthFail, GLenum depthPass)
+{
+	EnsureInitialized();
+	bool changed = s_State.stencilFail != stencilFail || s_State.stencilDepthFail != depthFail ||
+		s_State.stencilDepthPass != depthPass;
+	if (Track(StateCall::Stencil, changed))
+	{
+		glStencilOp(stencilFail, depthFail, depthPass);
+		s_State.stencilFail = stencilFail;
+		s_State.stencilDepthFail = depthFail;
+		s_State.stencilDepthPass = depthPass;
+	}
+}
+
+void RenderState::StencilMask(unsigned int mask)
+{
+	EnsureInitialized();
+	if (Track(StateCall::Stencil, !s_State.stencilMaskKnown || s_State.stencilMask != mask))
+	{
+		glStencilMask(mask);
+		s_State.stencilMask = mask;
+		s_State.stencilMaskKnown = true;
+	}
+}
+
+void RenderState::CullFace(GLenum mode)
+{
+	EnsureInitialized();
+	if (Track(StateCall::CullFace, s_State.cullFace != mode))
+	{
+		glCullFace(mode);
+		s_State.cullFace = mode;
+	}
+}
+
+void RenderState::ForgetProgram(unsigned int program)
+{
+	if (s_State.program == program)
+		s_State.program = 0;
+}
+
+void RenderState::ForgetVertexArray(unsigned int vao)
+{
+	if (s_State.vao == vao)
+		s_State.vao = 0;
+}
+
+void RenderState::ForgetTexture(unsigned int texture)
+{
+	for (unsigned int unit = 0; unit < MAX_TEXTURE_UNITS; ++unit)
+	{
+		for (int target = 0; target < TARGET_COUNT; ++target)
+		{
+			if (s_State.textures[unit][target] == texture)
+				s_State.textures[unit][target] = 0;
+		}
+	}
+}
+
+void RenderState::Invalidate()
+{
+	s_State.program = UNKNOWN;
+	s_State.vao = UNKNOWN;
+	s_State.activeUnit = UNKNOWN;
+	for (unsigned int unit = 0; unit < MAX_TEXTURE_UNITS; ++unit)
+	{
+		for (int target = 0; target < TARGET_COUNT; ++target)
+			s_State.textures[unit][target] = UNKNOWN;
+	}
+	for (int i = 0; i < CAP_COUNT; ++i)
+		s_State.capabilities[i] = UNKNOWN;
+	s_State.depthFunc = UNKNOWN;
+	s_State.blendSrc = s_State.blendDst = UNKNOWN;
+	s_State.stencilFuncKnown = false;
+	s_State.stencilFail = s_State.stencilDepthFail = s_State.stencilDepthPass = UNKNOWN;
+	s_State.stencilMaskKnown = false;
+	s_State.cullFace = UNKNOWN;
+	s_Initialized = true;
+}
+
+void RenderState::ResetStats()
+{
+	s_Stats = RenderStateStats();
+}
+
+const RenderStateStats& RenderState::GetStats()
+{
+	return s_Stats;
+}
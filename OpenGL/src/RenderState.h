@@ -0,0 +1,71 @@
+#pragma once
+#include <GL/glew.h>
+
+// Categories of state changes we keep counters for
+enum class StateCall
+{
+	Program,
+	VertexArray,
+	ActiveTexture,
+	Texture,
+	Capability,
+	DepthFunc,
+	BlendFunc,
+	Stencil,
+	CullFace,
+	Count
+};
+
+struct RenderStateStats
+{
+	unsigned int issued[(int)StateCall::Count] = {};
+	unsigned int elided[(int)StateCall::Count] = {};
+
+	unsigned int Issued(StateCall call) const { return issued[(int)call]; }
+	unsigned int Elided(StateCall call) const { return elided[(int)call]; }
+	unsigned int TotalIssued() const;
+	unsigned int TotalElided() const;
+};
+
+// Shadows the GL state that gets touched every draw so redundant driver calls can be skipped.
+// Everything that binds programs, vertex arrays or textures, or toggles blend/depth/stencil/cull
+// state should go through here. If something changes that state behind our back, call Invalidate()
+// and the next call of each kind will be issued unconditionally.
+class RenderState
+{
+public:
+	static constexpr unsigned int MAX_TEXTURE_UNITS = 32;
+public:
+	static void UseProgram(unsigned int program);
+	static void BindVertexArray(unsigned int vao);
+
+	static void ActiveTexture(unsigned int unit);
+	static void BindTexture(unsigned int unit, GLenum target, unsigned int texture);
+	static unsigned int GetActiveTextureUnit();
+
+	// Only GL_BLEND, GL_DEPTH_TEST, GL_STENCIL_TEST and GL_CULL_FACE are shadowed,
+	// other capabilities are forwarded to the driver every time
+	static void Enable(GLenum cap);
+	static void Disable(GLenum cap);
+	static void SetEnabled(GLenum cap, bool enabled);
+	// From the shadow state if it's known, from the driver otherwise
+	static bool IsEnabled(GLenum cap);
+
+	static void DepthFunc(GLenum func);
+	static void BlendFunc(GLenum src, GLenum dst);
+	static void StencilFunc(GLenum func, int ref, unsigned int mask);
+	static void StencilOp(GLenum stencilFail, GLenum depthFail, GLenum depthPass);
+	static void StencilMask(unsigned int mask);
+	static void CullFace(GLenum mode);
+
+	// Objects that are deleted must be forgotten, GL silently rebinds 0 in their place
+	static void ForgetProgram(unsigned int program);
+	static void ForgetVertexArray(unsigned int vao);
+	static void ForgetTexture(unsigned int texture);
+
+	static void Invalidate();
+
+	// Call once at the start of every frame
+	static void ResetStats();
+	static const RenderStateStats& GetStats();
+};
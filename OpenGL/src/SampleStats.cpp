@@ -0,0 +1,14 @@
+#include "SampleStats.h"
+#include <algorithm>
+#include <cmath>
+
+double SampleStats::GetPercentile(double percentile) const
+{
+	if (m_Samples.empty())
+		return 0.0;
+	std::vector<double> sorted(m_Samples);
+	std::sort(sorted.begin(), sorted.end());
+	double rank = std::ceil(percentile / 100.0 * sorted.size());
+	size_t index = (size_t)std::max(rank, 1.0) - 1;
+	return sorted[std::min(index, sorted.size() - 1)];
+}
@@ -0,0 +1,25 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+// Collects per-frame measurements for benchmarks. Reserve() up front so adding never allocates.
+class SampleStats
+{
+private:
+	std::vector<double> m_Samples;
+	double m_Total;
+public:
+	SampleStats() : m_Total(0.0) {}
+
+	void Reserve(size_t count) { m_Samples.reserve(count); }
+	void Add(double sample) { m_Samples.push_back(sample); m_Total += sample; }
+	void Clear() { m_Samples.clear(); m_Total = 0.0; }
+
+	size_t GetCount() const { return m_Samples.size(); }
+	double GetTotal() const { return m_Total; }
+	double GetMean() const { return m_Samples.empty() ? 0.0 : m_Total / m_Samples.size(); }
+	double GetMin() const { return GetPercentile(0.0); }
+	double GetMax() const { return GetPercentile(100.0); }
+	// Nearest rank, percentile in [0, 100]
+	double GetPercentile(double percentile) const;
+};
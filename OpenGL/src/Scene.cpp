@@ -0,0 +1,161 @@
+#include "Scene.h"
+#include "CpuProfiler.h"
+#include "Model.h"
+#include <algorithm>
+#include <cassert>
+
+void Scene::Reserve(size_t entityCount)
+{
+	m_Transforms.Reserve(entityCount);
+	m_Nodes.reserve(entityCount);
+	m_NodeEntities.reserve(entityCount);
+	m_ChildCounts.reserve(entityCount);
+	m_Renderables.Reserve(entityCount);
+	m_LocalBounds.Reserve(entityCount);
+	m_WorldBounds.Reserve(entityCount);
+}
+
+void Scene::Clear()
+{
+	m_Entities.Clear();
+	m_Transforms.Clear();
+	m_Nodes.clear();
+	m_NodeEntities.clear();
+	m_ChildCounts.clear();
+	m_FreeNodes.clear();
+	m_Renderables.Clear();
+	m_LocalBounds.Clear();
+	m_WorldBounds.Clear();
+	m_PointLights.Clear();
+}
+
+Entity Scene::CreateEntity(const glm::mat4& local, Entity parent)
+{
+	// A stale parent's node may belong to someone else by now
+	assert(parent == NO_ENTITY || IsAlive(parent));
+	uint32_t parentNode = parent == NO_ENTITY ? TransformHierarchy::NO_PARENT : GetNode(parent);
+	Entity entity = m_Entities.Create();
+	if (entity == NO_ENTITY)
+		return NO_ENTITY;
+	if (GetEntityIndex(entity) >= m_Nodes.size())
+		m_Nodes.resize(GetEntityIndex(entity) + 1);
+
+	// A free node only works if it comes after the parent's, the hierarchy is in topological order
+	uint32_t node;
+	auto free = parentNode == TransformHierarchy::NO_PARENT ? m_FreeNodes.begin() : m_FreeNodes.upper_bound(parentNode);
+	if (free != m_FreeNodes.end())
+	{
+		node = *free;
+		m_FreeNodes.erase(free);
+		m_Transforms.ResetNode(node, parentNode, local);
+		m_NodeEntities[node] = entity;
+	}
+	else
+	{
+		node = m_Transforms.AddNode(parentNode, local);
+		m_NodeEntities.push_back(entity);
+		m_ChildCounts.push_back(0);
+	}
+	if (parentNode != TransformHierarchy::NO_PARENT)
+		++m_ChildCounts[parentNode];
+	m_Nodes[GetEntityIndex(entity)] = node;
+	return entity;
+}
+
+void Scene::FreeNode(uint32_t node)
+{
+	Entity entity = m_NodeEntities[node];
+	m_Renderables.Remove(entity);
+	m_LocalBounds.Remove(entity);
+	m_WorldBounds.Remove(entity);
+	m_PointLights.Remove(entity);
+	m_Entities.Destroy(entity);
+
+	uint32_t parent = m_Transforms.GetParent(node);
+	if (parent != TransformHierarchy::NO_PARENT)
+		--m_ChildCounts[parent];
+	// Detached so it stops following its old parent
+	m_Transforms.ResetNode(node, TransformHierarchy::NO_PARENT);
+	m_NodeEntities[node] = NO_ENTITY;
+	m_FreeNodes.insert(node);
+}
+
+void Scene::DestroyEntity(Entity entity)
+{
+	if (!IsAlive(entity))
+		return;
+	uint32_t root = GetNode(entity);
+	// Descendants come after the node, a node is one if its parent is. Only walked if there are any.
+	if (m_ChildCounts[root] > 0)
+	{
+		std::vector<uint32_t> destroyed(1, root);
+		for (uint32_t node = root + 1; node < m_Transforms.GetNodeCount(); ++node)
+		{
+			uint32_t parent = m_Transforms.GetParent(node);
+			if (m_NodeEntities[node] != NO_ENTITY && parent != TransformHierarchy::NO_PARENT
+				&& std::binary_search(destroyed.begin(), destroyed.end(), parent))
+				destroyed.push_back(node);
+		}
+		// Children before parents, so the child counts never see a freed parent
+		for (size_t i = destroyed.size(); i-- > 1;)
+			FreeNode(destroyed[i]);
+	}
+	FreeNode(root);
+}
+
+void Scene::AddRenderable(Entity entity, const RenderableComponent& renderable)
+{
+	m_Renderables.Add(entity, renderable);
+	m_LocalBounds.Add(entity, renderable.model->GetBounds());
+	m_WorldBounds.Add(entity, renderable.model->GetBounds().Transformed(GetWorldTransform(entity)));
+}
+
+void Scene::AddPointLight(Entity entity, const PointLightComponent& light)
+{
+	m_PointLights.Add(entity, light);
+}
+
+void Scene::UpdateTransforms()
+{
+	PROFILE_SCOPE("Scene::UpdateTransforms");
+	// Nothing moved, the bounds are still right
+	if (m_Transforms.Update() == 0)
+		return;
+	for (size_t slot = 0; slot < m_WorldBounds.GetSize(); ++slot)
+		m_WorldBounds[slot] = m_LocalBounds[slot].Transformed(m_Transforms.GetWorld(GetNode(m_WorldBounds.GetEntity(slot))));
+}
+
+unsigned int Scene::GatherPointLights(const glm::vec3& position, PointLightInstance* lights, unsigned int maxLights) const
+{
+	PROFILE_SCOPE("Scene::GatherPointLights");
+	maxLights = std::min(maxLights, MAX_GATHERED_LIGHTS);
+
+	// Nearest first
+	uint32_t slots[MAX_GATHERED_LIGHTS];
+	float distances[MAX_GATHERED_LIGHTS];
+	unsigned int count = 0;
+	for (size_t slot = 0; slot < m_PointLights.GetSize(); ++slot)
+	{
+		glm::vec3 offset = glm::vec3(m_Transforms.GetWorld(GetNode(m_PointLights.GetEntity(slot)))[3]) - position;
+		float distance = glm::dot(offset, offset);
+		if (count == maxLights && (count == 0 || distance >= distances[count - 1]))
+			continue;
+
+		unsigned int i = count < maxLights ? count++ : count - 1;
+		for (; i > 0 && distances[i - 1] > distance; --i)
+		{
+			slots[i] = slots[i - 1];
+			distances[i] = distances[i - 1];
+		}
+		slots[i] = (uint32_t)slot;
+		distances[i] = distance;
+	}
+
+	std::sort(slots, slots + count);
+	for (unsigned int i = 0; i < count; ++i)
+	{
+		lights[i].position = glm::vec3(m_Transforms.GetWorld(GetNode(m_PointLights.GetEntity(slots[i])))[3]);
+		lights[i].light = m_PointLights[slots[i]];
+	}
+	return count;
+}
@@ -0,0 +1,102 @@
+#pragma once
+#include <cstdint>
+#include <set>
+#include <vector>
+#include <glm/glm.hpp>
+#include "Bounds.h"
+#include "EntityStore.h"
+#include "RenderQueue.h"
+#include "TransformHierarchy.h"
+
+class Model;
+class Shader;
+
+// One model drawn with one shader in one pass
+struct RenderableComponent
+{
+	Model* model = nullptr;
+	Shader* shader = nullptr;
+	// The NORMAL_MAP permutation of shader, for the meshes that have a normal map. Without one they
+	// use shader too.
+	Shader* normalMapShader = nullptr;
+	unsigned int pass = 0;
+	DrawParams params;
+};
+
+struct PointLightComponent
+{
+	glm::vec3 color = glm::vec3(1.0f);
+	float constant = 1.0f;
+	float linear = 0.09f;
+	float quadratic = 0.032f;
+};
+
+// A light picked by Scene::GatherPointLights(), with its world position
+struct PointLightInstance
+{
+	glm::vec3 position;
+	PointLightComponent light;
+};
+
+// Scene content as entities. Every entity has a transform, which is a node of the scene's
+// TransformHierarchy, everything else is an optional component living in a pool of its own.
+// Systems are the loops over those pools: UpdateTransforms(), GatherPointLights() and the
+// FrameBuilder for culling and recording.
+class Scene
+{
+public:
+	static constexpr unsigned int MAX_GATHERED_LIGHTS = 32;
+private:
+	EntityAllocator m_Entities;
+	TransformHierarchy m_Transforms;
+	// Hierarchy node by entity index, and the other way around (NO_ENTITY for free nodes)
+	std::vector<uint32_t> m_Nodes;
+	std::vector<Entity> m_NodeEntities;
+	std::vector<uint32_t> m_ChildCounts;
+	// Nodes of destroyed entities. Each new entity takes the lowest one after its parent's, which
+	// leaves the higher ones for children of later parents.
+	std::set<uint32_t> m_FreeNodes;
+	ComponentPool<RenderableComponent> m_Renderables;
+	// Boxes around the renderables, the model's and the one culling tests. Separate pools so culling
+	// streams through world boxes only. Both always hold the same entities in the same slots.
+	ComponentPool<Bounds> m_LocalBounds;
+	ComponentPool<Bounds> m_WorldBounds;
+	ComponentPool<PointLightComponent> m_PointLights;
+private:
+	void FreeNode(uint32_t node);
+public:
+	void Reserve(size_t entityCount);
+	void Clear();
+
+	// Parents have to exist already, which keeps the hierarchy in the order it's updated in.
+	// NO_ENTITY once all 2^24 - 1 entity indices are in use.
+	Entity CreateEntity(const glm::mat4& local = glm::mat4(1.0f), Entity parent = NO_ENTITY);
+	// Removes the entity and everything below it in the hierarchy with their components. Their
+	// nodes go to later entities. Stale handles are ignored.
+	void DestroyEntity(Entity entity);
+	bool IsAlive(Entity entity) const { return m_Entities.IsAlive(entity); }
+	size_t GetEntityCount() const { return m_Entities.GetAliveCount(); }
+
+	void SetLocalTransform(Entity entity, const glm::mat4& local) { m_Transforms.SetLocal(GetNode(entity), local); }
+	// As of the last UpdateTransforms()
+	const glm::mat4& GetWorldTransform(Entity entity) const { return m_Transforms.GetWorld(GetNode(entity)); }
+	uint32_t GetNode(Entity entity) const { return m_Nodes[GetEntityIndex(entity)]; }
+	const TransformHierarchy& GetTransforms() const { return m_Transforms; }
+
+	// Adds the bounds along with it, from the model's
+	void AddRenderable(Entity entity, const RenderableComponent& renderable);
+	void AddPointLight(Entity entity, const PointLightComponent& light);
+
+	ComponentPool<RenderableComponent>& GetRenderables() { return m_Renderables; }
+	const ComponentPool<RenderableComponent>& GetRenderables() const { return m_Renderables; }
+	// Kept up to date by UpdateTransforms()
+	const ComponentPool<Bounds>& GetWorldBounds() const { return m_WorldBounds; }
+	ComponentPool<PointLightComponent>& GetPointLights() { return m_PointLights; }
+	const ComponentPool<PointLightComponent>& GetPointLights() const { return m_PointLights; }
+
+	// World matrices of whatever changed, then the world bounds if anything did
+	void UpdateTransforms();
+	// Up to maxLights (at most MAX_GATHERED_LIGHTS) lights nearest to position, in the order they
+	// were added so the shader sums them the same way every frame. Returns how many were written.
+	unsigned int GatherPointLights(const glm::vec3& position, PointLightInstance* lights, unsigned int maxLights) const;
+};
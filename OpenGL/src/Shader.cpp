@@ -1,24 +1,54 @@
 #include "Shader.h"
 #include <GL/glew.h>
+#include "RenderState.h"
+#include <algorithm>
 #include <iostream>
 #include <fstream>
 #include <string>
 #include <sstream>
-Shader::Shader(const std::string& vs, const std::string& fs, const std::string& gs /*= ""*/) :
+
+namespace
+{
+	void InsertDefines(std::string& source, const std::string& defines)
+	{
+		// No geometry shader stays no geometry shader
+		if (defines.empty() || source.empty())
+			return;
+		// #version has to stay the first line
+		size_t version = source.find("#version");
+		size_t lineEnd = version == std::string::npos ? std::string::npos : source.find('\n', version);
+		// A #version among the defines replaces the file's, for permutations that need a newer GLSL
+		std::string lines = defines;
+		size_t override = lines.find("#version");
+		if (override != std::string::npos && lineEnd != std::string::npos)
+		{
+			size_t overrideEnd = std::min(lines.find('\n', override), lines.size());
+			source.replace(version, lineEnd - version, lines, override, overrideEnd - override);
+			lines.erase(override, overrideEnd + 1 - override);
+			lineEnd = source.find('\n', version);
+		}
+		if (lineEnd == std::string::npos)
+			source.insert(0, lines);
+		else
+			source.insert(lineEnd + 1, lines);
+	}
+}
+
+Shader::Shader(const std::string& vs, const std::string& fs, const std::string& gs /*= ""*/, const std::string& defines /*= ""*/) :
 	m_RendererID(0)
 {
-	ShaderProgramSource source = ParseShader(vs, fs, gs);
+	ShaderProgramSource source = ParseShader(vs, fs, gs, defines);
 	m_RendererID = CreateShader(source.VertexSource, source.FragmentSource, source.GeometrySource);
 }
 
 void Shader::Bind() const
 {
-	glUseProgram(m_RendererID);
+	RenderState::UseProgram(m_RendererID);
 }
 
 void Shader::Unbind() const
 {
-	glUseProgram(0);
+	RenderState::UseProgram(0);
 }
 
 void Shader::SetUniform1i(const std::string& name, int i0)
@@ -31,6 +61,16 @@ void Shader::SetUniform1f(const std::string& name, float v0)
 	glUniform1f(GetUniformLocation(name), v0);
 }
 
+void Shader::SetUniform1fv(const std::string& name, int count, const float* values)
+{
+	glUniform1fv(GetUniformLocation(name), count, values);
+}
+
+void Shader::SetUniform2f(const std::string& name, float v0, float v1)
+{
+	glUniform2f(GetUniformLocation(name), v0, v1);
+}
+
 void Shader::SetUniform3f(const std::string& name, float v0, float v1, float v2)
 {
 	glUniform3f(GetUniformLocation(name), v0, v1, v2);
@@ -51,11 +91,17 @@ void Shader::SetUniformMat4f(const std::string& name, glm::mat4 matrix)
 	glUniformMatrix4fv(GetUniformLocation(name), 1, GL_FALSE, &matrix[0][0]);
 }
 
+void Shader::SetUniformMat4fv(const std::string& name, int count, const glm::mat4* matrices)
+{
+	glUniformMatrix4fv(GetUniformLocation(name), count, GL_FALSE, &matrices[0][0][0]);
+}
+
 int Shader::GetUniformLocation(const std::string& name)
 {
-	if (m_UniformLocationCache.find(name) != m_UniformLocationCache.end())
+	auto cached = m_UniformLocationCache.find(name);
+	if (cached != m_UniformLocationCache.end())
 	{
-		return m_UniformLocationCache[name];
+		return cached->second;
 	}
 
 	int location = glGetUniformLocation(m_RendererID, name.c_str());
@@ -92,7 +138,7 @@ unsigned int Shader::CreateShader(const std::string& vertexShader, const std::st
 
 
 
-ShaderProgramSource Shader::ParseShader(const std::string& vs, const std::string& fs, const std::string& gs /*= ""*/)
+ShaderProgramSource Shader::ParseShader(const std::string& vs, const std::string& fs, const std::string& gs /*= ""*/, const std::string& defines /*= ""*/)
 {
 
 	ShaderProgramSource source;
@@ -115,7 +161,9 @@ ShaderProgramSource Shader::ParseShader(const std::string& vs, const std::string
 	{
 		source.GeometrySource = "";
 	}
-
+	InsertDefines(source.VertexSource, defines);
+	InsertDefines(source.FragmentSource, defines);
+	InsertDefines(source.GeometrySource, defines);
 
 	return source;
 }
@@ -153,6 +201,7 @@ unsigned int Shader::CompileShader(unsigned int type, const std::string& source)
 
 Shader::~Shader()
 {
+	RenderState::ForgetProgram(m_RendererID);
 	glDeleteProgram(m_RendererID);
 }
 
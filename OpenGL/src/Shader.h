@@ -17,9 +17,11 @@ private:
 	std::unordered_map<std::string, int> m_UniformLocationCache;
 	// caching for uniforms
 public:
-	Shader(const std::string& vs, const std::string& fs, const std::string& gs = "");
+	// defines are inserted after each stage's #version line, e.g. "#define NORMAL_MAP\n" to build a
+	// permutation of the same files. A #version line among them replaces the files' own.
+	Shader(const std::string& vs, const std::string& fs, const std::string& gs = "", const std::string& defines = "");
 
-	unsigned int GetID() { return m_RendererID; }
+	unsigned int GetID() const { return m_RendererID; }
 
 	void Bind() const;
 	void Unbind() const;
@@ -27,15 +29,18 @@ public:
 	// Set uniforms
 	void SetUniform1i(const std::string& name, int i0);
 	void SetUniform1f(const std::string& name, float v0);
+	void SetUniform1fv(const std::string& name, int count, const float* values);
+	void SetUniform2f(const std::string& name, float v0, float v1);
 	void SetUniform3f(const std::string& name, float v0, float v1, float v2);
 	void SetUniform3f(const std::string& name, glm::vec3 vector);
 	void SetUniform4f(const std::string& name, float v0, float v1, float v2, float v3);
 	void SetUniformMat4f(const std::string& name, glm::mat4 matrix);
+	void SetUniformMat4fv(const std::string& name, int count, const glm::mat4* matrices);
 
 	~Shader();
 private:
 	unsigned int CompileShader(unsigned int type, const std::string& source);
 	int GetUniformLocation(const std::string& name);
 	unsigned int CreateShader(const std::string& vertexShader, const std::string& fragmentShader, const std::string& geometryShader = "");
-	ShaderProgramSource ParseShader(const std::string& vs, const std::string& fs, const std::string& gs = "");
+	ShaderProgramSource ParseShader(const std::string& vs, const std::string& fs, const std::string& gs = "", const std::string& defines = "");
 };
\ No newline at end of file
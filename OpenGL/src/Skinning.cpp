@@ -0,0 +1,73 @@
+#include "Skinning.h"
+#include <cstddef>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SKINNING_SSE
+#include <emmintrin.h>
+#endif
+
+void SkinVerticesScalar(const Vertex* vertices, const VertexWeights* weights, size_t count, const glm::mat4* palette, Vertex* out)
+{
+	for (size_t i = 0; i < count; ++i)
+	{
+		const VertexWeights& vertexWeights = weights[i];
+		glm::mat4 skin = palette[vertexWeights.bones[0]] * vertexWeights.weights[0];
+		for (unsigned int j = 1; j < VertexWeights::MAX_INFLUENCES; ++j)
+			skin += palette[vertexWeights.bones[j]] * vertexWeights.weights[j];
+
+		out[i].position = glm::vec3(skin * glm::vec4(vertices[i].position, 1.0f));
+		out[i].normal = glm::normalize(glm::vec3(skin * glm::vec4(vertices[i].normal, 0.0f)));
+		out[i].texCoords = vertices[i].texCoords;
+	}
+}
+
+#ifdef SKINNING_SSE
+// Each store writes a float past the vec3, which the next store or the texture coordinates overwrite
+static_assert(sizeof(Vertex) == 8 * sizeof(float) && offsetof(Vertex, normal) == 3 * sizeof(float)
+	&& offsetof(Vertex, texCoords) == 6 * sizeof(float), "SkinVertices relies on the packed Vertex layout");
+
+void SkinVertices(const Vertex* vertices, const VertexWeights* weights, size_t count, const glm::mat4* palette, Vertex* out)
+{
+	for (size_t i = 0; i < count; ++i)
+	{
+		// The blended matrix, one register per column
+		const VertexWeights& vertexWeights = weights[i];
+		__m128 column0 = _mm_setzero_ps();
+		__m128 column1 = _mm_setzero_ps();
+		__m128 column2 = _mm_setzero_ps();
+		__m128 column3 = _mm_setzero_ps();
+		for (unsigned int j = 0; j < VertexWeights::MAX_INFLUENCES; ++j)
+		{
+			const float* bone = &palette[vertexWeights.bones[j]][0][0];
+			__m128 weight = _mm_set1_ps(vertexWeights.weights[j]);
+			column0 = _mm_add_ps(column0, _mm_mul_ps(_mm_loadu_ps(bone), weight));
+			column1 = _mm_add_ps(column1, _mm_mul_ps(_mm_loadu_ps(bone + 4), weight));
+			column2 = _mm_add_ps(column2, _mm_mul_ps(_mm_loadu_ps(bone + 8), weight));
+			column3 = _mm_add_ps(column3, _mm_mul_ps(_mm_loadu_ps(bone + 12), weight));
+		}
+
+		const Vertex& vertex = vertices[i];
+		__m128 position = _mm_add_ps(
+			_mm_add_ps(_mm_mul_ps(column0, _mm_set1_ps(vertex.position.x)), _mm_mul_ps(column1, _mm_set1_ps(vertex.position.y))),
+			_mm_add_ps(_mm_mul_ps(column2, _mm_set1_ps(vertex.position.z)), column3));
+		__m128 normal = _mm_add_ps(
+			_mm_add_ps(_mm_mul_ps(column0, _mm_set1_ps(vertex.normal.x)), _mm_mul_ps(column1, _mm_set1_ps(vertex.normal.y))),
+			_mm_mul_ps(column2, _mm_set1_ps(vertex.normal.z)));
+
+		// Length in every lane, w is 0 for affine bone matrices
+		__m128 squared = _mm_mul_ps(normal, normal);
+		__m128 length = _mm_add_ps(squared, _mm_shuffle_ps(squared, squared, _MM_SHUFFLE(2, 3, 0, 1)));
+		length = _mm_add_ps(length, _mm_shuffle_ps(length, length, _MM_SHUFFLE(1, 0, 3, 2)));
+		normal = _mm_div_ps(normal, _mm_sqrt_ps(_mm_max_ps(length, _mm_set1_ps(1e-20f))));
+
+		_mm_storeu_ps(&out[i].position.x, position);
+		_mm_storeu_ps(&out[i].normal.x, normal);
+		out[i].texCoords = vertex.texCoords;
+	}
+}
+#else
+void SkinVertices(const Vertex* vertices, const VertexWeights* weights, size_t count, const glm::mat4* palette, Vertex* out)
+{
+	SkinVerticesScalar(vertices, weights, count, palette, out);
+}
+#endif
@@ -0,0 +1,10 @@
+#pragma once
+#include <cstddef>
+#include <glm/glm.hpp>
+#include "Vertex.h"
+
+// Moves count vertices by the blend of their bones' palette matrices, like BasicLitSkinned.vs does
+// on the GPU, and writes them to out (which can't be vertices). Uses SSE where the target has it.
+void SkinVertices(const Vertex* vertices, const VertexWeights* weights, size_t count, const glm::mat4* palette, Vertex* out);
+// Same thing with plain glm, the fallback and the reference for the SSE path
+void SkinVerticesScalar(const Vertex* vertices, const VertexWeights* weights, size_t count, const glm::mat4* palette, Vertex* out);
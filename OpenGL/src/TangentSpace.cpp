@@ -0,0 +1,56 @@
+#include "TangentSpace.h"
+#include <cmath>
+#include <glm/gtc/quaternion.hpp>
+
+namespace
+{
+	const float SHORT_MAX = 32767.0f;
+	// Smallest w that survives quantization, a w of 0 would lose the bitangent's sign
+	const float MIN_W = 1.0f / SHORT_MAX;
+}
+
+glm::vec4 OrthogonalizeTangent(const glm::vec3& normal, const glm::vec3& tangent, const glm::vec3& bitangent)
+{
+	glm::vec3 orthogonal = tangent - normal * glm::dot(normal, tangent);
+	float length = glm::length(orthogonal);
+	if (length < 1e-6f)
+	{
+		// No usable UVs, the normal map can't be lined up anyway
+		glm::vec3 axis = std::abs(normal.x) < 0.9f ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+		orthogonal = glm::cross(axis, normal);
+		length = glm::length(orthogonal);
+	}
+	orthogonal /= length;
+	float sign = glm::dot(glm::cross(normal, orthogonal), bitangent) < 0.0f ? -1.0f : 1.0f;
+	return glm::vec4(orthogonal, sign);
+}
+
+PackedTangentFrame PackTangentFrame(const glm::vec3& normal, const glm::vec4& tangent)
+{
+	glm::vec3 t = glm::vec3(tangent);
+	glm::quat rotation = glm::normalize(glm::quat_cast(glm::mat3(t, glm::cross(normal, t), normal)));
+	// q and -q are the same rotation, so the sign of w is free to carry the bitangent's
+	if (rotation.w < 0.0f)
+		rotation = -rotation;
+	if (rotation.w < MIN_W)
+	{
+		float scale = std::sqrt(1.0f - MIN_W * MIN_W) / glm::length(glm::vec3(rotation.x, rotation.y, rotation.z));
+		rotation = glm::quat(MIN_W, rotation.x * scale, rotation.y * scale, rotation.z * scale);
+	}
+	if (tangent.w < 0.0f)
+		rotation = -rotation;
+
+	PackedTangentFrame frame;
+	float components[4] = { rotation.x, rotation.y, rotation.z, rotation.w };
+	for (int i = 0; i < 4; ++i)
+		frame.rotation[i] = (int16_t)std::lround(glm::clamp(components[i], -1.0f, 1.0f) * SHORT_MAX);
+	return frame;
+}
+
+void UnpackTangentFrame(const PackedTangentFrame& frame, glm::vec3& normal, glm::vec4& tangent)
+{
+	glm::quat rotation = glm::normalize(glm::quat(frame.rotation[3] / SHORT_MAX, frame.rotation[0] / SHORT_MAX,
+		frame.rotation[1] / SHORT_MAX, frame.rotation[2] / SHORT_MAX));
+	normal = rotation * glm::vec3(0.0f, 0.0f, 1.0f);
+	tangent = glm::vec4(rotation * glm::vec3(1.0f, 0.0f, 0.0f), frame.rotation[3] < 0 ? -1.0f : 1.0f);
+}
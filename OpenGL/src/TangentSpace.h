@@ -0,0 +1,19 @@
+#pragma once
+#include <cstdint>
+#include <glm/glm.hpp>
+
+// Tangent space of a vertex as one rotation, 4 normalized shorts instead of a normal and a tangent.
+// The rotation takes x, y and z to the tangent, cross(normal, tangent) and the normal, the sign of
+// w is the bitangent's sign. BasicLit.vs with PACKED_TANGENT_FRAME unpacks it.
+struct PackedTangentFrame
+{
+	int16_t rotation[4];
+};
+
+// Gram-Schmidt against the normal, w = the sign to multiply cross(normal, tangent) with to get
+// the bitangent. Degenerate tangents are replaced by any vector perpendicular to the normal.
+glm::vec4 OrthogonalizeTangent(const glm::vec3& normal, const glm::vec3& tangent, const glm::vec3& bitangent);
+
+PackedTangentFrame PackTangentFrame(const glm::vec3& normal, const glm::vec4& tangent);
+// The inverse, what the shaders do
+void UnpackTangentFrame(const PackedTangentFrame& frame, glm::vec3& normal, glm::vec4& tangent);
@@ -1,14 +1,21 @@
 #include "Texture.h"
 #include "vendor/stb_image/stb_image.h"
+#include "RenderState.h"
+#include "CpuProfiler.h"
 
 Texture::Texture(const std::string& path, aiTextureType type) :
-	m_ID(0), m_Path(path), m_Type(type), m_LocalBuffer(nullptr), m_Width(0), m_Height(0), m_BPP(0)
+	m_ID(0), m_Path(path), m_Type(type), m_LocalBuffer(nullptr), m_Width(0), m_Height(0), m_BPP(0), m_Handle(0)
 {
 	stbi_set_flip_vertically_on_load(1); // b/c of OpenGL coordinate system
-	m_LocalBuffer = stbi_load(path.c_str(), &m_Width, &m_Height, &m_BPP, 4);
+
+	{
+		PROFILE_SCOPE("Texture decode");
+		m_LocalBuffer = stbi_load(path.c_str(), &m_Width, &m_Height, &m_BPP, 4);
+	}
+	PROFILE_SCOPE("Texture upload");
 
 	glGenTextures(1, &m_ID);
-	glBindTexture(GL_TEXTURE_2D, m_ID);
+	RenderState::BindTexture(RenderState::GetActiveTextureUnit(), GL_TEXTURE_2D, m_ID);
 
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
@@ -24,12 +31,29 @@ Texture::Texture(const std::string& path, aiTextureType type) :
 	}
 }
 
+Texture::Texture(int width, int height, int levelCount, aiTextureType type) :
+	m_ID(0), m_Type(type), m_LocalBuffer(nullptr), m_Width(width), m_Height(height), m_BPP(4), m_Handle(0)
+{
+	glGenTextures(1, &m_ID);
+	RenderState::BindTexture(RenderState::GetActiveTextureUnit(), GL_TEXTURE_2D, m_ID);
+
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, levelCount - 1);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levelCount - 1);
+}
+
 std::string Texture::GetTypeString()
 {
 	switch (m_Type)
 	{
 	case aiTextureType_DIFFUSE: return "diffuse";
 	case aiTextureType_SPECULAR: return "specular";
+	// OBJ's map_Bump comes in as a height map, in practice it's a normal map
+	case aiTextureType_NORMALS:
+	case aiTextureType_HEIGHT: return "normal";
 	default: return "invalid";
 	}
 
@@ -37,17 +61,29 @@ std::string Texture::GetTypeString()
 
 void Texture::Bind(unsigned int slot) const
 {
-	glActiveTexture(GL_TEXTURE0 + slot);
-	glBindTexture(GL_TEXTURE_2D, m_ID);
+	RenderState::BindTexture(slot, GL_TEXTURE_2D, m_ID);
+}
+
+uint64_t Texture::GetHandle()
+{
+	if (m_Handle == 0)
+	{
+		m_Handle = glGetTextureHandleARB(m_ID);
+		glMakeTextureHandleResidentARB(m_Handle);
+	}
+	return m_Handle;
 }
 
 void Texture::Unbind() const
 {
-	glBindTexture(GL_TEXTURE_2D, 0);
+	RenderState::BindTexture(RenderState::GetActiveTextureUnit(), GL_TEXTURE_2D, 0);
 }
 
 Texture::~Texture()
 {
+	if (m_Handle != 0)
+		glMakeTextureHandleNonResidentARB(m_Handle);
+	RenderState::ForgetTexture(m_ID);
 	glDeleteTextures(1, &m_ID);
 }
 
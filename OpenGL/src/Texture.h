@@ -1,5 +1,6 @@
 #pragma once
 #include <GL/glew.h>
+#include <cstdint>
 #include <string>
 #include "assimp/material.h"
 
@@ -11,13 +12,20 @@ private:
 	std::string m_Path;
 	unsigned char* m_LocalBuffer;
 	int m_Width, m_Height, m_BPP;
+	// ARB_bindless_texture, 0 until GetHandle()
+	uint64_t m_Handle;
 public:
 	Texture(const std::string& path, aiTextureType type);
+	// No levels yet, TextureStreamer uploads and frees them and moves GL_TEXTURE_BASE_LEVEL along
+	Texture(int width, int height, int levelCount, aiTextureType type);
 
 	void Bind(unsigned int slot = 0) const;
 	void Unbind() const;
 
 	unsigned int GetID() const { return m_ID; }
+	// Resident bindless handle, created on first use. The texture's sampling state can't change
+	// after that.
+	uint64_t GetHandle();
 
 	aiTextureType GetType() { return m_Type; }
 	std::string GetTypeString();
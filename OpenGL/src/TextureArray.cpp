@@ -0,0 +1,70 @@
+#include "TextureArray.h"
+#include <iostream>
+#include "vendor/stb_image/stb_image.h"
+#include "RenderState.h"
+#include "CpuProfiler.h"
+
+TextureArray::TextureArray(int width, int height, const std::vector<std::string>& paths) :
+	m_ID(0), m_Width(width), m_Height(height), m_LayerCount((unsigned int)paths.size()), m_Handle(0)
+{
+	PROFILE_SCOPE("TextureArray upload");
+	stbi_set_flip_vertically_on_load(1); // b/c of OpenGL coordinate system
+
+	glGenTextures(1, &m_ID);
+	RenderState::BindTexture(RenderState::GetActiveTextureUnit(), GL_TEXTURE_2D_ARRAY, m_ID);
+
+	// The layers get their mips below, minified ones would alias without them
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+
+	glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, width, height, m_LayerCount, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+
+	for (unsigned int layer = 0; layer < m_LayerCount; ++layer)
+	{
+		int imageWidth = 0, imageHeight = 0, bpp = 0;
+		unsigned char* pixels;
+		{
+			PROFILE_SCOPE("Texture decode");
+			pixels = stbi_load(paths[layer].c_str(), &imageWidth, &imageHeight, &bpp, 4);
+		}
+		if (pixels && imageWidth == width && imageHeight == height)
+		{
+			glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, width, height, 1, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+		}
+		else
+		{
+			std::cout << "WARNING::TEXTURE_ARRAY::couldn't load " << paths[layer] << " as a " << width << "x" << height << " layer" << std::endl;
+			// Black rather than whatever the driver left there
+			std::vector<unsigned char> black((size_t)width * height * 4, 0);
+			glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, width, height, 1, GL_RGBA, GL_UNSIGNED_BYTE, black.data());
+		}
+		if (pixels)
+			stbi_image_free(pixels);
+	}
+	glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+}
+
+void TextureArray::Bind(unsigned int slot) const
+{
+	RenderState::BindTexture(slot, GL_TEXTURE_2D_ARRAY, m_ID);
+}
+
+uint64_t TextureArray::GetHandle()
+{
+	if (m_Handle == 0)
+	{
+		m_Handle = glGetTextureHandleARB(m_ID);
+		glMakeTextureHandleResidentARB(m_Handle);
+	}
+	return m_Handle;
+}
+
+TextureArray::~TextureArray()
+{
+	if (m_Handle != 0)
+		glMakeTextureHandleNonResidentARB(m_Handle);
+	RenderState::ForgetTexture(m_ID);
+	glDeleteTextures(1, &m_ID);
+}
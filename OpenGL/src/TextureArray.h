@@ -0,0 +1,29 @@
+#pragma once
+#include <GL/glew.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Same-sized images as the layers of one GL_TEXTURE_2D_ARRAY, see TextureArrayPlan
+class TextureArray
+{
+private:
+	unsigned int m_ID;
+	int m_Width, m_Height;
+	unsigned int m_LayerCount;
+	uint64_t m_Handle;
+public:
+	// Images that don't have the array's size are left black
+	TextureArray(int width, int height, const std::vector<std::string>& paths);
+
+	void Bind(unsigned int slot = 0) const;
+
+	unsigned int GetID() const { return m_ID; }
+	// Like Texture::GetHandle()
+	uint64_t GetHandle();
+	int GetWidth() const { return m_Width; }
+	int GetHeight() const { return m_Height; }
+	unsigned int GetLayerCount() const { return m_LayerCount; }
+
+	~TextureArray();
+};
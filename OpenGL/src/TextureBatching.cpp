@@ -0,0 +1,51 @@
+#include "TextureBatching.h"
+#include <map>
+#include <utility>
+
+TextureArrayPlan TextureArrayPlan::Plan(const std::vector<int>& widths, const std::vector<int>& heights, uint32_t maxLayers)
+{
+	TextureArrayPlan plan;
+	plan.placements.resize(widths.size());
+	// The array currently being filled for each size
+	std::map<std::pair<int, int>, uint32_t> open;
+	for (uint32_t image = 0; image < (uint32_t)widths.size(); ++image)
+	{
+		std::pair<int, int> size(widths[image], heights[image]);
+		auto found = open.find(size);
+		if (found == open.end() || plan.arrays[found->second].images.size() >= maxLayers)
+		{
+			TextureArrayPlan::Array array;
+			array.width = size.first;
+			array.height = size.second;
+			plan.arrays.push_back(array);
+			found = open.insert_or_assign(size, (uint32_t)plan.arrays.size() - 1).first;
+		}
+		Array& array = plan.arrays[found->second];
+		plan.placements[image].array = found->second;
+		plan.placements[image].layer = (uint32_t)array.images.size();
+		array.images.push_back(image);
+	}
+	return plan;
+}
+
+bool BatchKey::operator<(const BatchKey& other) const
+{
+	if (material != other.material)
+		return material < other.material;
+	if (transform != other.transform)
+		return transform < other.transform;
+	return streams < other.streams;
+}
+
+std::vector<uint32_t> GroupBatches(const std::vector<BatchKey>& keys, uint32_t& batchCount)
+{
+	std::vector<uint32_t> batches(keys.size());
+	std::map<BatchKey, uint32_t> found;
+	for (uint32_t i = 0; i < (uint32_t)keys.size(); ++i)
+	{
+		auto inserted = found.insert(std::make_pair(keys[i], (uint32_t)found.size()));
+		batches[i] = inserted.first->second;
+	}
+	batchCount = (uint32_t)found.size();
+	return batches;
+}
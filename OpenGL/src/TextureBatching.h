@@ -0,0 +1,48 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+// Planning for ModelSettings::textureArrays, without GL so tools and benchmarks can use it too.
+// Images of the same size go into the same GL_TEXTURE_2D_ARRAY whatever map they are, once the
+// maps of several materials are layers of the same arrays the materials are the same as far as
+// binding goes and their meshes can be drawn together.
+
+struct TextureArrayPlan
+{
+	struct Array
+	{
+		int width;
+		int height;
+		// Indices into the sizes Plan() got, in layer order
+		std::vector<uint32_t> images;
+	};
+	struct Placement
+	{
+		uint32_t array;
+		uint32_t layer;
+	};
+
+	std::vector<Array> arrays;
+	// By image
+	std::vector<Placement> placements;
+
+	// One image per index of widths and heights. Layers are 8 bits per vertex, so arrays hold at
+	// most 256, more images of a size start another array.
+	static TextureArrayPlan Plan(const std::vector<int>& widths, const std::vector<int>& heights, uint32_t maxLayers = 256);
+};
+
+// What has to match for meshes to share a draw once their maps are in arrays
+struct BatchKey
+{
+	// Deduplicated material, with its maps in arrays materials differing only in layers are one
+	uint32_t material;
+	// Distinct node transform the mesh is placed with
+	uint32_t transform;
+	// Vertex streams the mesh has, skinned, tangents...
+	uint32_t streams;
+
+	bool operator<(const BatchKey& other) const;
+};
+
+// Batch index by key, batches are numbered in order of their first mesh
+std::vector<uint32_t> GroupBatches(const std::vector<BatchKey>& keys, uint32_t& batchCount);
@@ -0,0 +1,200 @@
+#include "TextureStreamer.h"
+#include <GL/glew.h>
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+#include "CpuProfiler.h"
+#include "Frustum.h"
+#include "Material.h"
+#include "Model.h"
+#include "RenderState.h"
+#include "Scene.h"
+#include "Texture.h"
+
+TextureStreamer::TextureStreamer(uint64_t budgetBytes, unsigned int maxUploadsPerFrame, unsigned int planInterval) :
+	m_BudgetBytes(budgetBytes), m_ResidentBytes(0), m_PlannedBytes(0), m_MaxUploads(std::max(maxUploadsPerFrame, 1u)),
+	m_PlanInterval(std::max(planInterval, 1u)), m_Frame(0), m_Uploads(0), m_Drops(0)
+{
+}
+
+Texture* TextureStreamer::Load(const std::string& path, aiTextureType type)
+{
+	std::unique_ptr<Entry> entry(new Entry());
+	if (!entry->file.Open(path))
+	{
+		std::cout << "ERROR::TEXTURE_STREAMER::couldn't open " << path << std::endl;
+		return nullptr;
+	}
+	MipChainFile& file = entry->file;
+	uint32_t levelCount = file.GetLevelCount();
+	uint32_t coarse = 0;
+	while (coarse + 1 < levelCount && std::max(file.GetLevelWidth(coarse), file.GetLevelHeight(coarse)) > RESIDENT_SIZE)
+		++coarse;
+	entry->minResident = levelCount - coarse;
+
+	entry->texture = new Texture((int)file.GetWidth(), (int)file.GetHeight(), (int)levelCount, type);
+	entry->base = levelCount;
+	for (uint32_t level = levelCount; level-- > coarse;)
+	{
+		if (!UploadLevel(*entry, level))
+		{
+			std::cout << "ERROR::TEXTURE_STREAMER::couldn't read level " << level << " of " << path << std::endl;
+			m_ResidentBytes -= GetMipChainBytes(file.GetWidth(), file.GetHeight(), level + 1);
+			delete entry->texture;
+			return nullptr;
+		}
+		SetBaseLevel(*entry, level);
+	}
+	entry->target = coarse;
+	entry->wanted = coarse;
+
+	Texture* texture = entry->texture;
+	m_Indices[texture] = m_Entries.size();
+	m_Order.push_back(m_Entries.size());
+	m_Entries.push_back(std::move(entry));
+	m_Requests.resize(m_Entries.size());
+	m_Levels.resize(m_Entries.size());
+	return texture;
+}
+
+bool TextureStreamer::UploadLevel(Entry& entry, uint32_t level)
+{
+	m_Buffer.resize((size_t)entry.file.GetLevelBytes(level));
+	if (!entry.file.ReadLevel(level, m_Buffer.data()))
+		return false;
+	RenderState::BindTexture(RenderState::GetActiveTextureUnit(), GL_TEXTURE_2D, entry.texture->GetID());
+	glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA8, entry.file.GetLevelWidth(level), entry.file.GetLevelHeight(level), 0,
+		GL_RGBA, GL_UNSIGNED_BYTE, m_Buffer.data());
+	m_ResidentBytes += entry.file.GetLevelBytes(level);
+	++m_Uploads;
+	return true;
+}
+
+void TextureStreamer::SetBaseLevel(Entry& entry, uint32_t level)
+{
+	RenderState::BindTexture(RenderState::GetActiveTextureUnit(), GL_TEXTURE_2D, entry.texture->GetID());
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level);
+	entry.base = level;
+}
+
+void TextureStreamer::Gather(const Scene& scene, const glm::vec3& cameraPosition, float fovYRadians, float screenHeight, const glm::mat4& viewProjection)
+{
+	for (std::unique_ptr<Entry>& entry : m_Entries)
+	{
+		entry->seen = false;
+		entry->priority = 0.0f;
+	}
+
+	Frustum frustum(viewProjection);
+	const ComponentPool<RenderableComponent>& renderables = scene.GetRenderables();
+	for (size_t slot = 0; slot < renderables.GetSize(); ++slot)
+	{
+		Entity entity = renderables.GetEntity(slot);
+		Model* model = renderables[slot].model;
+		const Bounds* bounds = scene.GetWorldBounds().Find(entity);
+		if (!model || !bounds || !frustum.Intersects(*bounds))
+			continue;
+
+		float pixelsPerUnit = PixelsPerWorldUnit(*bounds, cameraPosition, fovYRadians, screenHeight);
+		// Roughly how many pixels across the object is
+		float priority = pixelsPerUnit * glm::length(bounds->GetExtents()) * 2.0f;
+		// Model units per world unit, the largest axis so a stretched object gets the finer level
+		const glm::mat4& world = scene.GetWorldTransform(entity);
+		float scale = std::max(glm::length(glm::vec3(world[0])), std::max(glm::length(glm::vec3(world[1])), glm::length(glm::vec3(world[2]))));
+		if (!(scale > 0.0f))
+			continue;
+
+		for (const Mesh& mesh : model->GetMeshes())
+		{
+			const Material& material = MaterialLibrary::Get(mesh.GetMaterialID());
+			for (Texture* texture : material.textures)
+			{
+				auto found = texture ? m_Indices.find(texture) : m_Indices.end();
+				if (found == m_Indices.end())
+					continue;
+				Entry& entry = *m_Entries[found->second];
+				float texelsPerUnit = std::max(entry.file.GetWidth(), entry.file.GetHeight()) * mesh.GetUvDensity() / scale;
+				uint32_t wanted = WantedMip(texelsPerUnit, pixelsPerUnit);
+				entry.wanted = entry.seen ? std::min(entry.wanted, wanted) : wanted;
+				entry.priority = std::max(entry.priority, priority);
+				entry.seen = true;
+			}
+		}
+	}
+}
+
+void TextureStreamer::Plan()
+{
+	for (size_t i = 0; i < m_Entries.size(); ++i)
+	{
+		const Entry& entry = *m_Entries[i];
+		MipRequest& request = m_Requests[i];
+		request.width = entry.file.GetWidth();
+		request.height = entry.file.GetHeight();
+		// Out of sight keeps what it has, but is the first to give it up
+		request.wanted = entry.seen ? entry.wanted : entry.target;
+		request.minResident = entry.minResident;
+		request.priority = entry.seen ? entry.priority : 0.0f;
+	}
+	m_PlannedBytes = PlanMipResidency(m_Requests.data(), m_Requests.size(), m_BudgetBytes, m_Levels.data(), m_PlanScratch);
+	for (size_t i = 0; i < m_Entries.size(); ++i)
+		m_Entries[i]->target = m_Levels[i];
+	std::sort(m_Order.begin(), m_Order.end(), [&](size_t a, size_t b) { return m_Requests[a].priority > m_Requests[b].priority; });
+}
+
+void TextureStreamer::Update(const Scene& scene, const glm::vec3& cameraPosition, float fovYRadians, float screenHeight, const glm::mat4& viewProjection)
+{
+	if (m_Entries.empty())
+		return;
+	PROFILE_SCOPE("TextureStreamer");
+	if (m_Frame++ % m_PlanInterval == 0)
+	{
+		Gather(scene, cameraPosition, fovYRadians, screenHeight, viewProjection);
+		Plan();
+	}
+
+	// Drops first, the uploads after them then stay within the budget
+	for (std::unique_ptr<Entry>& entry : m_Entries)
+	{
+		if (entry->target <= entry->base)
+			continue;
+		uint32_t oldBase = entry->base;
+		SetBaseLevel(*entry, entry->target);
+		// Respecified as empty, which frees the level's memory
+		for (uint32_t level = oldBase; level < entry->target; ++level)
+		{
+			glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA8, 0, 0, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+			m_ResidentBytes -= entry->file.GetLevelBytes(level);
+			++m_Drops;
+		}
+	}
+
+	// The next finer level of the most important textures, so they sharpen a step at a time
+	unsigned int uploads = 0;
+	for (size_t i = 0; i < m_Order.size() && uploads < m_MaxUploads; ++i)
+	{
+		Entry& entry = *m_Entries[m_Order[i]];
+		if (entry.target >= entry.base)
+			continue;
+		if (!UploadLevel(entry, entry.base - 1))
+		{
+			std::cout << "ERROR::TEXTURE_STREAMER::couldn't read level " << entry.base - 1 << ", keeping level " << entry.base << std::endl;
+			entry.target = entry.base;
+			continue;
+		}
+		SetBaseLevel(entry, entry.base - 1);
+		++uploads;
+	}
+}
+
+std::string TextureStreamer::GetSummary() const
+{
+	uint32_t streaming = 0;
+	for (const std::unique_ptr<Entry>& entry : m_Entries)
+		streaming += entry->target < entry->base;
+	std::ostringstream summary;
+	summary << "Texture streaming: " << m_Entries.size() << " textures, " << m_ResidentBytes / (1024.0 * 1024.0) << " of "
+		<< m_BudgetBytes / (1024.0 * 1024.0) << " MB resident (" << m_PlannedBytes / (1024.0 * 1024.0) << " planned), "
+		<< streaming << " still streaming in, " << m_Uploads << " levels uploaded, " << m_Drops << " dropped";
+	return summary.str();
+}
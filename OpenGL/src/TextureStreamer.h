@@ -0,0 +1,82 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <glm/glm.hpp>
+#include "assimp/material.h"
+#include "MipStreaming.h"
+
+class Scene;
+class Texture;
+
+// Material maps that start out with only their coarse levels and get the finer ones from their
+// .mips (AssetTool mips) once something using them comes close enough to show them. Every few
+// frames the visible renderables give each texture the level a texel of it covers about a pixel
+// at, from the mesh's UV density, the object's scale and the distance to its bounds. Then
+// PlanMipResidency() fits that into the budget. Levels the plan drops are freed straight away,
+// the ones it adds come in one at a time and a few per frame, and GL_TEXTURE_BASE_LEVEL follows
+// what's actually there.
+//
+// Reads are synchronous. Bindless handles would freeze the base level, so there's no streaming
+// with MaterialLibrary::EnableBindless().
+class TextureStreamer
+{
+public:
+	// Levels up to this size along the longer side are loaded up front and never dropped
+	static constexpr uint32_t RESIDENT_SIZE = 64;
+private:
+	struct Entry
+	{
+		Texture* texture = nullptr;
+		MipChainFile file;
+		// Finest level on the GPU and the one the last plan wants there
+		uint32_t base = 0;
+		uint32_t target = 0;
+		uint32_t minResident = 1;
+		// Gathered for the next plan
+		uint32_t wanted = 0;
+		float priority = 0.0f;
+		bool seen = false;
+	};
+
+	std::vector<std::unique_ptr<Entry>> m_Entries;
+	std::unordered_map<const Texture*, size_t> m_Indices;
+	// Most important first, for handing out the uploads
+	std::vector<size_t> m_Order;
+	// One per entry, grown with them so planning doesn't allocate
+	std::vector<MipRequest> m_Requests;
+	std::vector<uint32_t> m_Levels;
+	MipPlanScratch m_PlanScratch;
+	uint64_t m_BudgetBytes;
+	uint64_t m_ResidentBytes;
+	uint64_t m_PlannedBytes;
+	unsigned int m_MaxUploads;
+	unsigned int m_PlanInterval;
+	unsigned int m_Frame;
+	std::vector<unsigned char> m_Buffer;
+	// Levels, since the start
+	unsigned int m_Uploads;
+	unsigned int m_Drops;
+private:
+	void Gather(const Scene& scene, const glm::vec3& cameraPosition, float fovYRadians, float screenHeight, const glm::mat4& viewProjection);
+	void Plan();
+	bool UploadLevel(Entry& entry, uint32_t level);
+	void SetBaseLevel(Entry& entry, uint32_t level);
+public:
+	TextureStreamer(uint64_t budgetBytes, unsigned int maxUploadsPerFrame = 2, unsigned int planInterval = 10);
+	TextureStreamer(const TextureStreamer&) = delete;
+	TextureStreamer& operator=(const TextureStreamer&) = delete;
+
+	// A texture with the coarse levels of the .mips, nullptr if it can't be read. The caller owns
+	// it, it has to stay alive as long as the streamer does.
+	Texture* Load(const std::string& path, aiTextureType type);
+
+	// Plans every few frames, then frees and uploads levels. screenHeight is what the scene is drawn at.
+	void Update(const Scene& scene, const glm::vec3& cameraPosition, float fovYRadians, float screenHeight, const glm::mat4& viewProjection);
+
+	size_t GetTextureCount() const { return m_Entries.size(); }
+	uint64_t GetResidentBytes() const { return m_ResidentBytes; }
+	std::string GetSummary() const;
+};
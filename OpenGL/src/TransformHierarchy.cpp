@@ -0,0 +1,100 @@
+#include "TransformHierarchy.h"
+#include "CpuProfiler.h"
+#include <algorithm>
+#include <cassert>
+
+void TransformHierarchy::Reserve(size_t count)
+{
+	m_Parents.reserve(count);
+	m_Locals.reserve(count);
+	m_Worlds.reserve(count);
+	m_Dirty.reserve(count);
+}
+
+void TransformHierarchy::Clear()
+{
+	m_Parents.clear();
+	m_Locals.clear();
+	m_Worlds.clear();
+	m_Dirty.clear();
+	m_FirstDirty = 0;
+}
+
+uint32_t TransformHierarchy::AddNode(uint32_t parent, const glm::mat4& local)
+{
+	uint32_t node = (uint32_t)m_Parents.size();
+	assert(parent == NO_PARENT || parent < node);
+	// Without asserts it becomes a root, which at least keeps the order
+	m_Parents.push_back(parent < node ? parent : NO_PARENT);
+	m_Locals.push_back(local);
+	m_Worlds.push_back(local);
+	m_Dirty.push_back(1);
+	m_FirstDirty = std::min(m_FirstDirty, (size_t)node);
+	return node;
+}
+
+void TransformHierarchy::SetLocal(uint32_t node, const glm::mat4& local)
+{
+	m_Locals[node] = local;
+	m_Dirty[node] = 1;
+	m_FirstDirty = std::min(m_FirstDirty, (size_t)node);
+}
+
+void TransformHierarchy::ResetNode(uint32_t node, uint32_t parent, const glm::mat4& local)
+{
+	assert(parent == NO_PARENT || parent < node);
+	m_Parents[node] = parent < node ? parent : NO_PARENT;
+	SetLocal(node, local);
+}
+
+unsigned int TransformHierarchy::Update()
+{
+	PROFILE_SCOPE("TransformHierarchy::Update");
+	size_t count = m_Parents.size();
+	if (m_FirstDirty >= count)
+		return 0;
+
+	const uint32_t* parents = m_Parents.data();
+	const glm::mat4* locals = m_Locals.data();
+	glm::mat4* worlds = m_Worlds.data();
+	uint8_t* dirty = m_Dirty.data();
+	unsigned int updated = 0;
+	for (size_t i = m_FirstDirty; i < count; ++i)
+	{
+		uint32_t parent = parents[i];
+		// Parents come first, so their flag already includes everything above them
+		if (parent != NO_PARENT)
+			dirty[i] |= dirty[parent];
+		if (!dirty[i])
+			continue;
+		worlds[i] = parent == NO_PARENT ? locals[i] : worlds[parent] * locals[i];
+		++updated;
+	}
+	std::fill(m_Dirty.begin() + m_FirstDirty, m_Dirty.end(), (uint8_t)0);
+	m_FirstDirty = count;
+	return updated;
+}
+
+void TransformHierarchy::UpdateAll()
+{
+	PROFILE_SCOPE("TransformHierarchy::UpdateAll");
+	size_t count = m_Parents.size();
+	for (size_t i = 0; i < count; ++i)
+	{
+		uint32_t parent = m_Parents[i];
+		m_Worlds[i] = parent == NO_PARENT ? m_Locals[i] : m_Worlds[parent] * m_Locals[i];
+	}
+	std::fill(m_Dirty.begin(), m_Dirty.end(), (uint8_t)0);
+	m_FirstDirty = count;
+}
+
+glm::mat4 ComposeTransform(const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale)
+{
+	glm::mat3 basis = glm::mat3_cast(rotation);
+	glm::mat4 transform;
+	transform[0] = glm::vec4(basis[0] * scale.x, 0.0f);
+	transform[1] = glm::vec4(basis[1] * scale.y, 0.0f);
+	transform[2] = glm::vec4(basis[2] * scale.z, 0.0f);
+	transform[3] = glm::vec4(position, 1.0f);
+	return transform;
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+// Parent/child transforms stored as flat arrays in topological order, every node comes after its
+// parent. Update() walks the arrays once, starting at the first changed node, and recomputes the
+// world matrices of changed nodes and everything below them. Static parts of a scene cost nothing.
+class TransformHierarchy
+{
+public:
+	static constexpr uint32_t NO_PARENT = 0xffffffffu;
+private:
+	std::vector<uint32_t> m_Parents;
+	std::vector<glm::mat4> m_Locals;
+	std::vector<glm::mat4> m_Worlds;
+	// Set when the world matrix is stale, Update() also uses it to pass changes down to children
+	std::vector<uint8_t> m_Dirty;
+	size_t m_FirstDirty;
+public:
+	TransformHierarchy() : m_FirstDirty(0) {}
+
+	void Reserve(size_t count);
+	void Clear();
+	// parent has to be an existing node or NO_PARENT, that's what keeps the arrays topologically
+	// sorted. Anything else asserts.
+	uint32_t AddNode(uint32_t parent, const glm::mat4& local = glm::mat4(1.0f));
+	void SetLocal(uint32_t node, const glm::mat4& local);
+	// Hands an existing node to someone else, for reusing the nodes of destroyed entities. Same
+	// rule as AddNode(), parent has to come before the node. Children it still has stay attached.
+	void ResetNode(uint32_t node, uint32_t parent, const glm::mat4& local = glm::mat4(1.0f));
+
+	size_t GetNodeCount() const { return m_Parents.size(); }
+	uint32_t GetParent(uint32_t node) const { return m_Parents[node]; }
+	const glm::mat4& GetLocal(uint32_t node) const { return m_Locals[node]; }
+	// Stale until the next Update() after a change
+	const glm::mat4& GetWorld(uint32_t node) const { return m_Worlds[node]; }
+	bool IsDirty() const { return m_FirstDirty < m_Parents.size(); }
+
+	// Returns how many world matrices were recomputed
+	unsigned int Update();
+	// Recomputes every node whether it changed or not
+	void UpdateAll();
+};
+
+// Same as translate * mat4_cast(rotation) * scale, without the full matrix products
+glm::mat4 ComposeTransform(const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale);
@@ -1,4 +1,7 @@
 #pragma once
+#include <cstdint>
+#include <glm/glm.hpp>
+#include "Material.h"
 
 struct Vertex {
 	glm::vec3 position;
@@ -6,3 +9,18 @@ struct Vertex {
 	glm::vec2 texCoords;
 };
 
+// Bones a skinned vertex follows, kept in a stream of its own so static meshes don't pay for it.
+// Unused influences have a weight of 0, the weights add up to 1.
+struct VertexWeights {
+	static constexpr unsigned int MAX_INFLUENCES = 4;
+
+	uint8_t bones[MAX_INFLUENCES];
+	float weights[MAX_INFLUENCES];
+};
+
+// Texture array layers of the maps of a vertex's material, for meshes merged across materials.
+// Indexed by Material::Slot. Aligned so vertices stay 4 bytes apart in the stream.
+struct alignas(4) VertexLayers {
+	uint8_t layers[Material::SLOT_COUNT];
+};
+static_assert(Material::SLOT_COUNT <= 4, "VertexLayers is a single vertex attribute, 4 components at most");
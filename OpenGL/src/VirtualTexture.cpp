@@ -0,0 +1,276 @@
+#include "VirtualTexture.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <sstream>
+#include "CpuProfiler.h"
+#include "RenderState.h"
+#include "Shader.h"
+
+namespace
+{
+	const std::string CACHE_UNIFORM = "pageCache";
+	const std::string INDIRECTION_UNIFORM = "indirection";
+	const std::string VIRTUAL_SIZE_UNIFORM = "virtualSize";
+	const std::string TILES_UNIFORM = "tilesPerSide";
+	const std::string MIP_COUNT_UNIFORM = "mipCount";
+	const std::string MIP_BIAS_UNIFORM = "mipBias";
+	const std::string PAGE_UNIFORM = "pageLayout";
+	const std::string CACHE_SIZE_UNIFORM = "cacheSize";
+	const unsigned int READBACK_LATENCY = 3;
+	const unsigned int ROOT_ONLY_WARNING = 120;
+}
+
+VirtualTexture::VirtualTexture(const std::string& path, unsigned int pagesPerSide, int feedbackWidth, int feedbackHeight,
+	unsigned int maxUploadsPerFrame) :
+	m_Cache(0), m_Indirection(0), m_MaxUploads(maxUploadsPerFrame), m_FeedbackWidth(feedbackWidth), m_FeedbackHeight(feedbackHeight),
+	m_FeedbackFramebuffer(0), m_FeedbackColor(0), m_FeedbackDepth(0), m_Readbacks(READBACK_LATENCY), m_Oldest(0), m_Pending(0),
+	m_DroppedReadbacks(0), m_FeedbackTiles(0), m_RootOnlyFeedbacks(0), m_SavedFramebuffer(0), m_SavedViewport(),
+	m_SavedBlend(false), m_SavedStencilTest(false), m_SavedCullFace(false), m_SavedDepthTest(false)
+{
+	if (!m_File.Open(path))
+	{
+		std::cout << "ERROR::VIRTUAL_TEXTURE::couldn't open " << path << std::endl;
+		return;
+	}
+	if (m_File.GetTilesPerSide() > PageResidency::MAX_TILES_PER_SIDE)
+	{
+		std::cout << "ERROR::VIRTUAL_TEXTURE::" << path << " has more than " << PageResidency::MAX_TILES_PER_SIDE << " tiles per side" << std::endl;
+		return;
+	}
+	m_Residency.reset(new PageResidency(m_File.GetTilesPerSide(), pagesPerSide));
+	uint32_t pageSize = m_File.GetPageSize();
+	int cacheSize = (int)(m_Residency->GetPagesPerSide() * pageSize);
+	m_Tile.resize((size_t)pageSize * pageSize * 4);
+
+	// Bilinear inside a page, the borders cover the filter's footprint. No mips, the indirection picks the level.
+	glGenTextures(1, &m_Cache);
+	RenderState::BindTexture(CACHE_UNIT, GL_TEXTURE_2D, m_Cache);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, cacheSize, cacheSize, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+
+	// A level per mip, an RGBA8 IndirectionEntry per tile, read with texelFetch
+	glGenTextures(1, &m_Indirection);
+	RenderState::BindTexture(INDIRECTION_UNIT, GL_TEXTURE_2D, m_Indirection);
+	for (uint32_t mip = 0; mip < m_Residency->GetMipCount(); ++mip)
+	{
+		int tiles = (int)(m_Residency->GetTilesPerSide() >> mip);
+		glTexImage2D(GL_TEXTURE_2D, mip, GL_RGBA8, tiles, tiles, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+	}
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, m_Residency->GetMipCount() - 1);
+
+	// Cleared to zero, which the shader never writes, so empty texels are easy to skip
+	glGenTextures(1, &m_FeedbackColor);
+	RenderState::BindTexture(RenderState::GetActiveTextureUnit(), GL_TEXTURE_2D, m_FeedbackColor);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, m_FeedbackWidth, m_FeedbackHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glGenRenderbuffers(1, &m_FeedbackDepth);
+	glBindRenderbuffer(GL_RENDERBUFFER, m_FeedbackDepth);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, m_FeedbackWidth, m_FeedbackHeight);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+	glGenFramebuffers(1, &m_FeedbackFramebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, m_FeedbackFramebuffer);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_FeedbackColor, 0);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, m_FeedbackDepth);
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+		std::cout << "ERROR::VIRTUAL_TEXTURE::feedback framebuffer is not complete" << std::endl;
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	size_t feedbackBytes = (size_t)m_FeedbackWidth * m_FeedbackHeight * 4;
+	for (Readback& readback : m_Readbacks)
+	{
+		glGenBuffers(1, &readback.buffer);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer);
+		glBufferData(GL_PIXEL_PACK_BUFFER, feedbackBytes, nullptr, GL_STREAM_READ);
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	// The root tile, so there's something to show from the first frame
+	Update();
+}
+
+VirtualTexture::~VirtualTexture()
+{
+	for (Readback& readback : m_Readbacks)
+	{
+		if (readback.fence)
+			glDeleteSync(readback.fence);
+		glDeleteBuffers(1, &readback.buffer);
+	}
+	glDeleteFramebuffers(1, &m_FeedbackFramebuffer);
+	glDeleteRenderbuffers(1, &m_FeedbackDepth);
+	for (unsigned int texture : { m_Cache, m_Indirection, m_FeedbackColor })
+	{
+		RenderState::ForgetTexture(texture);
+		glDeleteTextures(1, &texture);
+	}
+}
+
+void VirtualTexture::BeginFeedback()
+{
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &m_SavedFramebuffer);
+	glGetIntegerv(GL_VIEWPORT, m_SavedViewport);
+	glBindFramebuffer(GL_FRAMEBUFFER, m_FeedbackFramebuffer);
+	glViewport(0, 0, m_FeedbackWidth, m_FeedbackHeight);
+	// Whatever the queue's last pass left on. Blending would scale the encoded tile by its own alpha.
+	m_SavedBlend = RenderState::IsEnabled(GL_BLEND);
+	m_SavedStencilTest = RenderState::IsEnabled(GL_STENCIL_TEST);
+	m_SavedCullFace = RenderState::IsEnabled(GL_CULL_FACE);
+	m_SavedDepthTest = RenderState::IsEnabled(GL_DEPTH_TEST);
+	RenderState::Disable(GL_BLEND);
+	RenderState::Disable(GL_STENCIL_TEST);
+	RenderState::Disable(GL_CULL_FACE);
+	RenderState::Enable(GL_DEPTH_TEST);
+	glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+}
+
+void VirtualTexture::EndFeedback()
+{
+	if (m_Pending == m_Readbacks.size())
+	{
+		++m_DroppedReadbacks;
+	}
+	else
+	{
+		Readback& readback = m_Readbacks[(m_Oldest + m_Pending) % m_Readbacks.size()];
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, m_FeedbackFramebuffer);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer);
+		glPixelStorei(GL_PACK_ALIGNMENT, 4);
+		glReadPixels(0, 0, m_FeedbackWidth, m_FeedbackHeight, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+		readback.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		++m_Pending;
+	}
+	glBindFramebuffer(GL_FRAMEBUFFER, (unsigned int)m_SavedFramebuffer);
+	glViewport(m_SavedViewport[0], m_SavedViewport[1], m_SavedViewport[2], m_SavedViewport[3]);
+	RenderState::SetEnabled(GL_BLEND, m_SavedBlend);
+	RenderState::SetEnabled(GL_STENCIL_TEST, m_SavedStencilTest);
+	RenderState::SetEnabled(GL_CULL_FACE, m_SavedCullFace);
+	RenderState::SetEnabled(GL_DEPTH_TEST, m_SavedDepthTest);
+}
+
+bool VirtualTexture::CollectFeedback()
+{
+	Readback& readback = m_Readbacks[m_Oldest];
+	GLenum status = glClientWaitSync(readback.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+	if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+		return false;
+	glDeleteSync(readback.fence);
+	readback.fence = nullptr;
+
+	size_t size = (size_t)m_FeedbackWidth * m_FeedbackHeight * 4;
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer);
+	const unsigned char* texels = (const unsigned char*)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, size, GL_MAP_READ_BIT);
+	m_FeedbackTiles = 0;
+	if (texels)
+	{
+		uint32_t rootMip = m_Residency->GetMipCount() - 1;
+		// VirtualTexture.fs' FEEDBACK encoding: low bytes of x and y, their high nibbles, mip + 1
+		for (size_t i = 0; i < size; i += 4)
+		{
+			if (texels[i + 3] == 0)
+				continue;
+			uint32_t x = texels[i] | (texels[i + 2] & 0xf) << 8;
+			uint32_t y = texels[i + 1] | (texels[i + 2] >> 4) << 8;
+			uint32_t mip = texels[i + 3] - 1u;
+			m_Residency->Request(mip, x, y);
+			m_FeedbackTiles += mip < rootMip;
+		}
+		glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+	}
+	// The ground needs finer tiles than the root from anywhere in the scene, so a long run of
+	// feedback without any means it's broken or the ground has been out of view for a while
+	m_RootOnlyFeedbacks = m_FeedbackTiles > 0 ? 0 : m_RootOnlyFeedbacks + 1;
+	if (m_RootOnlyFeedbacks == ROOT_ONLY_WARNING)
+	{
+		std::cout << "WARNING::VIRTUAL_TEXTURE::no tiles finer than the root in " << ROOT_ONLY_WARNING
+			<< " feedback readbacks in a row" << std::endl;
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	m_Oldest = (m_Oldest + 1) % m_Readbacks.size();
+	--m_Pending;
+	return true;
+}
+
+void VirtualTexture::Update()
+{
+	if (!IsValid())
+		return;
+	PROFILE_SCOPE("VirtualTexture::Update");
+	while (m_Pending > 0 && CollectFeedback())
+		;
+
+	std::vector<PageLoad> loads = m_Residency->Update(m_MaxUploads);
+	if (!loads.empty())
+	{
+		uint32_t pageSize = m_File.GetPageSize();
+		RenderState::BindTexture(CACHE_UNIT, GL_TEXTURE_2D, m_Cache);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+		for (const PageLoad& load : loads)
+		{
+			{
+				PROFILE_SCOPE("Tile read");
+				// A tile that can't be read shows black rather than whatever the page held before
+				if (!m_File.ReadTile(load.mip, load.x, load.y, m_Tile.data()))
+					std::fill(m_Tile.begin(), m_Tile.end(), (unsigned char)0);
+			}
+			uint32_t pageX = load.page % m_Residency->GetPagesPerSide();
+			uint32_t pageY = load.page / m_Residency->GetPagesPerSide();
+			glTexSubImage2D(GL_TEXTURE_2D, 0, pageX * pageSize, pageY * pageSize, pageSize, pageSize, GL_RGBA, GL_UNSIGNED_BYTE, m_Tile.data());
+		}
+	}
+
+	if (m_Residency->IsIndirectionDirty())
+	{
+		RenderState::BindTexture(INDIRECTION_UNIT, GL_TEXTURE_2D, m_Indirection);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+		for (uint32_t mip = 0; mip < m_Residency->GetMipCount(); ++mip)
+		{
+			int tiles = (int)(m_Residency->GetTilesPerSide() >> mip);
+			glTexSubImage2D(GL_TEXTURE_2D, mip, 0, 0, tiles, tiles, GL_RGBA, GL_UNSIGNED_BYTE, m_Residency->GetIndirection(mip).data());
+		}
+		m_Residency->ClearIndirectionDirty();
+	}
+}
+
+void VirtualTexture::Bind() const
+{
+	RenderState::BindTexture(CACHE_UNIT, GL_TEXTURE_2D, m_Cache);
+	RenderState::BindTexture(INDIRECTION_UNIT, GL_TEXTURE_2D, m_Indirection);
+}
+
+void VirtualTexture::SetUniforms(Shader& shader, bool feedback, int screenWidth) const
+{
+	shader.Bind();
+	shader.SetUniform1i(INDIRECTION_UNIFORM, INDIRECTION_UNIT);
+	shader.SetUniform1f(VIRTUAL_SIZE_UNIFORM, (float)m_File.GetSize());
+	shader.SetUniform1f(TILES_UNIFORM, (float)m_File.GetTilesPerSide());
+	shader.SetUniform1f(MIP_COUNT_UNIFORM, (float)m_File.GetMipCount());
+	// The feedback's derivatives are that much larger than the real draw's
+	shader.SetUniform1f(MIP_BIAS_UNIFORM, feedback && screenWidth > 0 ? -std::log2((float)screenWidth / m_FeedbackWidth) : 0.0f);
+	if (feedback)
+		return;
+	shader.SetUniform1i(CACHE_UNIFORM, CACHE_UNIT);
+	shader.SetUniform2f(PAGE_UNIFORM, (float)m_File.GetPageSize(), (float)m_File.GetBorder());
+	shader.SetUniform1f(CACHE_SIZE_UNIFORM, (float)(m_Residency->GetPagesPerSide() * m_File.GetPageSize()));
+}
+
+std::string VirtualTexture::GetSummary() const
+{
+	const PageResidencyStats& stats = m_Residency->GetStats();
+	std::ostringstream summary;
+	summary << "Virtual texture: " << m_Residency->GetResidentCount() << " of " << m_Residency->GetPagesPerSide() * m_Residency->GetPagesPerSide()
+		<< " pages, feedback " << stats.hits << " hits " << stats.misses << " misses, " << stats.loads << " loads, "
+		<< stats.evictions << " evictions, " << stats.deferred << " deferred, " << m_DroppedReadbacks << " readbacks dropped, "
+		<< m_FeedbackTiles << " non-root feedback texels";
+	return summary.str();
+}
@@ -0,0 +1,85 @@
+#pragma once
+#include <GL/glew.h>
+#include <memory>
+#include <string>
+#include <vector>
+#include "Material.h"
+#include "PageResidency.h"
+#include "VirtualTextureFile.h"
+
+class Shader;
+
+// A texture bigger than would fit in memory, drawn through VirtualTexture.fs. Only the tiles the
+// camera needs live on the GPU, in the pages of one cache texture, and the indirection texture
+// tells the shader which page has each tile. Which tiles are needed comes from a feedback pass,
+// the same geometry drawn at low resolution with the FEEDBACK permutation writing tile coordinates
+// instead of colors. It's read back through pixel buffers like FrameCapture's, so the requests
+// are a frame or two old but the CPU never waits for them. Tiles are read from the .vtex and
+// uploaded a limited number per frame, anything missing meanwhile shows a coarser mip.
+class VirtualTexture
+{
+public:
+	// After the material's maps and the skybox
+	static constexpr unsigned int CACHE_UNIT = MaterialLibrary::SKYBOX_UNIT + 1;
+	static constexpr unsigned int INDIRECTION_UNIT = CACHE_UNIT + 1;
+private:
+	struct Readback
+	{
+		unsigned int buffer = 0;
+		GLsync fence = nullptr;
+	};
+
+	VirtualTextureFile m_File;
+	std::unique_ptr<PageResidency> m_Residency;
+	unsigned int m_Cache;
+	unsigned int m_Indirection;
+	unsigned int m_MaxUploads;
+	std::vector<unsigned char> m_Tile;
+
+	int m_FeedbackWidth;
+	int m_FeedbackHeight;
+	unsigned int m_FeedbackFramebuffer;
+	unsigned int m_FeedbackColor;
+	unsigned int m_FeedbackDepth;
+	std::vector<Readback> m_Readbacks;
+	// Same ring as FrameCapture's, [m_Oldest, m_Oldest + m_Pending) are in flight
+	unsigned int m_Oldest;
+	unsigned int m_Pending;
+	unsigned int m_DroppedReadbacks;
+	// Tiles finer than the root in the last collected feedback, and how many collections in a row
+	// had none. Blending or a stencil test left on by the last pass would empty the feedback.
+	unsigned int m_FeedbackTiles;
+	unsigned int m_RootOnlyFeedbacks;
+	// What BeginFeedback() replaced
+	int m_SavedFramebuffer;
+	int m_SavedViewport[4];
+	bool m_SavedBlend;
+	bool m_SavedStencilTest;
+	bool m_SavedCullFace;
+	bool m_SavedDepthTest;
+private:
+	// Requests the tiles of the oldest readback if it's done
+	bool CollectFeedback();
+public:
+	// pagesPerSide squared pages make up the cache
+	VirtualTexture(const std::string& path, unsigned int pagesPerSide = 32, int feedbackWidth = 160, int feedbackHeight = 90,
+		unsigned int maxUploadsPerFrame = 16);
+	~VirtualTexture();
+	VirtualTexture(const VirtualTexture&) = delete;
+	VirtualTexture& operator=(const VirtualTexture&) = delete;
+
+	bool IsValid() const { return m_Residency != nullptr; }
+
+	// Draw everything using the texture with a FEEDBACK program in between
+	void BeginFeedback();
+	void EndFeedback();
+	// Turns finished feedback into requests, streams in tiles and refreshes the indirection
+	void Update();
+	void Bind() const;
+	// Samplers and sizes. screenWidth is what the program draws at, the feedback's mip selection
+	// makes up for its lower resolution.
+	void SetUniforms(Shader& shader, bool feedback, int screenWidth) const;
+
+	const PageResidency& GetResidency() const { return *m_Residency; }
+	std::string GetSummary() const;
+};
@@ -0,0 +1,117 @@
+#include "VirtualTextureFile.h"
+#include "BinaryIO.h"
+#include <algorithm>
+
+namespace
+{
+	const uint32_t VTEX_MAGIC = 0x58455456; // "VTEX"
+	const uint32_t VTEX_VERSION = 1;
+
+	bool IsPowerOfTwo(uint32_t value)
+	{
+		return value != 0 && (value & (value - 1)) == 0;
+	}
+}
+
+VirtualTextureFile::VirtualTextureFile() :
+	m_Header()
+{
+}
+
+bool VirtualTextureFile::Build(const Image& image, uint32_t tileSize, uint32_t border, const std::string& path)
+{
+	uint32_t size = (uint32_t)image.width;
+	if (image.channels != 4 || image.width != image.height || !IsPowerOfTwo(size) || !IsPowerOfTwo(tileSize) || size < tileSize)
+		return false;
+
+	VirtualTextureHeader header = { VTEX_MAGIC, VTEX_VERSION, size, tileSize, border, 1 };
+	while ((size >> (header.mipCount - 1)) > tileSize)
+		++header.mipCount;
+
+	uint32_t pageSize = tileSize + 2 * border;
+	size_t tileBytes = (size_t)pageSize * pageSize * 4;
+	size_t tileCount = 0;
+	for (uint32_t mip = 0; mip < header.mipCount; ++mip)
+	{
+		uint32_t tiles = (size >> mip) / tileSize;
+		tileCount += (size_t)tiles * tiles;
+	}
+
+	std::ofstream file(path, std::ios::binary);
+	if (!file)
+		return false;
+	Write(file, header);
+	uint64_t offset = sizeof(VirtualTextureHeader) + tileCount * sizeof(uint64_t);
+	for (size_t i = 0; i < tileCount; ++i, offset += tileBytes)
+		Write(file, offset);
+
+	Image level = image;
+	std::vector<unsigned char> tile(tileBytes);
+	for (uint32_t mip = 0; mip < header.mipCount; ++mip)
+	{
+		if (mip > 0)
+			level = Downsample(level);
+		int last = level.width - 1;
+		uint32_t tiles = (uint32_t)level.width / tileSize;
+		for (uint32_t tileY = 0; tileY < tiles; ++tileY)
+		{
+			for (uint32_t tileX = 0; tileX < tiles; ++tileX)
+			{
+				// Borders clamp at the image's edges
+				for (uint32_t y = 0; y < pageSize; ++y)
+				{
+					int sourceY = std::min(std::max((int)(tileY * tileSize + y) - (int)border, 0), last);
+					for (uint32_t x = 0; x < pageSize; ++x)
+					{
+						int sourceX = std::min(std::max((int)(tileX * tileSize + x) - (int)border, 0), last);
+						const unsigned char* texel = level.GetRow(sourceY) + sourceX * 4;
+						std::copy(texel, texel + 4, &tile[((size_t)y * pageSize + x) * 4]);
+					}
+				}
+				file.write((const char*)tile.data(), tile.size());
+			}
+		}
+	}
+	return (bool)file;
+}
+
+bool VirtualTextureFile::Open(const std::string& path)
+{
+	m_File.close();
+	m_File.open(path, std::ios::binary);
+	if (!m_File || !Read(m_File, m_Header) || m_Header.magic != VTEX_MAGIC || m_Header.version != VTEX_VERSION
+		|| !IsPowerOfTwo(m_Header.tileSize) || !IsPowerOfTwo(m_Header.size) || m_Header.size < m_Header.tileSize
+		|| m_Header.mipCount == 0 || (m_Header.size >> (m_Header.mipCount - 1)) < m_Header.tileSize)
+	{
+		m_File.close();
+		m_Header = VirtualTextureHeader();
+		return false;
+	}
+
+	m_MipStarts.clear();
+	uint32_t tileCount = 0;
+	for (uint32_t mip = 0; mip < m_Header.mipCount; ++mip)
+	{
+		m_MipStarts.push_back(tileCount);
+		uint32_t tiles = GetTilesPerSide() >> mip;
+		tileCount += tiles * tiles;
+	}
+	m_Offsets.resize(tileCount);
+	if (!m_File.read((char*)m_Offsets.data(), m_Offsets.size() * sizeof(uint64_t)))
+	{
+		m_File.close();
+		return false;
+	}
+	return true;
+}
+
+bool VirtualTextureFile::ReadTile(uint32_t mip, uint32_t x, uint32_t y, unsigned char* pixels)
+{
+	uint32_t tiles = GetTilesPerSide() >> mip;
+	if (!m_File.is_open() || mip >= m_Header.mipCount || x >= tiles || y >= tiles)
+		return false;
+	size_t bytes = (size_t)GetPageSize() * GetPageSize() * 4;
+	m_File.clear();
+	m_File.seekg((std::streamoff)m_Offsets[m_MipStarts[mip] + y * tiles + x]);
+	return (bool)m_File.read((char*)pixels, bytes);
+}
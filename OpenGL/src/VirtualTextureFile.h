@@ -0,0 +1,53 @@
+#pragma once
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "Image.h"
+
+// The on-disk side of VirtualTexture. A .vtex holds a square, power of two RGBA image cut into
+// tiles for every mip down to the one that fits in a single tile. Each tile is stored with a
+// border of its neighbours' texels so bilinear filtering inside the page cache doesn't need them.
+//
+// Layout, native byte order: header, then one uint64 file offset per tile (mip 0 first, rows top
+// to bottom), then the tiles as tightly packed RGBA rows of GetPageSize() texels.
+struct VirtualTextureHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	// Texels along each side of mip 0
+	uint32_t size;
+	uint32_t tileSize;
+	uint32_t border;
+	uint32_t mipCount;
+};
+
+class VirtualTextureFile
+{
+private:
+	VirtualTextureHeader m_Header;
+	std::vector<uint64_t> m_Offsets;
+	// First offset of each mip
+	std::vector<uint32_t> m_MipStarts;
+	std::ifstream m_File;
+public:
+	VirtualTextureFile();
+
+	// Cuts a 4 channel image into tiles and writes the mips. Fails unless the image is square, a
+	// power of two and at least tileSize.
+	static bool Build(const Image& image, uint32_t tileSize, uint32_t border, const std::string& path);
+
+	bool Open(const std::string& path);
+	bool IsOpen() const { return m_File.is_open(); }
+	// GetPageSize() squared RGBA texels
+	bool ReadTile(uint32_t mip, uint32_t x, uint32_t y, unsigned char* pixels);
+
+	uint32_t GetSize() const { return m_Header.size; }
+	uint32_t GetTileSize() const { return m_Header.tileSize; }
+	uint32_t GetBorder() const { return m_Header.border; }
+	// Tile plus the border on both sides
+	uint32_t GetPageSize() const { return m_Header.tileSize + 2 * m_Header.border; }
+	uint32_t GetMipCount() const { return m_Header.mipCount; }
+	// Along each side of mip 0
+	uint32_t GetTilesPerSide() const { return m_Header.tileSize ? m_Header.size / m_Header.tileSize : 0; }
+};
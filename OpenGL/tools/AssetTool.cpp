@@ -0,0 +1,348 @@
+// Offline asset processing. Runs without a GL context so it works on build machines.
+//
+// Usage: AssetTool info <model>                                  prints meshes, vertex/index counts, textures and bounds
+//        AssetTool animations <model> [outputDir] [tolerance]   compresses the model's clips, prints their sizes and
+//                                                                errors and writes them to outputDir as <index>.clip
+//        AssetTool batches <model>                               draws with one per mesh and with the maps in texture
+//                                                                arrays, see ModelSettings::textureArrays
+//        AssetTool vt <image> <output> [tileSize] [border]       cuts a square power of two image into a .vtex for
+//                                                                VirtualTexture
+//        AssetTool mips <image> [output]                         writes the image's mip chain as a .mips, by default
+//                                                                next to it for ModelSettings::mipStreamer to find
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <assimp/Importer.hpp>
+#include <assimp/scene.h>
+#include <assimp/postprocess.h>
+
+#include "AnimationCompression.h"
+#include "AnimationImport.h"
+#include "Bounds.h"
+#include "Image.h"
+#include "MipStreaming.h"
+#include "TextureBatching.h"
+#include "VirtualTextureFile.h"
+#include "vendor/stb_image/stb_image.h"
+
+namespace
+{
+	void PrintUsage()
+	{
+		std::cout << "Usage: AssetTool info <model>\n"
+			<< "       AssetTool animations <model> [outputDir] [tolerance]\n"
+			<< "       AssetTool batches <model>\n"
+			<< "       AssetTool vt <image> <output> [tileSize] [border]\n"
+			<< "       AssetTool mips <image> [output]\n";
+	}
+
+	int Info(const std::string& path)
+	{
+		// Same flags as Model::LoadModel so the numbers match what the engine sees
+		Assimp::Importer importer;
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		const aiScene* scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_FlipUVs);
+		double importMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)
+		{
+			std::cout << "ERROR::ASSIMP::" << importer.GetErrorString() << "\n";
+			return 1;
+		}
+
+		size_t totalVertices = 0;
+		size_t totalIndices = 0;
+		Bounds bounds;
+		std::cout << path << ": " << scene->mNumMeshes << " meshes, " << scene->mNumMaterials << " materials, imported in "
+			<< importMs << " ms\n";
+		for (unsigned int i = 0; i < scene->mNumMeshes; ++i)
+		{
+			const aiMesh* mesh = scene->mMeshes[i];
+			size_t indices = 0;
+			for (unsigned int f = 0; f < mesh->mNumFaces; ++f)
+				indices += mesh->mFaces[f].mNumIndices;
+			for (unsigned int v = 0; v < mesh->mNumVertices; ++v)
+				bounds.Expand(glm::vec3(mesh->mVertices[v].x, mesh->mVertices[v].y, mesh->mVertices[v].z));
+			totalVertices += mesh->mNumVertices;
+			totalIndices += indices;
+			std::cout << "  mesh " << i << " '" << mesh->mName.C_Str() << "': " << mesh->mNumVertices << " vertices, "
+				<< indices << " indices, material " << mesh->mMaterialIndex << "\n";
+		}
+
+		std::set<std::string> textures;
+		for (unsigned int i = 0; i < scene->mNumMaterials; ++i)
+		{
+			const aiMaterial* material = scene->mMaterials[i];
+			for (aiTextureType type : { aiTextureType_DIFFUSE, aiTextureType_SPECULAR, aiTextureType_NORMALS, aiTextureType_HEIGHT })
+			{
+				for (unsigned int t = 0; t < material->GetTextureCount(type); ++t)
+				{
+					aiString texture;
+					material->GetTexture(type, t, &texture);
+					textures.insert(texture.C_Str());
+				}
+			}
+		}
+
+		std::cout << "total: " << totalVertices << " vertices, " << totalIndices << " indices, "
+			<< textures.size() << " textures\n";
+		for (const std::string& texture : textures)
+			std::cout << "  texture " << texture << "\n";
+		if (bounds.IsValid())
+		{
+			std::cout << "bounds: (" << bounds.min.x << ", " << bounds.min.y << ", " << bounds.min.z << ") - ("
+				<< bounds.max.x << ", " << bounds.max.y << ", " << bounds.max.z << ")\n";
+		}
+		return 0;
+	}
+
+	int Animations(const std::string& path, const std::string& outputDirectory, float tolerance)
+	{
+		// Same flags as Model::LoadModel, the joints have to line up with the engine's
+		Assimp::Importer importer;
+		const aiScene* scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_FlipUVs | aiProcess_LimitBoneWeights);
+		if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)
+		{
+			std::cout << "ERROR::ASSIMP::" << importer.GetErrorString() << "\n";
+			return 1;
+		}
+
+		Skeleton skeleton;
+		ImportSkeleton(scene->mRootNode, skeleton);
+		std::vector<AnimationClip> clips;
+		ImportAnimations(scene, skeleton, clips);
+		CompressionSettings settings;
+		settings.translationTolerance = tolerance;
+		settings.rotationTolerance = tolerance;
+		settings.scaleTolerance = tolerance;
+
+		std::cout << path << ": " << skeleton.GetJointCount() << " joints, " << clips.size() << " clips, tolerance " << tolerance << "\n";
+		size_t totalBytes = 0;
+		size_t totalCompressedBytes = 0;
+		int result = 0;
+		for (size_t i = 0; i < clips.size(); ++i)
+		{
+			const AnimationClip& clip = clips[i];
+			CompressedClip compressed = CompressedClip::Compress(clip, skeleton, settings);
+			CompressionError error = MeasureCompressionError(clip, compressed, skeleton);
+			totalBytes += clip.GetMemoryUsage();
+			totalCompressedBytes += compressed.GetMemoryUsage();
+			std::cout << "  clip " << i << " '" << clip.name << "': " << clip.duration << " s, " << clip.GetKeyCount() << " -> "
+				<< compressed.GetKeyCount() << " keys, " << clip.GetMemoryUsage() << " -> " << compressed.GetMemoryUsage()
+				<< " bytes, max error " << error.translation << " translation, " << error.rotation << " rad, " << error.scale << " scale\n";
+
+			// Names are often things like "Armature|Walk", so the files are numbered instead
+			if (!outputDirectory.empty())
+			{
+				std::string clipPath = outputDirectory + "/" + std::to_string(i) + ".clip";
+				if (!compressed.Save(clipPath))
+				{
+					std::cout << "Could not write " << clipPath << "\n";
+					result = 1;
+				}
+			}
+		}
+		if (totalCompressedBytes > 0)
+		{
+			std::cout << "total: " << totalBytes << " -> " << totalCompressedBytes << " bytes ("
+				<< (double)totalBytes / totalCompressedBytes << "x)\n";
+		}
+		return result;
+	}
+
+	// Mesh and node of every mesh in the tree, with the distinct world transforms numbered
+	void CollectMeshes(const aiNode* node, const aiMatrix4x4& parent, std::vector<aiMatrix4x4>& transforms,
+		std::vector<std::pair<unsigned int, uint32_t>>& meshes)
+	{
+		aiMatrix4x4 world = parent * node->mTransformation;
+		uint32_t transform = 0;
+		while (transform < transforms.size() && !(transforms[transform] == world))
+			++transform;
+		if (transform == transforms.size())
+			transforms.push_back(world);
+		for (unsigned int i = 0; i < node->mNumMeshes; ++i)
+			meshes.push_back(std::make_pair(node->mMeshes[i], transform));
+		for (unsigned int i = 0; i < node->mNumChildren; ++i)
+			CollectMeshes(node->mChildren[i], world, transforms, meshes);
+	}
+
+	int Batches(const std::string& path)
+	{
+		Assimp::Importer importer;
+		const aiScene* scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_FlipUVs);
+		if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)
+		{
+			std::cout << "ERROR::ASSIMP::" << importer.GetErrorString() << "\n";
+			return 1;
+		}
+		std::string directory = path.substr(0, path.find_last_of('/'));
+
+		// The first map of each slot, same order as Material::Slot
+		const uint32_t NO_IMAGE = 0xffffffff;
+		std::map<std::string, uint32_t> imageIndices;
+		std::vector<int> widths, heights;
+		std::vector<std::vector<uint32_t>> materialImages(scene->mNumMaterials, std::vector<uint32_t>(3, NO_IMAGE));
+		for (unsigned int i = 0; i < scene->mNumMaterials; ++i)
+		{
+			const aiMaterial* material = scene->mMaterials[i];
+			aiTextureType normalType = material->GetTextureCount(aiTextureType_NORMALS) > 0 ? aiTextureType_NORMALS : aiTextureType_HEIGHT;
+			aiTextureType types[] = { aiTextureType_DIFFUSE, aiTextureType_SPECULAR, normalType };
+			for (unsigned int slot = 0; slot < 3; ++slot)
+			{
+				aiString name;
+				if (material->GetTexture(types[slot], 0, &name) != AI_SUCCESS)
+					continue;
+				std::string texture = directory + "/" + name.C_Str();
+				auto found = imageIndices.find(texture);
+				if (found == imageIndices.end())
+				{
+					int width = 0, height = 0, components = 0;
+					if (!stbi_info(texture.c_str(), &width, &height, &components))
+					{
+						std::cout << "Could not read " << texture << "\n";
+						continue;
+					}
+					found = imageIndices.insert(std::make_pair(texture, (uint32_t)widths.size())).first;
+					widths.push_back(width);
+					heights.push_back(height);
+				}
+				materialImages[i][slot] = found->second;
+			}
+		}
+		TextureArrayPlan plan = TextureArrayPlan::Plan(widths, heights);
+
+		// What MaterialLibrary would merge, the arrays and Kd/Ks/Ns
+		std::map<std::vector<float>, uint32_t> distinct;
+		std::vector<uint32_t> arrayMaterials(scene->mNumMaterials);
+		for (unsigned int i = 0; i < scene->mNumMaterials; ++i)
+		{
+			const aiMaterial* material = scene->mMaterials[i];
+			std::vector<float> key;
+			for (uint32_t image : materialImages[i])
+				key.push_back(image == NO_IMAGE ? -1.0f : (float)plan.placements[image].array);
+			aiColor3D diffuse(1.0f, 1.0f, 1.0f), specular(1.0f, 1.0f, 1.0f);
+			float shininess = 0.0f;
+			material->Get(AI_MATKEY_COLOR_DIFFUSE, diffuse);
+			material->Get(AI_MATKEY_COLOR_SPECULAR, specular);
+			material->Get(AI_MATKEY_SHININESS, shininess);
+			key.insert(key.end(), { diffuse.r, diffuse.g, diffuse.b, specular.r, specular.g, specular.b, shininess });
+			arrayMaterials[i] = distinct.insert(std::make_pair(key, (uint32_t)distinct.size())).first->second;
+		}
+
+		std::vector<aiMatrix4x4> transforms;
+		std::vector<std::pair<unsigned int, uint32_t>> meshes;
+		CollectMeshes(scene->mRootNode, aiMatrix4x4(), transforms, meshes);
+		std::vector<BatchKey> keys(meshes.size());
+		for (size_t i = 0; i < meshes.size(); ++i)
+		{
+			const aiMesh* mesh = scene->mMeshes[meshes[i].first];
+			keys[i].material = arrayMaterials[mesh->mMaterialIndex];
+			keys[i].transform = meshes[i].second;
+			// Tangents come with a normal map
+			keys[i].streams = (mesh->HasBones() ? 1 : 0) | (materialImages[mesh->mMaterialIndex][2] == NO_IMAGE ? 0 : 2);
+		}
+		uint32_t batchCount = 0;
+		GroupBatches(keys, batchCount);
+
+		std::cout << path << ": " << meshes.size() << " meshes, " << scene->mNumMaterials << " materials, "
+			<< widths.size() << " maps, " << transforms.size() << " transforms\n";
+		for (size_t i = 0; i < plan.arrays.size(); ++i)
+		{
+			std::cout << "  array " << i << ": " << plan.arrays[i].width << "x" << plan.arrays[i].height << ", "
+				<< plan.arrays[i].images.size() << " layers\n";
+		}
+		std::cout << "draws: " << meshes.size() << " -> " << batchCount << ", materials: " << scene->mNumMaterials
+			<< " -> " << distinct.size() << "\n";
+		return 0;
+	}
+
+	int BuildVirtualTexture(const std::string& path, const std::string& output, uint32_t tileSize, uint32_t border)
+	{
+		Image image;
+		if (!LoadImage(path, 4, image))
+		{
+			std::cout << "Could not read " << path << "\n";
+			return 1;
+		}
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		if (!VirtualTextureFile::Build(image, tileSize, border, output))
+		{
+			std::cout << "Could not build " << output << ", the image has to be square, a power of two and at least "
+				<< tileSize << " texels and so does the tile size\n";
+			return 1;
+		}
+		double buildMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+		VirtualTextureFile file;
+		if (!file.Open(output))
+		{
+			std::cout << "Could not read back " << output << "\n";
+			return 1;
+		}
+		std::cout << output << ": " << file.GetSize() << "x" << file.GetSize() << ", " << file.GetTilesPerSide() << "x"
+			<< file.GetTilesPerSide() << " tiles of " << file.GetTileSize() << " with a " << file.GetBorder() << " texel border, "
+			<< file.GetMipCount() << " mips, built in " << buildMs << " ms\n";
+		return 0;
+	}
+
+	int BuildMipChain(const std::string& path, const std::string& output)
+	{
+		Image image;
+		if (!LoadImage(path, 4, image))
+		{
+			std::cout << "Could not read " << path << "\n";
+			return 1;
+		}
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		if (!MipChainFile::Build(image, output))
+		{
+			std::cout << "Could not write " << output << "\n";
+			return 1;
+		}
+		double buildMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+		MipChainFile file;
+		if (!file.Open(output))
+		{
+			std::cout << "Could not read back " << output << "\n";
+			return 1;
+		}
+		uint64_t bytes = GetMipChainBytes(file.GetWidth(), file.GetHeight(), 0);
+		std::cout << output << ": " << file.GetWidth() << "x" << file.GetHeight() << ", " << file.GetLevelCount() << " levels, "
+			<< bytes / 1024 << " KB, built in " << buildMs << " ms\n";
+		return 0;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	if (argc < 3)
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	std::string command = argv[1];
+	if (command == "info")
+		return Info(argv[2]);
+	if (command == "animations")
+		return Animations(argv[2], argc > 3 ? argv[3] : "", argc > 4 ? (float)std::atof(argv[4]) : CompressionSettings().rotationTolerance);
+
+	if (command == "batches")
+		return Batches(argv[2]);
+	if (command == "vt" && argc > 3)
+	{
+		uint32_t tileSize = argc > 4 ? (uint32_t)std::atoi(argv[4]) : 128;
+		uint32_t border = argc > 5 ? (uint32_t)std::atoi(argv[5]) : 4;
+		return BuildVirtualTexture(argv[2], argv[3], tileSize, border);
+	}
+	if (command == "mips")
+		return BuildMipChain(argv[2], argc > 3 ? argv[3] : std::string(argv[2]) + ".mips");
+
+	PrintUsage();
+	return 1;
+}